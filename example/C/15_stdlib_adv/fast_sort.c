@@ -0,0 +1,301 @@
+/**
+ * @file fast_sort.c
+ * @brief 基数排序与记录排序的实现
+ */
+
+#include "fast_sort.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS      8         /* 每轮排几位 */
+#define RADIX_WIDE_BITS 16        /* 大数组每轮排几位 */
+#define RADIX_WIDE_MIN  (1 << 20) /* 元素数不少于它时用 16 位一轮 */
+#define RADIX_MIN_COUNT 256       /* 少于它时直方图的固定开销不划算，改用内省排序 */
+
+/*
+ * float/double 的数组要按同宽度的无符号整数读写。C 的别名规则不允许用 uint32_t* 访问 float 对象，
+ * GCC/Clang 用 may_alias 告诉编译器这些指针可能指向任何类型；MSVC 不做基于类型的别名优化。
+ */
+#if defined(__GNUC__) || defined(__clang__)
+typedef uint32_t __attribute__((may_alias)) bits32_t;
+typedef uint64_t __attribute__((may_alias)) bits64_t;
+#else
+typedef uint32_t bits32_t;
+typedef uint64_t bits64_t;
+#endif
+
+/* ========================================================================== */
+/*                              可排序的键                                    */
+/* ========================================================================== */
+
+/*
+ * 把原始位模式变成“按无符号比较就有序”的键，变换可逆：
+ *   无符号    不变
+ *   有符号    符号位取反：负数落到前半段，且内部顺序不变
+ *   浮点数    负数所有位取反（绝对值越大越靠前），正数只取反符号位
+ * 三种都写成 x ^ mask，mask 由符号位和两个常量决定，排序循环里没有分支。
+ */
+typedef struct {
+    uint64_t sign; /* 有符号和浮点数为最高位，无符号为 0 */
+    uint64_t neg;  /* 浮点数为全 1：负数要额外取反其余各位 */
+} KeyFlip;
+
+static const KeyFlip flip_unsigned32 = {0, 0};
+static const KeyFlip flip_signed32 = {0x80000000u, 0};
+static const KeyFlip flip_float32 = {0x80000000u, 0xFFFFFFFFu};
+static const KeyFlip flip_unsigned64 = {0, 0};
+static const KeyFlip flip_signed64 = {0x8000000000000000u, 0};
+static const KeyFlip flip_float64 = {0x8000000000000000u, ~(uint64_t)0};
+
+static inline uint32_t key32_encode(uint32_t x, KeyFlip f) {
+    uint32_t neg = (uint32_t)0 - (x >> 31);
+    return x ^ ((neg & (uint32_t)f.neg) | (uint32_t)f.sign);
+}
+
+/* 编码后最高位为 0 的是原来的负数 */
+static inline uint32_t key32_decode(uint32_t k, KeyFlip f) {
+    uint32_t neg = (uint32_t)0 - ((~k) >> 31);
+    return k ^ ((neg & (uint32_t)f.neg) | (uint32_t)f.sign);
+}
+
+static inline uint64_t key64_encode(uint64_t x, KeyFlip f) {
+    uint64_t neg = (uint64_t)0 - (x >> 63);
+    return x ^ ((neg & f.neg) | f.sign);
+}
+
+static inline uint64_t key64_decode(uint64_t k, KeyFlip f) {
+    uint64_t neg = (uint64_t)0 - ((~k) >> 63);
+    return k ^ ((neg & f.neg) | f.sign);
+}
+
+/* 小数组和申请不到缓冲区时的兜底：同样比较编码后的键，和基数排序的结果一致 */
+#define U32_LESS(a, b) ((a) < (b))
+#define S32_LESS(a, b) (key32_encode((a), flip_signed32) < key32_encode((b), flip_signed32))
+#define F32_LESS(a, b) (key32_encode((a), flip_float32) < key32_encode((b), flip_float32))
+#define U64_LESS(a, b) ((a) < (b))
+#define S64_LESS(a, b) (key64_encode((a), flip_signed64) < key64_encode((b), flip_signed64))
+#define F64_LESS(a, b) (key64_encode((a), flip_float64) < key64_encode((b), flip_float64))
+
+INTROSORT_DEFINE(introsort_u32, bits32_t, U32_LESS)
+INTROSORT_DEFINE(introsort_s32, bits32_t, S32_LESS)
+INTROSORT_DEFINE(introsort_f32, bits32_t, F32_LESS)
+INTROSORT_DEFINE(introsort_u64, bits64_t, U64_LESS)
+INTROSORT_DEFINE(introsort_s64, bits64_t, S64_LESS)
+INTROSORT_DEFINE(introsort_f64, bits64_t, F64_LESS)
+
+/* ========================================================================== */
+/*                              LSD 基数排序                                  */
+/* ========================================================================== */
+
+/*
+ * 第一遍：原地编码，同时统计每一轮的直方图。
+ * 之后每一轮把 src 按该轮的数字稳定地分发到 dst；最后一轮顺带解码写回原始位模式。
+ * 某一轮所有元素的数字都相同（直方图只有一个桶非 0）时，分发不会改变顺序，直接跳过。
+ *
+ * 每一轮都要把整个数组读一遍、乱序写一遍，数组远大于缓存时耗时几乎只取决于轮数。
+ * 所以大数组改用 16 位数字：轮数减半，代价是 65536 个桶的直方图（每轮 512KB）和前缀和。
+ */
+static unsigned radix_bits(size_t n) {
+    return n >= RADIX_WIDE_MIN ? RADIX_WIDE_BITS : RADIX_BITS;
+}
+
+/* 申请不到直方图返回 false，此时还没有改动数组 */
+static bool radix32(bits32_t* a, bits32_t* tmp, size_t n, KeyFlip f) {
+    unsigned bits = radix_bits(n), buckets = 1u << bits, passes = 32 / bits;
+    uint32_t mask = buckets - 1;
+    size_t* count = (size_t*)calloc((size_t)passes * buckets, sizeof(size_t));
+    size_t* offset = (size_t*)malloc(buckets * sizeof(size_t));
+    if (!count || !offset) {
+        free(count);
+        free(offset);
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint32_t k = key32_encode(a[i], f);
+        a[i] = k;
+        for (unsigned p = 0; p < passes; p++) count[p * buckets + ((k >> (p * bits)) & mask)]++;
+    }
+
+    unsigned active[32], nactive = 0;
+    for (unsigned p = 0; p < passes; p++) {
+        if (count[p * buckets + ((a[0] >> (p * bits)) & mask)] != n) active[nactive++] = p;
+    }
+
+    bits32_t* src = a;
+    bits32_t* dst = tmp;
+    for (unsigned i = 0; i < nactive; i++) {
+        unsigned shift = active[i] * bits;
+        const size_t* c = count + (size_t)active[i] * buckets;
+        size_t sum = 0;
+        for (unsigned b = 0; b < buckets; b++) {
+            offset[b] = sum;
+            sum += c[b];
+        }
+        if (i + 1 < nactive) {
+            for (size_t j = 0; j < n; j++) {
+                uint32_t k = src[j];
+                dst[offset[(k >> shift) & mask]++] = k;
+            }
+        } else {
+            for (size_t j = 0; j < n; j++) {
+                uint32_t k = src[j];
+                dst[offset[(k >> shift) & mask]++] = key32_decode(k, f);
+            }
+        }
+        bits32_t* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (nactive == 0) {
+        for (size_t i = 0; i < n; i++) a[i] = key32_decode(a[i], f);
+    } else if (src != a) {
+        memcpy(a, src, n * sizeof(uint32_t));
+    }
+    free(count);
+    free(offset);
+    return true;
+}
+
+/* 与 radix32 相同，键为 64 位；first_bit 以下的低位不参与排序（sort_records 用） */
+static bool radix64(bits64_t* a, bits64_t* tmp, size_t n, KeyFlip f, unsigned first_bit) {
+    unsigned bits = radix_bits(n), buckets = 1u << bits, passes = 64 / bits;
+    unsigned first = first_bit / bits;
+    uint64_t mask = buckets - 1;
+    size_t* count = (size_t*)calloc((size_t)passes * buckets, sizeof(size_t));
+    size_t* offset = (size_t*)malloc(buckets * sizeof(size_t));
+    if (!count || !offset) {
+        free(count);
+        free(offset);
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint64_t k = key64_encode(a[i], f);
+        a[i] = k;
+        for (unsigned p = first; p < passes; p++) {
+            count[p * buckets + ((k >> (p * bits)) & mask)]++;
+        }
+    }
+
+    unsigned active[64], nactive = 0;
+    for (unsigned p = first; p < passes; p++) {
+        if (count[p * buckets + ((a[0] >> (p * bits)) & mask)] != n) active[nactive++] = p;
+    }
+
+    bits64_t* src = a;
+    bits64_t* dst = tmp;
+    for (unsigned i = 0; i < nactive; i++) {
+        unsigned shift = active[i] * bits;
+        const size_t* c = count + (size_t)active[i] * buckets;
+        size_t sum = 0;
+        for (unsigned b = 0; b < buckets; b++) {
+            offset[b] = sum;
+            sum += c[b];
+        }
+        if (i + 1 < nactive) {
+            for (size_t j = 0; j < n; j++) {
+                uint64_t k = src[j];
+                dst[offset[(k >> shift) & mask]++] = k;
+            }
+        } else {
+            for (size_t j = 0; j < n; j++) {
+                uint64_t k = src[j];
+                dst[offset[(k >> shift) & mask]++] = key64_decode(k, f);
+            }
+        }
+        bits64_t* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (nactive == 0) {
+        for (size_t i = 0; i < n; i++) a[i] = key64_decode(a[i], f);
+    } else if (src != a) {
+        memcpy(a, src, n * sizeof(uint64_t));
+    }
+    free(count);
+    free(offset);
+    return true;
+}
+
+static void sort_bits32(bits32_t* a, size_t n, KeyFlip f, void (*fallback)(bits32_t*, size_t)) {
+    bits32_t* tmp = n >= RADIX_MIN_COUNT ? (bits32_t*)malloc(n * sizeof(uint32_t)) : NULL;
+    if (!tmp || !radix32(a, tmp, n, f)) fallback(a, n);
+    free(tmp);
+}
+
+static void sort_bits64(bits64_t* a, size_t n, KeyFlip f, void (*fallback)(bits64_t*, size_t)) {
+    bits64_t* tmp = n >= RADIX_MIN_COUNT ? (bits64_t*)malloc(n * sizeof(uint64_t)) : NULL;
+    if (!tmp || !radix64(a, tmp, n, f, 0)) fallback(a, n);
+    free(tmp);
+}
+
+/* 有符号整数和浮点数都按同宽度的位模式处理 */
+void sort_i32(int32_t* a, size_t n) {
+    sort_bits32((bits32_t*)a, n, flip_signed32, introsort_s32);
+}
+
+void sort_u32(uint32_t* a, size_t n) {
+    sort_bits32((bits32_t*)a, n, flip_unsigned32, introsort_u32);
+}
+
+void sort_i64(int64_t* a, size_t n) {
+    sort_bits64((bits64_t*)a, n, flip_signed64, introsort_s64);
+}
+
+void sort_u64(uint64_t* a, size_t n) {
+    sort_bits64((bits64_t*)a, n, flip_unsigned64, introsort_u64);
+}
+
+void sort_f32(float* a, size_t n) {
+    sort_bits32((bits32_t*)a, n, flip_float32, introsort_f32);
+}
+
+void sort_f64(double* a, size_t n) {
+    sort_bits64((bits64_t*)a, n, flip_float64, introsort_f64);
+}
+
+/* ========================================================================== */
+/*                              记录排序                                      */
+/* ========================================================================== */
+
+bool sort_records(void* base, size_t n, size_t size, size_t key_offset, SortKeyKind kind,
+                  bool descending) {
+    if (n < 2) return true;
+    if (n > UINT32_MAX) return false;
+    bits64_t* keys = (bits64_t*)malloc(n * sizeof(uint64_t));
+    bits64_t* tmp = (bits64_t*)malloc(n * sizeof(uint64_t));
+    unsigned char* out = (unsigned char*)malloc(n * size);
+    if (!keys || !tmp || !out) {
+        free(keys);
+        free(tmp);
+        free(out);
+        return false;
+    }
+
+    /* 高 32 位是可排序的键，低 32 位是原下标；低位本来就按下标递增，只排高 32 位结果就是稳定的 */
+    KeyFlip f = flip_unsigned32;
+    if (kind == SORT_KEY_I32) f = flip_signed32;
+    else if (kind == SORT_KEY_F32) f = flip_float32;
+    uint32_t invert = descending ? 0xFFFFFFFFu : 0;
+    const unsigned char* rec = (const unsigned char*)base;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t bits;
+        memcpy(&bits, rec + i * size + key_offset, sizeof(bits));
+        keys[i] = (uint64_t)(key32_encode(bits, f) ^ invert) << 32 | (uint64_t)i;
+    }
+    if (!radix64(keys, tmp, n, flip_unsigned64, 32)) {
+        free(keys);
+        free(tmp);
+        free(out);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        memcpy(out + i * size, rec + (size_t)(uint32_t)keys[i] * size, size);
+    }
+    memcpy(base, out, n * size);
+    free(keys);
+    free(tmp);
+    free(out);
+    return true;
+}
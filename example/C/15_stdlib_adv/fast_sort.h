@@ -0,0 +1,299 @@
+/**
+ * @file fast_sort.h
+ * @brief 按类型特化的排序：基数排序 + 内联比较的内省排序 + “键 + 负载”记录排序
+ *
+ * main.c 第一节的 qsort(list, count, sizeof(int), compare_numbers) 很通用，但有两个代价：
+ * 1. 每次比较都要通过函数指针调用 compare_numbers，无法内联，10^7 个元素要调用约 2.3 亿次；
+ * 2. 元素大小在运行时才知道，交换只能逐字节或按 memcpy 搬运。
+ * 这里按类型给出专用实现：
+ *
+ * 1. sort_i32 / sort_u32 / sort_i64 / sort_u64 / sort_f32 / sort_f64：LSD 基数排序。
+ *    每轮按 8 位数字做一次计数排序，32 位 4 轮、64 位 8 轮，不做任何比较；
+ *    元素超过 2^20 个时每轮改排 16 位，轮数减半（大数组每轮都要过一遍内存，轮数决定耗时）。
+ *    有符号数把符号位取反、浮点数负数全部取反正数只取反符号位，变成按无符号比较就有序的键；
+ *    所有轮的直方图在第一遍读数据时一起统计，某一位上所有元素都相同的轮直接跳过。
+ *    浮点数按位排序：-0.0 排在 +0.0 前面，NaN 按符号位排在两端。
+ *    元素很少或申请不到临时缓冲区时改用下面的内省排序。
+ *
+ * 2. INTROSORT_DEFINE(名字, 元素类型, LESS)：生成一个不依赖基数的通用排序，比较直接内联。
+ *    算法参照 pdqsort（模式消除快速排序）：
+ *    - 小区间插入排序，枢轴取三数中值，大区间取 ninther；
+ *    - 枢轴与左侧上一轮的枢轴相等时，把相等的一段整体放到左边跳过，大量重复值也是 O(n log n)；
+ *    - 划分前已经分好的区间先试探一次“最多移动 8 个元素”的插入排序，有序输入接近 O(n)；
+ *    - 划分严重不均就打乱几个元素，连续坏划分超过 log2(n) 次就改用堆排序，最坏 O(n log n)。
+ *    LESS(a, b) 是一个表达式宏，a、b 是两个元素（左值），返回 a 是否应排在 b 前面，
+ *    必须是严格弱序（a < a 为假）。不稳定。例如：
+ *        #define SCORE_LESS(a, b) ((a).score < (b).score)
+ *        INTROSORT_DEFINE(sort_by_score, Student, SCORE_LESS)
+ *        sort_by_score(students, n);
+ *
+ * 3. sort_records：按记录中的一个 32 位字段（int32/uint32/float）稳定排序任意大小的结构体。
+ *    先抽出 (键, 下标) 组成 64 位整数做基数排序，只排键所在的高 32 位，
+ *    再按下标把记录搬到临时缓冲区，每条记录只搬一次。
+ */
+
+#ifndef FAST_SORT_H
+#define FAST_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void sort_i32(int32_t* a, size_t n);
+void sort_u32(uint32_t* a, size_t n);
+void sort_i64(int64_t* a, size_t n);
+void sort_u64(uint64_t* a, size_t n);
+void sort_f32(float* a, size_t n);
+void sort_f64(double* a, size_t n);
+
+typedef enum {
+    SORT_KEY_I32,
+    SORT_KEY_U32,
+    SORT_KEY_F32,
+} SortKeyKind;
+
+/*
+ * 按 base 中每条记录 key_offset 处的键稳定排序，descending 为真时从大到小。
+ * n 不能超过 UINT32_MAX；申请不到临时缓冲区返回 false，此时数组保持原样。
+ */
+bool sort_records(void* base, size_t n, size_t size, size_t key_offset, SortKeyKind kind,
+                  bool descending);
+
+/* 按结构体的字段排序，例如 SORT_RECORDS_BY(students, n, Student, score, SORT_KEY_F32, true) */
+#define SORT_RECORDS_BY(base, n, Type, field, kind, descending) \
+    sort_records((base), (n), sizeof(Type), offsetof(Type, field), (kind), (descending))
+
+/* ========================================================================== */
+/*                       内省排序模板 (INTROSORT_DEFINE)                      */
+/* ========================================================================== */
+
+#define SORT_INSERTION_LIMIT 24  /* 小于它的区间直接插入排序 */
+#define SORT_NINTHER_LIMIT   128 /* 大于它的区间用 ninther 选枢轴 */
+#define SORT_PARTIAL_LIMIT   8   /* 试探性插入排序最多移动的元素个数 */
+
+#define INTROSORT_DEFINE(Name, T, LESS)                                                            \
+    static inline void Name##_sort2(T* a, T* b) {                                                  \
+        if (LESS(*b, *a)) {                                                                        \
+            T t_ = *a;                                                                             \
+            *a = *b;                                                                               \
+            *b = t_;                                                                               \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name##_sort3(T* a, T* b, T* c) {                                            \
+        Name##_sort2(a, b);                                                                        \
+        Name##_sort2(b, c);                                                                        \
+        Name##_sort2(a, b);                                                                        \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name##_swap(T* a, T* b) {                                                   \
+        T t_ = *a;                                                                                 \
+        *a = *b;                                                                                   \
+        *b = t_;                                                                                   \
+    }                                                                                              \
+                                                                                                   \
+    /* 带边界检查的插入排序 */                                                                     \
+    static inline void Name##_insertion(T* begin, T* end) {                                        \
+        if (begin == end) return;                                                                  \
+        for (T* cur = begin + 1; cur != end; cur++) {                                              \
+            T* sift = cur;                                                                         \
+            T* sift_1 = cur - 1;                                                                   \
+            if (LESS(*sift, *sift_1)) {                                                            \
+                T tmp = *sift;                                                                     \
+                do {                                                                               \
+                    *sift-- = *sift_1;                                                             \
+                } while (sift != begin && LESS(tmp, *--sift_1));                                   \
+                *sift = tmp;                                                                       \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /* 不检查左边界：调用方保证 begin[-1] 不大于区间内任何元素 */                                  \
+    static inline void Name##_insertion_unguarded(T* begin, T* end) {                              \
+        if (begin == end) return;                                                                  \
+        for (T* cur = begin + 1; cur != end; cur++) {                                              \
+            T* sift = cur;                                                                         \
+            T* sift_1 = cur - 1;                                                                   \
+            if (LESS(*sift, *sift_1)) {                                                            \
+                T tmp = *sift;                                                                     \
+                do {                                                                               \
+                    *sift-- = *sift_1;                                                             \
+                } while (LESS(tmp, *--sift_1));                                                    \
+                *sift = tmp;                                                                       \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /* 移动超过 SORT_PARTIAL_LIMIT 个元素就放弃，用来以 O(n) 的代价识别已经有序的区间 */           \
+    static inline bool Name##_insertion_partial(T* begin, T* end) {                                \
+        if (begin == end) return true;                                                             \
+        size_t moved = 0;                                                                          \
+        for (T* cur = begin + 1; cur != end; cur++) {                                              \
+            T* sift = cur;                                                                         \
+            T* sift_1 = cur - 1;                                                                   \
+            if (LESS(*sift, *sift_1)) {                                                            \
+                T tmp = *sift;                                                                     \
+                do {                                                                               \
+                    *sift-- = *sift_1;                                                             \
+                } while (sift != begin && LESS(tmp, *--sift_1));                                   \
+                *sift = tmp;                                                                       \
+                moved += (size_t)(cur - sift);                                                     \
+            }                                                                                      \
+            if (moved > SORT_PARTIAL_LIMIT) return false;                                          \
+        }                                                                                          \
+        return true;                                                                               \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name##_sift_down(T* a, size_t root, size_t n) {                             \
+        T tmp = a[root];                                                                           \
+        for (size_t child; (child = 2 * root + 1) < n; root = child) {                             \
+            if (child + 1 < n && LESS(a[child], a[child + 1])) child++;                            \
+            if (!LESS(tmp, a[child])) break;                                                       \
+            a[root] = a[child];                                                                    \
+        }                                                                                          \
+        a[root] = tmp;                                                                             \
+    }                                                                                              \
+                                                                                                   \
+    /* 坏划分太多时的兜底，保证最坏 O(n log n) */                                                  \
+    static inline void Name##_heapsort(T* begin, T* end) {                                         \
+        size_t n = (size_t)(end - begin);                                                          \
+        for (size_t i = n / 2; i-- > 0;) Name##_sift_down(begin, i, n);                            \
+        for (size_t i = n; i-- > 1;) {                                                             \
+            Name##_swap(&begin[0], &begin[i]);                                                     \
+            Name##_sift_down(begin, 0, i);                                                         \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /*                                                                                             \
+     * 以 *begin 为枢轴划分，小于枢轴的放左边；返回枢轴的最终位置。                                \
+     * *already 表示划分前区间就已经分好（一次交换都没做）。                                       \
+     */                                                                                            \
+    static inline T* Name##_partition_right(T* begin, T* end, bool* already) {                     \
+        T pivot = *begin;                                                                          \
+        T* first = begin;                                                                          \
+        T* last = end;                                                                             \
+        while (LESS(*++first, pivot)) {                                                            \
+        }                                                                                          \
+        if (first - 1 == begin) {                                                                  \
+            while (first < last && !LESS(*--last, pivot)) {                                        \
+            }                                                                                      \
+        } else {                                                                                   \
+            while (!LESS(*--last, pivot)) {                                                        \
+            }                                                                                      \
+        }                                                                                          \
+        *already = first >= last;                                                                  \
+        while (first < last) {                                                                     \
+            Name##_swap(first, last);                                                              \
+            while (LESS(*++first, pivot)) {                                                        \
+            }                                                                                      \
+            while (!LESS(*--last, pivot)) {                                                        \
+            }                                                                                      \
+        }                                                                                          \
+        T* pivot_pos = first - 1;                                                                  \
+        *begin = *pivot_pos;                                                                       \
+        *pivot_pos = pivot;                                                                        \
+        return pivot_pos;                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /* 与枢轴相等的元素都放到左边并一起跳过，大量重复值时每轮至少去掉一整类 */                     \
+    static inline T* Name##_partition_left(T* begin, T* end) {                                     \
+        T pivot = *begin;                                                                          \
+        T* first = begin;                                                                          \
+        T* last = end;                                                                             \
+        while (LESS(pivot, *--last)) {                                                             \
+        }                                                                                          \
+        if (last + 1 == end) {                                                                     \
+            while (first < last && !LESS(pivot, *++first)) {                                       \
+            }                                                                                      \
+        } else {                                                                                   \
+            while (!LESS(pivot, *++first)) {                                                       \
+            }                                                                                      \
+        }                                                                                          \
+        while (first < last) {                                                                     \
+            Name##_swap(first, last);                                                              \
+            while (LESS(pivot, *--last)) {                                                         \
+            }                                                                                      \
+            while (!LESS(pivot, *++first)) {                                                       \
+            }                                                                                      \
+        }                                                                                          \
+        *begin = *last;                                                                            \
+        *last = pivot;                                                                             \
+        return last;                                                                               \
+    }                                                                                              \
+                                                                                                   \
+    /* 打乱划分点附近的几个元素，破坏导致连续坏划分的输入模式 */                                   \
+    static inline void Name##_break_pattern(T* begin, T* pivot_pos, T* end) {                      \
+        size_t l = (size_t)(pivot_pos - begin), r = (size_t)(end - (pivot_pos + 1));               \
+        if (l >= SORT_INSERTION_LIMIT) {                                                           \
+            Name##_swap(begin, begin + l / 4);                                                     \
+            Name##_swap(pivot_pos - 1, pivot_pos - l / 4);                                         \
+            if (l > SORT_NINTHER_LIMIT) {                                                          \
+                Name##_swap(begin + 1, begin + (l / 4 + 1));                                       \
+                Name##_swap(begin + 2, begin + (l / 4 + 2));                                       \
+                Name##_swap(pivot_pos - 2, pivot_pos - (l / 4 + 1));                               \
+                Name##_swap(pivot_pos - 3, pivot_pos - (l / 4 + 2));                               \
+            }                                                                                      \
+        }                                                                                          \
+        if (r >= SORT_INSERTION_LIMIT) {                                                           \
+            Name##_swap(pivot_pos + 1, pivot_pos + (1 + r / 4));                                   \
+            Name##_swap(end - 1, end - r / 4);                                                     \
+            if (r > SORT_NINTHER_LIMIT) {                                                          \
+                Name##_swap(pivot_pos + 2, pivot_pos + (2 + r / 4));                               \
+                Name##_swap(pivot_pos + 3, pivot_pos + (3 + r / 4));                               \
+                Name##_swap(end - 2, end - (1 + r / 4));                                           \
+                Name##_swap(end - 3, end - (2 + r / 4));                                           \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name##_loop(T* begin, T* end, int bad_allowed, bool leftmost) {             \
+        for (;;) {                                                                                 \
+            size_t size = (size_t)(end - begin);                                                   \
+            if (size < SORT_INSERTION_LIMIT) {                                                     \
+                if (leftmost) Name##_insertion(begin, end);                                        \
+                else Name##_insertion_unguarded(begin, end);                                       \
+                return;                                                                            \
+            }                                                                                      \
+            /* 枢轴取三数中值，大区间取“中值的中值”(ninther)，放到 begin */                        \
+            size_t s2 = size / 2;                                                                  \
+            if (size > SORT_NINTHER_LIMIT) {                                                       \
+                Name##_sort3(begin, begin + s2, end - 1);                                          \
+                Name##_sort3(begin + 1, begin + (s2 - 1), end - 2);                                \
+                Name##_sort3(begin + 2, begin + (s2 + 1), end - 3);                                \
+                Name##_sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1));                      \
+                Name##_swap(begin, begin + s2);                                                    \
+            } else {                                                                               \
+                Name##_sort3(begin + s2, begin, end - 1);                                          \
+            }                                                                                      \
+            /* 左边界外的元素是上一轮的枢轴；枢轴不比它大说明两者相等，把相等的一段整体跳过 */     \
+            if (!leftmost && !LESS(*(begin - 1), *begin)) {                                        \
+                begin = Name##_partition_left(begin, end) + 1;                                     \
+                continue;                                                                          \
+            }                                                                                      \
+            bool already;                                                                          \
+            T* pivot_pos = Name##_partition_right(begin, end, &already);                           \
+            size_t l = (size_t)(pivot_pos - begin), r = (size_t)(end - (pivot_pos + 1));           \
+            if (l < size / 8 || r < size / 8) {                                                    \
+                if (--bad_allowed == 0) {                                                          \
+                    Name##_heapsort(begin, end);                                                   \
+                    return;                                                                        \
+                }                                                                                  \
+                Name##_break_pattern(begin, pivot_pos, end);                                       \
+            } else if (already && Name##_insertion_partial(begin, pivot_pos) &&                    \
+                       Name##_insertion_partial(pivot_pos + 1, end)) {                             \
+                return;                                                                            \
+            }                                                                                      \
+            /* 递归左半、循环右半 */                                                               \
+            Name##_loop(begin, pivot_pos, bad_allowed, leftmost);                                  \
+            begin = pivot_pos + 1;                                                                 \
+            leftmost = false;                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name(T* a, size_t n) {                                                      \
+        int bad_allowed = 1;                                                                       \
+        while (n >> bad_allowed) bad_allowed++;                                                    \
+        Name##_loop(a, a + n, bad_allowed, true);                                                  \
+    }
+
+#endif /* FAST_SORT_H */
@@ -2,6 +2,10 @@
 #include <stdlib.h> // 包含 qsort, rand, malloc 等工具
 #include <math.h>   // 包含 sqrt, pow, sin 等数学函数
 #include <time.h>   // 包含处理时间的函数
+#include <stdint.h>
+#include <string.h>
+
+#include "fast_sort.h" // 按类型特化的排序（基数排序 / 内省排序模板 / 记录排序）
 
 /**
  * 知识点：标准库工具与现代 C 语言特性 (Standard Library & Advanced)
@@ -10,6 +14,9 @@
  * 3. 随机数：如何生成“看起来真正随机”的数字。
  * 4. 时间处理：获取当前系统的时间戳。
  * 5. C99 新特性：变长数组 (VLA)，允许数组大小是变量。
+ * 6. 按类型特化的排序：qsort 每次比较都要调一次函数指针，fast_sort.h 为整数/浮点数提供基数排序，
+ *    为任意类型提供比较内联的内省排序模板。运行 `./15_stdlib_adv --bench [n]` 对比 n 个元素
+ *    （默认 10^7）时与 qsort 的耗时。
  */
 
 // [知识点] qsort 的回调函数：告诉排序器如何比较两个数字
@@ -21,10 +28,173 @@ int compare_numbers(const void *a, const void *b) {
     // 返回负数：a 应该在 b 前面
     // 返回正数：a 应该在 b 后面
     // 返回零： 随便
-    return (val_a - val_b); 
+    // [坑点] 不要写 val_a - val_b：INT_MIN - 1 这类相减会溢出，符号反过来，排序结果就乱了
+    return (val_a > val_b) - (val_a < val_b);
+}
+
+// 与 09_struct_union 相同的学生记录
+typedef struct {
+    int id;
+    char name[20];
+    float score;
+} Student;
+
+// [知识点] 内省排序模板：比较写成宏，展开在排序代码里，没有函数指针调用
+#define NAME_LESS(a, b) (strcmp((a).name, (b).name) < 0)
+INTROSORT_DEFINE(sort_students_by_name, Student, NAME_LESS)
+
+#define INT_LESS(a, b) ((a) < (b))
+INTROSORT_DEFINE(introsort_int, int32_t, INT_LESS)
+
+/* ========================================================================== */
+/*                        --bench：与 qsort 的耗时对比                        */
+/* ========================================================================== */
+
+#define SORT_BENCH_DEFAULT 10000000
+
+static double now_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
 }
 
-int main() {
+/* xorshift64：比 rand() 快，且能给出完整的 64 位随机数 */
+static uint64_t bench_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int compare_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_score_desc(const void* a, const void* b) {
+    float x = ((const Student*)a)->score, y = ((const Student*)b)->score;
+    return (x < y) - (x > y);
+}
+
+static void bench_print(const char* label, double qsort_ms, double intro_ms, double radix_ms,
+                        int ok) {
+    char intro[32] = "         -";
+    if (intro_ms > 0) snprintf(intro, sizeof(intro), "%10.1f", intro_ms);
+    printf("  %s %10.1f %s %10.1f %8.1fx%s\n", label, qsort_ms, intro, radix_ms,
+           qsort_ms / radix_ms, ok ? "" : "  (结果不一致!)");
+}
+
+static int bench_sort(size_t n) {
+    int32_t* a = (int32_t*)malloc(n * sizeof(int32_t));
+    int32_t* b = (int32_t*)malloc(n * sizeof(int32_t));
+    int32_t* c = (int32_t*)malloc(n * sizeof(int32_t));
+    size_t ns = n / 10 > 0 ? n / 10 : 1;
+    Student* s1 = (Student*)malloc(ns * sizeof(Student));
+    Student* s2 = (Student*)malloc(ns * sizeof(Student));
+    if (!a || !b || !c || !s1 || !s2) {
+        printf("内存不足\n");
+        free(a);
+        free(b);
+        free(c);
+        free(s1);
+        free(s2);
+        return 1;
+    }
+    uint64_t seed = 88172645463325252u;
+    printf("排序 %zu 个随机数 (ms)，基数排序 = fast_sort.h 的 sort_*，内省排序 = INTROSORT_DEFINE\n",
+           n);
+    printf("  数据                  qsort   内省排序   基数排序    加速比\n");
+
+    // 1. int32：覆盖正负全范围
+    for (size_t i = 0; i < n; i++) a[i] = (int32_t)(uint32_t)bench_rand(&seed);
+    memcpy(b, a, n * sizeof(int32_t));
+    memcpy(c, a, n * sizeof(int32_t));
+    double t0 = now_ms();
+    qsort(a, n, sizeof(int32_t), compare_numbers);
+    double t1 = now_ms();
+    introsort_int(b, n);
+    double t2 = now_ms();
+    sort_i32(c, n);
+    double t3 = now_ms();
+    int ok = memcmp(a, b, n * sizeof(int32_t)) == 0 && memcmp(a, c, n * sizeof(int32_t)) == 0;
+    bench_print("int32 (全范围)    ", t1 - t0, t2 - t1, t3 - t2, ok);
+
+    // 2. float：正负都有，负数的位模式需要整体取反
+    float* fa = (float*)a;
+    float* fc = (float*)c;
+    for (size_t i = 0; i < n; i++) {
+        fa[i] = (float)((double)(int32_t)(uint32_t)bench_rand(&seed) / 1024.0);
+    }
+    memcpy(fc, fa, n * sizeof(float));
+    t0 = now_ms();
+    qsort(fa, n, sizeof(float), compare_floats);
+    t1 = now_ms();
+    sort_f32(fc, n);
+    t2 = now_ms();
+    ok = memcmp(fa, fc, n * sizeof(float)) == 0;
+    bench_print("float             ", t1 - t0, 0, t2 - t1, ok);
+    free(b);
+    free(c);
+
+    // 3. int64：少于 2^20 个时 8 轮、每轮 8 位，默认的 10^7 个改为 4 轮、每轮 16 位
+    int64_t* la = (int64_t*)malloc(n * sizeof(int64_t));
+    int64_t* lc = (int64_t*)malloc(n * sizeof(int64_t));
+    if (la && lc) {
+        for (size_t i = 0; i < n; i++) la[i] = (int64_t)bench_rand(&seed);
+        memcpy(lc, la, n * sizeof(int64_t));
+        t0 = now_ms();
+        qsort(la, n, sizeof(int64_t), compare_i64);
+        t1 = now_ms();
+        sort_i64(lc, n);
+        t2 = now_ms();
+        ok = memcmp(la, lc, n * sizeof(int64_t)) == 0;
+        bench_print("int64             ", t1 - t0, 0, t2 - t1, ok);
+    }
+    free(la);
+    free(lc);
+
+    // 4. 记录：按成绩从高到低，sort_records 是稳定的，qsort 不保证，所以只比较成绩序列
+    for (size_t i = 0; i < ns; i++) {
+        s1[i].id = (int)i;
+        snprintf(s1[i].name, sizeof(s1[i].name), "student%zu", i % 100000);
+        s1[i].score = (float)(bench_rand(&seed) % 1001) / 10.0f;
+    }
+    memcpy(s2, s1, ns * sizeof(Student));
+    t0 = now_ms();
+    qsort(s1, ns, sizeof(Student), compare_score_desc);
+    t1 = now_ms();
+    SORT_RECORDS_BY(s2, ns, Student, score, SORT_KEY_F32, true);
+    t2 = now_ms();
+    ok = 1;
+    for (size_t i = 0; i < ns; i++) {
+        if (s1[i].score != s2[i].score) ok = 0;
+        if (i > 0 && s2[i].score == s2[i - 1].score && s2[i].id < s2[i - 1].id) ok = 0;
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "Student x %-8zu", ns);
+    bench_print(label, t1 - t0, 0, t2 - t1, ok);
+    printf("  （Student 按 score 从高到低，同分保持原顺序；加速比 = qsort / 基数排序）\n");
+
+    free(a);
+    free(s1);
+    free(s2);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // --bench [n]：对比 qsort 与 fast_sort.h 的耗时，n 默认 10^7
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        double n = argc > 2 ? strtod(argv[2], NULL) : SORT_BENCH_DEFAULT;
+        return bench_sort(n >= 1 ? (size_t)n : 1);
+    }
+
     printf("==== 1. 万能排序利器：qsort ====\n");
     int list[] = {100, 50, 200, 10, 30};
     int count = sizeof(list) / sizeof(list[0]);
@@ -36,6 +206,26 @@ int main() {
     
     printf("[成功] 排序结果: %d, %d, %d, %d, %d\n", list[0], list[1], list[2], list[3], list[4]);
 
+    // [进阶] 类型已知时用专用排序：基数排序不做比较，INT32_MIN 这样的极值也不会溢出
+    int32_t nums[] = {100, -50, INT32_MAX, INT32_MIN, 0, -1};
+    sort_i32(nums, sizeof(nums) / sizeof(nums[0]));
+    printf("[进阶] sort_i32: %d, %d, %d, %d, %d, %d\n", nums[0], nums[1], nums[2], nums[3],
+           nums[4], nums[5]);
+
+    // [进阶] 按结构体字段排序：成绩从高到低，同分的保持原来的先后顺序（稳定）
+    Student students[] = {
+        {1001, "Alice", 95.5f}, {1002, "Bob", 88.0f}, {1003, "Carol", 95.5f}, {1004, "Dave", 72.5f},
+    };
+    size_t nstudents = sizeof(students) / sizeof(students[0]);
+    SORT_RECORDS_BY(students, nstudents, Student, score, SORT_KEY_F32, true);
+    printf("[进阶] 按成绩排名:");
+    for (size_t i = 0; i < nstudents; i++) printf(" %s(%.1f)", students[i].name, students[i].score);
+    printf("\n");
+    sort_students_by_name(students, nstudents);
+    printf("[进阶] 按姓名排序:");
+    for (size_t i = 0; i < nstudents; i++) printf(" %s", students[i].name);
+    printf("\n  - 1000 万个数的耗时对比见 --bench\n");
+
     printf("\n==== 2. 让随机数“动起来” ====\n");
     // [坑点] 如果不加下面这一行，rand() 每次运行出来的结果序列都是死板固定的。
     // 我们用当前时间作为“种子”，让序列每次都不同。
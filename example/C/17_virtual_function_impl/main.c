@@ -1,5 +1,10 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "shape_store.h"
 
 /**
  * @file main.c
@@ -15,6 +20,12 @@
  * 指针（vptr），通常位于对象的内存布局的最前面。
  *
  * 下面我们将手动构建这一机制。
+ *
+ * 后面的“批量调用”一节在此基础上实现 Shape_area_batch：按 vptr 找同类型连续段或分桶，
+ * 每段/每桶只做一次间接调用。运行 `./17_virtual_function_impl --bench` 对比逐个调用和批量调用的耗时。
+ *
+ * 对象多到一定程度，更好的做法是干脆不要 vptr：shape_store.h 把圆和矩形的参数按类型分列存放，
+ * 面积内核用 SIMD 扫描连续的 double。运行 `--store [n]` 对比两种布局（n 默认 10^8）。
  */
 
 /* ========================================================================== */
@@ -31,10 +42,14 @@ struct Shape;
  * 这里我们定义了两个虚函数：
  * - area: 计算面积
  * - draw: 绘制图形
+ *
+ * 以及一个可选的批量版本 area_batch（见“批量调用”一节）：一次处理一批同类型的对象。
+ * idx 为 NULL 时处理 shapes[0..n) 并写入 out[0..n)；否则处理 shapes[idx[k]] 并写入 out[idx[k]]。
  */
 typedef struct {
     double (*area)(struct Shape* self); // 虚函数指针：计算面积
     void (*draw)(struct Shape* self);   // 虚函数指针：绘制自己
+    void (*area_batch)(struct Shape* const* shapes, const size_t* idx, size_t n, double* out);
 } ShapeVTable;
 
 /**
@@ -93,11 +108,28 @@ typedef struct {
     double radius;  // Circle 特有的成员
 } Circle;
 
+// 面积的计算本体：static inline，批量版本的循环里可以直接内联
+static inline double circle_area_of(const Circle* c) {
+    return 3.14159 * c->radius * c->radius;
+}
+
 // Circle 的具体实现函数
 double Circle_area(Shape* self) {
     // 将基类指针转换为派生类指针以访问特有成员
     Circle* this = (Circle*)self;
-    return 3.14159 * this->radius * this->radius;
+    return circle_area_of(this);
+}
+
+// 批量版本：循环体内没有间接调用，编译器可以展开和流水化
+void Circle_area_batch(Shape* const* shapes, const size_t* idx, size_t n, double* out) {
+    if (!idx) {
+        for (size_t k = 0; k < n; k++) out[k] = circle_area_of((const Circle*)shapes[k]);
+        return;
+    }
+    for (size_t k = 0; k < n; k++) {
+        size_t i = idx[k];
+        out[i] = circle_area_of((const Circle*)shapes[i]);
+    }
 }
 
 void Circle_draw(Shape* self) {
@@ -109,7 +141,8 @@ void Circle_draw(Shape* self) {
 // 注意：这是一个静态常量，所有 Circle 对象共享同一个 vtable
 const ShapeVTable circle_vtable = {
     .area = Circle_area,
-    .draw = Circle_draw
+    .draw = Circle_draw,
+    .area_batch = Circle_area_batch
 };
 
 // Circle 的构造函数
@@ -132,10 +165,25 @@ typedef struct {
     double height;
 } Rectangle;
 
+static inline double rectangle_area_of(const Rectangle* r) {
+    return r->width * r->height;
+}
+
 // Rectangle 的具体实现函数
 double Rectangle_area(Shape* self) {
     Rectangle* this = (Rectangle*)self;
-    return this->width * this->height;
+    return rectangle_area_of(this);
+}
+
+void Rectangle_area_batch(Shape* const* shapes, const size_t* idx, size_t n, double* out) {
+    if (!idx) {
+        for (size_t k = 0; k < n; k++) out[k] = rectangle_area_of((const Rectangle*)shapes[k]);
+        return;
+    }
+    for (size_t k = 0; k < n; k++) {
+        size_t i = idx[k];
+        out[i] = rectangle_area_of((const Rectangle*)shapes[i]);
+    }
 }
 
 void Rectangle_draw(Shape* self) {
@@ -147,7 +195,8 @@ void Rectangle_draw(Shape* self) {
 // Rectangle 的虚函数表
 const ShapeVTable rectangle_vtable = {
     .area = Rectangle_area,
-    .draw = Rectangle_draw
+    .draw = Rectangle_draw,
+    .area_batch = Rectangle_area_batch
 };
 
 // Rectangle 的构造函数
@@ -157,11 +206,352 @@ void Rectangle_ctor(Rectangle* self, const char* name, double width, double heig
     self->height = height;
 }
 
+/* ========================================================================== */
+/*                       批量调用：按 vptr 分桶                              */
+/* ========================================================================== */
+
+#define SHAPE_BATCH_BLOCK     2048 /* 分桶时每块的对象数，块内的下标数组放在栈上 */
+#define SHAPE_BATCH_MAX_TYPES 16   /* 一块里最多区分这么多种 vtable，更多时这一块逐个调用 */
+#define SHAPE_BATCH_SLOTS     32   /* vptr -> 桶号 的小哈希表，容量是 MAX_TYPES 的两倍 */
+#define SHAPE_BATCH_MIN_RUN   32   /* 同类型连续段至少这么长才直接按段调用，否则分桶 */
+
+/* vtable 是相邻的全局变量，地址低位就足够区分 */
+static inline size_t shape_batch_slot(const ShapeVTable* vt) {
+    uintptr_t v = (uintptr_t)vt;
+    return (size_t)((v >> 3) ^ (v >> 8)) % SHAPE_BATCH_SLOTS;
+}
+
+/*
+ * 分桶处理一块（n <= SHAPE_BATCH_BLOCK）：先给每个对象算出桶号，再计数排序出每个桶的下标，
+ * 最后每个桶调用一次 area_batch。桶号用哈希表查而不是和已知类型逐个比较：
+ * 逐个比较会被编译成一串条件跳转，类型随机时照样预测失败，省下的间接调用又赔回去了。
+ * 遇到没有 area_batch 的类型或类型过多时，整块逐个调用。
+ */
+static void shape_batch_bucketed(Shape** shapes, size_t n, double* out) {
+    const ShapeVTable* types[SHAPE_BATCH_MAX_TYPES];
+    const ShapeVTable* slot_vt[SHAPE_BATCH_SLOTS] = {NULL};
+    unsigned char slot_bucket[SHAPE_BATCH_SLOTS];
+    unsigned char bucket[SHAPE_BATCH_BLOCK];
+    size_t ntypes = 0;
+    for (size_t i = 0; i < n; i++) {
+        const ShapeVTable* vt = shapes[i]->vptr;
+        size_t h = shape_batch_slot(vt);
+        while (slot_vt[h] != vt) {
+            if (slot_vt[h]) { // 冲突，线性探测
+                h = (h + 1) % SHAPE_BATCH_SLOTS;
+                continue;
+            }
+            if (ntypes == SHAPE_BATCH_MAX_TYPES || !vt->area_batch) {
+                for (size_t k = 0; k < n; k++) out[k] = Shape_area(shapes[k]);
+                return;
+            }
+            slot_vt[h] = vt;
+            slot_bucket[h] = (unsigned char)ntypes;
+            types[ntypes++] = vt;
+        }
+        bucket[i] = slot_bucket[h];
+    }
+
+    size_t count[SHAPE_BATCH_MAX_TYPES] = {0};
+    size_t start[SHAPE_BATCH_MAX_TYPES], pos[SHAPE_BATCH_MAX_TYPES];
+    size_t idx[SHAPE_BATCH_BLOCK];
+    for (size_t i = 0; i < n; i++) count[bucket[i]]++;
+    for (size_t t = 0, sum = 0; t < ntypes; t++) {
+        start[t] = pos[t] = sum;
+        sum += count[t];
+    }
+    for (size_t i = 0; i < n; i++) idx[pos[bucket[i]]++] = i;
+    for (size_t t = 0; t < ntypes; t++) {
+        types[t]->area_batch(shapes, idx + start[t], count[t], out);
+    }
+}
+
+/**
+ * @brief 批量计算面积：out[i] = Shape_area(shapes[i])
+ *
+ * 逐个调用时每个对象一次间接调用，类型混杂时分支预测器每次都要猜目标地址。
+ * 这里沿数组找同一 vptr 的连续段：段足够长（输入已按类型排好）就对整段调用一次 area_batch；
+ * 段太短说明类型交错，就把从这里开始的一块按 vptr 分桶，每种类型调用一次。
+ * 两种情况下间接调用都从“每对象一次”变成“每段/每桶一次”，面积计算也能在循环里内联。
+ * 没有提供 area_batch 的类型照常逐个调用，结果相同。
+ */
+void Shape_area_batch(Shape** shapes, size_t n, double* out) {
+    size_t i = 0;
+    while (i < n) {
+        // 段长也以块为上限，调用 area_batch 时这段对象还在缓存里
+        size_t end = n - i < SHAPE_BATCH_BLOCK ? n : i + SHAPE_BATCH_BLOCK;
+        const ShapeVTable* vt = shapes[i]->vptr;
+        size_t j = i + 1;
+        while (j < end && shapes[j]->vptr == vt) j++;
+        if (j - i >= SHAPE_BATCH_MIN_RUN || j == n) {
+            if (vt->area_batch) vt->area_batch(shapes + i, NULL, j - i, out + i);
+            else for (size_t k = i; k < j; k++) out[k] = vt->area(shapes[k]);
+            i = j;
+            continue;
+        }
+        shape_batch_bucketed(shapes + i, end - i, out + i);
+        i = end;
+    }
+}
+
+/* ========================================================================== */
+/*                              基准测试                                     */
+/* ========================================================================== */
+
+/*
+ * 两种规模：小的能放进 L2，测到的主要是分支预测和间接调用的开销；
+ * 大的远超缓存，每个对象都要从内存取，预测失败的代价会被访存等待部分掩盖。
+ */
+#define BENCH_SMALL_SHAPES 32768
+#define BENCH_SMALL_ROUNDS 200
+#define BENCH_LARGE_SHAPES 4000000
+#define BENCH_LARGE_ROUNDS 5
+
+/* 对象按下标顺序存放，类型排列只影响调用顺序，不影响内存访问模式 */
+typedef union {
+    Shape base;
+    Circle circle;
+    Rectangle rect;
+} AnyShape;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/* 构造对象：shuffled 为 0 时前一半是圆、后一半是矩形，否则类型随机交错。内存不足时返回 -1 */
+static int bench_build(AnyShape* pool, Shape** shapes, size_t n, int shuffled) {
+    unsigned char* is_circle = (unsigned char*)malloc(n);
+    if (!is_circle) return -1;
+    for (size_t i = 0; i < n; i++) is_circle[i] = i < n / 2;
+    uint64_t seed = 42;
+    for (size_t i = n - 1; shuffled && i > 0; i--) {
+        size_t j = (size_t)(bench_rand(&seed) % (i + 1));
+        unsigned char t = is_circle[i];
+        is_circle[i] = is_circle[j];
+        is_circle[j] = t;
+    }
+    for (size_t i = 0; i < n; i++) {
+        double x = 1.0 + (double)(i % 100) * 0.01;
+        if (is_circle[i]) Circle_ctor(&pool[i].circle, "c", x);
+        else Rectangle_ctor(&pool[i].rect, "r", x, 2.0 * x);
+        shapes[i] = &pool[i].base;
+    }
+    free(is_circle);
+    return 0;
+}
+
+static double bench_sum(const double* out, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; i++) s += out[i];
+    return s;
+}
+
+static int bench_batch_size(size_t n, int rounds) {
+    AnyShape* pool = (AnyShape*)malloc(n * sizeof(AnyShape));
+    Shape** shapes = (Shape**)malloc(n * sizeof(Shape*));
+    double* out = (double*)malloc(n * sizeof(double));
+    if (!pool || !shapes || !out) {
+        fprintf(stderr, "内存不足\n");
+        free(pool);
+        free(shapes);
+        free(out);
+        return 1;
+    }
+
+    printf("[batch] %zu 个对象 (圆和矩形各一半)，单位 ns/对象，取 %d 轮中最快的一轮\n", n, rounds);
+    printf("  输入          逐个 Shape_area   Shape_area_batch   加速比\n");
+    for (int shuffled = 0; shuffled <= 1; shuffled++) {
+        if (bench_build(pool, shapes, n, shuffled) != 0) {
+            fprintf(stderr, "内存不足\n");
+            free(pool);
+            free(shapes);
+            free(out);
+            return 1;
+        }
+        double best[2] = {0, 0}, sums[2] = {0, 0};
+        for (int r = 0; r < rounds; r++) {
+            uint64_t t0 = bench_now_ns();
+            for (size_t i = 0; i < n; i++) out[i] = Shape_area(shapes[i]);
+            double ns = (double)(bench_now_ns() - t0) / (double)n;
+            sums[0] = bench_sum(out, n);
+            if (r == 0 || ns < best[0]) best[0] = ns;
+
+            memset(out, 0, n * sizeof(double));
+            t0 = bench_now_ns();
+            Shape_area_batch(shapes, n, out);
+            ns = (double)(bench_now_ns() - t0) / (double)n;
+            sums[1] = bench_sum(out, n);
+            if (r == 0 || ns < best[1]) best[1] = ns;
+        }
+        printf("  %s  %14.2f   %16.2f   %6.2fx%s\n", shuffled ? "随机交错    " : "按类型排好  ",
+               best[0], best[1], best[0] / best[1], sums[0] == sums[1] ? "" : "  (结果不一致!)");
+    }
+    free(pool);
+    free(shapes);
+    free(out);
+    return 0;
+}
+
+static int bench_batch(void) {
+    if (bench_batch_size(BENCH_SMALL_SHAPES, BENCH_SMALL_ROUNDS) != 0) return 1;
+    printf("\n");
+    return bench_batch_size(BENCH_LARGE_SHAPES, BENCH_LARGE_ROUNDS);
+}
+
+/*
+ * --store [n]：同样的“求所有面积之和”，对比
+ *   AoS  Shape* 数组 + 每个对象一次 Shape_area（最多 STORE_AOS_MAX 个，否则内存不够）
+ *   SoA  ShapeStore 的标量 / AVX2 / AVX-512 内核
+ * 另外测分段写出面积和按面积过滤。n 默认 10^8，圆和矩形随机各占一半。
+ */
+#define STORE_DEFAULT_SHAPES 100000000
+#define STORE_AOS_MAX        10000000
+#define STORE_ROUNDS         3
+#define STORE_CHUNK          65536 /* 分段输出的段长，输出缓冲留在 L2 里 */
+#define STORE_MIN_AREA       5.5   /* 过滤阈值，大约一半的图形满足 */
+
+/* 返回最快一轮的 ns/个，内存不足时返回负数 */
+static double bench_store_aos(size_t n) {
+    AnyShape* pool = (AnyShape*)malloc(n * sizeof(AnyShape));
+    Shape** shapes = (Shape**)malloc(n * sizeof(Shape*));
+    double best = -1.0;
+    if (pool && shapes && bench_build(pool, shapes, n, 1) == 0) {
+        for (int r = 0; r < STORE_ROUNDS; r++) {
+            uint64_t t0 = bench_now_ns();
+            double sum = 0.0;
+            for (size_t i = 0; i < n; i++) sum += Shape_area(shapes[i]);
+            double ns = (double)(bench_now_ns() - t0) / (double)n;
+            if (r == 0 || ns < best) best = ns;
+            if (sum < 0.0) printf("?"); // 让编译器保留求和
+        }
+    }
+    free(pool);
+    free(shapes);
+    return best;
+}
+
+static int bench_store(size_t n) {
+    size_t naos = n < STORE_AOS_MAX ? n : STORE_AOS_MAX;
+    double aos_ns = bench_store_aos(naos);
+    if (aos_ns < 0.0) {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+    printf("[store] AoS 基线：%zu 个对象，逐个 Shape_area 求和 %.2f ns/个\n", naos, aos_ns);
+
+    ShapeStore store;
+    shape_store_init(&store);
+    double* chunk = (double*)malloc(STORE_CHUNK * sizeof(double));
+    ShapeHandle* hits = (ShapeHandle*)malloc(STORE_CHUNK * sizeof(ShapeHandle));
+    if (!chunk || !hits || !shape_store_reserve(&store, n / 2 + n / 16, n / 2 + n / 16)) {
+        fprintf(stderr, "内存不足\n");
+        free(chunk);
+        free(hits);
+        shape_store_destroy(&store);
+        return 1;
+    }
+    uint64_t seed = 42;
+    for (size_t i = 0; i < n; i++) {
+        double x = 1.0 + (double)(i % 100) * 0.01;
+        ShapeHandle h = (bench_rand(&seed) & 1) ? shape_store_add_circle(&store, x)
+                                                : shape_store_add_rectangle(&store, x, 2.0 * x);
+        if (h == SHAPE_HANDLE_INVALID) {
+            fprintf(stderr, "内存不足\n");
+            free(chunk);
+            free(hits);
+            shape_store_destroy(&store);
+            return 1;
+        }
+    }
+    double bytes = (double)(store.ncircles + 2 * store.nrects) * sizeof(double); // 每次扫描读的字节
+    printf("[store] SoA：%zu 个圆 + %zu 个矩形，参数共 %.0f MB（AoS 对象本身就要 %.0f MB）\n",
+           store.ncircles, store.nrects, bytes / 1e6, (double)n * sizeof(AnyShape) / 1e6);
+    printf("  实现      求和 ns/个    GB/s   分段面积 ns/个   过滤 ns/个   命中数\n");
+
+    const ShapeIsa isas[] = {SHAPE_ISA_SCALAR, SHAPE_ISA_AVX2, SHAPE_ISA_AVX512};
+    double ref_sum = 0.0;
+    for (size_t v = 0; v < sizeof(isas) / sizeof(isas[0]); v++) {
+        if (shape_store_set_isa(isas[v]) != isas[v]) {
+            printf("  %-8s  CPU 不支持\n", shape_isa_name(isas[v]));
+            continue;
+        }
+        double best[3] = {0, 0, 0}, sum = 0.0;
+        size_t nhits = 0;
+        for (int r = 0; r < STORE_ROUNDS; r++) {
+            double ns[3];
+            uint64_t t0 = bench_now_ns();
+            sum = shape_store_total_area(&store);
+            ns[0] = (double)(bench_now_ns() - t0);
+
+            double check = 0.0;
+            t0 = bench_now_ns();
+            for (int k = 0; k < SHAPE_KIND_COUNT; k++) {
+                size_t total = shape_store_count(&store, (ShapeKind)k);
+                for (size_t i = 0; i < total; i += STORE_CHUNK) {
+                    size_t len = total - i < STORE_CHUNK ? total - i : STORE_CHUNK;
+                    shape_store_areas(&store, (ShapeKind)k, i, len, chunk);
+                    check += chunk[len - 1];
+                }
+            }
+            ns[1] = (double)(bench_now_ns() - t0);
+            if (check < 0.0) printf("?");
+
+            nhits = 0;
+            t0 = bench_now_ns();
+            for (int k = 0; k < SHAPE_KIND_COUNT; k++) {
+                size_t total = shape_store_count(&store, (ShapeKind)k);
+                for (size_t i = 0; i < total; i += STORE_CHUNK) {
+                    size_t len = total - i < STORE_CHUNK ? total - i : STORE_CHUNK;
+                    nhits += shape_store_filter_area(&store, (ShapeKind)k, i, len,
+                                                     STORE_MIN_AREA, hits);
+                }
+            }
+            ns[2] = (double)(bench_now_ns() - t0);
+            for (int m = 0; m < 3; m++) {
+                if (r == 0 || ns[m] < best[m]) best[m] = ns[m];
+            }
+        }
+        if (v == 0) ref_sum = sum;
+        double diff = ref_sum != 0.0 ? (sum - ref_sum) / ref_sum : 0.0;
+        printf("  %-8s  %11.3f  %6.2f   %14.3f   %10.3f   %zu%s\n", shape_isa_name(isas[v]),
+               best[0] / (double)n, bytes / best[0], best[1] / (double)n, best[2] / (double)n,
+               nhits, diff > 1e-9 || diff < -1e-9 ? "  (求和与标量不一致!)" : "");
+    }
+    shape_store_set_isa(SHAPE_ISA_AUTO);
+    free(chunk);
+    free(hits);
+    shape_store_destroy(&store);
+    return 0;
+}
+
 /* ========================================================================== */
 /*                                主函数                                     */
 /* ========================================================================== */
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --bench：对比逐个调用和按 vptr 分桶的批量调用
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return bench_batch();
+    // --store [n]：对比 AoS 逐个调用和列式存储的 SIMD 内核
+    if (argc > 1 && strcmp(argv[1], "--store") == 0) {
+        double n = argc > 2 ? strtod(argv[2], NULL) : STORE_DEFAULT_SHAPES;
+        if (n < 1.0 || n > 2.0 * (double)SHAPE_STORE_MAX_PER_KIND) {
+            fprintf(stderr, "图形数应在 1 到 %zu 之间\n", 2 * SHAPE_STORE_MAX_PER_KIND);
+            return 1;
+        }
+        return bench_store((size_t)n);
+    }
+
     printf("=== C语言 虚函数与虚函数表 模拟 ===\n\n");
 
     // 1. 创建对象
@@ -218,5 +608,23 @@ int main() {
     // 手动通过 vptr 调用
     vptr_value->draw((Shape*)&c1);
 
+    /* 批量调用：同一种 vtable 的对象只做一次间接调用 */
+    double areas[2];
+    Shape_area_batch(shapes, 2, areas);
+    printf("\n批量计算面积: %.2f, %.2f (逐个调用与批量调用的耗时对比见 --bench)\n",
+           areas[0], areas[1]);
+
+    /* 列式存储：同样的两个图形，参数分列存放，用句柄访问 */
+    ShapeStore store;
+    shape_store_init(&store);
+    ShapeHandle hc = shape_store_add_circle(&store, c1.radius);
+    ShapeHandle hr = shape_store_add_rectangle(&store, r1.width, r1.height);
+    if (hc != SHAPE_HANDLE_INVALID && hr != SHAPE_HANDLE_INVALID) {
+        printf("列式存储 (%s 内核): 圆 %.2f, 矩形 %.2f, 合计 %.2f (大规模对比见 --store)\n",
+               shape_isa_name(shape_store_isa()), shape_store_area(&store, hc),
+               shape_store_area(&store, hr), shape_store_total_area(&store));
+    }
+    shape_store_destroy(&store);
+
     return 0;
 }
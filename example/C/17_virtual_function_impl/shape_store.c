@@ -0,0 +1,360 @@
+/**
+ * @file shape_store.c
+ * @brief 列式图形存储与面积内核（标量 / AVX2 / AVX-512）
+ */
+
+#include "shape_store.h"
+
+#include <stdlib.h>
+
+/* x86 上的 GCC/Clang 可以单独为某个函数开启 AVX2/AVX-512，并在运行时检测 CPU 是否支持 */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define SHAPE_STORE_HAS_SIMD 1
+#else
+  #define SHAPE_STORE_HAS_SIMD 0
+#endif
+
+#define SHAPE_STORE_INITIAL_CAP 64
+
+/* ========================================================================== */
+/*                              存储与句柄                                    */
+/* ========================================================================== */
+
+void shape_store_init(ShapeStore* s) {
+    s->radius = NULL;
+    s->ncircles = 0;
+    s->circle_cap = 0;
+    s->width = NULL;
+    s->height = NULL;
+    s->nrects = 0;
+    s->rect_cap = 0;
+}
+
+void shape_store_destroy(ShapeStore* s) {
+    free(s->radius);
+    free(s->width);
+    free(s->height);
+    shape_store_init(s);
+}
+
+/* 把一列扩到 cap 个元素；失败时原列不变 */
+static bool grow_column(double** col, size_t cap) {
+    if (cap > SIZE_MAX / sizeof(double)) return false;
+    double* p = (double*)realloc(*col, cap * sizeof(double));
+    if (!p) return false;
+    *col = p;
+    return true;
+}
+
+bool shape_store_reserve(ShapeStore* s, size_t circles, size_t rects) {
+    if (circles > SHAPE_STORE_MAX_PER_KIND || rects > SHAPE_STORE_MAX_PER_KIND) return false;
+    if (circles > s->circle_cap) {
+        if (!grow_column(&s->radius, circles)) return false;
+        s->circle_cap = circles;
+    }
+    if (rects > s->rect_cap) {
+        /* width 扩成功而 height 失败时，width 只是多占了些空间，rect_cap 不变 */
+        if (!grow_column(&s->width, rects) || !grow_column(&s->height, rects)) return false;
+        s->rect_cap = rects;
+    }
+    return true;
+}
+
+/* 满了就翻倍，不超过每种类型的上限 */
+static size_t next_cap(size_t cap) {
+    size_t next = cap ? cap * 2 : SHAPE_STORE_INITIAL_CAP;
+    return next > SHAPE_STORE_MAX_PER_KIND ? SHAPE_STORE_MAX_PER_KIND : next;
+}
+
+ShapeHandle shape_store_add_circle(ShapeStore* s, double radius) {
+    if (s->ncircles == s->circle_cap) {
+        if (s->ncircles == SHAPE_STORE_MAX_PER_KIND) return SHAPE_HANDLE_INVALID;
+        if (!shape_store_reserve(s, next_cap(s->circle_cap), 0)) return SHAPE_HANDLE_INVALID;
+    }
+    s->radius[s->ncircles] = radius;
+    return shape_handle_make(SHAPE_KIND_CIRCLE, s->ncircles++);
+}
+
+ShapeHandle shape_store_add_rectangle(ShapeStore* s, double width, double height) {
+    if (s->nrects == s->rect_cap) {
+        if (s->nrects == SHAPE_STORE_MAX_PER_KIND) return SHAPE_HANDLE_INVALID;
+        if (!shape_store_reserve(s, 0, next_cap(s->rect_cap))) return SHAPE_HANDLE_INVALID;
+    }
+    s->width[s->nrects] = width;
+    s->height[s->nrects] = height;
+    return shape_handle_make(SHAPE_KIND_RECTANGLE, s->nrects++);
+}
+
+size_t shape_store_count(const ShapeStore* s, ShapeKind kind) {
+    return kind == SHAPE_KIND_CIRCLE ? s->ncircles : kind == SHAPE_KIND_RECTANGLE ? s->nrects : 0;
+}
+
+/*
+ * 两种类型的面积都写成 (c * x[i]) * y[i]：
+ *   圆    c = π, x = y = radius
+ *   矩形  c = 1, x = width, y = height（1 * w 精确等于 w，结果和 w * h 相同）
+ * 这样每种运算只需要一份内核，各个实现的逐项结果也完全一致。
+ */
+typedef struct {
+    double c;
+    const double* x;
+    const double* y;
+} AreaColumns;
+
+static AreaColumns columns_of(const ShapeStore* s, ShapeKind kind, size_t first) {
+    AreaColumns col;
+    if (kind == SHAPE_KIND_CIRCLE) {
+        col.c = SHAPE_STORE_PI;
+        col.x = s->radius + first;
+        col.y = s->radius + first;
+    } else {
+        col.c = 1.0;
+        col.x = s->width + first;
+        col.y = s->height + first;
+    }
+    return col;
+}
+
+double shape_store_area(const ShapeStore* s, ShapeHandle h) {
+    AreaColumns col = columns_of(s, shape_handle_kind(h), shape_handle_index(h));
+    return col.c * col.x[0] * col.y[0];
+}
+
+/* ========================================================================== */
+/*                                标量内核                                    */
+/* ========================================================================== */
+
+static void areas_scalar(double c, const double* x, const double* y, size_t n, double* out) {
+    for (size_t i = 0; i < n; i++) out[i] = c * x[i] * y[i];
+}
+
+/* 4 路部分和，打断加法的依赖链 */
+static double sum_scalar(double c, const double* x, const double* y, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += c * x[i] * y[i];
+        s1 += c * x[i + 1] * y[i + 1];
+        s2 += c * x[i + 2] * y[i + 2];
+        s3 += c * x[i + 3] * y[i + 3];
+    }
+    for (; i < n; i++) s0 += c * x[i] * y[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/* 无分支：每个句柄都先写进去，满足条件才让写指针前进 */
+static size_t filter_scalar(double c, const double* x, const double* y, size_t n, double min_area,
+                            ShapeHandle base, ShapeHandle* out) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[k] = base + (ShapeHandle)i;
+        k += c * x[i] * y[i] >= min_area;
+    }
+    return k;
+}
+
+/* ========================================================================== */
+/*                            AVX2 / AVX-512 内核                             */
+/* ========================================================================== */
+
+#if SHAPE_STORE_HAS_SIMD
+
+__attribute__((target("avx2"))) static inline __m256d area4(__m256d c, const double* x,
+                                                            const double* y) {
+    return _mm256_mul_pd(_mm256_mul_pd(c, _mm256_loadu_pd(x)), _mm256_loadu_pd(y));
+}
+
+__attribute__((target("avx2"))) static void areas_avx2(double c, const double* x,
+                                                       const double* y, size_t n, double* out) {
+    const __m256d vc = _mm256_set1_pd(c);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_pd(out + i, area4(vc, x + i, y + i));
+        _mm256_storeu_pd(out + i + 4, area4(vc, x + i + 4, y + i + 4));
+    }
+    areas_scalar(c, x + i, y + i, n - i, out + i);
+}
+
+/* 4 个向量累加器，每轮 16 个元素 */
+__attribute__((target("avx2"))) static double sum_avx2(double c, const double* x,
+                                                       const double* y, size_t n) {
+    const __m256d vc = _mm256_set1_pd(c);
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_pd(s0, area4(vc, x + i, y + i));
+        s1 = _mm256_add_pd(s1, area4(vc, x + i + 4, y + i + 4));
+        s2 = _mm256_add_pd(s2, area4(vc, x + i + 8, y + i + 8));
+        s3 = _mm256_add_pd(s3, area4(vc, x + i + 12, y + i + 12));
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    h = _mm_add_sd(h, _mm_unpackhi_pd(h, h));
+    return _mm_cvtsd_f64(h) + sum_scalar(c, x + i, y + i, n - i);
+}
+
+/* 比较得到 4 位掩码，再像标量版一样无分支地写句柄 */
+__attribute__((target("avx2"))) static size_t filter_avx2(double c, const double* x,
+                                                          const double* y, size_t n,
+                                                          double min_area, ShapeHandle base,
+                                                          ShapeHandle* out) {
+    const __m256d vc = _mm256_set1_pd(c);
+    const __m256d vmin = _mm256_set1_pd(min_area);
+    size_t i = 0, k = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d ge = _mm256_cmp_pd(area4(vc, x + i, y + i), vmin, _CMP_GE_OQ);
+        unsigned m = (unsigned)_mm256_movemask_pd(ge);
+        ShapeHandle h = base + (ShapeHandle)i;
+        out[k] = h;
+        k += m & 1u;
+        out[k] = h + 1;
+        k += (m >> 1) & 1u;
+        out[k] = h + 2;
+        k += (m >> 2) & 1u;
+        out[k] = h + 3;
+        k += m >> 3;
+    }
+    return k + filter_scalar(c, x + i, y + i, n - i, min_area, base + (ShapeHandle)i, out + k);
+}
+
+__attribute__((target("avx512f"))) static inline __m512d area8(__m512d c, const double* x,
+                                                               const double* y) {
+    return _mm512_mul_pd(_mm512_mul_pd(c, _mm512_loadu_pd(x)), _mm512_loadu_pd(y));
+}
+
+__attribute__((target("avx512f"))) static void areas_avx512(double c, const double* x,
+                                                            const double* y, size_t n,
+                                                            double* out) {
+    const __m512d vc = _mm512_set1_pd(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_pd(out + i, area8(vc, x + i, y + i));
+        _mm512_storeu_pd(out + i + 8, area8(vc, x + i + 8, y + i + 8));
+    }
+    areas_scalar(c, x + i, y + i, n - i, out + i);
+}
+
+__attribute__((target("avx512f"))) static double sum_avx512(double c, const double* x,
+                                                            const double* y, size_t n) {
+    const __m512d vc = _mm512_set1_pd(c);
+    __m512d s0 = _mm512_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm512_add_pd(s0, area8(vc, x + i, y + i));
+        s1 = _mm512_add_pd(s1, area8(vc, x + i + 8, y + i + 8));
+        s2 = _mm512_add_pd(s2, area8(vc, x + i + 16, y + i + 16));
+        s3 = _mm512_add_pd(s3, area8(vc, x + i + 24, y + i + 24));
+    }
+    __m512d s = _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3));
+    return _mm512_reduce_add_pd(s) + sum_scalar(c, x + i, y + i, n - i);
+}
+
+/* 每轮 16 个：两次比较拼成 16 位掩码，用 compress 指令把命中的句柄紧凑地写出 */
+__attribute__((target("avx512f"))) static size_t filter_avx512(double c, const double* x,
+                                                               const double* y, size_t n,
+                                                               double min_area, ShapeHandle base,
+                                                               ShapeHandle* out) {
+    const __m512d vc = _mm512_set1_pd(c);
+    const __m512d vmin = _mm512_set1_pd(min_area);
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                            8, 9, 10, 11, 12, 13, 14, 15);
+    size_t i = 0, k = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask8 lo = _mm512_cmp_pd_mask(area8(vc, x + i, y + i), vmin, _CMP_GE_OQ);
+        __mmask8 hi = _mm512_cmp_pd_mask(area8(vc, x + i + 8, y + i + 8), vmin, _CMP_GE_OQ);
+        __mmask16 m = (__mmask16)((unsigned)lo | ((unsigned)hi << 8));
+        __m512i h = _mm512_add_epi32(_mm512_set1_epi32((int)(base + (ShapeHandle)i)), lanes);
+        _mm512_mask_compressstoreu_epi32(out + k, m, h);
+        k += (size_t)__builtin_popcount(m);
+    }
+    return k + filter_scalar(c, x + i, y + i, n - i, min_area, base + (ShapeHandle)i, out + k);
+}
+
+#endif /* SHAPE_STORE_HAS_SIMD */
+
+/* ========================================================================== */
+/*                                运行时分派                                  */
+/* ========================================================================== */
+
+typedef struct {
+    void (*areas)(double c, const double* x, const double* y, size_t n, double* out);
+    double (*sum)(double c, const double* x, const double* y, size_t n);
+    size_t (*filter)(double c, const double* x, const double* y, size_t n, double min_area,
+                     ShapeHandle base, ShapeHandle* out);
+} AreaKernels;
+
+static const AreaKernels kernels_scalar = {areas_scalar, sum_scalar, filter_scalar};
+#if SHAPE_STORE_HAS_SIMD
+static const AreaKernels kernels_avx2 = {areas_avx2, sum_avx2, filter_avx2};
+static const AreaKernels kernels_avx512 = {areas_avx512, sum_avx512, filter_avx512};
+#endif
+
+static const AreaKernels* g_kernels = NULL; /* 首次使用时按 SHAPE_ISA_AUTO 选择 */
+static ShapeIsa g_isa = SHAPE_ISA_SCALAR;
+
+ShapeIsa shape_store_set_isa(ShapeIsa isa) {
+    g_kernels = &kernels_scalar;
+    g_isa = SHAPE_ISA_SCALAR;
+#if SHAPE_STORE_HAS_SIMD
+    bool want512 = isa == SHAPE_ISA_AUTO || isa == SHAPE_ISA_AVX512;
+    bool want2 = want512 || isa == SHAPE_ISA_AVX2;
+    if (want512 && __builtin_cpu_supports("avx512f")) {
+        g_kernels = &kernels_avx512;
+        g_isa = SHAPE_ISA_AVX512;
+    } else if (want2 && __builtin_cpu_supports("avx2")) {
+        g_kernels = &kernels_avx2;
+        g_isa = SHAPE_ISA_AVX2;
+    }
+#else
+    (void)isa;
+#endif
+    return g_isa;
+}
+
+ShapeIsa shape_store_isa(void) {
+    if (!g_kernels) shape_store_set_isa(SHAPE_ISA_AUTO);
+    return g_isa;
+}
+
+const char* shape_isa_name(ShapeIsa isa) {
+    switch (isa) {
+    case SHAPE_ISA_AUTO: return "auto";
+    case SHAPE_ISA_SCALAR: return "scalar";
+    case SHAPE_ISA_AVX2: return "avx2";
+    case SHAPE_ISA_AVX512: return "avx512";
+    }
+    return "?";
+}
+
+static const AreaKernels* kernels(void) {
+    if (!g_kernels) shape_store_set_isa(SHAPE_ISA_AUTO);
+    return g_kernels;
+}
+
+/* ========================================================================== */
+/*                                对外的内核                                  */
+/* ========================================================================== */
+
+void shape_store_areas(const ShapeStore* s, ShapeKind kind, size_t first, size_t count,
+                       double* out) {
+    AreaColumns col = columns_of(s, kind, first);
+    kernels()->areas(col.c, col.x, col.y, count, out);
+}
+
+double shape_store_sum_area(const ShapeStore* s, ShapeKind kind, size_t first, size_t count) {
+    AreaColumns col = columns_of(s, kind, first);
+    return kernels()->sum(col.c, col.x, col.y, count);
+}
+
+double shape_store_total_area(const ShapeStore* s) {
+    return shape_store_sum_area(s, SHAPE_KIND_CIRCLE, 0, s->ncircles) +
+           shape_store_sum_area(s, SHAPE_KIND_RECTANGLE, 0, s->nrects);
+}
+
+size_t shape_store_filter_area(const ShapeStore* s, ShapeKind kind, size_t first, size_t count,
+                               double min_area, ShapeHandle* out) {
+    AreaColumns col = columns_of(s, kind, first);
+    return kernels()->filter(col.c, col.x, col.y, count, min_area, shape_handle_make(kind, first),
+                             out);
+}
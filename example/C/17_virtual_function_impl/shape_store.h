@@ -0,0 +1,113 @@
+/**
+ * @file shape_store.h
+ * @brief 列式（SoA）图形存储：按类型分列存放参数，用句柄代替指针，面积内核用 SIMD
+ *
+ * main.c 里的 Circle/Rectangle 是“结构体数组”（AoS）：每个对象前面都有 16 字节的 Shape 头
+ * （vptr + name），扫描所有面积时这些头和真正要用的 double 一起被搬进缓存，
+ * 每个对象还要一次间接调用。对象一多，瓶颈就在调用和无用字节上，而不是内存带宽。
+ *
+ * ShapeStore 换成“数组结构体”（SoA）：
+ *   圆    radius[]               连续的 double
+ *   矩形  width[]、height[]      两列连续的 double
+ * 类型由所在的列决定，不再需要 vptr；同一类型的面积计算就是对一两列做同样的运算，
+ * 可以用 AVX2（一次 4 个 double）或 AVX-512（一次 8 个）处理，只读真正需要的字节。
+ *
+ * 句柄 ShapeHandle 是 32 位整数：高 2 位是类型，低 30 位是该类型列中的下标。
+ * 列扩容时会整体搬家，指针会失效，句柄不会。存储只追加不删除。
+ *
+ * 内核在运行时按 CPU 选择 AVX-512 / AVX2 / 标量实现（只有 x86 上的 GCC/Clang 才有 SIMD 版本），
+ * 也可以用 shape_store_set_isa 指定，便于对比。所有实现的面积都按 (π * r) * r、w * h 计算，
+ * 逐个结果和 shape_store_area 完全一致；求和因累加顺序不同，末几位可能有差别。
+ */
+
+#ifndef SHAPE_STORE_H
+#define SHAPE_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 和 main.c 中 Circle_area 用的常数一致 */
+#define SHAPE_STORE_PI 3.14159
+
+typedef enum {
+    SHAPE_KIND_CIRCLE,
+    SHAPE_KIND_RECTANGLE,
+    SHAPE_KIND_COUNT,
+} ShapeKind;
+
+typedef uint32_t ShapeHandle;
+
+#define SHAPE_HANDLE_INVALID    UINT32_MAX
+#define SHAPE_HANDLE_KIND_SHIFT 30
+#define SHAPE_HANDLE_INDEX_MASK ((1u << SHAPE_HANDLE_KIND_SHIFT) - 1u)
+#define SHAPE_STORE_MAX_PER_KIND ((size_t)SHAPE_HANDLE_INDEX_MASK) /* 每种类型的上限 */
+
+static inline ShapeHandle shape_handle_make(ShapeKind kind, size_t index) {
+    return ((uint32_t)kind << SHAPE_HANDLE_KIND_SHIFT) | (uint32_t)index;
+}
+static inline ShapeKind shape_handle_kind(ShapeHandle h) {
+    return (ShapeKind)(h >> SHAPE_HANDLE_KIND_SHIFT);
+}
+static inline size_t shape_handle_index(ShapeHandle h) {
+    return (size_t)(h & SHAPE_HANDLE_INDEX_MASK);
+}
+
+typedef struct {
+    double* radius;  /* 圆：ncircles 个半径 */
+    size_t ncircles;
+    size_t circle_cap;
+    double* width;   /* 矩形：nrects 个宽和高 */
+    double* height;
+    size_t nrects;
+    size_t rect_cap;
+} ShapeStore;
+
+typedef enum {
+    SHAPE_ISA_AUTO,   /* 运行时选 CPU 支持的最宽实现 */
+    SHAPE_ISA_SCALAR,
+    SHAPE_ISA_AVX2,
+    SHAPE_ISA_AVX512,
+} ShapeIsa;
+
+void shape_store_init(ShapeStore* s);
+void shape_store_destroy(ShapeStore* s);
+
+/* 预留容量，避免追加过程中反复扩容；内存不足返回 false，原有内容不变 */
+bool shape_store_reserve(ShapeStore* s, size_t circles, size_t rects);
+
+/* 追加一个图形，返回句柄；内存不足或超过 SHAPE_STORE_MAX_PER_KIND 返回 SHAPE_HANDLE_INVALID */
+ShapeHandle shape_store_add_circle(ShapeStore* s, double radius);
+ShapeHandle shape_store_add_rectangle(ShapeStore* s, double width, double height);
+
+size_t shape_store_count(const ShapeStore* s, ShapeKind kind);
+
+/* 单个图形的面积，句柄必须有效 */
+double shape_store_area(const ShapeStore* s, ShapeHandle h);
+
+/*
+ * 以下内核都按“类型 + 下标区间 [first, first + count)”工作，大存储可以分段处理，
+ * 不必一次准备和对象数一样大的输出数组。区间必须在该类型的范围内。
+ */
+
+/* out[k] = 第 first + k 个该类型图形的面积 */
+void shape_store_areas(const ShapeStore* s, ShapeKind kind, size_t first, size_t count,
+                       double* out);
+
+/* 区间内面积之和 */
+double shape_store_sum_area(const ShapeStore* s, ShapeKind kind, size_t first, size_t count);
+
+/* 所有图形的面积之和 */
+double shape_store_total_area(const ShapeStore* s);
+
+/* 把区间内面积 >= min_area 的图形句柄按下标顺序写入 out（最多 count 个），返回个数 */
+size_t shape_store_filter_area(const ShapeStore* s, ShapeKind kind, size_t first, size_t count,
+                               double min_area, ShapeHandle* out);
+
+/* 指定内核实现，CPU 不支持时降级；返回实际生效的实现。应在使用存储的线程启动前调用 */
+ShapeIsa shape_store_set_isa(ShapeIsa isa);
+/* 当前生效的实现 */
+ShapeIsa shape_store_isa(void);
+const char* shape_isa_name(ShapeIsa isa);
+
+#endif /* SHAPE_STORE_H */
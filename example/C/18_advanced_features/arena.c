@@ -0,0 +1,127 @@
+/**
+ * @file arena.c
+ * @brief 区域分配器的实现
+ */
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define ARENA_DEFAULT_BLOCK_SIZE ((size_t)64 * 1024)
+
+static ArenaBlock* block_new(size_t capacity) {
+    if (capacity > SIZE_MAX - sizeof(ArenaBlock)) return NULL;
+    ArenaBlock* b = (ArenaBlock*)malloc(sizeof(ArenaBlock) + capacity);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->capacity = capacity;
+    b->used = 0;
+    return b;
+}
+
+/* 在块内按 align 对齐后推进 size 字节，放不下返回 NULL */
+static void* block_bump(ArenaBlock* b, size_t size, size_t align) {
+    uintptr_t base = (uintptr_t)b->data;
+    size_t off = (size_t)(ALIGN_UP(base + b->used, (uintptr_t)align) - base);
+    if (off > b->capacity || size > b->capacity - off) return NULL;
+    b->used = off + size;
+    return b->data + off;
+}
+
+void arena_init(Arena* a, size_t block_size) {
+    a->first = NULL;
+    a->current = NULL;
+    a->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    a->last_alloc = NULL;
+}
+
+void arena_destroy(Arena* a) {
+    ArenaBlock* b = a->first;
+    while (b) {
+        ArenaBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    arena_init(a, a->block_size);
+}
+
+void* arena_alloc_aligned(Arena* a, size_t size, size_t align) {
+    if (!IS_POWER_OF_2(align)) return NULL;
+
+    // 快路径：当前块还放得下，只是推进一下偏移
+    void* p = a->current ? block_bump(a->current, size, align) : NULL;
+    if (!p) {
+        // 先复用之前回退时留下的空闲块
+        ArenaBlock* next = a->current ? a->current->next : NULL;
+        if (next) {
+            next->used = 0;
+            p = block_bump(next, size, align);
+        }
+        if (p) {
+            a->current = next;
+        } else {
+            // 超大请求单独开一块，保证至少能放下这一次分配
+            size_t need = size > SIZE_MAX - align ? SIZE_MAX : size + align;
+            ArenaBlock* b = block_new(need > a->block_size ? need : a->block_size);
+            if (!b) return NULL;
+            if (a->current) {
+                b->next = a->current->next;
+                a->current->next = b;
+            } else {
+                a->first = b;
+            }
+            a->current = b;
+            p = block_bump(b, size, align);
+        }
+    }
+    a->last_alloc = p;
+    return p;
+}
+
+void* arena_alloc(Arena* a, size_t size) {
+    return arena_alloc_aligned(a, size, ARENA_DEFAULT_ALIGN);
+}
+
+void* arena_realloc(Arena* a, void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return arena_alloc(a, new_size);
+
+    // 最近一次分配一定位于 current 块的末尾，只要块里还有空间就原地伸缩
+    if (ptr == a->last_alloc) {
+        ArenaBlock* b = a->current;
+        size_t off = (size_t)((char*)ptr - b->data);
+        if (new_size <= b->capacity - off) {
+            b->used = off + new_size;
+            return ptr;
+        }
+    }
+    if (new_size <= old_size) return ptr;
+
+    void* fresh = arena_alloc(a, new_size);
+    if (fresh) memcpy(fresh, ptr, old_size);
+    return fresh;
+}
+
+ArenaMark arena_mark(const Arena* a) {
+    ArenaMark m = {a->current, a->current ? a->current->used : 0};
+    return m;
+}
+
+void arena_restore(Arena* a, ArenaMark mark) {
+    if (!mark.block) {
+        arena_reset(a);
+        return;
+    }
+    a->current = mark.block;
+    a->current->used = mark.used;
+    a->last_alloc = NULL;
+}
+
+void arena_reset(Arena* a) {
+    a->current = a->first;
+    if (a->current) a->current->used = 0;
+    a->last_alloc = NULL;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file arena.h
+ * @brief 区域 (arena / bump) 分配器
+ *
+ * 适合“按请求分配、请求结束整体丢弃”的场景：
+ * 1. 分配只是把指针往后推（用 ALIGN_UP 对齐），没有逐个 free。
+ * 2. arena_mark 记录当前位置，arena_restore 一步回到标记处，O(1) 释放之后的所有分配。
+ * 3. arena_realloc 扩容的是最近一次分配时，直接在原地长大，不拷贝。
+ *
+ * 回退后多出来的块不会立即还给系统，而是留在链上给后续分配复用，arena_destroy 时统一释放。
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 默认对齐与 malloc 一致，能放下任何基本类型 */
+#define ARENA_DEFAULT_ALIGN _Alignof(max_align_t)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t capacity; /* data 的字节数 */
+    size_t used;     /* 已经推进到的偏移 */
+    char data[];     /* C99 柔性数组成员 */
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;  /* 正在分配的块，它之后的块都是空闲可复用的 */
+    size_t block_size;    /* 新块的默认容量 */
+    void* last_alloc;     /* 最近一次分配的起始地址，用于原地 realloc */
+} Arena;
+
+/* 标记只是“块 + 偏移”，恢复时无需遍历任何分配 */
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena* a, size_t block_size);
+void arena_destroy(Arena* a);
+
+void* arena_alloc(Arena* a, size_t size);
+/* align 必须是 2 的幂 */
+void* arena_alloc_aligned(Arena* a, size_t size, size_t align);
+/* ptr 是最近一次分配且当前块放得下时原地扩容，否则分配新空间并拷贝 old_size 字节 */
+void* arena_realloc(Arena* a, void* ptr, size_t old_size, size_t new_size);
+
+ArenaMark arena_mark(const Arena* a);
+void arena_restore(Arena* a, ArenaMark mark);
+/* 回到初始状态，保留所有块供复用 */
+void arena_reset(Arena* a);
+
+#endif /* ARENA_H */
@@ -0,0 +1,613 @@
+/**
+ * @file async_log.c
+ * @brief 异步日志后端的实现
+ */
+
+#include "async_log.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+#if HAS_THREADS
+static atomic_int min_level = LOG_LEVEL_DEBUG;
+#define MIN_LEVEL_LOAD()   atomic_load_explicit(&min_level, memory_order_relaxed)
+#define MIN_LEVEL_STORE(v) atomic_store_explicit(&min_level, (v), memory_order_relaxed)
+#else
+static int min_level = LOG_LEVEL_DEBUG;
+#define MIN_LEVEL_LOAD()   (min_level)
+#define MIN_LEVEL_STORE(v) (min_level = (v))
+#endif
+
+LogLevel log_level_from_name(const char* name) {
+    switch (name ? name[0] : 'I') {
+        case 'D': return LOG_LEVEL_DEBUG;
+        case 'W': return LOG_LEVEL_WARN;
+        case 'E': return LOG_LEVEL_ERROR;
+        default: return LOG_LEVEL_INFO;
+    }
+}
+
+void log_set_level(LogLevel min) {
+    MIN_LEVEL_STORE((int)min);
+}
+
+bool log_level_enabled(LogLevel level) {
+    return (int)level >= MIN_LEVEL_LOAD();
+}
+
+#if HAS_THREADS
+
+#include "mem_align.h"
+
+#define LOG_DEFAULT_RING (64 * 1024)
+#define LOG_OUT_BUFFER   (64 * 1024) /* 后台线程攒够这么多字节才 write 一次 */
+#define LOG_MAX_ARGS     32
+#define LOG_WRAP         UINT32_MAX /* 记录头的 size 为此值表示“跳到缓冲区开头” */
+#define LOG_IDLE_SLEEP_NS 1000000   /* 所有缓冲区都空时后台线程休眠 1ms */
+#define LOG_SPEC_PART_MAX 16        /* 标志、宽度、精度各自最多几个字符，超过按无法识别处理 */
+/* 重新拼出的说明符："%" + 标志 + 宽度 + "." + 精度 + "ll" + 转换字符 + '\0'，"*" 展开后不超过 11 位 */
+#define LOG_SPEC_BUF      (1 + 3 * LOG_SPEC_PART_MAX + 1 + 2 + 1 + 1)
+
+/* ========================================================================== */
+/*                              格式说明符解析                                */
+/* ========================================================================== */
+
+typedef enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T, LEN_BIG_L } LenMod;
+
+/* 一个 % 转换说明的各部分在格式串中的位置 */
+typedef struct {
+    const char* flags;
+    size_t flags_len;
+    const char* width; /* 数字串，或 "*" */
+    size_t width_len;
+    bool has_precision;
+    const char* precision;
+    size_t precision_len;
+    LenMod len;
+    char conv; /* 0 表示无法识别，之后的内容按原样输出 */
+} LogSpec;
+
+static bool is_flag_char(char c) {
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+}
+
+static size_t span_flags(const char* s) {
+    size_t n = 0;
+    while (is_flag_char(s[n])) n++;
+    return n;
+}
+
+static size_t span_digits(const char* s) {
+    size_t n = 0;
+    while (s[n] >= '0' && s[n] <= '9') n++;
+    return n;
+}
+
+/* f 指向 '%' 之后的字符，返回转换字符之后的位置 */
+static const char* parse_spec(const char* f, LogSpec* spec) {
+    spec->flags = f;
+    spec->flags_len = span_flags(f);
+    f += spec->flags_len;
+    spec->width = f;
+    spec->width_len = *f == '*' ? 1 : span_digits(f);
+    f += spec->width_len;
+    spec->has_precision = *f == '.';
+    if (spec->has_precision) f++;
+    spec->precision = f;
+    spec->precision_len = *f == '*' ? 1 : span_digits(f);
+    f += spec->precision_len;
+
+    spec->len = LEN_NONE;
+    switch (*f) {
+        case 'h': spec->len = f[1] == 'h' ? LEN_HH : LEN_H; break;
+        case 'l': spec->len = f[1] == 'l' ? LEN_LL : LEN_L; break;
+        case 'j': spec->len = LEN_J; break;
+        case 'z': spec->len = LEN_Z; break;
+        case 't': spec->len = LEN_T; break;
+        case 'L': spec->len = LEN_BIG_L; break;
+        default: break;
+    }
+    if (spec->len != LEN_NONE) f += (spec->len == LEN_HH || spec->len == LEN_LL) ? 2 : 1;
+
+    spec->conv = *f && strchr("diouxXcsfFeEgGaAp", *f) ? *f : 0;
+    // 不支持宽字符/宽字符串：%lc、%ls 的参数是 wint_t/wchar_t*，不能按 %c、%s 取
+    if ((spec->conv == 's' || spec->conv == 'c') && spec->len != LEN_NONE) spec->conv = 0;
+    // 合法但过长的标志/数字串（如 100 个 '0'）同样停止解析，后台线程拼说明符时不会越界
+    if (spec->flags_len > LOG_SPEC_PART_MAX || spec->width_len > LOG_SPEC_PART_MAX ||
+        spec->precision_len > LOG_SPEC_PART_MAX) {
+        spec->conv = 0;
+    }
+    return spec->conv ? f + 1 : f;
+}
+
+/* ========================================================================== */
+/*                              线程私有环形缓冲区                            */
+/* ========================================================================== */
+
+typedef union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void* p;
+    size_t len; /* %s：字符串长度，内容跟在所有参数之后 */
+} LogArg;
+
+/* 每条日志在缓冲区中的头部，后面是 nargs 个 LogArg 和拷贝的字符串，整体按 8 字节对齐 */
+typedef struct {
+    uint32_t size;
+    uint32_t nargs;
+    const char* level;
+    const char* fmt;
+} LogRecord;
+
+typedef struct LogRing {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head; /* 后台线程写 */
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail; /* 所属线程写 */
+    size_t cached_head;                           /* 所属线程私有 */
+    atomic_size_t dropped;
+    _Alignas(CACHE_LINE_SIZE) char* buf;
+    size_t mask;
+    atomic_bool orphaned; /* 所属线程已退出，读空后由后台线程释放 */
+    struct LogRing* next;
+} LogRing;
+
+static mtx_t registry_lock;
+static LogRing* registry; /* 所有线程的缓冲区，持有 registry_lock 时访问 */
+static tss_t ring_key;    /* 仅用于在线程退出时得到通知 */
+static _Thread_local LogRing* tls_ring;
+
+static thrd_t logger_thread;
+static atomic_bool running;
+static atomic_bool stopping;
+static atomic_int blocked_producers; /* 正在等待空间的生产者数，后台线程据此决定是否休眠 */
+static LogFullPolicy full_policy;
+static size_t ring_capacity;
+static int out_fd;
+static size_t dropped_from_freed; /* 已释放缓冲区的丢弃计数，持有 registry_lock 时访问 */
+static bool logger_alive;         /* 后台线程已启动且尚未被 join，持有 registry_lock 时访问 */
+
+static void ring_free(LogRing* r) {
+    mem_aligned_free(r->buf);
+    mem_aligned_free(r);
+}
+
+/* 从 registry 摘下并释放 r，调用者持有 registry_lock；没写出的内容已经不会再有人读 */
+static void ring_unlink_free(LogRing* r) {
+    for (LogRing** link = &registry; *link; link = &(*link)->next) {
+        if (*link == r) {
+            *link = r->next;
+            break;
+        }
+    }
+    dropped_from_freed += atomic_load(&r->dropped);
+    ring_free(r);
+}
+
+/*
+ * 线程退出：后台线程在跑时只做标记，由它读空后释放；已经停止时没人会再来释放，当场释放。
+ * async_log_stop 之后才退出的线程的缓冲区就是这样回收的。
+ */
+static void ring_on_thread_exit(void* ring) {
+    LogRing* r = (LogRing*)ring;
+    mtx_lock(&registry_lock);
+    if (logger_alive) {
+        atomic_store_explicit(&r->orphaned, true, memory_order_release);
+    } else {
+        ring_unlink_free(r);
+    }
+    mtx_unlock(&registry_lock);
+}
+
+static LogRing* ring_register(void) {
+    LogRing* r = (LogRing*)mem_alloc_cacheline(sizeof(LogRing));
+    if (!r) return NULL;
+    r->buf = (char*)mem_alloc_cacheline(ring_capacity);
+    if (!r->buf) {
+        mem_aligned_free(r);
+        return NULL;
+    }
+    r->mask = ring_capacity - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->dropped, 0);
+    atomic_init(&r->orphaned, false);
+    r->cached_head = 0;
+
+    mtx_lock(&registry_lock);
+    r->next = registry;
+    registry = r;
+    mtx_unlock(&registry_lock);
+    tss_set(ring_key, r);
+    tls_ring = r;
+    return r;
+}
+
+/* ========================================================================== */
+/*                              生产者：只拷贝参数                            */
+/* ========================================================================== */
+
+void async_log_vwrite(const char* level, const char* fmt, va_list ap) {
+    LogRing* r = tls_ring ? tls_ring : ring_register();
+    if (!r) return;
+
+    // 按格式串把参数原样取出，%s 记下字符串稍后拷贝
+    LogArg args[LOG_MAX_ARGS];
+    const char* strs[LOG_MAX_ARGS];
+    size_t nargs = 0, str_bytes = 0;
+    for (const char* f = fmt; nargs < LOG_MAX_ARGS - 2; f++) {
+        f = strchr(f, '%'); /* 普通字符整段跳过，由 libc 的向量化实现完成 */
+        if (!f) break;
+        if (*++f == '%') continue;
+        LogSpec spec;
+        const char* next = parse_spec(f, &spec);
+        if (!spec.conv) break;
+        // "*" 的宽度/精度各占一个参数槽，它们不是字符串，strs 也要清空
+        if (spec.width_len == 1 && *spec.width == '*') {
+            strs[nargs] = NULL;
+            args[nargs++].i = va_arg(ap, int);
+        }
+        if (spec.precision_len == 1 && *spec.precision == '*') {
+            strs[nargs] = NULL;
+            args[nargs++].i = va_arg(ap, int);
+        }
+
+        LogArg* a = &args[nargs];
+        strs[nargs] = NULL;
+        switch (spec.conv) {
+            case 'd': case 'i':
+                switch (spec.len) {
+                    case LEN_L: a->i = va_arg(ap, long); break;
+                    case LEN_LL: a->i = va_arg(ap, long long); break;
+                    case LEN_J: a->i = (long long)va_arg(ap, intmax_t); break;
+                    case LEN_Z: case LEN_T: a->i = (long long)va_arg(ap, ptrdiff_t); break;
+                    case LEN_HH: a->i = (signed char)va_arg(ap, int); break;
+                    case LEN_H: a->i = (short)va_arg(ap, int); break;
+                    default: a->i = va_arg(ap, int); break;
+                }
+                break;
+            case 'o': case 'u': case 'x': case 'X':
+                switch (spec.len) {
+                    case LEN_L: a->u = va_arg(ap, unsigned long); break;
+                    case LEN_LL: a->u = va_arg(ap, unsigned long long); break;
+                    case LEN_J: a->u = (unsigned long long)va_arg(ap, uintmax_t); break;
+                    case LEN_Z: case LEN_T: a->u = va_arg(ap, size_t); break;
+                    case LEN_HH: a->u = (unsigned char)va_arg(ap, unsigned); break;
+                    case LEN_H: a->u = (unsigned short)va_arg(ap, unsigned); break;
+                    default: a->u = va_arg(ap, unsigned); break;
+                }
+                break;
+            case 'c': a->i = va_arg(ap, int); break;
+            case 'p': a->p = va_arg(ap, void*); break;
+            case 's': {
+                const char* s = va_arg(ap, const char*);
+                strs[nargs] = s ? s : "(null)";
+                a->len = strlen(strs[nargs]);
+                str_bytes += a->len + 1;
+                break;
+            }
+            default: /* 浮点 */
+                a->d = spec.len == LEN_BIG_L ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                break;
+        }
+        nargs++;
+        f = next - 1;
+    }
+
+    size_t need = ALIGN_UP(sizeof(LogRecord) + nargs * sizeof(LogArg) + str_bytes, (size_t)8);
+    if (need > ring_capacity / 2) {
+        atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed); /* 单条日志过大 */
+        return;
+    }
+
+    // 预留空间：尾部放不下一整条记录时先写“回绕”标记，从缓冲区开头继续
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t to_end = ring_capacity - (tail & r->mask);
+    size_t total = to_end < need ? to_end + need : need;
+    while (ring_capacity - (tail - r->cached_head) < total) {
+        r->cached_head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (ring_capacity - (tail - r->cached_head) >= total) break;
+        if (full_policy == LOG_FULL_DROP || !atomic_load(&running)) {
+            atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+            return;
+        }
+        atomic_fetch_add(&blocked_producers, 1);
+        thrd_yield();
+        atomic_fetch_sub(&blocked_producers, 1);
+    }
+    if (to_end < need) {
+        if (to_end >= sizeof(LogRecord)) ((LogRecord*)(r->buf + (tail & r->mask)))->size = LOG_WRAP;
+        tail += to_end;
+    }
+
+    char* p = r->buf + (tail & r->mask);
+    LogRecord* rec = (LogRecord*)p;
+    rec->size = (uint32_t)need;
+    rec->nargs = (uint32_t)nargs;
+    rec->level = level;
+    rec->fmt = fmt;
+    memcpy(p + sizeof(LogRecord), args, nargs * sizeof(LogArg));
+    char* sp = p + sizeof(LogRecord) + nargs * sizeof(LogArg);
+    for (size_t i = 0; i < nargs; i++) {
+        if (!strs[i]) continue;
+        memcpy(sp, strs[i], args[i].len + 1);
+        sp += args[i].len + 1;
+    }
+    atomic_store_explicit(&r->tail, tail + need, memory_order_release);
+}
+
+size_t async_log_dropped(void) {
+    mtx_lock(&registry_lock);
+    size_t n = dropped_from_freed;
+    for (LogRing* r = registry; r; r = r->next) n += atomic_load(&r->dropped);
+    mtx_unlock(&registry_lock);
+    return n;
+}
+
+/* ========================================================================== */
+/*                              后台线程：格式化并批量写出                    */
+/* ========================================================================== */
+
+static char out_buf[LOG_OUT_BUFFER];
+static size_t out_len;
+
+static void out_flush(void) {
+    if (!out_len) return;
+#if defined(_WIN32)
+    fwrite(out_buf, 1, out_len, stdout);
+    fflush(stdout);
+#else
+    if (out_fd == STDOUT_FILENO) fflush(stdout); /* 先把同步 printf 的内容送出去，减少交错 */
+    size_t off = 0;
+    while (off < out_len) {
+        ssize_t n = write(out_fd, out_buf + off, out_len - off);
+        if (n <= 0) break;
+        off += (size_t)n;
+    }
+#endif
+    out_len = 0;
+}
+
+/* 追加到输出缓冲区，放不下就先写出；超过整个缓冲区的内容分段写出 */
+static void out_append(const char* s, size_t n) {
+    while (n > 0) {
+        if (out_len == LOG_OUT_BUFFER) out_flush();
+        size_t chunk = LOG_OUT_BUFFER - out_len;
+        if (chunk > n) chunk = n;
+        memcpy(out_buf + out_len, s, chunk);
+        out_len += chunk;
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+/* 把 "*" 换成参数里的实际数值，负的精度等同于没写精度 */
+static size_t spec_part(char* dst, const char* part, size_t len, const LogArg* args, size_t* ai,
+                        bool is_precision) {
+    if (len == 1 && *part == '*') {
+        long long v = args[(*ai)++].i;
+        if (is_precision && v < 0) return 0;
+        return (size_t)sprintf(dst, "%s%lld", is_precision ? "." : "", v);
+    }
+    if (is_precision) {
+        dst[0] = '.';
+        memcpy(dst + 1, part, len);
+        return len + 1;
+    }
+    memcpy(dst, part, len);
+    return len;
+}
+
+/* 说明符是运行时拼出来的，经 va_list 转发给 vsnprintf */
+static int format_one(char* dst, size_t size, const char* spec, ...) {
+    va_list ap;
+    va_start(ap, spec);
+    int n = vsnprintf(dst, size, spec, ap);
+    va_end(ap);
+    return n;
+}
+
+static int format_arg(char* dst, size_t size, const char* sf, char conv, const LogArg* a,
+                      const char* str) {
+    switch (conv) {
+        case 'd': case 'i': return format_one(dst, size, sf, a->i);
+        case 'o': case 'u': case 'x': case 'X': return format_one(dst, size, sf, a->u);
+        case 'c': return format_one(dst, size, sf, (int)a->i);
+        case 'p': return format_one(dst, size, sf, a->p);
+        case 's': return format_one(dst, size, sf, str);
+        default: return format_one(dst, size, sf, a->d);
+    }
+}
+
+static void format_record(const LogRecord* rec) {
+    const LogArg* args = (const LogArg*)(rec + 1);
+    const char* strs = (const char*)(args + rec->nargs);
+    char tmp[512];
+
+    out_append("[", 1);
+    out_append(rec->level, strlen(rec->level));
+    out_append("] ", 2);
+
+    size_t ai = 0;
+    const char* f = rec->fmt;
+    while (*f) {
+        const char* lit = f;
+        while (*f && *f != '%') f++;
+        out_append(lit, (size_t)(f - lit));
+        if (!*f) break;
+        if (f[1] == '%') {
+            out_append("%", 1);
+            f += 2;
+            continue;
+        }
+
+        LogSpec spec;
+        const char* next = parse_spec(f + 1, &spec);
+        if (!spec.conv || ai >= rec->nargs) {
+            out_append(f, strlen(f)); /* 与生产者一样在这里停止解析 */
+            break;
+        }
+        // 没有宽度和精度的 %s 不必经过 vsnprintf，字符串直接追加
+        if (spec.conv == 's' && !spec.width_len && !spec.has_precision) {
+            out_append(strs, args[ai].len);
+            strs += args[ai++].len + 1;
+            f = next;
+            continue;
+        }
+
+        // 重新拼出一个说明符：整数统一用 ll 长度（取值时已按原长度截断）
+        char sf[LOG_SPEC_BUF];
+        size_t k = 0;
+        sf[k++] = '%';
+        memcpy(sf + k, spec.flags, spec.flags_len);
+        k += spec.flags_len;
+        k += spec_part(sf + k, spec.width, spec.width_len, args, &ai, false);
+        if (spec.has_precision) {
+            k += spec_part(sf + k, spec.precision, spec.precision_len, args, &ai, true);
+        }
+        bool is_int = strchr("diouxX", spec.conv) != NULL;
+        if (is_int) {
+            sf[k++] = 'l';
+            sf[k++] = 'l';
+        }
+        sf[k++] = spec.conv;
+        sf[k] = '\0';
+
+        const LogArg* a = &args[ai++];
+        int n = format_arg(tmp, sizeof(tmp), sf, spec.conv, a, strs);
+        if (n > 0 && (size_t)n < sizeof(tmp)) {
+            out_append(tmp, (size_t)n);
+        } else if (n > 0) {
+            // 长字符串或很大的宽度：按实际长度另申请一块重新格式化，与同步 log_printf 的输出一致
+            char* big = (char*)malloc((size_t)n + 1);
+            int m = big ? format_arg(big, (size_t)n + 1, sf, spec.conv, a, strs) : -1;
+            if (m > 0) {
+                out_append(big, (size_t)m < (size_t)n ? (size_t)m : (size_t)n);
+            } else {
+                out_append(tmp, sizeof(tmp) - 1); /* 申请失败只能截断 */
+            }
+            free(big);
+        }
+        if (spec.conv == 's') strs += a->len + 1;
+        f = next;
+    }
+    out_append("\n", 1);
+}
+
+/* 读空一个缓冲区，返回处理的记录数 */
+static size_t ring_drain(LogRing* r) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t count = 0;
+    while (head != tail) {
+        size_t to_end = r->mask + 1 - (head & r->mask);
+        const LogRecord* rec = (const LogRecord*)(r->buf + (head & r->mask));
+        if (to_end < sizeof(LogRecord) || rec->size == LOG_WRAP) {
+            head += to_end;
+            continue;
+        }
+        format_record(rec);
+        head += rec->size;
+        count++;
+        atomic_store_explicit(&r->head, head, memory_order_release); /* 尽早让阻塞的生产者继续 */
+    }
+    return count;
+}
+
+static size_t drain_all(void) {
+    size_t count = 0;
+    mtx_lock(&registry_lock);
+    for (LogRing** link = &registry; *link;) {
+        LogRing* r = *link;
+        bool orphaned = atomic_load_explicit(&r->orphaned, memory_order_acquire);
+        count += ring_drain(r);
+        if (orphaned) {
+            *link = r->next;
+            dropped_from_freed += atomic_load(&r->dropped);
+            ring_free(r);
+        } else {
+            link = &r->next;
+        }
+    }
+    mtx_unlock(&registry_lock);
+    return count;
+}
+
+static int logger_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        bool stop = atomic_load(&stopping);
+        if (drain_all()) continue;
+        out_flush();
+        if (stop) break;
+        if (atomic_load(&blocked_producers) > 0) {
+            thrd_yield(); /* 有生产者在等空间，不能睡 */
+            continue;
+        }
+        thrd_sleep(&(struct timespec){.tv_sec = 0, .tv_nsec = LOG_IDLE_SLEEP_NS}, NULL);
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/*                              启动与停止                                    */
+/* ========================================================================== */
+
+static once_flag init_once = ONCE_FLAG_INIT;
+static bool init_ok;
+
+static void log_init_once(void) {
+    init_ok = mtx_init(&registry_lock, mtx_plain) == thrd_success &&
+              tss_create(&ring_key, ring_on_thread_exit) == thrd_success;
+}
+
+bool async_log_start(int fd, size_t ring_bytes, LogFullPolicy policy) {
+    call_once(&init_once, log_init_once);
+    if (!init_ok || atomic_load(&running)) return false;
+
+    // 各线程的缓冲区一旦建立就沿用，容量只在第一次启动时决定
+    if (!ring_capacity) {
+        size_t cap = ring_bytes ? ring_bytes : LOG_DEFAULT_RING;
+        ring_capacity = 4096;
+        while (ring_capacity < cap) ring_capacity *= 2;
+    }
+    full_policy = policy;
+    out_fd = fd;
+    atomic_store(&stopping, false);
+    mtx_lock(&registry_lock);
+    logger_alive = thrd_create(&logger_thread, logger_main, NULL) == thrd_success;
+    mtx_unlock(&registry_lock);
+    if (!logger_alive) return false;
+    atomic_store(&running, true);
+    return true;
+}
+
+void async_log_stop(void) {
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, false);
+    atomic_store(&stopping, true);
+    thrd_join(logger_thread, NULL);
+
+    // 后台线程最后一轮读空之后才标记为孤儿的缓冲区没人释放，在这里释放
+    mtx_lock(&registry_lock);
+    logger_alive = false;
+    for (LogRing* r = registry; r;) {
+        LogRing* next = r->next;
+        if (atomic_load_explicit(&r->orphaned, memory_order_acquire)) ring_unlink_free(r);
+        r = next;
+    }
+    mtx_unlock(&registry_lock);
+}
+
+bool async_log_running(void) {
+    return atomic_load_explicit(&running, memory_order_relaxed);
+}
+
+#endif /* HAS_THREADS */
@@ -0,0 +1,64 @@
+/**
+ * @file async_log.h
+ * @brief 异步无锁日志后端
+ *
+ * 同步的 log_printf 每条日志调用三次 stdio，每次都要拿 stdout 的锁，终端或磁盘慢时还会阻塞调用线程。
+ * 异步模式下：
+ * 1. 级别过滤最先做，被过滤掉的日志只花一次比较。
+ * 2. 调用线程只扫描一遍格式串，把 fmt 指针和原始参数（%s 的字符串内容要拷贝）写进自己线程私有的环形缓冲区，
+ *    不格式化、不加锁、不进内核。
+ * 3. 后台线程轮询所有线程的缓冲区，在那里调用 snprintf 格式化，攒满一大块后一次 write。
+ * 4. 缓冲区满时按策略丢弃（计数，之后输出一条提示）或阻塞等待后台线程腾出空间。
+ *
+ * 限制：fmt 和 level 只保存指针，必须是字符串字面量（或在 async_log_stop 前一直有效）；
+ * 同一线程的日志保持顺序，不同线程之间的先后顺序不保证；不支持 %n，long double 按 double 输出。
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+} LogLevel;
+
+typedef enum {
+    LOG_FULL_DROP,  /* 缓冲区满时丢弃这条日志，调用方永不阻塞 */
+    LOG_FULL_BLOCK, /* 缓冲区满时等待后台线程腾出空间，不丢日志 */
+} LogFullPolicy;
+
+/* "DEBUG"/"INFO"/"WARN"/"ERROR" 映射到级别，只看首字母；未知名称按 INFO 处理 */
+LogLevel log_level_from_name(const char* name);
+
+/* 低于 min 的日志直接丢弃（同步和异步模式都生效） */
+void log_set_level(LogLevel min);
+bool log_level_enabled(LogLevel level);
+
+#if HAS_THREADS
+
+/*
+ * 启动后台线程，之后的日志写到 fd（Windows 上忽略 fd，写 stdout）。
+ * ring_bytes 是每个线程缓冲区的大小，向上取整到 2 的幂，0 表示默认 64KB。
+ */
+bool async_log_start(int fd, size_t ring_bytes, LogFullPolicy policy);
+/* 把所有缓冲区里的日志写完后停止后台线程 */
+void async_log_stop(void);
+bool async_log_running(void);
+
+/* 生产者接口：记录一条日志，调用者应先用 log_level_enabled 过滤 */
+void async_log_vwrite(const char* level, const char* fmt, va_list args);
+
+/* 因缓冲区满被丢弃的日志条数 */
+size_t async_log_dropped(void);
+
+#endif /* HAS_THREADS */
+
+#endif /* ASYNC_LOG_H */
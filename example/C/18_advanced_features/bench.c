@@ -0,0 +1,2041 @@
+/**
+ * @file bench.c
+ * @brief 各模块的性能基准测试
+ */
+
+/* 严格 C11 模式下 syscall 和 MAP_ANONYMOUS 需要打开 POSIX/BSD 扩展 */
+#define _DEFAULT_SOURCE
+
+#include "bench.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "async_log.h"
+#include "cmd_hash_tables.h"
+#include "cmd_queue.h"
+#include "commands.h"
+#include "cpu_topo.h"
+#include "mem_align.h"
+#include "mem_pool.h"
+#include "mem_track.h"
+#include "parallel.h"
+#include "ring_queue.h"
+#include "sharded_counter.h"
+#include "slab.h"
+#include "tc_pool.h"
+#include "vec.h"
+#include "ws_pool.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+#endif
+
+#if defined(_WIN32)
+  #define BENCH_NULL_DEVICE "NUL"
+#else
+  #define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+volatile uintptr_t bench_sink;
+
+int bench_cpu_count(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return (int)n;
+#endif
+    return 1;
+}
+
+size_t bench_rss_bytes(void) {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long total = 0, resident = 0;
+    int n = fscanf(f, "%lu %lu", &total, &resident);
+    fclose(f);
+    if (n != 2) return 0;
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+int bench_counter_open(BenchCounterKind kind) {
+#if defined(__linux__) && defined(__NR_perf_event_open)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    if (kind == BENCH_COUNTER_DTLB_MISS) {
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    } else {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    }
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; /* 普通用户通常只允许统计用户态 */
+    attr.exclude_hv = 1;
+    long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    return fd < 0 ? -1 : (int)fd;
+#else
+    (void)kind;
+    return -1;
+#endif
+}
+
+void bench_counter_start(int counter) {
+#if defined(__linux__)
+    if (counter < 0) return;
+    ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+#else
+    (void)counter;
+#endif
+}
+
+uint64_t bench_counter_stop(int counter) {
+#if defined(__linux__)
+    if (counter < 0) return 0;
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value = 0;
+    if (read(counter, &value, sizeof(value)) != (ssize_t)sizeof(value)) return 0;
+    return value;
+#else
+    (void)counter;
+    return 0;
+#endif
+}
+
+void bench_counter_close(int counter) {
+#if defined(__linux__)
+    if (counter >= 0) close(counter);
+#else
+    (void)counter;
+#endif
+}
+
+/* ========================================================================== */
+/*                       内存池：空闲链表 vs 分层位图                         */
+/* ========================================================================== */
+
+#define POOL_BENCH_BLOCK_SIZE 32
+#define POOL_BENCH_CHURN_OPS  100000
+
+/*
+ * 测三个阶段：
+ * 1. 填充：从空池连续分配到满，统计每次 alloc 的平均耗时。
+ * 2. 满载抖动：池满时随机释放一块再分配一块，模拟长期运行的服务。
+ * 3. 遍历（仅位图模式）：释放一半后遍历全部存活块，模拟批量析构。
+ */
+static void bench_pool_visit(void* block, void* ctx) {
+    (void)ctx;
+    bench_sink += (uintptr_t)block;
+}
+
+static void bench_pool_one(size_t count, PoolMode mode) {
+    MemPool* pool = pool_create_ex(POOL_BENCH_BLOCK_SIZE, count, mode, 0);
+    void** blocks = (void**)malloc(count * sizeof(void*));
+    if (!pool || !blocks) {
+        printf("  内存不足，跳过 count=%zu\n", count);
+        pool_destroy(pool);
+        free(blocks);
+        return;
+    }
+
+    uint64_t t0 = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = pool_alloc(pool);
+    }
+    double fill_ns = (double)(bench_now_ns() - t0) / (double)count;
+
+    uint64_t seed = 0x9E3779B97F4A7C15u;
+    t0 = bench_now_ns();
+    for (int i = 0; i < POOL_BENCH_CHURN_OPS; i++) {
+        size_t idx = (size_t)(bench_rand(&seed) % count);
+        pool_free(pool, blocks[idx]);
+        blocks[idx] = pool_alloc(pool);
+    }
+    double churn_ns = (double)(bench_now_ns() - t0) / POOL_BENCH_CHURN_OPS;
+    bench_sink = (uintptr_t)blocks[0];
+
+    const char* label = mode == POOL_MODE_FREELIST ? "空闲链表" : "分层位图";
+    printf("  %s  块数=%-8zu 填充: %7.1f ns/op  满载 free+alloc: %7.1f ns/op", label, count,
+           fill_ns, churn_ns);
+
+    if (mode == POOL_MODE_BITMAP) {
+        for (size_t i = 0; i < count; i += 2) {
+            pool_free(pool, blocks[i]);
+        }
+        t0 = bench_now_ns();
+        size_t live = pool_foreach_live(pool, bench_pool_visit, NULL);
+        double visit_ns = (double)(bench_now_ns() - t0) / (double)live;
+        printf("  遍历存活块: %5.2f ns/块", visit_ns);
+    }
+    printf("\n");
+
+    free(blocks);
+    pool_destroy(pool);
+}
+
+static void bench_pool(void) {
+    printf("\n[pool] 内存池分配策略对比 (块大小 %d 字节)\n", POOL_BENCH_BLOCK_SIZE);
+    const size_t sizes[] = {1024, 64 * 1024, 1024 * 1024};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_pool_one(sizes[i], POOL_MODE_FREELIST);
+        bench_pool_one(sizes[i], POOL_MODE_BITMAP);
+    }
+}
+
+/* ========================================================================== */
+/*                       大页：GB 级内存池的随机访问                          */
+/* ========================================================================== */
+
+#define HUGE_BENCH_BYTES      ((size_t)1024 * 1024 * 1024)
+#define HUGE_BENCH_BLOCK_SIZE 64
+#define HUGE_BENCH_ACCESSES   20000000
+
+/*
+ * /proc/self/smaps 中与 [addr, addr+len) 重叠的映射的 AnonHugePages 之和（字节），仅 Linux 支持。
+ * 只统计池自己的映射，不受进程里其他大页的影响；拿不到 dTLB 计数器时用它证明大页确实生效。
+ */
+static size_t bench_anon_huge_bytes(const void* addr, size_t len) {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f) return 0;
+    uintptr_t lo = (uintptr_t)addr, hi = lo + len;
+    char line[512];
+    unsigned long kb, total_kb = 0;
+    bool inside = false;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start < hi && end > lo; /* 映射头行，后面的字段都属于这个映射 */
+        } else if (inside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            total_kb += kb;
+        }
+    }
+    fclose(f);
+    return (size_t)total_kb * 1024;
+#else
+    (void)addr;
+    (void)len;
+    return 0;
+#endif
+}
+
+/*
+ * 每个块里存一个随机数，访问时用它算出下一个块的下标，形成一条依赖链：
+ * CPU 无法提前预取，每一步几乎都是一次 cache miss + TLB miss。
+ * 1GB 用 4KB 页需要 26 万个页表项，远超 TLB 容量；用 2MB 页只需要 512 个。
+ */
+static void bench_hugepage_one(const char* label, unsigned flags) {
+    const size_t count = HUGE_BENCH_BYTES / HUGE_BENCH_BLOCK_SIZE;
+
+    uint64_t t0 = bench_now_ns();
+    MemPool* pool = pool_create_ex(HUGE_BENCH_BLOCK_SIZE, count, POOL_MODE_FREELIST, flags);
+    if (!pool) {
+        printf("  %-26s 创建失败，跳过\n", label);
+        return;
+    }
+    uint64_t seed = 0x2545F4914F6CDD1Du;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t* block = (uint64_t*)pool_alloc(pool);
+        *block = bench_rand(&seed);
+    }
+    double setup_ms = (double)(bench_now_ns() - t0) / 1e6;
+    size_t pool_bytes = count * pool->block_size;
+    size_t huge_bytes = bench_anon_huge_bytes(pool->memory, pool_bytes);
+
+    // 池是连续的，直接按下标算地址，避免额外的指针数组干扰 TLB
+    const char* base = (const char*)pool->memory;
+    int counter = bench_counter_open(BENCH_COUNTER_DTLB_MISS);
+    size_t idx = 0;
+    bench_counter_start(counter);
+    t0 = bench_now_ns();
+    for (int i = 0; i < HUGE_BENCH_ACCESSES; i++) {
+        uint64_t next = *(const uint64_t*)(base + idx * HUGE_BENCH_BLOCK_SIZE);
+        idx = (size_t)((next ^ (uint64_t)i) % count);
+    }
+    double access_ns = (double)(bench_now_ns() - t0) / HUGE_BENCH_ACCESSES;
+    uint64_t misses = bench_counter_stop(counter);
+    bench_sink = idx;
+
+    printf("  %-26s 创建+填充: %7.1f ms  随机访问: %6.1f ns/次  池内大页: %5zu MB (%3.0f%%)",
+           label, setup_ms, access_ns, huge_bytes >> 20,
+           100.0 * (double)huge_bytes / (double)pool_bytes);
+    if (counter >= 0) {
+        printf("  dTLB miss: %.2f/次\n", (double)misses / HUGE_BENCH_ACCESSES);
+    } else {
+        printf("  dTLB miss: 不可用\n");
+    }
+    bench_counter_close(counter);
+
+    // 整池清空后把物理页还给内核，RSS 应该明显下降
+    pool_reset(pool);
+    size_t rss_before = bench_rss_bytes();
+    size_t released = pool_release_free(pool);
+    if (released) {
+        printf("  %-26s reset + pool_release_free: 归还 %zu MB，RSS %zu MB -> %zu MB\n", "",
+               released >> 20, rss_before >> 20, bench_rss_bytes() >> 20);
+    }
+    pool_destroy(pool);
+}
+
+static void bench_hugepage(void) {
+    printf("\n[hugepage] %zu MB 内存池 (块 %d 字节) 上的依赖链随机访问\n", HUGE_BENCH_BYTES >> 20,
+           HUGE_BENCH_BLOCK_SIZE);
+    bench_hugepage_one("malloc", 0);
+    bench_hugepage_one("mmap 4KB", POOL_FLAG_MMAP);
+    bench_hugepage_one("mmap 4KB + populate", POOL_FLAG_MMAP | POOL_FLAG_POPULATE);
+    bench_hugepage_one("mmap 2MB huge", POOL_FLAG_HUGEPAGE);
+    bench_hugepage_one("mmap 2MB huge + populate", POOL_FLAG_HUGEPAGE | POOL_FLAG_POPULATE);
+    printf("  （池内大页 = /proc/self/smaps 中池所在映射的 AnonHugePages，"
+           "没有 dTLB 计数器时用它确认大页是否生效）\n");
+}
+
+/* ========================================================================== */
+/*                    多线程分配：线程缓存池 vs 全局锁 vs malloc                */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define MT_BENCH_OPS        2000000 /* 每个线程的 alloc/free 对数 */
+#define MT_BENCH_BATCH      16      /* 每轮先分配这么多块再全部释放 */
+#define MT_BENCH_BLOCK_SIZE 64
+#define MT_BENCH_MAX_THREADS 256
+
+typedef enum { MT_MALLOC, MT_LOCKED_POOL, MT_TC_POOL } MtAllocKind;
+
+typedef struct {
+    MtAllocKind kind;
+    MemPool* pool; /* MT_LOCKED_POOL 使用 */
+    mtx_t* pool_lock;
+    TcPool* tc_pool; /* MT_TC_POOL 使用 */
+    atomic_int* ready;
+    atomic_bool* go;
+} MtBenchArg;
+
+static int mt_bench_worker(void* arg) {
+    MtBenchArg* a = (MtBenchArg*)arg;
+    TcCache* cache = a->kind == MT_TC_POOL ? tc_cache_create(a->tc_pool) : NULL;
+    void* blocks[MT_BENCH_BATCH];
+
+    // 所有线程就绪后同时开跑
+    atomic_fetch_add(a->ready, 1);
+    while (!atomic_load(a->go)) {
+    }
+
+    for (int round = 0; round < MT_BENCH_OPS / MT_BENCH_BATCH; round++) {
+        for (int i = 0; i < MT_BENCH_BATCH; i++) {
+            switch (a->kind) {
+                case MT_MALLOC:
+                    blocks[i] = malloc(MT_BENCH_BLOCK_SIZE);
+                    break;
+                case MT_LOCKED_POOL:
+                    mtx_lock(a->pool_lock);
+                    blocks[i] = pool_alloc(a->pool);
+                    mtx_unlock(a->pool_lock);
+                    break;
+                case MT_TC_POOL:
+                    blocks[i] = tc_alloc(cache);
+                    break;
+            }
+            *(volatile char*)blocks[i] = (char)i; /* 真正写一下块，模拟使用 */
+        }
+        for (int i = MT_BENCH_BATCH - 1; i >= 0; i--) {
+            switch (a->kind) {
+                case MT_MALLOC:
+                    free(blocks[i]);
+                    break;
+                case MT_LOCKED_POOL:
+                    mtx_lock(a->pool_lock);
+                    pool_free(a->pool, blocks[i]);
+                    mtx_unlock(a->pool_lock);
+                    break;
+                case MT_TC_POOL:
+                    tc_free(cache, blocks[i]);
+                    break;
+            }
+        }
+    }
+
+    tc_cache_destroy(cache);
+    return 0;
+}
+
+/* 返回总吞吐 (百万次 alloc+free / 秒) */
+static double mt_bench_run(MtAllocKind kind, int nthreads) {
+    size_t capacity = (size_t)nthreads * (MT_BENCH_BATCH + 2 * TC_MAGAZINE_SIZE) * 2;
+    MemPool* pool = NULL;
+    TcPool* tc_pool = NULL;
+    mtx_t lock;
+    mtx_init(&lock, mtx_plain);
+    if (kind == MT_LOCKED_POOL) pool = pool_create(MT_BENCH_BLOCK_SIZE, capacity);
+    if (kind == MT_TC_POOL) tc_pool = tc_pool_create(MT_BENCH_BLOCK_SIZE, capacity);
+
+    atomic_int ready;
+    atomic_bool go;
+    atomic_init(&ready, 0);
+    atomic_init(&go, false);
+
+    thrd_t threads[MT_BENCH_MAX_THREADS];
+    MtBenchArg args[MT_BENCH_MAX_THREADS];
+    for (int i = 0; i < nthreads; i++) {
+        args[i] = (MtBenchArg){kind, pool, &lock, tc_pool, &ready, &go};
+        thrd_create(&threads[i], mt_bench_worker, &args[i]);
+    }
+    while (atomic_load(&ready) < nthreads) {
+    }
+
+    uint64_t t0 = bench_now_ns();
+    atomic_store(&go, true);
+    for (int i = 0; i < nthreads; i++) thrd_join(threads[i], NULL);
+    uint64_t elapsed = bench_now_ns() - t0;
+
+    pool_destroy(pool);
+    tc_pool_destroy(tc_pool);
+    mtx_destroy(&lock);
+    return (double)nthreads * MT_BENCH_OPS / ((double)elapsed / 1e3);
+}
+
+static void bench_mt_alloc(void) {
+    int ncpu = bench_cpu_count();
+    if (ncpu > MT_BENCH_MAX_THREADS) ncpu = MT_BENCH_MAX_THREADS;
+    printf("\n[mt] 多线程 alloc/free 吞吐 (块大小 %d, 单位: 百万对/秒, CPU 核心数 %d)\n",
+           MT_BENCH_BLOCK_SIZE, ncpu);
+    printf("  %-6s %12s %12s %12s\n", "线程", "malloc", "全局锁池", "线程缓存池");
+
+    for (int n = 1;; n *= 2) {
+        if (n > ncpu) n = ncpu;
+        printf("  %-6d %12.1f %12.1f %12.1f\n", n, mt_bench_run(MT_MALLOC, n),
+               mt_bench_run(MT_LOCKED_POOL, n), mt_bench_run(MT_TC_POOL, n));
+        if (n == ncpu) break;
+    }
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                        slab 分配器 vs glibc malloc                         */
+/* ========================================================================== */
+
+#define SLAB_BENCH_LIVE 200000  /* 同时存活的对象数 */
+#define SLAB_BENCH_OPS  4000000 /* 随机替换次数 */
+
+typedef struct {
+    const char* name;
+    void* (*alloc)(size_t);
+    void (*release)(void*);
+} AllocatorVTable;
+
+/* 小对象为主的尺寸分布：70% 8~64B，25% 65~512B，5% 513~4096B */
+static size_t slab_bench_size(uint64_t* seed) {
+    uint64_t r = bench_rand(seed);
+    unsigned bucket = (unsigned)(r % 100);
+    r >>= 8;
+    if (bucket < 70) return 8 + (size_t)(r % 57);
+    if (bucket < 95) return 65 + (size_t)(r % 448);
+    return 513 + (size_t)(r % 3584);
+}
+
+static void bench_slab_one(const AllocatorVTable* a) {
+    void** objs = (void**)calloc(SLAB_BENCH_LIVE, sizeof(void*));
+    if (!objs) return;
+    uint64_t seed = 42;
+    size_t rss_before = bench_rss_bytes();
+
+    uint64_t t0 = bench_now_ns();
+    for (size_t i = 0; i < SLAB_BENCH_LIVE; i++) {
+        objs[i] = a->alloc(slab_bench_size(&seed));
+        *(char*)objs[i] = 1;
+    }
+    for (int i = 0; i < SLAB_BENCH_OPS; i++) {
+        size_t idx = (size_t)(bench_rand(&seed) % SLAB_BENCH_LIVE);
+        a->release(objs[idx]);
+        objs[idx] = a->alloc(slab_bench_size(&seed));
+        *(char*)objs[idx] = 1;
+    }
+    double ns = (double)(bench_now_ns() - t0) / (SLAB_BENCH_LIVE + SLAB_BENCH_OPS);
+    size_t rss_peak = bench_rss_bytes();
+
+    for (size_t i = 0; i < SLAB_BENCH_LIVE; i++) a->release(objs[i]);
+    size_t rss_after = bench_rss_bytes();
+    free(objs);
+
+    printf("  %-8s %8.1f ns/op   RSS 增量: 峰值 %7.1f MB  全部释放后 %7.1f MB\n", a->name, ns,
+           (double)(rss_peak - rss_before) / 1048576.0,
+           (double)((rss_after > rss_before ? rss_after : rss_before) - rss_before) / 1048576.0);
+}
+
+static void bench_slab(void) {
+    printf("\n[slab] 分级 slab 分配器 vs 系统 malloc (%d 个存活对象, %d 次随机替换)\n",
+           SLAB_BENCH_LIVE, SLAB_BENCH_OPS);
+    const AllocatorVTable allocators[] = {
+        {"malloc", malloc, free},
+        {"slab", slab_malloc, slab_free},
+    };
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+        bench_slab_one(&allocators[i]);
+    }
+    printf("  slab 全部释放后仍向系统持有的区块数: %zu (每级最多保留 1 个备用)\n", slab_os_chunks());
+}
+
+/* ========================================================================== */
+/*                    区域分配器：解析后整体丢弃 vs malloc/free               */
+/* ========================================================================== */
+
+#define ARENA_BENCH_REQUESTS 20000
+#define ARENA_BENCH_TOKENS   200
+
+typedef struct {
+    char* text;
+    size_t len;
+} BenchToken;
+
+/* 模拟一次请求：把 "k0=v0;k1=v1;..." 拆成 token，每个 token 一个节点 + 一份字符串拷贝，
+ * token 指针数组从 4 开始按 2 倍 realloc 增长 */
+static size_t parse_with_malloc(const char* input) {
+    size_t cap = 4, n = 0;
+    BenchToken** tokens = (BenchToken**)malloc(cap * sizeof(BenchToken*));
+    for (const char* p = input; *p;) {
+        const char* end = p;
+        while (*end && *end != ';' && *end != '=') end++;
+        if (n == cap) {
+            cap *= 2;
+            tokens = (BenchToken**)realloc(tokens, cap * sizeof(BenchToken*));
+        }
+        BenchToken* t = (BenchToken*)malloc(sizeof(BenchToken));
+        t->len = (size_t)(end - p);
+        t->text = (char*)malloc(t->len + 1);
+        memcpy(t->text, p, t->len);
+        t->text[t->len] = '\0';
+        tokens[n++] = t;
+        p = *end ? end + 1 : end;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += tokens[i]->len;
+        free(tokens[i]->text);
+        free(tokens[i]);
+    }
+    free(tokens);
+    return total;
+}
+
+static size_t parse_with_arena(Arena* arena, const char* input) {
+    ArenaMark mark = arena_mark(arena);
+    size_t cap = 4, n = 0;
+    BenchToken** tokens = (BenchToken**)arena_alloc(arena, cap * sizeof(BenchToken*));
+    for (const char* p = input; *p;) {
+        const char* end = p;
+        while (*end && *end != ';' && *end != '=') end++;
+        if (n == cap) {
+            tokens = (BenchToken**)arena_realloc(arena, tokens, cap * sizeof(BenchToken*),
+                                                 cap * 2 * sizeof(BenchToken*));
+            cap *= 2;
+        }
+        BenchToken* t = (BenchToken*)arena_alloc(arena, sizeof(BenchToken));
+        t->len = (size_t)(end - p);
+        t->text = (char*)arena_alloc_aligned(arena, t->len + 1, 1);
+        memcpy(t->text, p, t->len);
+        t->text[t->len] = '\0';
+        tokens[n++] = t;
+        p = *end ? end + 1 : end;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) total += tokens[i]->len;
+    arena_restore(arena, mark); /* 整个请求的内存一步释放 */
+    return total;
+}
+
+static void bench_arena(void) {
+    char input[ARENA_BENCH_TOKENS * 16];
+    size_t len = 0;
+    for (int i = 0; i < ARENA_BENCH_TOKENS / 2; i++) {
+        len += (size_t)snprintf(input + len, sizeof(input) - len, "key%d=value%d;", i, i * 7);
+    }
+
+    printf("\n[arena] 解析后整体丢弃 (%d 个请求, 每个约 %d 个 token)\n", ARENA_BENCH_REQUESTS,
+           ARENA_BENCH_TOKENS);
+
+    size_t total = 0;
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < ARENA_BENCH_REQUESTS; i++) total += parse_with_malloc(input);
+    double malloc_ns = (double)(bench_now_ns() - t0) / ARENA_BENCH_REQUESTS;
+
+    Arena arena;
+    arena_init(&arena, 0);
+    t0 = bench_now_ns();
+    for (int i = 0; i < ARENA_BENCH_REQUESTS; i++) total += parse_with_arena(&arena, input);
+    double arena_ns = (double)(bench_now_ns() - t0) / ARENA_BENCH_REQUESTS;
+    arena_destroy(&arena);
+    bench_sink = total;
+
+    printf("  malloc/realloc/free: %9.1f ns/请求\n", malloc_ns);
+    printf("  arena + mark/restore: %8.1f ns/请求  (加速 %.1fx)\n", arena_ns, malloc_ns / arena_ns);
+}
+
+/* ========================================================================== */
+/*                        动态数组：几何增长 vs 逐元素 realloc                */
+/* ========================================================================== */
+
+#define VEC_BENCH_LARGE       10000000 /* 一个大数组 push 的元素数 */
+#define VEC_BENCH_SMALL_COUNT 1000000  /* 小数组的个数 */
+#define VEC_BENCH_SMALL_LEN   8        /* 每个小数组的元素数，放得进内部缓冲区 */
+#define VEC_BENCH_CHUNK       1024     /* 批量追加时每批的元素数 */
+
+VEC_DEFINE(BenchIntVec, int, 16)
+
+/* 11_memory 的写法推广到每个元素：每 push 一次就 realloc 到刚好够用 */
+static int* naive_push(int* arr, size_t len, int value) {
+    int* fresh = (int*)realloc(arr, (len + 1) * sizeof(int));
+    if (!fresh) return arr;
+    fresh[len] = value;
+    return fresh;
+}
+
+static void bench_vec_large(void) {
+    uint64_t t0 = bench_now_ns();
+    int* naive = NULL;
+    for (size_t i = 0; i < VEC_BENCH_LARGE; i++) naive = naive_push(naive, i, (int)i);
+    double naive_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_LARGE;
+    bench_sink = (uintptr_t)naive[VEC_BENCH_LARGE - 1];
+
+    BenchIntVec v;
+    BenchIntVec_init(&v);
+    t0 = bench_now_ns();
+    for (int i = 0; i < VEC_BENCH_LARGE; i++) BenchIntVec_push(&v, i);
+    double push_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_LARGE;
+    BenchIntVec_free(&v);
+
+    BenchIntVec_init(&v);
+    t0 = bench_now_ns();
+    BenchIntVec_reserve(&v, VEC_BENCH_LARGE);
+    for (int i = 0; i < VEC_BENCH_LARGE; i++) BenchIntVec_push(&v, i);
+    double reserve_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_LARGE;
+    BenchIntVec_free(&v);
+
+    // 批量追加：源数据直接复用 naive 数组
+    BenchIntVec_init(&v);
+    t0 = bench_now_ns();
+    for (size_t i = 0; i < VEC_BENCH_LARGE; i += VEC_BENCH_CHUNK) {
+        size_t n = VEC_BENCH_LARGE - i < VEC_BENCH_CHUNK ? VEC_BENCH_LARGE - i : VEC_BENCH_CHUNK;
+        BenchIntVec_append(&v, naive + i, n);
+    }
+    double append_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_LARGE;
+    bench_sink = (uintptr_t)BenchIntVec_data(&v)[VEC_BENCH_LARGE - 1];
+    BenchIntVec_free(&v);
+    free(naive);
+
+    printf("  大数组 (%d 个 int):\n", VEC_BENCH_LARGE);
+    printf("    逐元素 realloc:   %6.2f ns/元素\n", naive_ns);
+    printf("    push (2 倍增长):  %6.2f ns/元素  (加速 %.1fx)\n", push_ns, naive_ns / push_ns);
+    printf("    reserve + push:   %6.2f ns/元素  (加速 %.1fx)\n", reserve_ns, naive_ns / reserve_ns);
+    printf("    append 每批 %d:  %6.2f ns/元素  (加速 %.1fx)\n", VEC_BENCH_CHUNK, append_ns,
+           naive_ns / append_ns);
+}
+
+static void bench_vec_small(void) {
+    size_t total = 0;
+    uint64_t t0 = bench_now_ns();
+    for (int n = 0; n < VEC_BENCH_SMALL_COUNT; n++) {
+        int* naive = NULL;
+        for (size_t i = 0; i < VEC_BENCH_SMALL_LEN; i++) naive = naive_push(naive, i, (int)i);
+        total += (size_t)naive[VEC_BENCH_SMALL_LEN - 1];
+        free(naive);
+    }
+    double naive_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_SMALL_COUNT;
+
+    t0 = bench_now_ns();
+    for (int n = 0; n < VEC_BENCH_SMALL_COUNT; n++) {
+        BenchIntVec v;
+        BenchIntVec_init(&v);
+        for (int i = 0; i < VEC_BENCH_SMALL_LEN; i++) BenchIntVec_push(&v, i);
+        total += (size_t)BenchIntVec_data(&v)[VEC_BENCH_SMALL_LEN - 1];
+        BenchIntVec_free(&v);
+    }
+    double vec_ns = (double)(bench_now_ns() - t0) / VEC_BENCH_SMALL_COUNT;
+    bench_sink = total;
+
+    printf("  小数组 (%d 个, 每个 %d 个 int):\n", VEC_BENCH_SMALL_COUNT, VEC_BENCH_SMALL_LEN);
+    printf("    逐元素 realloc:   %6.1f ns/数组\n", naive_ns);
+    printf("    内部缓冲区:       %6.1f ns/数组  (加速 %.1fx)\n", vec_ns, naive_ns / vec_ns);
+}
+
+static void bench_vec(void) {
+    printf("\n[vec] 动态数组 push 吞吐\n");
+    bench_vec_large();
+    bench_vec_small();
+}
+
+/* ========================================================================== */
+/*                   命令名查找：strcmp 逐个比较 vs 完美哈希                  */
+/* ========================================================================== */
+
+#define CMDHASH_BENCH_QUERIES 65536 /* 不同的查询串，放在一块连续的“报文”缓冲区里 */
+#define CMDHASH_BENCH_PASSES  4     /* 每轮把全部查询过几遍 */
+#define CMDHASH_BENCH_ROUNDS  5
+#define CMDHASH_BENCH_BATCH   64    /* 与 main.c 中 dispatch_many 的批大小一致 */
+
+static const char* const cmdhash_command_names[CMD_MAX] = {
+#define COMMAND_NAME(id, name) [id] = name,
+    COMMAND_LIST(COMMAND_NAME)
+#undef COMMAND_NAME
+};
+
+/* 改造前的做法：和每个命令名依次 strcmp */
+static int cmd_linear_find(const char* const* names, size_t count, const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+typedef struct {
+    const char* const* query;
+    const size_t* len;
+    size_t n;
+} CmdQueries;
+
+/* 方式 0：strcmp；1：逐条完美哈希；2：每 CMDHASH_BENCH_BATCH 条一次 cmd_hash_find_many */
+static uint64_t cmdhash_run(int mode, const CmdHashTable* table, const char* const* names,
+                            const CmdQueries* q) {
+    uint64_t sum = 0;
+    int ids[CMDHASH_BENCH_BATCH];
+    for (int pass = 0; pass < CMDHASH_BENCH_PASSES; pass++) {
+        if (mode == 0) {
+            for (size_t i = 0; i < q->n; i++) {
+                sum += (uint64_t)cmd_linear_find(names, table->count, q->query[i]);
+            }
+        } else if (mode == 1) {
+            for (size_t i = 0; i < q->n; i++) {
+                sum += (uint64_t)cmd_hash_find(table, q->query[i], q->len[i]);
+            }
+        } else {
+            for (size_t i = 0; i < q->n; i += CMDHASH_BENCH_BATCH) {
+                size_t m = q->n - i < CMDHASH_BENCH_BATCH ? q->n - i : CMDHASH_BENCH_BATCH;
+                cmd_hash_find_many(table, q->query + i, q->len + i, m, ids);
+                for (size_t k = 0; k < m; k++) sum += (uint64_t)ids[k];
+            }
+        }
+    }
+    return sum;
+}
+
+/* 所有命令名都应当查到自己的编号，改掉一个字符或多一个字符都应当查不到 */
+static bool cmdhash_verify(const CmdHashTable* table, const char* const* names) {
+    char buf[80];
+    for (size_t i = 0; i < table->count; i++) {
+        size_t len = strlen(names[i]);
+        if (len + 2 > sizeof(buf)) return false;
+        if (cmd_hash_find(table, names[i], len) != (int)i) return false;
+        memcpy(buf, names[i], len + 1);
+        buf[len - 1] ^= 0x20;
+        if (cmd_hash_find(table, buf, len) >= 0) return false;
+        buf[len - 1] ^= 0x20;
+        buf[len] = 's';
+        if (cmd_hash_find(table, buf, len + 1) >= 0) return false;
+    }
+    return true;
+}
+
+static void bench_cmdhash_set(const CmdHashTable* table, const char* const* names, char* wire,
+                              size_t wire_size, const char** query, size_t* len) {
+    /* 查询串拷贝进报文缓冲区：和表里的字符串地址不同，也不一定对齐 */
+    uint64_t seed = 7;
+    size_t used = 0;
+    for (size_t i = 0; i < CMDHASH_BENCH_QUERIES; i++) {
+        const char* name = names[bench_rand(&seed) % table->count];
+        size_t n = strlen(name);
+        if (used + n + 1 > wire_size) used = 0;
+        memcpy(wire + used, name, n + 1);
+        query[i] = wire + used;
+        len[i] = n;
+        used += n + 1;
+    }
+    CmdQueries q = {query, len, CMDHASH_BENCH_QUERIES};
+
+    double best[3] = {0, 0, 0};
+    uint64_t sums[3] = {0, 0, 0};
+    for (int r = 0; r < CMDHASH_BENCH_ROUNDS; r++) {
+        for (int mode = 0; mode < 3; mode++) {
+            uint64_t t0 = bench_now_ns();
+            sums[mode] = cmdhash_run(mode, table, names, &q);
+            double ns = (double)(bench_now_ns() - t0) /
+                        ((double)CMDHASH_BENCH_QUERIES * CMDHASH_BENCH_PASSES);
+            if (r == 0 || ns < best[mode]) best[mode] = ns;
+        }
+    }
+    bool ok = sums[0] == sums[1] && sums[1] == sums[2] && cmdhash_verify(table, names);
+    printf("  %6zu %17.2f %11.2f %16.2f %9.1fx%s\n", table->count, best[0], best[1], best[2],
+           best[0] / best[2], ok ? "" : "  (结果不一致!)");
+}
+
+static void bench_cmdhash(void) {
+    size_t wire_size = (size_t)CMDHASH_BENCH_QUERIES * 16;
+    char* wire = (char*)malloc(wire_size);
+    const char** query = (const char**)malloc(CMDHASH_BENCH_QUERIES * sizeof(const char*));
+    size_t* len = (size_t*)malloc(CMDHASH_BENCH_QUERIES * sizeof(size_t));
+    if (wire && query && len) {
+        printf("\n[cmdhash] 命令名 -> 编号，%d 条随机查询过 %d 遍，ns/次，取 %d 轮中最快的一轮\n",
+               CMDHASH_BENCH_QUERIES, CMDHASH_BENCH_PASSES, CMDHASH_BENCH_ROUNDS);
+        printf("  命令数   strcmp 逐个比较   完美哈希   批量 find_many    加速比\n");
+        bench_cmdhash_set(&cmd_hash_commands, cmdhash_command_names, wire, wire_size, query, len);
+        bench_cmdhash_set(&cmd_hash_bench50, cmd_bench50_names, wire, wire_size, query, len);
+        bench_cmdhash_set(&cmd_hash_bench500, cmd_bench500_names, wire, wire_size, query, len);
+        printf("  完美哈希的表由 tools/cmd_hash_gen.c 在构建时生成，查找时长度由报文给出\n");
+    }
+    free(wire);
+    free(query);
+    free(len);
+}
+
+/* ========================================================================== */
+/*                        分配追踪器的额外开销                                */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define TRACK_BENCH_LIVE 4096
+#define TRACK_BENCH_OPS  2000000
+
+/* rate = 0 表示直接调用 malloc/free 作为基线 */
+static double track_bench_run(unsigned rate) {
+    void* live[TRACK_BENCH_LIVE] = {0};
+    uint64_t seed = 7;
+    track_set_sample_rate(rate);
+
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < TRACK_BENCH_OPS; i++) {
+        size_t idx = (size_t)(bench_rand(&seed) % TRACK_BENCH_LIVE);
+        size_t size = 16 + (size_t)(i & 255);
+        if (rate == 0) {
+            free(live[idx]);
+            live[idx] = malloc(size);
+        } else {
+            track_free(live[idx]);
+            live[idx] = track_malloc(size, __FILE__, __LINE__);
+        }
+    }
+    double ns = (double)(bench_now_ns() - t0) / TRACK_BENCH_OPS;
+
+    for (size_t i = 0; i < TRACK_BENCH_LIVE; i++) {
+        if (rate == 0) free(live[i]);
+        else track_free(live[i]);
+    }
+    track_set_sample_rate(1);
+    return ns;
+}
+
+static void bench_track(void) {
+    printf("\n[track] 分配追踪开销 (%d 次 free+malloc, 存活 %d 个)\n", TRACK_BENCH_OPS,
+           TRACK_BENCH_LIVE);
+    double base = track_bench_run(0);
+    printf("  %-16s %7.1f ns/对\n", "malloc/free", base);
+    const unsigned rates[] = {1, 100};
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        double ns = track_bench_run(rates[i]);
+        printf("  追踪 采样 1/%-4u %7.1f ns/对  每次调用额外开销 %5.1f ns\n", rates[i], ns,
+               (ns - base) / 2);
+    }
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                        伪共享：紧凑块 vs 缓存行对齐块                      */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define FALSE_SHARE_OPS         50000000 /* 每个线程的自增次数 */
+#define FALSE_SHARE_MAX_THREADS 8
+
+typedef struct {
+    volatile uint64_t* counter; /* 线程独占的计数器，位于内存池的一个块里 */
+    atomic_int* ready;
+    atomic_bool* go;
+} FalseShareArg;
+
+static int false_share_worker(void* arg) {
+    FalseShareArg* a = (FalseShareArg*)arg;
+    atomic_fetch_add(a->ready, 1);
+    while (!atomic_load(a->go)) {
+    }
+    for (int i = 0; i < FALSE_SHARE_OPS; i++) (*a->counter)++;
+    return 0;
+}
+
+/* 每个线程从同一个池里拿一块做计数器，返回总耗时 (ns) */
+static uint64_t false_share_run(int nthreads, unsigned flags) {
+    MemPool* pool = pool_create_ex(sizeof(uint64_t), (size_t)nthreads, POOL_MODE_FREELIST, flags);
+    if (!pool) return 0;
+
+    atomic_int ready;
+    atomic_bool go;
+    atomic_init(&ready, 0);
+    atomic_init(&go, false);
+
+    thrd_t threads[FALSE_SHARE_MAX_THREADS];
+    FalseShareArg args[FALSE_SHARE_MAX_THREADS];
+    for (int i = 0; i < nthreads; i++) {
+        args[i] = (FalseShareArg){(volatile uint64_t*)pool_alloc(pool), &ready, &go};
+        *args[i].counter = 0;
+        thrd_create(&threads[i], false_share_worker, &args[i]);
+    }
+    while (atomic_load(&ready) < nthreads) {
+    }
+
+    uint64_t t0 = bench_now_ns();
+    atomic_store(&go, true);
+    for (int i = 0; i < nthreads; i++) thrd_join(threads[i], NULL);
+    uint64_t elapsed = bench_now_ns() - t0;
+
+    pool_destroy(pool);
+    return elapsed;
+}
+
+static void bench_false_share(void) {
+    int ncpu = bench_cpu_count();
+    int nthreads = ncpu < 2 ? 2 : ncpu > FALSE_SHARE_MAX_THREADS ? FALSE_SHARE_MAX_THREADS : ncpu;
+    printf("\n[falseshare] %d 个线程各自累加池中的一个 8 字节计数器 (每线程 %d 次)\n", nthreads,
+           FALSE_SHARE_OPS);
+    if (ncpu < 2) printf("  [提示] 只有 1 个 CPU，线程不会真正并行，看不到伪共享的代价\n");
+
+    uint64_t packed = false_share_run(nthreads, 0);
+    uint64_t padded = false_share_run(nthreads, POOL_FLAG_CACHE_ALIGN);
+    printf("  紧凑块 (8 字节相邻):        %8.1f ms\n", (double)packed / 1e6);
+    printf("  POOL_FLAG_CACHE_ALIGN (64): %8.1f ms  (加速 %.1fx)\n", (double)padded / 1e6,
+           (double)packed / (double)padded);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                     fork-join：工作窃取线程池 vs 每任务一个线程            */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define WS_FIB_N         32
+#define WS_FIB_CUTOFF    12        /* 小于它就串行计算，控制任务粒度 */
+#define WS_SUM_LEN       (1 << 24) /* 并行求和的元素数 */
+#define WS_SUM_CHUNK     4096      /* 每个任务求和的元素数 */
+
+static long fib_serial(int n) {
+    return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+typedef struct {
+    WsPool* pool;
+    int n;
+    long result;
+} FibArg;
+
+/* 左子树作为任务提交出去（可能被偷走），右子树自己算，然后等左边 */
+static void fib_ws_task(void* arg) {
+    FibArg* f = (FibArg*)arg;
+    if (f->n < WS_FIB_CUTOFF) {
+        f->result = fib_serial(f->n);
+        return;
+    }
+    FibArg left = {f->pool, f->n - 1, 0};
+    FibArg right = {f->pool, f->n - 2, 0};
+    WsWaitGroup wg;
+    ws_wait_group_init(&wg);
+    ws_submit(f->pool, &wg, fib_ws_task, &left);
+    fib_ws_task(&right);
+    ws_wait(f->pool, &wg);
+    f->result = left.result + right.result;
+}
+
+/* 同样的分解，但左子树每次都新建一个线程再 join（第五节演示的写法） */
+static int fib_thread_task(void* arg) {
+    FibArg* f = (FibArg*)arg;
+    if (f->n < WS_FIB_CUTOFF) {
+        f->result = fib_serial(f->n);
+        return 0;
+    }
+    FibArg left = {NULL, f->n - 1, 0};
+    FibArg right = {NULL, f->n - 2, 0};
+    thrd_t t;
+    bool spawned = thrd_create(&t, fib_thread_task, &left) == thrd_success;
+    fib_thread_task(&right);
+    if (spawned) thrd_join(t, NULL);
+    else fib_thread_task(&left);
+    f->result = left.result + right.result;
+    return 0;
+}
+
+typedef struct {
+    const uint32_t* data;
+    size_t len;
+    uint64_t sum;
+} SumArg;
+
+static void sum_ws_task(void* arg) {
+    SumArg* s = (SumArg*)arg;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < s->len; i++) sum += s->data[i];
+    s->sum = sum;
+}
+
+static int sum_thread_task(void* arg) {
+    sum_ws_task(arg);
+    return 0;
+}
+
+static void bench_ws_fib(WsPool* pool) {
+    uint64_t t0 = bench_now_ns();
+    long expect = fib_serial(WS_FIB_N);
+    double serial_ms = (double)(bench_now_ns() - t0) / 1e6;
+
+    FibArg root = {pool, WS_FIB_N, 0};
+    t0 = bench_now_ns();
+    fib_ws_task(&root);
+    double ws_ms = (double)(bench_now_ns() - t0) / 1e6;
+    bool ws_ok = root.result == expect;
+
+    root = (FibArg){NULL, WS_FIB_N, 0};
+    t0 = bench_now_ns();
+    fib_thread_task(&root);
+    double thread_ms = (double)(bench_now_ns() - t0) / 1e6;
+    bool thread_ok = root.result == expect;
+
+    printf("  fib(%d), 粒度阈值 %d:\n", WS_FIB_N, WS_FIB_CUTOFF);
+    printf("    串行:             %8.1f ms\n", serial_ms);
+    printf("    工作窃取线程池:   %8.1f ms%s\n", ws_ms, ws_ok ? "" : "  (结果错误!)");
+    printf("    每任务一个线程:   %8.1f ms%s  (线程池快 %.1fx)\n", thread_ms,
+           thread_ok ? "" : "  (结果错误!)", thread_ms / ws_ms);
+}
+
+static void bench_ws_sum(WsPool* pool) {
+    uint32_t* data = (uint32_t*)malloc(WS_SUM_LEN * sizeof(uint32_t));
+    const size_t nchunks = WS_SUM_LEN / WS_SUM_CHUNK;
+    SumArg* args = (SumArg*)malloc(nchunks * sizeof(SumArg));
+    if (!data || !args) {
+        free(data);
+        free(args);
+        return;
+    }
+    uint64_t seed = 42, expect = 0;
+    for (size_t i = 0; i < WS_SUM_LEN; i++) {
+        data[i] = (uint32_t)bench_rand(&seed);
+        expect += data[i];
+    }
+    for (size_t i = 0; i < nchunks; i++) args[i] = (SumArg){data + i * WS_SUM_CHUNK, WS_SUM_CHUNK, 0};
+
+    uint64_t t0 = bench_now_ns();
+    WsWaitGroup wg;
+    ws_wait_group_init(&wg);
+    for (size_t i = 0; i < nchunks; i++) ws_submit(pool, &wg, sum_ws_task, &args[i]);
+    ws_wait(pool, &wg);
+    uint64_t total = 0;
+    for (size_t i = 0; i < nchunks; i++) total += args[i].sum;
+    double ws_ms = (double)(bench_now_ns() - t0) / 1e6;
+    bool ws_ok = total == expect;
+
+    // 每个块一个线程，同时最多 ws_pool_size 个在跑
+    int batch = ws_pool_size(pool);
+    thrd_t threads[MT_BENCH_MAX_THREADS];
+    if (batch > MT_BENCH_MAX_THREADS) batch = MT_BENCH_MAX_THREADS;
+    t0 = bench_now_ns();
+    for (size_t i = 0; i < nchunks; i += (size_t)batch) {
+        size_t n = nchunks - i < (size_t)batch ? nchunks - i : (size_t)batch;
+        for (size_t j = 0; j < n; j++) thrd_create(&threads[j], sum_thread_task, &args[i + j]);
+        for (size_t j = 0; j < n; j++) thrd_join(threads[j], NULL);
+    }
+    total = 0;
+    for (size_t i = 0; i < nchunks; i++) total += args[i].sum;
+    double thread_ms = (double)(bench_now_ns() - t0) / 1e6;
+    bool thread_ok = total == expect;
+
+    printf("  并行求和 %d 个 uint32, 每任务 %d 个 (%zu 个任务):\n", WS_SUM_LEN, WS_SUM_CHUNK, nchunks);
+    printf("    工作窃取线程池:   %8.1f ms%s\n", ws_ms, ws_ok ? "" : "  (结果错误!)");
+    printf("    每任务一个线程:   %8.1f ms%s  (线程池快 %.1fx)\n", thread_ms,
+           thread_ok ? "" : "  (结果错误!)", thread_ms / ws_ms);
+    free(args);
+    free(data);
+}
+
+static void bench_ws(void) {
+    WsPool* pool = ws_pool_create(0);
+    if (!pool) return;
+    printf("\n[ws] fork-join 任务 (%d 个工作线程)\n", ws_pool_size(pool));
+    bench_ws_fib(pool);
+    bench_ws_sum(pool);
+    ws_pool_destroy(pool);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                      数据并行：parallel_for / parallel_reduce               */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define PAR_BENCH_LEN    100000000u /* 10^8 个 uint32，约 400MB */
+#define PAR_BENCH_SAMPLE (1u << 20) /* 前缀和每隔这么多个元素抽查一次 */
+
+/* 由下标直接算出元素值，填充本身也能并行，不需要共享随机数状态 */
+static uint32_t par_value(size_t i) {
+    uint64_t x = (uint64_t)i * 0x9E3779B97F4A7C15u;
+    return (uint32_t)((x ^ (x >> 29)) % 1000u);
+}
+
+static void par_fill(size_t begin, size_t end, void* ctx) {
+    uint32_t* data = (uint32_t*)ctx;
+    for (size_t i = begin; i < end; i++) data[i] = par_value(i);
+}
+
+/* 访存密集：整数求和 */
+static void par_sum_body(size_t begin, size_t end, void* acc, void* ctx) {
+    const uint32_t* data = (const uint32_t*)ctx;
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; i++) sum += data[i];
+    *(uint64_t*)acc += sum;
+}
+
+static void par_sum_combine(void* acc, const void* other, void* ctx) {
+    (void)ctx;
+    *(uint64_t*)acc += *(const uint64_t*)other;
+}
+
+/* 计算密集：对每个元素求一个多项式再按 double 累加，结果与累加顺序有关 */
+static double par_poly(uint32_t v) {
+    double x = v * 0.001;
+    double y = 0.0;
+    for (int k = 0; k < 8; k++) y = y * x + 1.0 / (k + 1);
+    return y;
+}
+
+static void par_poly_body(size_t begin, size_t end, void* acc, void* ctx) {
+    const uint32_t* data = (const uint32_t*)ctx;
+    double sum = 0.0;
+    for (size_t i = begin; i < end; i++) sum += par_poly(data[i]);
+    *(double*)acc += sum;
+}
+
+static void par_poly_combine(void* acc, const void* other, void* ctx) {
+    (void)ctx;
+    *(double*)acc += *(const double*)other;
+}
+
+/* 两遍扫描的前缀和：第一遍各块求和，串行算出每块的起始偏移，第二遍各块独立地写前缀和 */
+typedef struct {
+    uint32_t* data;
+    uint32_t* block_offset;
+    size_t grain;
+} ParScan;
+
+static void par_scan_block_sum(size_t begin, size_t end, void* ctx) {
+    ParScan* sc = (ParScan*)ctx;
+    uint32_t sum = 0; /* 按 2^32 取模，与串行版本的回绕一致 */
+    for (size_t i = begin; i < end; i++) sum += sc->data[i];
+    sc->block_offset[begin / sc->grain] = sum;
+}
+
+static void par_scan_block_apply(size_t begin, size_t end, void* ctx) {
+    ParScan* sc = (ParScan*)ctx;
+    uint32_t run = sc->block_offset[begin / sc->grain];
+    for (size_t i = begin; i < end; i++) {
+        run += sc->data[i];
+        sc->data[i] = run;
+    }
+}
+
+static bool par_scan(uint32_t* data, size_t n) {
+    size_t grain = parallel_grain(n, 0, 0);
+    size_t nblocks = (n - 1) / grain + 1;
+    ParScan sc = {data, (uint32_t*)malloc(nblocks * sizeof(uint32_t)), grain};
+    if (!sc.block_offset) return false;
+    parallel_for(0, n, grain, par_scan_block_sum, &sc);
+    uint32_t run = 0;
+    for (size_t b = 0; b < nblocks; b++) {
+        uint32_t block_sum = sc.block_offset[b];
+        sc.block_offset[b] = run; /* 改成块之前所有元素的和 */
+        run += block_sum;
+    }
+    parallel_for(0, n, grain, par_scan_block_apply, &sc);
+    free(sc.block_offset);
+    return true;
+}
+
+typedef struct {
+    double sum_ms;
+    double poly_ms;
+    double poly_det_ms;
+    double scan_ms;
+    uint64_t sum;
+    double poly;
+    double poly_det;
+    bool scan_ok;
+} ParBenchResult;
+
+/* 在当前线程池配置下跑一遍 */
+static ParBenchResult par_bench_once(uint32_t* data, const uint32_t* samples) {
+    ParBenchResult r = {0};
+    parallel_for(0, PAR_BENCH_LEN, 0, par_fill, data);
+
+    uint64_t t0 = bench_now_ns();
+    parallel_reduce(0, PAR_BENCH_LEN, 0, &r.sum, sizeof(r.sum), par_sum_body, par_sum_combine,
+                    data, 0);
+    r.sum_ms = (double)(bench_now_ns() - t0) / 1e6;
+
+    t0 = bench_now_ns();
+    parallel_reduce(0, PAR_BENCH_LEN, 0, &r.poly, sizeof(r.poly), par_poly_body,
+                    par_poly_combine, data, 0);
+    r.poly_ms = (double)(bench_now_ns() - t0) / 1e6;
+
+    t0 = bench_now_ns();
+    parallel_reduce(0, PAR_BENCH_LEN, 0, &r.poly_det, sizeof(r.poly_det), par_poly_body,
+                    par_poly_combine, data, PARALLEL_DETERMINISTIC);
+    r.poly_det_ms = (double)(bench_now_ns() - t0) / 1e6;
+
+    t0 = bench_now_ns();
+    r.scan_ok = par_scan(data, PAR_BENCH_LEN);
+    r.scan_ms = (double)(bench_now_ns() - t0) / 1e6;
+    for (size_t i = 0; r.scan_ok && i < PAR_BENCH_LEN / PAR_BENCH_SAMPLE; i++) {
+        r.scan_ok = data[i * PAR_BENCH_SAMPLE] == samples[i];
+    }
+    return r;
+}
+
+static void bench_parallel(void) {
+    uint32_t* data = (uint32_t*)malloc((size_t)PAR_BENCH_LEN * sizeof(uint32_t));
+    uint32_t* samples = (uint32_t*)malloc(PAR_BENCH_LEN / PAR_BENCH_SAMPLE * sizeof(uint32_t));
+    if (!data || !samples) {
+        printf("\n[parallel] 内存不足，跳过\n");
+        free(data);
+        free(samples);
+        return;
+    }
+    // 串行前缀和的抽查点
+    uint32_t run = 0;
+    for (size_t i = 0; i < PAR_BENCH_LEN; i++) {
+        run += par_value(i);
+        if (i % PAR_BENCH_SAMPLE == 0) samples[i / PAR_BENCH_SAMPLE] = run;
+    }
+
+    int ncpu = bench_cpu_count();
+    printf("\n[parallel] %u 个 uint32 (%d 个 CPU)，单位 ms，括号内为相对串行的加速比\n",
+           PAR_BENCH_LEN, ncpu);
+    printf("  线程数   求和(访存)          多项式(计算)        多项式-确定性       前缀和\n");
+
+    // 串行基线：不经过 parallel_*，直接调用同样的循环体
+    ParBenchResult base = {0};
+    par_fill(0, PAR_BENCH_LEN, data);
+    uint64_t t0 = bench_now_ns();
+    par_sum_body(0, PAR_BENCH_LEN, &base.sum, data);
+    base.sum_ms = (double)(bench_now_ns() - t0) / 1e6;
+    t0 = bench_now_ns();
+    par_poly_body(0, PAR_BENCH_LEN, &base.poly, data);
+    base.poly_ms = (double)(bench_now_ns() - t0) / 1e6;
+    t0 = bench_now_ns();
+    run = 0;
+    for (size_t i = 0; i < PAR_BENCH_LEN; i++) data[i] = run += data[i];
+    base.scan_ms = (double)(bench_now_ns() - t0) / 1e6;
+    printf("  串行   %7.1f            %7.1f            %7s            %7.1f\n", base.sum_ms,
+           base.poly_ms, "-", base.scan_ms);
+    printf("         多项式和: %.17g\n", base.poly);
+
+    int max_threads = ncpu > 2 ? ncpu : 2; /* 单核机器上也跑 2 线程，观察调度开销 */
+    for (int threads = 2; threads <= max_threads; threads *= 2) {
+        WsPool* pool = ws_pool_create(threads - 1); /* 调用线程也算一个 */
+        if (!pool) break;
+        parallel_set_pool(pool);
+        ParBenchResult r = par_bench_once(data, samples);
+        parallel_set_pool(NULL);
+        ws_pool_destroy(pool);
+
+        bool ok = r.sum == base.sum && r.scan_ok;
+        printf("  %4d   %7.1f (%4.2fx)    %7.1f (%4.2fx)    %7.1f (%4.2fx)    %7.1f (%4.2fx)%s\n",
+               threads, r.sum_ms, base.sum_ms / r.sum_ms, r.poly_ms, base.poly_ms / r.poly_ms,
+               r.poly_det_ms, base.poly_ms / r.poly_det_ms, r.scan_ms, base.scan_ms / r.scan_ms,
+               ok ? "" : "  (结果错误!)");
+        printf("         多项式和: 默认 %.17g, 确定性 %.17g\n", r.poly, r.poly_det);
+    }
+    printf("  确定性模式按 %d 块切分并按下标合并，不同线程数下的结果逐位相同；\n"
+           "  默认模式的合并顺序取决于调度，最后几位可能不同。\n",
+           PARALLEL_DETERMINISTIC_CHUNKS);
+    free(samples);
+    free(data);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                      计数器竞争：自旋锁 vs 单个原子量 vs 分片               */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define COUNTER_BENCH_OPS 5000000 /* 每个线程的自增次数 */
+
+typedef enum { COUNTER_SPINLOCK, COUNTER_ATOMIC, COUNTER_SHARDED } CounterKind;
+
+/* main.c 早期的 ThreadSafeCounter：自旋锁 + fetch_add */
+typedef struct {
+    atomic_int counter;
+    atomic_flag lock;
+} SpinCounter;
+
+typedef struct {
+    CounterKind kind;
+    SpinCounter* spin;
+    atomic_long* single;
+    ShardedCounter* sharded;
+    atomic_int* ready;
+    atomic_bool* go;
+} CounterBenchArg;
+
+static int counter_bench_worker(void* arg) {
+    CounterBenchArg* a = (CounterBenchArg*)arg;
+    atomic_fetch_add(a->ready, 1);
+    while (!atomic_load(a->go)) {
+    }
+    for (int i = 0; i < COUNTER_BENCH_OPS; i++) {
+        switch (a->kind) {
+            case COUNTER_SPINLOCK:
+                while (atomic_flag_test_and_set(&a->spin->lock)) {
+                }
+                atomic_fetch_add(&a->spin->counter, 1);
+                atomic_flag_clear(&a->spin->lock);
+                break;
+            case COUNTER_ATOMIC:
+                atomic_fetch_add_explicit(a->single, 1, memory_order_relaxed);
+                break;
+            case COUNTER_SHARDED:
+                sharded_counter_inc(a->sharded);
+                break;
+        }
+    }
+    return 0;
+}
+
+/* 返回每秒百万次自增；结果不等于期望值时返回负数 */
+static double counter_bench_run(CounterKind kind, int nthreads) {
+    SpinCounter spin;
+    atomic_init(&spin.counter, 0);
+    atomic_flag_clear(&spin.lock);
+    _Alignas(CACHE_LINE_SIZE) atomic_long single;
+    atomic_init(&single, 0);
+    ShardedCounter* sharded = (ShardedCounter*)mem_alloc_cacheline(sizeof(ShardedCounter));
+    if (!sharded) return 0;
+    sharded_counter_init(sharded);
+
+    atomic_int ready;
+    atomic_bool go;
+    atomic_init(&ready, 0);
+    atomic_init(&go, false);
+
+    thrd_t threads[MT_BENCH_MAX_THREADS];
+    CounterBenchArg args[MT_BENCH_MAX_THREADS];
+    for (int i = 0; i < nthreads; i++) {
+        args[i] = (CounterBenchArg){kind, &spin, &single, sharded, &ready, &go};
+        thrd_create(&threads[i], counter_bench_worker, &args[i]);
+    }
+    while (atomic_load(&ready) < nthreads) {
+    }
+    uint64_t t0 = bench_now_ns();
+    atomic_store(&go, true);
+    for (int i = 0; i < nthreads; i++) thrd_join(threads[i], NULL);
+    uint64_t elapsed = bench_now_ns() - t0;
+
+    long expect = (long)nthreads * COUNTER_BENCH_OPS;
+    long got = kind == COUNTER_SPINLOCK ? atomic_load(&spin.counter)
+               : kind == COUNTER_ATOMIC ? atomic_load(&single)
+                                        : sharded_counter_read(sharded);
+    mem_aligned_free(sharded);
+    double mops = (double)expect / ((double)elapsed / 1e3);
+    return got == expect ? mops : -mops;
+}
+
+static void bench_counter(void) {
+    int max_threads = bench_cpu_count();
+    if (max_threads < 4) max_threads = 4; /* 单核机器上也看看多线程抢锁的代价 */
+    if (max_threads > MT_BENCH_MAX_THREADS) max_threads = MT_BENCH_MAX_THREADS;
+    printf("\n[counter] 多线程自增吞吐 (M 次/秒, 每线程 %d 次)\n", COUNTER_BENCH_OPS);
+    printf("  线程数   自旋锁+原子量  单个原子量   分片计数器\n");
+    for (int n = 1; n <= max_threads; n *= 2) {
+        printf("  %4d", n);
+        const CounterKind kinds[] = {COUNTER_SPINLOCK, COUNTER_ATOMIC, COUNTER_SHARDED};
+        for (int k = 0; k < 3; k++) {
+            double mops = counter_bench_run(kinds[k], n);
+            if (mops < 0) printf("   %10s", "结果错误");
+            else printf("   %10.1f", mops);
+        }
+        printf("\n");
+    }
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                      无锁环形队列：消息速率与 p99 延迟                     */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define QUEUE_BENCH_MESSAGES (1 << 21) /* 每种配置传递的消息总数 */
+#define QUEUE_BENCH_CAPACITY 1024
+#define QUEUE_BENCH_SAMPLE   64 /* 每 64 条消息带一个发送时间戳，用于统计延迟 */
+#define QUEUE_BENCH_MAX_SIDE 64 /* 生产者/消费者各自的最大线程数 */
+
+typedef struct {
+    bool spsc;
+    MpmcQueue* mpmc;
+    SpscQueue* spsc_q;
+    size_t batch;     /* 1 表示逐条收发 */
+    size_t count;     /* 本线程要发送/接收的消息数 */
+    uint64_t* lat;    /* 消费者：延迟样本 (ns) */
+    size_t lat_count;
+    atomic_int* ready;
+    atomic_bool* go;
+} QueueBenchArg;
+
+static int queue_wait_start(QueueBenchArg* a) {
+    atomic_fetch_add(a->ready, 1);
+    while (!atomic_load(a->go)) {
+    }
+    return 0;
+}
+
+static int queue_producer(void* arg) {
+    QueueBenchArg* a = (QueueBenchArg*)arg;
+    void* items[64];
+    queue_wait_start(a);
+    for (size_t sent = 0; sent < a->count;) {
+        size_t n = a->count - sent < a->batch ? a->count - sent : a->batch;
+        for (size_t i = 0; i < n; i++) {
+            bool sample = (sent + i) % QUEUE_BENCH_SAMPLE == 0;
+            items[i] = sample ? (void*)(uintptr_t)bench_now_ns() : NULL;
+        }
+        for (size_t done = 0; done < n;) {
+            size_t k = a->spsc ? spsc_push_batch(a->spsc_q, items + done, n - done)
+                               : mpmc_push_batch(a->mpmc, items + done, n - done);
+            if (!k) thrd_yield(); /* 队列满：单核机器上必须让出 CPU 给消费者 */
+            done += k;
+        }
+        sent += n;
+    }
+    return 0;
+}
+
+static int queue_consumer(void* arg) {
+    QueueBenchArg* a = (QueueBenchArg*)arg;
+    void* items[64];
+    queue_wait_start(a);
+    for (size_t got = 0; got < a->count;) {
+        size_t want = a->count - got < a->batch ? a->count - got : a->batch;
+        size_t k = a->spsc ? spsc_pop_batch(a->spsc_q, items, want)
+                           : mpmc_pop_batch(a->mpmc, items, want);
+        if (!k) {
+            thrd_yield();
+            continue;
+        }
+        uint64_t now = 0;
+        for (size_t i = 0; i < k; i++) {
+            if (!items[i]) continue;
+            if (!now) now = bench_now_ns();
+            a->lat[a->lat_count++] = now - (uint64_t)(uintptr_t)items[i];
+        }
+        got += k;
+    }
+    return 0;
+}
+
+static int cmp_u64(const void* x, const void* y) {
+    uint64_t a = *(const uint64_t*)x, b = *(const uint64_t*)y;
+    return (a > b) - (a < b);
+}
+
+static void queue_bench_one(const char* label, bool spsc, int producers, int consumers,
+                            size_t batch) {
+    MpmcQueue mpmc;
+    SpscQueue spsc_q;
+    if (spsc ? !spsc_init(&spsc_q, QUEUE_BENCH_CAPACITY) : !mpmc_init(&mpmc, QUEUE_BENCH_CAPACITY)) {
+        return;
+    }
+    // 每个消费者收到的带时间戳消息不会超过它收到的消息数，按总消息数分配一块共用
+    uint64_t* lat = (uint64_t*)malloc(QUEUE_BENCH_MESSAGES * sizeof(uint64_t));
+    if (!lat) {
+        if (spsc) spsc_destroy(&spsc_q);
+        else mpmc_destroy(&mpmc);
+        return;
+    }
+    atomic_int ready;
+    atomic_bool go;
+    atomic_init(&ready, 0);
+    atomic_init(&go, false);
+
+    // 消息平均分给生产者和消费者，余数给第一个
+    QueueBenchArg args[2 * QUEUE_BENCH_MAX_SIDE];
+    thrd_t threads[2 * QUEUE_BENCH_MAX_SIDE];
+    int nthreads = producers + consumers;
+    size_t lat_offset = 0;
+    for (int i = 0; i < nthreads; i++) {
+        bool is_producer = i < producers;
+        int side = is_producer ? producers : consumers;
+        int idx = is_producer ? i : i - producers;
+        size_t count = QUEUE_BENCH_MESSAGES / (size_t)side;
+        if (idx == 0) count += QUEUE_BENCH_MESSAGES % (size_t)side;
+        args[i] = (QueueBenchArg){spsc, &mpmc, &spsc_q, batch, count, NULL, 0, &ready, &go};
+        if (!is_producer) {
+            args[i].lat = lat + lat_offset;
+            lat_offset += count;
+        }
+        thrd_create(&threads[i], is_producer ? queue_producer : queue_consumer, &args[i]);
+    }
+    while (atomic_load(&ready) < nthreads) {
+    }
+    uint64_t t0 = bench_now_ns();
+    atomic_store(&go, true);
+    for (int i = 0; i < nthreads; i++) thrd_join(threads[i], NULL);
+    double elapsed = (double)(bench_now_ns() - t0);
+
+    // 把各消费者的样本挪到一起再排序取分位数
+    size_t samples = 0;
+    for (int i = producers; i < nthreads; i++) {
+        memmove(lat + samples, args[i].lat, args[i].lat_count * sizeof(uint64_t));
+        samples += args[i].lat_count;
+    }
+    qsort(lat, samples, sizeof(uint64_t), cmp_u64);
+    double p50 = samples ? (double)lat[samples / 2] / 1e3 : 0;
+    double p99 = samples ? (double)lat[samples * 99 / 100] / 1e3 : 0;
+
+    printf("  %-22s %dP%dC  %7.2f M 条/秒  p50 %9.1f us  p99 %9.1f us\n", label, producers,
+           consumers, QUEUE_BENCH_MESSAGES / (elapsed / 1e3), p50, p99);
+    free(lat);
+    if (spsc) spsc_destroy(&spsc_q);
+    else mpmc_destroy(&mpmc);
+}
+
+static void bench_queue(void) {
+    int n = bench_cpu_count();
+    if (n < 2) n = 2;
+    if (n > QUEUE_BENCH_MAX_SIDE) n = QUEUE_BENCH_MAX_SIDE;
+    printf("\n[queue] 有界无锁队列 (容量 %d, 共 %d 条消息)\n", QUEUE_BENCH_CAPACITY,
+           QUEUE_BENCH_MESSAGES);
+    if (bench_cpu_count() < 2) {
+        printf("  [提示] 只有 1 个 CPU，生产者和消费者轮流运行，延迟反映的是调度时间片\n");
+    }
+    queue_bench_one("SPSC", true, 1, 1, 1);
+    queue_bench_one("SPSC batch 32", true, 1, 1, 32);
+    queue_bench_one("MPMC", false, 1, 1, 1);
+    queue_bench_one("MPMC", false, 4, 4, 1);
+    queue_bench_one("MPMC batch 32", false, 4, 4, 32);
+    queue_bench_one("MPMC", false, n, n, 1);
+    queue_bench_one("MPMC batch 32", false, n, n, 32);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                  命令队列：同步 dispatch vs 多线程成批执行                  */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define CMDQ_BENCH_IO_CMDS  2000
+#define CMDQ_BENCH_IO_US    50    /* 模拟 I/O 的命令每条阻塞 50us */
+#define CMDQ_BENCH_TYPES    64
+#define CMDQ_BENCH_TABLE    16384 /* 每种命令一张 64KB 的表，64 种共 4MB，超过 L2 */
+#define CMDQ_BENCH_STEPS    1024  /* 每条命令在自己的表里做多少次相互依赖的读 */
+#define CMDQ_BENCH_CPU_CMDS 20000
+#define CMDQ_BENCH_KEYS     1024
+
+/* 模拟等 I/O 的 load/save：线程阻塞，不占 CPU */
+static void cmdq_bench_io(const char* args) {
+    (void)args;
+    struct timespec ts = {0, CMDQ_BENCH_IO_US * 1000};
+    thrd_sleep(&ts, NULL);
+}
+
+/* nworkers 为 0 时在当前线程上逐条同步执行，相当于 dispatch；返回总耗时 (ms) */
+static double cmdq_bench_io_run(int nworkers, bool report) {
+    static const CmdQueueHandler table[2] = {cmdq_bench_io, cmdq_bench_io};
+    static const char* const names[2] = {"load", "save"};
+    uint64_t t0 = bench_now_ns();
+    if (nworkers == 0) {
+        for (int i = 0; i < CMDQ_BENCH_IO_CMDS; i++) table[i & 1]("file");
+        return (double)(bench_now_ns() - t0) / 1e6;
+    }
+    // I/O 型命令执行时间远大于取队列的开销，批小一些让记录分散到更多线程上
+    CmdQueueOptions opts = {.nworkers = nworkers, .batch = 4, .group_by_type = true};
+    CmdQueue* q = cmd_queue_create(table, 2, &opts);
+    if (!q) return 0;
+    for (int i = 0; i < CMDQ_BENCH_IO_CMDS; i++) {
+        CmdRequest req = {i & 1, "file", 0, NULL, NULL};
+        cmd_queue_submit(q, &req);
+    }
+    cmd_queue_wait(q);
+    double ms = (double)(bench_now_ns() - t0) / 1e6;
+    if (report) cmd_queue_report(q, names, stdout);
+    cmd_queue_destroy(q);
+    return ms;
+}
+
+/* args 不一定是文本：这里直接指向该类型命令自己的表，表里是一个随机的环 */
+static void cmdq_bench_chase(const char* args) {
+    const uint32_t* next = (const uint32_t*)(const void*)args;
+    uint32_t i = 0;
+    for (int s = 0; s < CMDQ_BENCH_STEPS; s++) i = next[i];
+    bench_sink += i;
+}
+
+typedef struct {
+    const uint32_t* tables;
+    const uint8_t* type; /* 第 i 条命令的类型 */
+    uint32_t* last;      /* 每个 key 最近完成的命令序号 + 1，用于检查顺序 */
+    uint32_t* index;     /* index[i] == i，作为完成回调的 user */
+    long disorder;
+} CmdqCpuBench;
+
+static CmdqCpuBench cmdq_cpu;
+
+static void cmdq_bench_check_order(int cmd, const char* args, void* user) {
+    (void)cmd;
+    (void)args;
+    uint32_t i = *(const uint32_t*)user;
+    uint32_t k = i % CMDQ_BENCH_KEYS;
+    if (cmdq_cpu.last[k] > i) cmdq_cpu.disorder++;
+    cmdq_cpu.last[k] = i + 1;
+}
+
+/* mode: 0 同步逐条，1 队列不分组，2 队列按类型分组，3 分组 + 按 key 保序；返回 ns/条 */
+static double cmdq_bench_cpu_run(int mode, double* groups_per_batch) {
+    CmdQueueHandler table[CMDQ_BENCH_TYPES];
+    for (int t = 0; t < CMDQ_BENCH_TYPES; t++) table[t] = cmdq_bench_chase;
+    const char* args[CMDQ_BENCH_TYPES];
+    for (int t = 0; t < CMDQ_BENCH_TYPES; t++) {
+        args[t] = (const char*)(const void*)(cmdq_cpu.tables + (size_t)t * CMDQ_BENCH_TABLE);
+    }
+    uint64_t t0 = bench_now_ns();
+    if (mode == 0) {
+        for (int i = 0; i < CMDQ_BENCH_CPU_CMDS; i++) {
+            table[cmdq_cpu.type[i]](args[cmdq_cpu.type[i]]);
+        }
+        return (double)(bench_now_ns() - t0) / CMDQ_BENCH_CPU_CMDS;
+    }
+    // 这一项看的是缓存命中，只用 1 个工作线程，和同步执行比的是同一个核上的执行顺序
+    CmdQueueOptions opts = {.nworkers = 1, .batch = CMDQ_MAX_BATCH, .group_by_type = mode >= 2};
+    CmdQueue* q = cmd_queue_create(table, CMDQ_BENCH_TYPES, &opts);
+    if (!q) return 0;
+    memset(cmdq_cpu.last, 0, CMDQ_BENCH_KEYS * sizeof(uint32_t));
+    cmdq_cpu.disorder = 0;
+    for (uint32_t i = 0; i < CMDQ_BENCH_CPU_CMDS; i++) {
+        int t = cmdq_cpu.type[i];
+        CmdRequest req = {t, args[t], 0, NULL, NULL};
+        if (mode == 3) {
+            req.key = i % CMDQ_BENCH_KEYS + 1;
+            req.done = cmdq_bench_check_order;
+            req.user = &cmdq_cpu.index[i];
+        }
+        cmd_queue_submit(q, &req);
+    }
+    cmd_queue_wait(q);
+    double ns = (double)(bench_now_ns() - t0) / CMDQ_BENCH_CPU_CMDS;
+    CmdQueueStats st = cmd_queue_stats(q);
+    *groups_per_batch = st.batches ? (double)st.groups / (double)st.batches : 0;
+    cmd_queue_destroy(q);
+    return ns;
+}
+
+static void bench_cmdqueue(void) {
+    printf("\n[cmdqueue] 命令队列\n");
+    printf("  I/O 型：%d 条 load/save，每条阻塞 %dus\n", CMDQ_BENCH_IO_CMDS, CMDQ_BENCH_IO_US);
+    double sync_ms = cmdq_bench_io_run(0, false);
+    printf("    同步 dispatch        %9.1f ms\n", sync_ms);
+    static const int workers[] = {1, 4, 16, 64};
+    for (size_t i = 0; i < sizeof(workers) / sizeof(workers[0]); i++) {
+        double ms = cmdq_bench_io_run(workers[i], false);
+        printf("    队列 %2d 个工作线程   %9.1f ms  %6.1fx\n", workers[i], ms, sync_ms / ms);
+    }
+    printf("  16 个工作线程时各命令的耗时分布：\n");
+    cmdq_bench_io_run(16, true);
+
+    size_t table_words = (size_t)CMDQ_BENCH_TYPES * CMDQ_BENCH_TABLE;
+    uint32_t* tables = (uint32_t*)malloc(table_words * sizeof(uint32_t));
+    uint8_t* type = (uint8_t*)malloc(CMDQ_BENCH_CPU_CMDS);
+    cmdq_cpu.last = (uint32_t*)malloc(CMDQ_BENCH_KEYS * sizeof(uint32_t));
+    cmdq_cpu.index = (uint32_t*)malloc(CMDQ_BENCH_CPU_CMDS * sizeof(uint32_t));
+    if (tables && type && cmdq_cpu.last && cmdq_cpu.index) {
+        // Sattolo 洗牌：每张表是一个长度为 CMDQ_BENCH_TABLE 的环，读取顺序无法预取
+        uint64_t seed = 7;
+        for (int t = 0; t < CMDQ_BENCH_TYPES; t++) {
+            uint32_t* next = tables + (size_t)t * CMDQ_BENCH_TABLE;
+            for (uint32_t i = 0; i < CMDQ_BENCH_TABLE; i++) next[i] = i;
+            for (uint32_t i = CMDQ_BENCH_TABLE - 1; i > 0; i--) {
+                uint32_t j = (uint32_t)(bench_rand(&seed) % i);
+                uint32_t tmp = next[i];
+                next[i] = next[j];
+                next[j] = tmp;
+            }
+        }
+        for (uint32_t i = 0; i < CMDQ_BENCH_CPU_CMDS; i++) {
+            type[i] = (uint8_t)(bench_rand(&seed) % CMDQ_BENCH_TYPES);
+            cmdq_cpu.index[i] = i;
+        }
+        cmdq_cpu.tables = tables;
+        cmdq_cpu.type = type;
+
+        printf("  CPU 型：%d 种命令随机交错，每种读自己的 %dKB 表，%d 条，1 个工作线程，每批 %d 条\n",
+               CMDQ_BENCH_TYPES, CMDQ_BENCH_TABLE * 4 / 1024, CMDQ_BENCH_CPU_CMDS,
+               CMDQ_MAX_BATCH);
+        static const char* const labels[] = {"同步 dispatch       ", "队列，不分组        ",
+                                             "队列，按类型分组    ", "分组 + 按 key 保序  "};
+        double base = 0;
+        for (int mode = 0; mode < 4; mode++) {
+            double groups = 0;
+            double ns = cmdq_bench_cpu_run(mode, &groups);
+            if (mode == 0) base = ns;
+            printf("    %s %9.0f ns/条  %5.2fx", labels[mode], ns, base / ns);
+            if (mode > 0) printf("  每批 %5.1f 段", groups);
+            if (mode == 3) printf("  顺序%s", cmdq_cpu.disorder ? "错乱!" : "正确");
+            printf("\n");
+        }
+    }
+    free(tables);
+    free(type);
+    free(cmdq_cpu.last);
+    free(cmdq_cpu.index);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                     日志：同步 stdio vs 异步无锁缓冲区                      */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define LOG_BENCH_CALLS   1000000 /* 每个线程的日志条数 */
+#define LOG_BENCH_THREADS 4
+
+static FILE* log_bench_sync_out;
+
+/* 与 main.c 的 log_printf 相同的结构，输出目标换成 /dev/null，只比较调用方的开销 */
+static void log_bench_printf(const char* level, const char* fmt, ...) {
+    if (!log_level_enabled(log_level_from_name(level))) return;
+    va_list args;
+    va_start(args, fmt);
+    if (async_log_running()) {
+        async_log_vwrite(level, fmt, args);
+    } else {
+        fprintf(log_bench_sync_out, "[%s] ", level);
+        vfprintf(log_bench_sync_out, fmt, args);
+        fprintf(log_bench_sync_out, "\n");
+    }
+    va_end(args);
+}
+
+/* 当前线程消耗的 CPU 时间 (ns)；不支持时退回墙钟时间 */
+static uint64_t thread_cpu_ns(void) {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    }
+#endif
+    return bench_now_ns();
+}
+
+typedef struct {
+    const char* level;
+    uint64_t cpu_ns;
+} LogBenchArg;
+
+static int log_bench_worker(void* arg) {
+    LogBenchArg* a = (LogBenchArg*)arg;
+    // 只统计调用线程自己的 CPU 时间：后台格式化线程的开销不算在调用方头上（单核机器上尤其重要）
+    uint64_t t0 = thread_cpu_ns();
+    for (int i = 0; i < LOG_BENCH_CALLS; i++) {
+        log_bench_printf(a->level, "请求 %d 完成, 耗时 %.3f ms, 用户 %s, 状态 %u", i, i * 0.001,
+                         "alice", 200u);
+    }
+    a->cpu_ns = thread_cpu_ns() - t0;
+    return 0;
+}
+
+/* 返回每条日志在调用线程上的平均 CPU 耗时 (ns) */
+static double log_bench_run(int nthreads, const char* level) {
+    thrd_t threads[LOG_BENCH_THREADS];
+    LogBenchArg args[LOG_BENCH_THREADS];
+    for (int i = 0; i < nthreads; i++) {
+        args[i] = (LogBenchArg){level, 0};
+        thrd_create(&threads[i], log_bench_worker, &args[i]);
+    }
+    uint64_t total = 0;
+    for (int i = 0; i < nthreads; i++) {
+        thrd_join(threads[i], NULL);
+        total += args[i].cpu_ns;
+    }
+    return (double)total / ((double)nthreads * LOG_BENCH_CALLS);
+}
+
+static void bench_log(void) {
+    log_bench_sync_out = fopen(BENCH_NULL_DEVICE, "w");
+    if (!log_bench_sync_out) return;
+    int null_fd = fileno(log_bench_sync_out);
+    printf("\n[log] 每条日志在调用线程上的 CPU 耗时 (输出到 %s, 每线程 %d 条)\n", BENCH_NULL_DEVICE,
+           LOG_BENCH_CALLS);
+
+    printf("  同步 stdio, 1 线程:             %7.1f ns/条\n", log_bench_run(1, "INFO"));
+    printf("  同步 stdio, %d 线程:             %7.1f ns/条\n", LOG_BENCH_THREADS,
+           log_bench_run(LOG_BENCH_THREADS, "INFO"));
+
+    const LogFullPolicy policies[] = {LOG_FULL_DROP, LOG_FULL_BLOCK};
+    for (int p = 0; p < 2; p++) {
+        const char* name = policies[p] == LOG_FULL_DROP ? "丢弃" : "阻塞";
+        const int counts[] = {1, LOG_BENCH_THREADS};
+        for (int c = 0; c < 2; c++) {
+            if (!async_log_start(null_fd, 1024 * 1024, policies[p])) continue;
+            size_t dropped_before = async_log_dropped();
+            double ns = log_bench_run(counts[c], "INFO");
+            async_log_stop();
+            printf("  异步, 满时%s, %d 线程:          %7.1f ns/条  (丢弃 %zu 条)\n", name,
+                   counts[c], ns, async_log_dropped() - dropped_before);
+        }
+    }
+
+    log_set_level(LOG_LEVEL_INFO);
+    printf("  被级别过滤的 DEBUG:             %7.1f ns/条\n", log_bench_run(1, "DEBUG"));
+    log_set_level(LOG_LEVEL_DEBUG);
+    fclose(log_bench_sync_out);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                      CPU 拓扑：跨插槽访存与线程放置                        */
+/* ========================================================================== */
+
+#if HAS_THREADS
+
+#define TOPO_BENCH_BYTES  ((size_t)512 * 1024 * 1024) /* 远大于 L3，每次都要从内存读 */
+#define TOPO_BENCH_ROUNDS 3                           /* 取最快的一轮 */
+
+typedef struct {
+    uint64_t* data;
+    size_t n;
+    int cpu;   /* 绑定的逻辑 CPU */
+    bool fill; /* true：首次写入，页面分配在这个 CPU 所在的节点上 */
+    double gbps;
+    uint64_t sum;
+} TopoBenchArg;
+
+/* 访存受限的核心循环：顺序求和，每个 uint64 只做一次加法 */
+static uint64_t topo_sum(const uint64_t* data, size_t begin, size_t end) {
+    uint64_t s0 = 0, s1 = 0;
+    size_t i = begin;
+    for (; i + 1 < end; i += 2) {
+        s0 += data[i];
+        s1 += data[i + 1];
+    }
+    if (i < end) s0 += data[i];
+    return s0 + s1;
+}
+
+static int topo_bench_worker(void* arg) {
+    TopoBenchArg* a = (TopoBenchArg*)arg;
+    cpu_pin_current(a->cpu);
+    if (a->fill) {
+        for (size_t i = 0; i < a->n; i++) a->data[i] = i;
+        return 0;
+    }
+    double best = 0;
+    for (int r = 0; r < TOPO_BENCH_ROUNDS; r++) {
+        uint64_t t0 = bench_now_ns();
+        a->sum = topo_sum(a->data, 0, a->n);
+        double gbps = (double)(a->n * sizeof(uint64_t)) / (double)(bench_now_ns() - t0);
+        if (gbps > best) best = gbps;
+    }
+    a->gbps = best;
+    return 0;
+}
+
+/* 在绑定到 cpu 的新线程上执行一次 topo_bench_worker */
+static bool topo_run_on(TopoBenchArg* a, int cpu) {
+    a->cpu = cpu;
+    thrd_t t;
+    if (thrd_create(&t, topo_bench_worker, a) != thrd_success) return false;
+    thrd_join(t, NULL);
+    return true;
+}
+
+/* 单线程：内存由 CPU A 首次写入，再分别从本核、同节点另一核心、另一个插槽读取 */
+static void bench_topo_remote(const CpuTopo* topo, uint64_t* data, size_t n) {
+    const CpuInfo* home = &topo->cpus[0];
+    const CpuInfo* near = NULL;
+    const CpuInfo* far = NULL;
+    for (int i = 1; i < topo->ncpus; i++) {
+        const CpuInfo* c = &topo->cpus[i];
+        if (!near && c->node == home->node && c->package == home->package && c->core != home->core) {
+            near = c;
+        }
+        if (!far && (c->node != home->node || c->package != home->package)) far = c;
+    }
+
+    TopoBenchArg a = {.data = data, .n = n, .fill = true};
+    if (!topo_run_on(&a, home->cpu)) return;
+    a.fill = false;
+    uint64_t expect = (uint64_t)n * (n - 1) / 2;
+    printf("  单线程顺序读 %zu MB，内存由 CPU %d (插槽 %d, 节点 %d) 首次写入:\n",
+           n * sizeof(uint64_t) >> 20, home->cpu, home->package, home->node);
+
+    const CpuInfo* readers[] = {home, near, far};
+    const char* labels[] = {"同一核心      ", "同节点其他核心", "另一插槽/节点 "};
+    double local = 0;
+    for (int k = 0; k < 3; k++) {
+        if (!readers[k]) {
+            printf("    %s  无 (本机没有这样的 CPU)\n", labels[k]);
+            continue;
+        }
+        if (!topo_run_on(&a, readers[k]->cpu)) continue;
+        if (k == 0) local = a.gbps;
+        printf("    %s  CPU %-4d %6.2f GB/s", labels[k], readers[k]->cpu, a.gbps);
+        if (k > 0 && local > 0) printf("  (本地的 %.0f%%)", 100.0 * a.gbps / local);
+        printf("%s\n", a.sum == expect ? "" : "  (结果错误!)");
+    }
+    if (!far) printf("    只有一个插槽和 NUMA 节点，跨插槽的代价要在多路服务器上才能看到。\n");
+}
+
+static void topo_fill_body(size_t begin, size_t end, void* ctx) {
+    uint64_t* data = (uint64_t*)ctx;
+    for (size_t i = begin; i < end; i++) data[i] = i;
+}
+
+static void topo_sum_body(size_t begin, size_t end, void* acc, void* ctx) {
+    *(uint64_t*)acc += topo_sum((const uint64_t*)ctx, begin, end);
+}
+
+static void topo_sum_combine(void* acc, const void* other, void* ctx) {
+    (void)ctx;
+    *(uint64_t*)acc += *(const uint64_t*)other;
+}
+
+/* 多线程：同一个访存受限的归约，比较工作线程不绑定 / 紧凑绑定 / 分散绑定 */
+static void bench_topo_placement(const CpuTopo* topo, size_t n) {
+    // 只用一半的核心：紧凑放置会挤在一个插槽上，分散放置能用上所有插槽的内存控制器
+    int threads = topo->ncores / 2 > 1 ? topo->ncores / 2 : 2;
+    printf("  并行求和 %zu MB，%d 个工作线程 + 调用线程，页面由同一线程池首次写入:\n",
+           n * sizeof(uint64_t) >> 20, threads);
+    const CpuPlacement places[] = {CPU_PLACE_NONE, CPU_PLACE_COMPACT, CPU_PLACE_SCATTER};
+    const char* labels[] = {"不绑定        ", "紧凑 (compact)", "分散 (scatter)"};
+    uint64_t expect = (uint64_t)n * (n - 1) / 2;
+    for (int p = 0; p < 3; p++) {
+        // 每种放置各自分配、首次写入，页面落在这组线程所在的节点上
+        uint64_t* data = (uint64_t*)mem_alloc_cacheline(n * sizeof(uint64_t));
+        WsPool* pool = ws_pool_create_ex(&(WsPoolOptions){threads, places[p]});
+        if (!data || !pool) {
+            mem_aligned_free(data);
+            ws_pool_destroy(pool);
+            return;
+        }
+        parallel_set_pool(pool);
+        parallel_for(0, n, 0, topo_fill_body, data);
+        double best = 0;
+        bool ok = true;
+        for (int r = 0; r < TOPO_BENCH_ROUNDS; r++) {
+            uint64_t sum = 0;
+            uint64_t t0 = bench_now_ns();
+            parallel_reduce(0, n, 0, &sum, sizeof(sum), topo_sum_body, topo_sum_combine, data, 0);
+            double gbps = (double)(n * sizeof(uint64_t)) / (double)(bench_now_ns() - t0);
+            if (gbps > best) best = gbps;
+            ok = ok && sum == expect;
+        }
+        parallel_set_pool(NULL);
+        WsPoolStats st = ws_pool_stats(pool);
+        printf("    %s  %6.2f GB/s  窃取: 同 L3 %ld 次, 跨 L3 %ld 次  CPU:", labels[p], best,
+               st.steals_near, st.steals_far);
+        for (int i = 0; i < ws_pool_size(pool) && i < 8; i++) {
+            printf(" %d", ws_pool_worker_cpu(pool, i));
+        }
+        printf("%s%s\n", ws_pool_size(pool) > 8 ? " ..." : "", ok ? "" : "  (结果错误!)");
+        ws_pool_destroy(pool);
+        mem_aligned_free(data);
+    }
+}
+
+static void bench_topo(void) {
+    CpuTopo* topo = cpu_topo_load();
+    if (!topo) return;
+    printf("\n[topo] ");
+    cpu_topo_print(topo, stdout);
+
+    size_t n = TOPO_BENCH_BYTES / sizeof(uint64_t);
+    uint64_t* data = (uint64_t*)mem_alloc_cacheline(n * sizeof(uint64_t));
+    if (data) {
+        bench_topo_remote(topo, data, n);
+        mem_aligned_free(data);
+    }
+    bench_topo_placement(topo, n);
+    cpu_topo_free(topo);
+}
+
+#endif /* HAS_THREADS */
+
+/* ========================================================================== */
+/*                               基准入口                                     */
+/* ========================================================================== */
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} BenchEntry;
+
+/* 与 main.c 中的命令跳转表同样的思路：名字 -> 函数 */
+static const BenchEntry bench_table[] = {
+    {"pool", bench_pool},
+    {"slab", bench_slab},
+    {"arena", bench_arena},
+    {"vec", bench_vec},
+    {"hugepage", bench_hugepage},
+    {"cmdhash", bench_cmdhash},
+#if HAS_THREADS
+    {"mt", bench_mt_alloc},
+    {"track", bench_track},
+    {"falseshare", bench_false_share},
+    {"ws", bench_ws},
+    {"parallel", bench_parallel},
+    {"counter", bench_counter},
+    {"queue", bench_queue},
+    {"cmdqueue", bench_cmdqueue},
+    {"log", bench_log},
+    {"topo", bench_topo},
+#endif
+};
+
+int bench_main(const char* name) {
+#ifndef NDEBUG
+    printf("[提示] 当前为未定义 NDEBUG 的构建，建议使用 Release 构建后再对比数字。\n");
+#endif
+    const size_t n = sizeof(bench_table) / sizeof(bench_table[0]);
+    bool found = false;
+    for (size_t i = 0; i < n; i++) {
+        if (!name || strcmp(name, bench_table[i].name) == 0) {
+            bench_table[i].run();
+            found = true;
+        }
+    }
+    if (!found) {
+        printf("未知基准: %s，可选:", name);
+        for (size_t i = 0; i < n; i++) printf(" %s", bench_table[i].name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file bench.h
+ * @brief 基准测试的公共工具与入口
+ *
+ * 运行方式：
+ *   ./18_advanced_features --bench          运行全部基准
+ *   ./18_advanced_features --bench pool     只运行名为 pool 的基准
+ *
+ * 注意：请使用 Release 构建 (cmake -DCMAKE_BUILD_TYPE=Release) 再看数字，
+ * Debug 构建没有优化，结果没有参考意义。
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* 当前时间（纳秒）。timespec_get 是 C11 标准函数，Linux/Windows 均可用 */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift64 伪随机数：比 rand() 快且没有全局状态 */
+static inline uint64_t bench_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/* 把结果写入 volatile 变量，防止编译器把被测代码整个优化掉 */
+extern volatile uintptr_t bench_sink;
+
+/* 在线 CPU 核心数（取不到时返回 1） */
+int bench_cpu_count(void);
+
+/* 当前进程常驻内存 (RSS) 字节数，仅 Linux 支持，其他平台返回 0 */
+size_t bench_rss_bytes(void);
+
+/* 硬件性能计数器种类 */
+typedef enum {
+    BENCH_COUNTER_DTLB_MISS,   /* 数据 TLB 读缺失 */
+    BENCH_COUNTER_BRANCH_MISS, /* 分支预测失败 */
+} BenchCounterKind;
+
+/*
+ * 打开当前线程的一个硬件计数器（Linux perf_event_open），返回句柄；
+ * 没有权限、虚拟机没有 PMU 或非 Linux 平台返回 -1，调用方应显示“不可用”而不是报错。
+ */
+int bench_counter_open(BenchCounterKind kind);
+/* 清零并开始计数，-1 句柄上的调用都是空操作 */
+void bench_counter_start(int counter);
+/* 停止计数并返回计数值 */
+uint64_t bench_counter_stop(int counter);
+void bench_counter_close(int counter);
+
+/* 基准入口：name 为 NULL 时运行全部，返回进程退出码 */
+int bench_main(const char* name);
+
+#endif /* BENCH_H */
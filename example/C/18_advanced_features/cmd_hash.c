@@ -0,0 +1,16 @@
+/**
+ * @file cmd_hash.c
+ * @brief 完美哈希表的批量查找
+ */
+
+#include "cmd_hash.h"
+
+size_t cmd_hash_find_many(const CmdHashTable* t, const char* const* names, const size_t* lens,
+                          size_t n, int* out) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = cmd_hash_find(t, names[i], lens[i]);
+        found += (size_t)(out[i] >= 0);
+    }
+    return found;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file cmd_hash.h
+ * @brief 构建时生成的完美哈希：把线上收到的命令名字符串映射成编号
+ *
+ * 命令名逐个 strcmp 比较，平均要比较一半的命令；命令集合在编译时就已知，
+ * 可以预先找一个对这组名字没有冲突的哈希，查找变成“算一次哈希 + 一次 memcmp 确认”。
+ *
+ * 表由 tools/cmd_hash_gen.c 在构建时生成（cmd_hash_tables.h/.c），采用“哈希-位移”法：
+ * 1. h = cmd_hash_bytes(seed, name, len)，高 32 位选桶，低 32 位选槽；
+ * 2. 每个桶有一个位移 disp，槽号 = (低 32 位 ^ disp[桶]) & slot_mask；
+ * 3. 生成器从大桶开始为每个桶找一个让桶内所有名字都落到空槽的 disp，找不到就换 seed 重来。
+ * 槽数取命令数两倍以上的 2 的幂，每个槽直接存名字、长度和编号，查找只访问一个槽。
+ * 不在集合里的名字也会落到某个槽，由长度和 memcmp 的确认排除。
+ *
+ * 哈希按本机字节序读取名字，生成器与程序在同一台机器上构建（不支持交叉编译）。
+ */
+
+#ifndef CMD_HASH_H
+#define CMD_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    const char* name; /* 空槽为 "" */
+    uint32_t len;
+    int32_t value;    /* 命令编号，空槽为 -1 */
+} CmdHashSlot;
+
+typedef struct {
+    uint64_t seed;
+    uint32_t slot_mask;   /* 槽数 - 1 */
+    uint32_t bucket_mask; /* 桶数 - 1 */
+    const uint16_t* disp; /* 每个桶的位移 */
+    const CmdHashSlot* slots;
+    size_t count;         /* 命令数 */
+} CmdHashTable;
+
+/* 每次吃 8 个字节；不足 8 字节的尾部，长名字用与前一块重叠的最后 8 字节，短名字逐字节拼 */
+static inline uint64_t cmd_hash_bytes(uint64_t seed, const char* s, size_t len) {
+    uint64_t h = seed ^ ((uint64_t)len * 0x9E3779B97F4A7C15u);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, s + i, 8);
+        h = (h ^ w) * 0xBF58476D1CE4E5B9u;
+        h ^= h >> 31;
+    }
+    if (i < len) {
+        uint64_t w = 0;
+        if (len >= 8) {
+            memcpy(&w, s + len - 8, 8);
+        } else {
+            for (size_t j = 0; j < len; j++) w |= (uint64_t)(unsigned char)s[j] << (8 * j);
+        }
+        h = (h ^ w) * 0x94D049BB133111EBu;
+    }
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9u;
+    return h ^ (h >> 32);
+}
+
+/* 名字（不要求以 '\0' 结尾）对应的编号，不在集合中返回 -1 */
+static inline int cmd_hash_find(const CmdHashTable* t, const char* name, size_t len) {
+    uint64_t h = cmd_hash_bytes(t->seed, name, len);
+    uint32_t bucket = (uint32_t)(h >> 32) & t->bucket_mask;
+    const CmdHashSlot* s = &t->slots[((uint32_t)h ^ t->disp[bucket]) & t->slot_mask];
+    return s->len == len && memcmp(s->name, name, len) == 0 ? s->value : -1;
+}
+
+/*
+ * 批量查找：out[i] = cmd_hash_find(t, names[i], lens[i])，返回找到的个数。
+ * 各次查找互不依赖，集中在一个循环里做时 CPU 可以同时推进好几次哈希和访存。
+ */
+size_t cmd_hash_find_many(const CmdHashTable* t, const char* const* names, const size_t* lens,
+                          size_t n, int* out);
+
+#endif /* CMD_HASH_H */
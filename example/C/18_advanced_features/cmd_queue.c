@@ -0,0 +1,511 @@
+/**
+ * @file cmd_queue.c
+ * @brief 命令队列的实现
+ *
+ * 队列本身复用 ring_queue.h 的 MPMC 环形队列：
+ *   free_list  空闲记录，提交时取一条，执行完放回；取不到说明排队的记录已达 capacity
+ *   shared     key 为 0 的记录，所有工作线程都来取
+ *   inbox      每个工作线程一个，存放 key 映射到该线程的记录，只有这个线程取
+ * 每个队列的容量都等于记录总数，记录放进去时不会失败。
+ */
+
+#include "cmd_queue.h"
+
+#if HAS_THREADS
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mem_align.h"
+#include "ring_queue.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <unistd.h>
+#endif
+
+#define CMDQ_DEFAULT_CAPACITY 4096
+#define CMDQ_DEFAULT_BATCH    64
+#define CMDQ_SPIN_ROUNDS      64                 /* 休眠前让出 CPU 重试的次数 */
+#define CMDQ_KEY_SLOTS        (2 * CMDQ_MAX_BATCH) /* 批内 key 计数表，装填率不超过一半 */
+
+typedef struct {
+    int cmd;
+    const char* args;
+    uint64_t key;
+    CmdDoneFn done;
+    void* user;
+    uint64_t submit_ns;
+    uint32_t epoch; /* 批内在它之前同 key 的记录条数，只在分组时由工作线程使用 */
+} CmdRecord;
+
+typedef struct {
+    uint64_t key;
+    uint32_t seen;
+    uint32_t stamp; /* 与工作线程当前的 stamp 不同表示空槽，省去每批清零 */
+} KeySlot;
+
+/* 只由所属工作线程写，读取方用 relaxed 原子读，不会构成数据竞争 */
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t max_exec_ns;
+    _Atomic uint64_t wait[CMDQ_HIST_BUCKETS];
+    _Atomic uint64_t exec[CMDQ_HIST_BUCKETS];
+} CmdHist;
+
+typedef struct {
+    MpmcQueue inbox;
+    CmdQueue* q;
+    cnd_t wake;
+    atomic_bool sleeping;
+    CmdHist* hist; /* ncmds 项 */
+    _Atomic uint64_t records;
+    _Atomic uint64_t batches;
+    _Atomic uint64_t groups;
+    /* 以下只在工作线程内部使用 */
+    uint32_t* cmd_start; /* ncmds + 1 项，计数排序的桶起点 */
+    uint32_t stamp;
+    KeySlot keys[CMDQ_KEY_SLOTS];
+    CmdRecord* batch[CMDQ_MAX_BATCH];
+    CmdRecord* sorted[CMDQ_MAX_BATCH];
+    thrd_t thread;
+} CmdWorker;
+
+struct CmdQueue {
+    const CmdQueueHandler* table;
+    int ncmds;
+    size_t batch;
+    bool group;
+    int nworkers; /* 已初始化的工作线程结构 */
+    int started;  /* 已启动的线程，key 只映射到这些线程 */
+    CmdWorker* workers;
+    CmdRecord* records;
+    MpmcQueue free_list;
+    MpmcQueue shared;
+    mtx_t lock; /* 只用于休眠/唤醒 */
+    cnd_t idle;
+    atomic_int waiters;
+    atomic_bool stop;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t submitted;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t completed;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9u;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBu;
+    return x ^ (x >> 31);
+}
+
+static void stat_add(_Atomic uint64_t* c, uint64_t v) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v,
+                          memory_order_relaxed);
+}
+
+static unsigned hist_bucket(uint64_t ns) {
+    unsigned b = ns ? 63u - bit_clz64(ns) : 0u;
+    return b < CMDQ_HIST_BUCKETS ? b : CMDQ_HIST_BUCKETS - 1;
+}
+
+/* ========================================================================== */
+/*                              唤醒与休眠                                    */
+/* ========================================================================== */
+
+/* 抢到 sleeping 标志的一方负责唤醒，连续提交的多条记录不会都去叫同一个线程 */
+static bool wake_worker(CmdQueue* q, CmdWorker* w) {
+    if (!atomic_exchange(&w->sleeping, false)) return false;
+    mtx_lock(&q->lock);
+    cnd_signal(&w->wake);
+    mtx_unlock(&q->lock);
+    return true;
+}
+
+static void wake_any(CmdQueue* q) {
+    for (int i = 0; i < q->started; i++) {
+        if (atomic_load_explicit(&q->workers[i].sleeping, memory_order_relaxed) &&
+            wake_worker(q, &q->workers[i])) {
+            return;
+        }
+    }
+}
+
+static bool has_work(CmdQueue* q, CmdWorker* self) {
+    return !mpmc_empty(&self->inbox) || !mpmc_empty(&q->shared);
+}
+
+/* ========================================================================== */
+/*                              成批执行                                      */
+/* ========================================================================== */
+
+/* 自己的 inbox 优先，不满一批再从共享队列补；共享队列还有剩余就再叫醒一个线程 */
+static size_t take_batch(CmdQueue* q, CmdWorker* self) {
+    size_t n = mpmc_pop_batch(&self->inbox, (void**)self->batch, q->batch);
+    if (n < q->batch) {
+        size_t m = mpmc_pop_batch(&q->shared, (void**)(self->batch + n), q->batch - n);
+        if (m > 0 && !mpmc_empty(&q->shared)) wake_any(q);
+        n += m;
+    }
+    return n;
+}
+
+/*
+ * 批内排序：主键 epoch、次键命令类型，都是稳定的计数排序。
+ * 同 key 的第 k 条记录 epoch 为 k，排在同 key 的前一条之后，所以 key 内顺序不变；
+ * key 各不相同时只有一个 epoch，整批直接按类型分组。
+ */
+static CmdRecord** group_batch(CmdQueue* q, CmdWorker* self, size_t n) {
+    uint32_t max_epoch = 0;
+    if (++self->stamp == 0) {
+        memset(self->keys, 0, sizeof(self->keys));
+        self->stamp = 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        CmdRecord* r = self->batch[i];
+        r->epoch = 0;
+        if (r->key == 0) continue;
+        size_t h = (size_t)mix64(r->key) & (CMDQ_KEY_SLOTS - 1);
+        while (self->keys[h].stamp == self->stamp && self->keys[h].key != r->key) {
+            h = (h + 1) & (CMDQ_KEY_SLOTS - 1);
+        }
+        KeySlot* s = &self->keys[h];
+        if (s->stamp != self->stamp) {
+            s->key = r->key;
+            s->seen = 0;
+            s->stamp = self->stamp;
+        }
+        r->epoch = s->seen++;
+        if (r->epoch > max_epoch) max_epoch = r->epoch;
+    }
+
+    uint32_t* start = self->cmd_start;
+    memset(start, 0, ((size_t)q->ncmds + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) start[self->batch[i]->cmd + 1]++;
+    for (int c = 0; c < q->ncmds; c++) start[c + 1] += start[c];
+    for (size_t i = 0; i < n; i++) self->sorted[start[self->batch[i]->cmd]++] = self->batch[i];
+    if (max_epoch == 0) return self->sorted;
+
+    uint32_t epoch_start[CMDQ_MAX_BATCH + 1] = {0};
+    for (size_t i = 0; i < n; i++) epoch_start[self->sorted[i]->epoch + 1]++;
+    for (uint32_t e = 0; e < max_epoch; e++) epoch_start[e + 1] += epoch_start[e];
+    for (size_t i = 0; i < n; i++) {
+        self->batch[epoch_start[self->sorted[i]->epoch]++] = self->sorted[i];
+    }
+    return self->batch;
+}
+
+static void run_batch(CmdQueue* q, CmdWorker* self, size_t n) {
+    CmdRecord** order = q->group && n > 1 ? group_batch(q, self, n) : self->batch;
+    uint64_t groups = 0;
+    int prev = -1;
+    uint64_t t = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        CmdRecord* r = order[i];
+        if (r->cmd != prev) {
+            groups++;
+            prev = r->cmd;
+        }
+        q->table[r->cmd](r->args);
+        if (r->done) r->done(r->cmd, r->args, r->user);
+        uint64_t end = now_ns();
+
+        CmdHist* h = &self->hist[r->cmd];
+        uint64_t exec = end - t;
+        stat_add(&h->count, 1);
+        stat_add(&h->wait[hist_bucket(t > r->submit_ns ? t - r->submit_ns : 0)], 1);
+        stat_add(&h->exec[hist_bucket(exec)], 1);
+        if (exec > atomic_load_explicit(&h->max_exec_ns, memory_order_relaxed)) {
+            atomic_store_explicit(&h->max_exec_ns, exec, memory_order_relaxed);
+        }
+        t = end;
+        mpmc_push(&q->free_list, r);
+    }
+    stat_add(&self->records, n);
+    stat_add(&self->batches, 1);
+    stat_add(&self->groups, groups);
+
+    // 与 cmd_queue_wait 的“先登记再复查”配对，同 ws_pool 的 sleepers
+    atomic_fetch_add_explicit(&q->completed, n, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&q->waiters, memory_order_relaxed) > 0) {
+        mtx_lock(&q->lock);
+        cnd_broadcast(&q->idle);
+        mtx_unlock(&q->lock);
+    }
+}
+
+static int worker_main(void* arg) {
+    CmdWorker* self = (CmdWorker*)arg;
+    CmdQueue* q = self->q;
+    for (;;) {
+        size_t n = take_batch(q, self);
+        for (int spin = 0; n == 0 && spin < CMDQ_SPIN_ROUNDS; spin++) {
+            thrd_yield();
+            n = take_batch(q, self);
+        }
+        if (n > 0) {
+            run_batch(q, self, n);
+            continue;
+        }
+
+        // 每次睡之前都重新登记：唤醒方会清掉标志，虚假唤醒后不重新登记就再也叫不醒了
+        mtx_lock(&q->lock);
+        for (;;) {
+            atomic_store(&self->sleeping, true);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (atomic_load(&q->stop) || has_work(q, self)) break;
+            cnd_wait(&self->wake, &q->lock);
+        }
+        atomic_store(&self->sleeping, false);
+        bool done = atomic_load(&q->stop) && !has_work(q, self);
+        mtx_unlock(&q->lock);
+        if (done) break;
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/*                              对外接口                                      */
+/* ========================================================================== */
+
+static bool worker_init(CmdQueue* q, CmdWorker* w, size_t capacity) {
+    memset(w, 0, sizeof(*w));
+    w->q = q;
+    atomic_init(&w->sleeping, false);
+    w->hist = (CmdHist*)calloc((size_t)q->ncmds, sizeof(CmdHist));
+    w->cmd_start = (uint32_t*)malloc(((size_t)q->ncmds + 1) * sizeof(uint32_t));
+    if (!w->hist || !w->cmd_start || !mpmc_init(&w->inbox, capacity)) {
+        free(w->hist);
+        free(w->cmd_start);
+        return false;
+    }
+    if (cnd_init(&w->wake) != thrd_success) {
+        mpmc_destroy(&w->inbox);
+        free(w->hist);
+        free(w->cmd_start);
+        return false;
+    }
+    return true;
+}
+
+static void worker_destroy(CmdWorker* w) {
+    cnd_destroy(&w->wake);
+    mpmc_destroy(&w->inbox);
+    free(w->hist);
+    free(w->cmd_start);
+}
+
+CmdQueue* cmd_queue_create(const CmdQueueHandler* table, int ncmds, const CmdQueueOptions* opts) {
+    CmdQueueOptions def = {0, 0, 0, true};
+    if (!opts) opts = &def;
+    if (!table || ncmds <= 0) return NULL;
+    int nworkers = opts->nworkers;
+    if (nworkers <= 0) {
+#if defined(_SC_NPROCESSORS_ONLN)
+        nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (nworkers <= 0) nworkers = 1;
+    }
+    size_t capacity = 2;
+    while (capacity < (opts->capacity ? opts->capacity : CMDQ_DEFAULT_CAPACITY)) capacity <<= 1;
+
+    // submitted / completed 各占一条缓存行，按缓存行对齐分配
+    CmdQueue* q = (CmdQueue*)mem_alloc_cacheline(sizeof(CmdQueue));
+    if (!q) return NULL;
+    memset(q, 0, sizeof(*q));
+    q->table = table;
+    q->ncmds = ncmds;
+    q->batch = opts->batch ? opts->batch : CMDQ_DEFAULT_BATCH;
+    if (q->batch > CMDQ_MAX_BATCH) q->batch = CMDQ_MAX_BATCH;
+    q->group = opts->group_by_type;
+    atomic_init(&q->waiters, 0);
+    atomic_init(&q->stop, false);
+    atomic_init(&q->submitted, 0);
+    atomic_init(&q->completed, 0);
+
+    q->records = (CmdRecord*)malloc(capacity * sizeof(CmdRecord));
+    q->workers = (CmdWorker*)mem_alloc_cacheline((size_t)nworkers * sizeof(CmdWorker));
+    bool ok = q->records && q->workers && mpmc_init(&q->free_list, capacity);
+    if (ok && !mpmc_init(&q->shared, capacity)) {
+        mpmc_destroy(&q->free_list);
+        ok = false;
+    }
+    if (ok && mtx_init(&q->lock, mtx_plain) != thrd_success) {
+        mpmc_destroy(&q->free_list);
+        mpmc_destroy(&q->shared);
+        ok = false;
+    }
+    if (ok && cnd_init(&q->idle) != thrd_success) {
+        mtx_destroy(&q->lock);
+        mpmc_destroy(&q->free_list);
+        mpmc_destroy(&q->shared);
+        ok = false;
+    }
+    if (!ok) {
+        free(q->records);
+        mem_aligned_free(q->workers);
+        mem_aligned_free(q);
+        return NULL;
+    }
+    for (size_t i = 0; i < capacity; i++) mpmc_push(&q->free_list, &q->records[i]);
+
+    for (int i = 0; i < nworkers && worker_init(q, &q->workers[i], capacity); i++) {
+        q->nworkers = i + 1;
+    }
+    while (q->started < q->nworkers &&
+           thrd_create(&q->workers[q->started].thread, worker_main,
+                       &q->workers[q->started]) == thrd_success) {
+        q->started++;
+    }
+    if (q->started == 0) {
+        cmd_queue_destroy(q);
+        return NULL;
+    }
+    return q;
+}
+
+void cmd_queue_destroy(CmdQueue* q) {
+    if (!q) return;
+    if (q->started > 0) cmd_queue_wait(q);
+    mtx_lock(&q->lock);
+    atomic_store(&q->stop, true);
+    for (int i = 0; i < q->started; i++) cnd_signal(&q->workers[i].wake);
+    mtx_unlock(&q->lock);
+
+    for (int i = 0; i < q->started; i++) thrd_join(q->workers[i].thread, NULL);
+    for (int i = 0; i < q->nworkers; i++) worker_destroy(&q->workers[i]);
+    cnd_destroy(&q->idle);
+    mtx_destroy(&q->lock);
+    mpmc_destroy(&q->shared);
+    mpmc_destroy(&q->free_list);
+    free(q->records);
+    mem_aligned_free(q->workers);
+    mem_aligned_free(q);
+}
+
+int cmd_queue_workers(const CmdQueue* q) {
+    return q->started;
+}
+
+bool cmd_queue_submit(CmdQueue* q, const CmdRequest* req) {
+    if (req->cmd < 0 || req->cmd >= q->ncmds || !q->table[req->cmd]) return false;
+    void* slot;
+    while (!mpmc_pop(&q->free_list, &slot)) thrd_yield(); // 背压：等工作线程执行完腾出记录
+    CmdRecord* r = (CmdRecord*)slot;
+    r->cmd = req->cmd;
+    r->args = req->args;
+    r->key = req->key;
+    r->done = req->done;
+    r->user = req->user;
+    r->submit_ns = now_ns();
+    atomic_fetch_add_explicit(&q->submitted, 1, memory_order_relaxed);
+
+    CmdWorker* target = NULL;
+    if (req->key != 0) {
+        // 乘法取高位把 64 位哈希映射到 [0, started)，同一个 key 总是落在同一个线程
+        uint64_t h = mix64(req->key) >> 32;
+        target = &q->workers[(h * (uint64_t)q->started) >> 32];
+        mpmc_push(&target->inbox, r);
+    } else {
+        mpmc_push(&q->shared, r);
+    }
+
+    // 记录已经发布，再看有没有人在睡；和 worker_main 的“先登记再复查”构成 Dekker 式配对
+    atomic_thread_fence(memory_order_seq_cst);
+    if (target) wake_worker(q, target);
+    else wake_any(q);
+    return true;
+}
+
+void cmd_queue_wait(CmdQueue* q) {
+    uint64_t target = atomic_load(&q->submitted);
+    if (atomic_load_explicit(&q->completed, memory_order_acquire) >= target) return;
+    mtx_lock(&q->lock);
+    atomic_fetch_add(&q->waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (atomic_load_explicit(&q->completed, memory_order_acquire) < target) {
+        cnd_wait(&q->idle, &q->lock);
+    }
+    atomic_fetch_sub(&q->waiters, 1);
+    mtx_unlock(&q->lock);
+}
+
+void cmd_queue_latency(const CmdQueue* q, int cmd, CmdLatency* out) {
+    memset(out, 0, sizeof(*out));
+    if (cmd < 0 || cmd >= q->ncmds) return;
+    for (int i = 0; i < q->nworkers; i++) {
+        CmdHist* h = &q->workers[i].hist[cmd];
+        out->count += atomic_load_explicit(&h->count, memory_order_relaxed);
+        uint64_t m = atomic_load_explicit(&h->max_exec_ns, memory_order_relaxed);
+        if (m > out->max_exec_ns) out->max_exec_ns = m;
+        for (int b = 0; b < CMDQ_HIST_BUCKETS; b++) {
+            out->wait[b] += atomic_load_explicit(&h->wait[b], memory_order_relaxed);
+            out->exec[b] += atomic_load_explicit(&h->exec[b], memory_order_relaxed);
+        }
+    }
+}
+
+CmdQueueStats cmd_queue_stats(const CmdQueue* q) {
+    CmdQueueStats st = {0, 0, 0};
+    for (int i = 0; i < q->nworkers; i++) {
+        st.records += atomic_load_explicit(&q->workers[i].records, memory_order_relaxed);
+        st.batches += atomic_load_explicit(&q->workers[i].batches, memory_order_relaxed);
+        st.groups += atomic_load_explicit(&q->workers[i].groups, memory_order_relaxed);
+    }
+    return st;
+}
+
+uint64_t cmd_latency_percentile(const uint64_t hist[CMDQ_HIST_BUCKETS], uint64_t count, double p) {
+    if (count == 0) return 0;
+    uint64_t need = (uint64_t)(p * (double)count);
+    if (need == 0) need = 1;
+    if (need > count) need = count;
+    uint64_t seen = 0;
+    for (int b = 0; b < CMDQ_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= need) return (uint64_t)2 << b;
+    }
+    return (uint64_t)2 << (CMDQ_HIST_BUCKETS - 1);
+}
+
+/* 把纳秒数按量级写成 "850ns" / "12.3us" / "4.1ms" / "1.20s" */
+static const char* format_ns(char* buf, size_t size, uint64_t ns) {
+    if (ns < 1000) snprintf(buf, size, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buf, size, "%.1fus", (double)ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, size, "%.1fms", (double)ns / 1e6);
+    else snprintf(buf, size, "%.2fs", (double)ns / 1e9);
+    return buf;
+}
+
+void cmd_queue_report(const CmdQueue* q, const char* const* names, FILE* out) {
+    fprintf(out, "  命令           次数    排队p50    排队p99    执行p50    执行p99    执行max\n");
+    for (int c = 0; c < q->ncmds; c++) {
+        CmdLatency lat;
+        cmd_queue_latency(q, c, &lat);
+        if (lat.count == 0) continue;
+        uint64_t exec_p50 = cmd_latency_percentile(lat.exec, lat.count, 0.50);
+        uint64_t exec_p99 = cmd_latency_percentile(lat.exec, lat.count, 0.99);
+        if (exec_p50 > lat.max_exec_ns) exec_p50 = lat.max_exec_ns;
+        if (exec_p99 > lat.max_exec_ns) exec_p99 = lat.max_exec_ns;
+        char id[16], b[5][16];
+        if (!names) snprintf(id, sizeof(id), "#%d", c);
+        fprintf(out, "  %-8s %8llu %10s %10s %10s %10s %10s\n", names ? names[c] : id,
+                (unsigned long long)lat.count,
+                format_ns(b[0], sizeof(b[0]), cmd_latency_percentile(lat.wait, lat.count, 0.50)),
+                format_ns(b[1], sizeof(b[1]), cmd_latency_percentile(lat.wait, lat.count, 0.99)),
+                format_ns(b[2], sizeof(b[2]), exec_p50), format_ns(b[3], sizeof(b[3]), exec_p99),
+                format_ns(b[4], sizeof(b[4]), lat.max_exec_ns));
+    }
+    CmdQueueStats st = cmd_queue_stats(q);
+    fprintf(out, "  共 %llu 条，%llu 批（平均每批 %.1f 条），连续同类命令 %llu 段\n",
+            (unsigned long long)st.records, (unsigned long long)st.batches,
+            st.batches ? (double)st.records / (double)st.batches : 0.0,
+            (unsigned long long)st.groups);
+    fprintf(out, "  （百分位取直方图桶的上界，执行时间再以最大值封顶）\n");
+}
+
+#endif /* HAS_THREADS */
@@ -0,0 +1,96 @@
+/**
+ * @file cmd_queue.h
+ * @brief 命令队列：多个工作线程成批执行第二节跳转表里的命令处理函数
+ *
+ * dispatch 在调用者线程上同步执行处理函数，load/save 这类等 I/O 的命令会一条条排队。
+ * 命令队列模式下调用者只提交 (命令, 参数) 记录就返回，工作线程负责执行：
+ * 1. 工作线程每次从队列取一批（默认 64 条），批内按命令类型分组后再执行，
+ *    连续执行同一个处理函数，它的代码和数据留在缓存里。
+ * 2. key 非 0 的记录按 key 固定交给一个工作线程，批内分组时也不会越过同 key 的前一条，
+ *    所以同 key 的记录严格按提交顺序执行（例如同一个文件先 load 后 save）；
+ *    key 为 0 的记录进共享队列，哪个线程空闲就由哪个执行，不保证顺序。
+ * 3. 记录可以带完成回调，处理函数返回后在工作线程上调用。
+ * 4. 每条命令记录两段耗时的直方图：排队（提交 → 开始执行）和执行，按 2 的幂分桶。
+ *
+ * 记录放在创建时分配好的定长数组里，排队的记录达到 capacity 时 cmd_queue_submit 让出 CPU 等待，
+ * 不会无限堆积（背压）。
+ */
+
+#ifndef CMD_QUEUE_H
+#define CMD_QUEUE_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CMDQ_MAX_BATCH    256
+#define CMDQ_HIST_BUCKETS 40 /* 第 i 个桶统计 [2^i, 2^(i+1)) 纳秒，最后一个桶兼收更长的 */
+
+/* 与 main.c 的 CmdHandler 签名相同，跳转表可以直接传进来 */
+typedef void (*CmdQueueHandler)(const char* args);
+
+/* 完成回调：在工作线程上、处理函数返回之后调用 */
+typedef void (*CmdDoneFn)(int cmd, const char* args, void* user);
+
+typedef struct CmdQueue CmdQueue;
+
+typedef struct {
+    int nworkers;       /* 0 表示在线 CPU 核心数 */
+    size_t capacity;    /* 最多同时排队的记录数，向上取整到 2 的幂，0 表示 4096 */
+    size_t batch;       /* 每批最多取多少条，0 表示 64，超过 CMDQ_MAX_BATCH 按上限处理 */
+    bool group_by_type; /* 批内按命令类型分组执行；false 时按取出的顺序执行 */
+} CmdQueueOptions;
+
+typedef struct {
+    int cmd;          /* 跳转表下标 */
+    const char* args; /* 只保存指针，执行完之前必须一直有效 */
+    uint64_t key;     /* 非 0 时同 key 的记录按提交顺序执行 */
+    CmdDoneFn done;   /* 可以为 NULL */
+    void* user;       /* 原样传给 done */
+} CmdRequest;
+
+/* 一条命令的耗时直方图 */
+typedef struct {
+    uint64_t count;
+    uint64_t wait[CMDQ_HIST_BUCKETS]; /* 排队时间 */
+    uint64_t exec[CMDQ_HIST_BUCKETS]; /* 处理函数 + 完成回调的执行时间 */
+    uint64_t max_exec_ns;
+} CmdLatency;
+
+typedef struct {
+    uint64_t records;
+    uint64_t batches; /* records / batches 是平均每批的条数 */
+    uint64_t groups;  /* 连续执行同一命令的段数，越接近 batches * 命令种类数越说明分组起了作用 */
+} CmdQueueStats;
+
+/* table 有 ncmds 项，创建后不能修改；opts 为 NULL 时全部取默认值并按类型分组 */
+CmdQueue* cmd_queue_create(const CmdQueueHandler* table, int ncmds, const CmdQueueOptions* opts);
+/* 等所有已提交的记录执行完，再回收工作线程 */
+void cmd_queue_destroy(CmdQueue* q);
+int cmd_queue_workers(const CmdQueue* q);
+
+/* cmd 越界或 table 中没有处理函数时返回 false；队列满时阻塞到有空位 */
+bool cmd_queue_submit(CmdQueue* q, const CmdRequest* req);
+
+/*
+ * 等到调用前提交的记录全部执行完（包括完成回调）。
+ * 不能在处理函数或完成回调里调用：当前批次的记录要等整批返回后才计入完成数，会自己等自己而死锁。
+ */
+void cmd_queue_wait(CmdQueue* q);
+
+/* 统计值只在没有记录在执行时读取才是准确值 */
+void cmd_queue_latency(const CmdQueue* q, int cmd, CmdLatency* out);
+CmdQueueStats cmd_queue_stats(const CmdQueue* q);
+/* 直方图中不少于 p (0~1) 的样本落在返回值以内，返回值是所在桶的上界（纳秒），没有样本返回 0 */
+uint64_t cmd_latency_percentile(const uint64_t hist[CMDQ_HIST_BUCKETS], uint64_t count, double p);
+/* 每条执行过的命令打印一行 p50/p99；names 可以为 NULL，此时打印编号 */
+void cmd_queue_report(const CmdQueue* q, const char* const* names, FILE* out);
+
+#endif /* HAS_THREADS */
+
+#endif /* CMD_QUEUE_H */
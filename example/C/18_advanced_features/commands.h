@@ -0,0 +1,25 @@
+/**
+ * @file commands.h
+ * @brief 第二节跳转表的命令清单：枚举值和线上使用的命令名
+ *
+ * 用 X 宏（见第三节“宏元编程”）只写一遍清单，展开成 CommandType 枚举；
+ * 构建时 tools/cmd_hash_gen.c 也包含本文件，按同一份清单生成“命令名 → CommandType”的完美哈希表。
+ * 增删命令只需要改 COMMAND_LIST，再在 main.c 的 cmd_table 里填上处理函数。
+ */
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#define COMMAND_LIST(X) \
+    X(CMD_HELP, "help") \
+    X(CMD_LOAD, "load") \
+    X(CMD_SAVE, "save")
+
+typedef enum {
+#define COMMAND_ENUM(id, name) id,
+    COMMAND_LIST(COMMAND_ENUM)
+#undef COMMAND_ENUM
+    CMD_MAX
+} CommandType;
+
+#endif /* COMMANDS_H */
@@ -0,0 +1,64 @@
+/**
+ * @file common.h
+ * @brief 本示例各模块共用的平台检测与位操作/对齐工具
+ *
+ * 这些宏最初只在 main.c 中演示，由于内存池、线程缓存池等模块也要用到，
+ * 这里把它们提取成公共头文件。
+ */
+
+#ifndef ADV_COMMON_H
+#define ADV_COMMON_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+/* 检测是否支持 C11 线程库 */
+#if defined(__STDC_NO_THREADS__) || defined(__MINGW32__)
+  #define HAS_THREADS 0
+#else
+  #include <threads.h>
+  #include <stdatomic.h>
+  #define HAS_THREADS 1
+#endif
+
+/* 主流 x86/ARM 处理器的缓存行大小 */
+#define CACHE_LINE_SIZE 64
+
+#define IS_POWER_OF_2(x) (((x) > 0) && (((x) & ((x) - 1)) == 0))
+#define ALIGN_UP(x, align) (((x) + (align) - 1) & ~((align) - 1))
+
+/* 最低位 1 的下标 (count trailing zeros)，x 必须非 0 */
+static inline unsigned bit_ctz64(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+/* 最高位 1 之上的 0 的个数 (count leading zeros)，x 必须非 0 */
+static inline unsigned bit_clz64(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return 63u - (unsigned)idx;
+#else
+    return (unsigned)__builtin_clzll(x);
+#endif
+}
+
+/* 1 的个数 (population count) */
+static inline unsigned bit_popcount64(uint64_t x) {
+#if defined(_MSC_VER)
+    return (unsigned)__popcnt64(x);
+#else
+    return (unsigned)__builtin_popcountll(x);
+#endif
+}
+
+#endif /* ADV_COMMON_H */
@@ -0,0 +1,364 @@
+/**
+ * @file cpu_topo.c
+ * @brief CPU 拓扑的读取、放置顺序与线程绑定
+ */
+
+/* 严格 C11 模式下 pthread_setaffinity_np、CPU_SET 和 sched_getcpu 需要 GNU 扩展 */
+#if defined(__linux__)
+  #define _GNU_SOURCE
+#endif
+
+#include "cpu_topo.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+  #include <unistd.h>
+#endif
+
+#define SYSFS_CPU  "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+#define TOPO_MAX_CACHE_INDEX 16 /* cache/index0..index15，实际一般只有 4 个 */
+
+/* ========================================================================== */
+/*                              sysfs 解析                                    */
+/* ========================================================================== */
+
+/* 读一个小文件到 buf，去掉末尾换行 */
+static bool read_text(const char* path, char* buf, size_t size) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    size_t n = fread(buf, 1, size - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ')) buf[--n] = '\0';
+    return n > 0;
+}
+
+static bool read_int(const char* path, int* value) {
+    char buf[32];
+    if (!read_text(path, buf, sizeof(buf))) return false;
+    char* end;
+    long v = strtol(buf, &end, 10);
+    if (end == buf) return false;
+    *value = (int)v;
+    return true;
+}
+
+/*
+ * 逐段解析 cpulist 格式（如 "0-3,8-11,16"）：每次取出一段 [lo, hi]，没有更多段时返回 false。
+ * sysfs 的 CPU 列表、NUMA 节点列表都是这种格式。
+ */
+static bool cpulist_next(const char** p, int* lo, int* hi) {
+    const char* s = *p;
+    while (*s == ',' || *s == ' ') s++;
+    if (*s < '0' || *s > '9') return false;
+    char* end;
+    *lo = (int)strtol(s, &end, 10);
+    *hi = *lo;
+    if (*end == '-') *hi = (int)strtol(end + 1, &end, 10);
+    *p = end;
+    return *hi >= *lo;
+}
+
+static int cpulist_count(const char* list) {
+    int count = 0, lo, hi;
+    while (cpulist_next(&list, &lo, &hi)) count += hi - lo + 1;
+    return count;
+}
+
+static int cpulist_first(const char* list) {
+    int lo, hi;
+    return cpulist_next(&list, &lo, &hi) ? lo : -1;
+}
+
+/* L3 域的标识：共享这块 L3 的编号最小的 CPU；没有 L3 信息时返回 -1 */
+static int l3_key(int cpu) {
+    char path[128], buf[1024];
+    for (int i = 0; i < TOPO_MAX_CACHE_INDEX; i++) {
+        int level;
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, i);
+        if (!read_int(path, &level)) break;
+        if (level != 3) continue;
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, i);
+        if (read_text(path, buf, sizeof(buf))) return cpulist_first(buf);
+    }
+    return -1;
+}
+
+/* 把 NUMA 节点号写进 raw（与 cpus[] 下标对应），读不到节点信息时保持原值 */
+static void read_nodes(const CpuTopo* t, int* raw) {
+    char buf[1024], path[128], cpus[4096];
+    if (!read_text(SYSFS_NODE "/online", buf, sizeof(buf))) return;
+    const char* p = buf;
+    int lo, hi;
+    while (cpulist_next(&p, &lo, &hi)) {
+        for (int node = lo; node <= hi; node++) {
+            snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", node);
+            if (!read_text(path, cpus, sizeof(cpus))) continue;
+            const char* q = cpus;
+            int a, b;
+            while (cpulist_next(&q, &a, &b)) {
+                for (int cpu = a; cpu <= b; cpu++) {
+                    int idx = cpu_topo_find(t, cpu);
+                    if (idx >= 0) raw[idx] = node;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * 把 cpus[].<offset 处的字段> 里的任意编号按首次出现的顺序压缩成 0..k-1，返回 k。
+ * sysfs 的 core_id 不连续（常见 0,1,2,4,5,6...），节点号也可能有空洞。
+ */
+static int densify(CpuTopo* t, size_t offset, int* scratch) {
+#define TOPO_FIELD(i) (*(int*)((char*)&t->cpus[i] + offset))
+    for (int i = 0; i < t->ncpus; i++) scratch[i] = TOPO_FIELD(i);
+    int k = 0;
+    for (int i = 0; i < t->ncpus; i++) {
+        int j = 0;
+        while (j < i && scratch[j] != scratch[i]) j++;
+        TOPO_FIELD(i) = j < i ? TOPO_FIELD(j) : k++;
+    }
+    return k;
+#undef TOPO_FIELD
+}
+
+static CpuTopo* topo_alloc(int ncpus) {
+    CpuTopo* t = (CpuTopo*)calloc(1, sizeof(CpuTopo) + (size_t)ncpus * sizeof(CpuInfo));
+    if (t) t->ncpus = ncpus;
+    return t;
+}
+
+/* 读不到 sysfs 时：每个 CPU 一个核心，全部在同一个插槽、L3 和节点 */
+static CpuTopo* topo_flat(void) {
+    int n = 1;
+#if defined(_SC_NPROCESSORS_ONLN)
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online > 0) n = (int)online;
+#endif
+    CpuTopo* t = topo_alloc(n);
+    if (!t) return NULL;
+    for (int i = 0; i < n; i++) t->cpus[i] = (CpuInfo){.cpu = i, .core = i};
+    t->ncores = n;
+    t->npackages = t->nl3 = t->nnodes = 1;
+    return t;
+}
+
+static CpuTopo* topo_from_sysfs(void) {
+    char online[4096], path[128];
+    if (!read_text(SYSFS_CPU "/online", online, sizeof(online))) return NULL;
+    int n = cpulist_count(online);
+    if (n <= 0) return NULL;
+    CpuTopo* t = topo_alloc(n);
+    int* scratch = (int*)malloc((size_t)n * sizeof(int));
+    if (!t || !scratch) {
+        free(t);
+        free(scratch);
+        return NULL;
+    }
+
+    // 先填原始编号，再压缩成连续编号
+    const char* p = online;
+    int lo, hi, i = 0;
+    while (cpulist_next(&p, &lo, &hi)) {
+        for (int cpu = lo; cpu <= hi && i < n; cpu++, i++) {
+            CpuInfo* c = &t->cpus[i];
+            int core_id = cpu, package = 0;
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_id", cpu);
+            read_int(path, &core_id);
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+            read_int(path, &package);
+            int l3 = l3_key(cpu);
+            c->cpu = cpu;
+            c->package = package;
+            c->core = package * 65536 + core_id;  // core_id 只在插槽内唯一
+            c->l3 = l3 >= 0 ? l3 : -1 - package;  // 没有 L3 信息就按插槽划分
+            c->node = 0;
+        }
+    }
+
+    for (int k = 0; k < n; k++) scratch[k] = 0;
+    read_nodes(t, scratch);
+    for (int k = 0; k < n; k++) t->cpus[k].node = scratch[k];
+
+    t->npackages = densify(t, offsetof(CpuInfo, package), scratch);
+    t->ncores = densify(t, offsetof(CpuInfo, core), scratch);
+    t->nl3 = densify(t, offsetof(CpuInfo, l3), scratch);
+    t->nnodes = densify(t, offsetof(CpuInfo, node), scratch);
+    for (int k = 0; k < n; k++) {
+        int smt = 0;
+        for (int j = 0; j < k; j++) smt += t->cpus[j].core == t->cpus[k].core;
+        t->cpus[k].smt = smt;
+    }
+    t->from_sysfs = true;
+    free(scratch);
+    return t;
+}
+
+/* ========================================================================== */
+/*                              对外接口                                      */
+/* ========================================================================== */
+
+CpuTopo* cpu_topo_load(void) {
+#if defined(__linux__)
+    CpuTopo* t = topo_from_sysfs();
+    if (t) return t;
+#endif
+    return topo_flat();
+}
+
+void cpu_topo_free(CpuTopo* topo) {
+    free(topo);
+}
+
+int cpu_topo_find(const CpuTopo* topo, int cpu) {
+    for (int i = 0; i < topo->ncpus; i++) {
+        if (topo->cpus[i].cpu == cpu) return i;
+    }
+    return -1;
+}
+
+typedef struct {
+    int key[4];
+    int idx;
+} PlaceKey;
+
+static int place_key_cmp(const void* a, const void* b) {
+    const PlaceKey* x = (const PlaceKey*)a;
+    const PlaceKey* y = (const PlaceKey*)b;
+    for (int i = 0; i < 4; i++) {
+        if (x->key[i] != y->key[i]) return x->key[i] < y->key[i] ? -1 : 1;
+    }
+    return (x->idx > y->idx) - (x->idx < y->idx);
+}
+
+void cpu_topo_order(const CpuTopo* topo, CpuPlacement placement, int* out) {
+    int n = topo->ncpus;
+    PlaceKey* keys = (PlaceKey*)malloc((size_t)n * sizeof(PlaceKey));
+    int* core_ord = (int*)calloc((size_t)topo->ncores, sizeof(int));
+    int* l3_ord = (int*)calloc((size_t)topo->nl3, sizeof(int));
+    if (!keys || !core_ord || !l3_ord || placement == CPU_PLACE_NONE) {
+        for (int i = 0; i < n; i++) out[i] = i;
+        free(keys);
+        free(core_ord);
+        free(l3_ord);
+        return;
+    }
+
+    // 核心在所属 L3 域内的序号、L3 域在所属插槽内的序号
+    int* core_l3 = (int*)malloc((size_t)topo->ncores * sizeof(int));
+    int* l3_pkg = (int*)malloc((size_t)topo->nl3 * sizeof(int));
+    if (core_l3 && l3_pkg) {
+        for (int i = 0; i < n; i++) {
+            core_l3[topo->cpus[i].core] = topo->cpus[i].l3;
+            l3_pkg[topo->cpus[i].l3] = topo->cpus[i].package;
+        }
+        for (int c = 0; c < topo->ncores; c++) {
+            for (int d = 0; d < c; d++) core_ord[c] += core_l3[d] == core_l3[c];
+        }
+        for (int l = 0; l < topo->nl3; l++) {
+            for (int d = 0; d < l; d++) l3_ord[l] += l3_pkg[d] == l3_pkg[l];
+        }
+    }
+    free(core_l3);
+    free(l3_pkg);
+
+    for (int i = 0; i < n; i++) {
+        const CpuInfo* c = &topo->cpus[i];
+        PlaceKey* k = &keys[i];
+        k->idx = i;
+        if (placement == CPU_PLACE_COMPACT) {
+            // 插槽 -> L3 域 -> 核心 -> SMT：相邻线程尽量共享核心和缓存
+            k->key[0] = c->package;
+            k->key[1] = c->l3;
+            k->key[2] = c->core;
+            k->key[3] = c->smt;
+        } else {
+            // 先用遍所有物理核心的第一个硬件线程，同一轮内轮流换插槽、换 L3 域
+            k->key[0] = c->smt;
+            k->key[1] = core_ord[c->core];
+            k->key[2] = l3_ord[c->l3];
+            k->key[3] = c->package;
+        }
+    }
+    qsort(keys, (size_t)n, sizeof(PlaceKey), place_key_cmp);
+    for (int i = 0; i < n; i++) out[i] = keys[i].idx;
+    free(keys);
+    free(core_ord);
+    free(l3_ord);
+}
+
+static void print_range(FILE* out, const char* sep, int lo, int hi) {
+    if (lo == hi) fprintf(out, "%s%d", sep, lo);
+    else fprintf(out, "%s%d-%d", sep, lo, hi);
+}
+
+void cpu_topo_print(const CpuTopo* topo, FILE* out) {
+    int smt = topo->ncores > 0 ? topo->ncpus / topo->ncores : 1;
+    fprintf(out, "CPU 拓扑%s: %d 个逻辑 CPU, %d 个物理核心 (SMT x%d), %d 个插槽, %d 个 L3 域, "
+            "%d 个 NUMA 节点\n", topo->from_sysfs ? "" : " (未读到 sysfs, 按平坦拓扑处理)",
+            topo->ncpus, topo->ncores, smt, topo->npackages, topo->nl3, topo->nnodes);
+    for (int l = 0; l < topo->nl3; l++) {
+        // 按 cpulist 格式输出，连续编号合并成区间
+        int lo = -1, prev = -1;
+        const char* sep = " ";
+        for (int i = 0; i < topo->ncpus; i++) {
+            const CpuInfo* c = &topo->cpus[i];
+            if (c->l3 != l) continue;
+            if (lo < 0) fprintf(out, "  L3 #%d (插槽 %d, 节点 %d): CPU", l, c->package, c->node);
+            if (lo >= 0 && c->cpu == prev + 1) {
+                prev = c->cpu;
+                continue;
+            }
+            if (lo >= 0) {
+                print_range(out, sep, lo, prev);
+                sep = ",";
+            }
+            lo = prev = c->cpu;
+        }
+        if (lo >= 0) {
+            print_range(out, sep, lo, prev);
+            fprintf(out, "\n");
+        }
+    }
+}
+
+bool cpu_pin_current(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((size_t)cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+bool cpu_unpin_current(void) {
+#if defined(__linux__)
+    // 掩码与进程允许的 CPU 取交集，所以直接全部置位即可
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < CPU_SETSIZE; i++) CPU_SET(i, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+int cpu_current(void) {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
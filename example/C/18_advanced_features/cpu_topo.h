@@ -0,0 +1,73 @@
+/**
+ * @file cpu_topo.h
+ * @brief CPU 拓扑：核心、SMT 兄弟、L3 域与 NUMA 节点，以及把线程绑到指定 CPU
+ *
+ * 线程默认由操作系统随意调度，两个频繁交换数据的线程可能一个在插槽 0、一个在插槽 1，
+ * 每次交接都要跨插槽搬缓存行；内存按“第一次写入”分配在写入者所在的 NUMA 节点，
+ * 之后从另一个节点读它要多走一跳。这里读取 Linux 的 /sys/devices/system/cpu：
+ * 1. topology/core_id、physical_package_id 得到物理核心与插槽，同一核心的逻辑 CPU 是 SMT 兄弟；
+ * 2. cache/indexN 中 level 为 3 的 shared_cpu_list 得到共享 L3 的 CPU 集合（没有 L3 时按插槽）；
+ * 3. /sys/devices/system/node/nodeN/cpulist 得到 NUMA 节点。
+ * 读不到 sysfs（非 Linux、容器限制）时退化为“每个 CPU 一个核心、同一个 L3 和节点”的平坦拓扑。
+ *
+ * 放置策略：
+ *   CPU_PLACE_COMPACT  先占满一个核心的 SMT 兄弟，再同一 L3 的其他核心，适合共享数据多的线程
+ *   CPU_PLACE_SCATTER  轮流分到各插槽/L3 域的不同物理核心，最后才用 SMT 兄弟，
+ *                      适合各自扫描大块内存、需要更多缓存和内存带宽的线程
+ */
+
+#ifndef CPU_TOPO_H
+#define CPU_TOPO_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct {
+    int cpu;     /* 逻辑 CPU 编号（cpuN 的 N） */
+    int core;    /* 物理核心，0..ncores-1，同一核心的 SMT 兄弟相同 */
+    int smt;     /* 在所属核心内的序号，0 是第一个硬件线程 */
+    int package; /* 插槽，0..npackages-1 */
+    int l3;      /* 共享 L3 的域，0..nl3-1 */
+    int node;    /* NUMA 节点，0..nnodes-1 */
+} CpuInfo;
+
+typedef struct {
+    int ncpus;
+    int ncores;
+    int npackages;
+    int nl3;
+    int nnodes;
+    bool from_sysfs; /* false 表示退化成了平坦拓扑 */
+    CpuInfo cpus[];  /* 按逻辑 CPU 编号升序 */
+} CpuTopo;
+
+typedef enum {
+    CPU_PLACE_NONE,    /* 不绑定，由操作系统调度 */
+    CPU_PLACE_COMPACT,
+    CPU_PLACE_SCATTER,
+} CpuPlacement;
+
+/* 读取当前在线 CPU 的拓扑，只有内存不足时返回 NULL */
+CpuTopo* cpu_topo_load(void);
+void cpu_topo_free(CpuTopo* topo);
+
+/* 逻辑 CPU 编号在 cpus[] 中的下标，不存在返回 -1 */
+int cpu_topo_find(const CpuTopo* topo, int cpu);
+
+/*
+ * 按放置策略给出 CPU 的使用顺序：out[k] 是第 k 个线程应绑定的 cpus[] 下标，
+ * out 至少要有 ncpus 个元素。CPU_PLACE_NONE 按编号顺序。
+ */
+void cpu_topo_order(const CpuTopo* topo, CpuPlacement placement, int* out);
+
+/* 一行概要加每个 L3 域的 CPU 列表 */
+void cpu_topo_print(const CpuTopo* topo, FILE* out);
+
+/* 把调用线程绑定到逻辑 CPU（pthread_setaffinity_np），不支持或失败返回 false */
+bool cpu_pin_current(int cpu);
+/* 解除绑定，允许在所有在线 CPU 上运行 */
+bool cpu_unpin_current(void);
+/* 调用线程此刻所在的逻辑 CPU，取不到返回 -1 */
+int cpu_current(void);
+
+#endif /* CPU_TOPO_H */
@@ -20,92 +20,65 @@
 #include <math.h>
 #include <assert.h>
 
-/* 检测是否支持 C11 线程库 */
-#if defined(__STDC_NO_THREADS__) || defined(__MINGW32__)
-  #define HAS_THREADS 0
-#else
-  #include <threads.h>
-  #include <stdatomic.h>
-  #define HAS_THREADS 1
-#endif
+#include "arena.h"
+#include "async_log.h"
+#include "bench.h"
+#include "cmd_hash_tables.h" /* 构建时由 tools/cmd_hash_gen.c 生成 */
+#include "cmd_queue.h"
+#include "commands.h"
+#include "common.h" /* HAS_THREADS：检测是否支持 C11 线程库 */
+#include "cpu_topo.h"
+#include "mem_align.h"
+#include "mem_pool.h"
+#include "mem_track.h"
+#include "parallel.h"
+#include "ring_queue.h"
+#include "sharded_counter.h"
+#include "slab.h"
+#include "tc_pool.h"
+#include "vec.h"
+#include "ws_pool.h"
 
 /* ========================================================================== */
 /*                           一、内存管理进阶                                */
 /* ========================================================================== */
 
-/* 1.1 自定义内存池 */
-typedef struct {
-    void* memory;
-    size_t block_size;
-    size_t block_count;
-    bool* free_map;
-} MemPool;
-
-MemPool* pool_create(size_t block_size, size_t count) {
-    MemPool* p = (MemPool*)malloc(sizeof(MemPool));
-    if (!p) return NULL;
-    
-    p->memory = malloc(block_size * count);
-    p->block_size = block_size;
-    p->block_count = count;
-    p->free_map = (bool*)calloc(count, sizeof(bool)); /* false = 空闲 */
-    
-    // 简单的错误处理
-    if (!p->memory || !p->free_map) {
-        free(p->memory);
-        free(p->free_map);
-        free(p);
-        return NULL;
-    }
-    return p;
-}
-
-void* pool_alloc(MemPool* p) {
-    for (size_t i = 0; i < p->block_count; i++) {
-        if (!p->free_map[i]) {
-            p->free_map[i] = true;
-            return (char*)p->memory + i * p->block_size;
-        }
-    }
-    return NULL; /* 池满 */
-}
-
-void pool_free(MemPool* p, void* ptr) {
-    // 检查指针是否在池内
-    char* start = (char*)p->memory;
-    char* end = start + (p->block_size * p->block_count);
-    if ((char*)ptr < start || (char*)ptr >= end) {
-        printf("错误: 释放了不属于该内存池的指针\n");
-        return;
-    }
-    
-    size_t idx = ((char*)ptr - (char*)p->memory) / p->block_size;
-    p->free_map[idx] = false;
-}
-
-void pool_destroy(MemPool* p) {
-    if (!p) return;
-    free(p->memory);
-    free(p->free_map);
-    free(p);
-}
+/* 1.1 自定义内存池：实现见 mem_pool.h / mem_pool.c */
 
 /* 1.2 内存泄漏检测宏演示 */
 /* 注意：实际工程中通常会放在独立的头文件中，并通过宏开关控制 */
-#ifdef DEBUG_MEM
+#if defined(DEBUG_MEM) && HAS_THREADS
+    /* 只记账不打印，退出时调用 track_report 输出泄漏与热点报告（见 mem_track.h） */
+    #define MY_MALLOC(size) track_malloc(size, __FILE__, __LINE__)
+    #define MY_FREE(ptr)    track_free(ptr)
+#elif defined(DEBUG_MEM)
     #define MY_MALLOC(size) _debug_malloc(size, __FILE__, __LINE__)
     #define MY_FREE(ptr)    free(ptr)
+#elif defined(USE_SLAB)
+    /* 接口与 malloc/free 一致，编译时加 -DUSE_SLAB 即可整体切换到 slab 分配器 */
+    #define MY_MALLOC(size) slab_malloc(size)
+    #define MY_FREE(ptr)    slab_free(ptr)
 #else
     #define MY_MALLOC(size) malloc(size)
     #define MY_FREE(ptr)    free(ptr)
 #endif
 
+/* 朴素版本：每次分配打印一行，只适合小程序肉眼观察，压力下既慢又找不到泄漏 */
 void* _debug_malloc(size_t size, const char* file, int line) {
     void* ptr = malloc(size);
     printf("[内存分配] 地址:%p 大小:%zu 位置:%s:%d\n", ptr, size, file, line);
     return ptr;
 }
 
+/* 1.3 类型泛型动态数组：前 4 个元素放在结构体内部，超出后才上堆 */
+VEC_DEFINE(IntVec, int, 4)
+
+/* 遍历回调：这里只是把 ctx 指向的计数加一，实际工程中可以在这里调用对象的析构函数 */
+static void count_live_block(void* block, void* ctx) {
+    (void)block;
+    (*(size_t*)ctx)++;
+}
+
 void test_memory_advanced() {
     printf("\n--- 1. 内存管理进阶示例 ---\n");
     
@@ -126,11 +99,111 @@ void test_memory_advanced() {
     printf("再次分配，应该复用 p2 的位置: %p\n", p4);
     
     pool_destroy(pool);
-    
+
+    // 位图模式：占用情况可查询，存活块可遍历
+    printf("位图模式内存池 (块大小: 32, 数量: 100)...\n");
+    MemPool* bitmap_pool = pool_create_ex(32, 100, POOL_MODE_BITMAP, 0);
+    void* blocks[10];
+    for (int i = 0; i < 10; i++) blocks[i] = pool_alloc(bitmap_pool);
+    for (int i = 0; i < 10; i += 3) pool_free(bitmap_pool, blocks[i]);
+    pool_free(bitmap_pool, blocks[0]); // 演示：位图模式能发现重复释放
+
+    size_t visited = 0;
+    pool_foreach_live(bitmap_pool, count_live_block, &visited);
+    PoolOccupancy occ = pool_occupancy(bitmap_pool);
+    printf("  遍历到 %zu 个存活块; 占用报告: 存活=%zu 跨度=%zu 空闲分组=%zu/%zu\n", visited,
+           occ.live_blocks, occ.live_span, occ.empty_words, occ.total_words);
+    PoolStats stats = pool_stats(bitmap_pool);
+    pool_stats_dump(stdout, "bitmap_demo", &stats);
+    pool_reset(bitmap_pool);
+    printf("  pool_reset 后存活块: %zu\n", pool_occupancy(bitmap_pool).live_blocks);
+    pool_destroy(bitmap_pool);
+    printf("两种模式的性能差异可运行 --bench pool 查看\n");
+
+    // 大池改用 mmap + 透明大页，空闲整页可以还给内核
+    MemPool* huge_pool = pool_create_ex(64, 64 * 1024, POOL_MODE_BITMAP, POOL_FLAG_HUGEPAGE);
+    if (huge_pool) {
+        for (int i = 0; i < 1000; i++) pool_alloc(huge_pool);
+        printf("大页内存池 (4MB): 分配 1000 块后归还空闲页 %zu KB\n",
+               pool_release_free(huge_pool) >> 10);
+        pool_destroy(huge_pool);
+    }
+    printf("大页对随机访问的影响可运行 --bench hugepage 查看\n");
+
+    // 对齐分配：缓存行对齐的块互不伪共享，NUMA 机器上还可以把页绑定到指定节点
+    MemPool* padded_pool = pool_create_ex(8, 4, POOL_MODE_FREELIST, POOL_FLAG_CACHE_ALIGN);
+    void* line = mem_alloc_cacheline(24);
+    void* pages = mem_alloc_on_node(8192, 0);
+    if (padded_pool && line && pages) {
+        char* b0 = (char*)pool_alloc(padded_pool);
+        char* b1 = (char*)pool_alloc(padded_pool);
+        printf("缓存行对齐池: 相邻块间距 %td 字节; 对齐分配地址 %% 64 = %zu; NUMA 节点数 %d\n",
+               b1 - b0, (size_t)((uintptr_t)line % CACHE_LINE_SIZE), mem_numa_node_count());
+    }
+    pool_destroy(padded_pool);
+    mem_aligned_free(line);
+    mem_free_pages(pages, 8192);
+
+    // 分级 slab 分配器：接口与 malloc/realloc/free 相同，演示 11_memory 中的扩容流程
+    int* arr = (int*)slab_malloc(sizeof(int) * 2);
+    if (arr) {
+        arr[0] = 10;
+        arr[1] = 20;
+        int* bigger = (int*)slab_realloc(arr, sizeof(int) * 100);
+        if (bigger) {
+            arr = bigger;
+            printf("slab 分配器: realloc 到 100 个 int 后数据仍在: %d, %d (可用 %zu 字节)\n",
+                   arr[0], arr[1], slab_usable_size(arr));
+        }
+        slab_free(arr);
+    } else {
+        printf("slab 分配失败\n");
+    }
+
+    // 区域分配器：按请求分配，标记/回退一步释放
+    Arena arena;
+    arena_init(&arena, 1024);
+    ArenaMark mark = arena_mark(&arena);
+    char* buf = (char*)arena_alloc(&arena, 16);
+    char* grown = (char*)arena_realloc(&arena, buf, 16, 256);
+    printf("arena: 最近一次分配原地扩容 16 -> 256 字节, 地址不变: %s\n", grown == buf ? "是" : "否");
+    arena_alloc(&arena, 100);
+    arena_restore(&arena, mark);
+    printf("arena: 回退到标记后再分配, 复用同一地址: %s\n",
+           arena_alloc(&arena, 16) == buf ? "是" : "否");
+    arena_destroy(&arena);
+
+    // 动态数组：取代 06_arrays 里手动传递的 int arr[] + size
+    IntVec vec;
+    IntVec_init(&vec);
+    for (int i = 1; i <= 3; i++) IntVec_push(&vec, i * 10);
+    printf("IntVec: 3 个元素仍在内部缓冲区 (容量 %zu)\n", vec.capacity);
+    const int more[] = {40, 50, 60, 70};
+    IntVec_append(&vec, more, sizeof(more) / sizeof(more[0]));
+    printf("IntVec: 批量追加后 %zu 个元素, 容量 %zu, 最后一个 %d\n", vec.size, vec.capacity,
+           IntVec_data(&vec)[vec.size - 1]);
+    vec.size = 2;
+    IntVec_shrink_to_fit(&vec);
+    printf("IntVec: 截断到 2 个并 shrink_to_fit, 容量回到 %zu\n", vec.capacity);
+    IntVec_free(&vec);
+
     // 测试 Debug Malloc (手动开启演示)
     printf("测试调试版 Malloc:\n");
     void* ptr = _debug_malloc(128, __FILE__, __LINE__);
     free(ptr);
+
+#if HAS_THREADS
+    // 追踪版：记录存活分配并按调用点聚合，需要时再统一输出报告
+    printf("测试追踪版 Malloc (模拟一个调用点未释放):\n");
+    void* tracked[8];
+    for (int i = 0; i < 8; i++) tracked[i] = track_malloc(64, __FILE__, __LINE__);
+    void* big = track_malloc(4096, __FILE__, __LINE__);
+    for (int i = 0; i < 6; i++) track_free(tracked[i]);
+    track_report(stdout, 3);
+    track_free(tracked[6]);
+    track_free(tracked[7]);
+    track_free(big);
+#endif
 }
 
 /* ========================================================================== */
@@ -140,13 +213,7 @@ void test_memory_advanced() {
 /* 2.1 函数指针数组（跳转表） */
 typedef void (*CmdHandler)(const char* args);
 
-/* 枚举命令 */
-typedef enum {
-    CMD_HELP,
-    CMD_LOAD,
-    CMD_SAVE,
-    CMD_MAX
-} CommandType;
+/* 枚举命令：CommandType 由 commands.h 中的 COMMAND_LIST 展开 */
 
 void cmd_help(const char* args) { printf("执行帮助命令, 参数: %s\n", args); }
 void cmd_load(const char* args) { printf("执行加载命令, 参数: %s\n", args); }
@@ -168,11 +235,127 @@ void dispatch(CommandType cmd, const char* args) {
     cmd_table[cmd](args);
 }
 
+/*
+ * 2.2 按命令名分派：线上收到的是字符串，用构建时生成的完美哈希表（cmd_hash.h）
+ * 一次哈希 + 一次 memcmp 得到 CommandType，再走上面的跳转表。名字不要求以 '\0' 结尾。
+ */
+bool dispatch_name(const char* name, size_t len, const char* args) {
+    int cmd = cmd_hash_find(&cmd_hash_commands, name, len);
+    if (cmd < 0) {
+        printf("未知命令: %.*s\n", (int)len, name);
+        return false;
+    }
+    cmd_table[cmd](args);
+    return true;
+}
+
+typedef struct {
+    const char* name;
+    size_t len;
+    const char* args;
+} CmdCall;
+
+#define DISPATCH_BATCH 64
+
+/*
+ * 批量分派：每 DISPATCH_BATCH 条先集中解析命令名，再依次执行。
+ * 解析互不依赖，放在一个循环里可以重叠；处理函数不会插在中间把哈希表挤出缓存。
+ * 返回执行成功的条数，未知命令跳过。
+ */
+size_t dispatch_many(const CmdCall* calls, size_t n) {
+    size_t done = 0;
+    for (size_t i = 0; i < n; i += DISPATCH_BATCH) {
+        size_t m = n - i < DISPATCH_BATCH ? n - i : DISPATCH_BATCH;
+        const char* names[DISPATCH_BATCH];
+        size_t lens[DISPATCH_BATCH];
+        int cmds[DISPATCH_BATCH];
+        for (size_t k = 0; k < m; k++) {
+            names[k] = calls[i + k].name;
+            lens[k] = calls[i + k].len;
+        }
+        cmd_hash_find_many(&cmd_hash_commands, names, lens, m, cmds);
+        for (size_t k = 0; k < m; k++) {
+            if (cmds[k] < 0) continue;
+            cmd_table[cmds[k]](calls[i + k].args);
+            done++;
+        }
+    }
+    return done;
+}
+
+#if HAS_THREADS
+/*
+ * 2.3 命令队列：提交后立即返回，由工作线程成批执行上面的跳转表（实现见 cmd_queue.h）。
+ * 同一个文件的命令用文件名的哈希作 key，保证先 load 后 save；help 不关心顺序，key 为 0。
+ */
+static const char* const cmd_names[CMD_MAX] = {
+#define COMMAND_NAME(id, name) [id] = name,
+    COMMAND_LIST(COMMAND_NAME)
+#undef COMMAND_NAME
+};
+
+static uint64_t cmd_key_of(const char* path) {
+    return cmd_hash_bytes(0, path, strlen(path)) | 1; /* key 为 0 表示不要求顺序 */
+}
+
+static void on_cmd_done(int cmd, const char* args, void* user) {
+    (void)cmd;
+    (void)args;
+    atomic_fetch_add((atomic_int*)user, 1);
+}
+
+static void demo_cmd_queue(void) {
+    CmdQueueOptions opts = {.nworkers = 2, .capacity = 64, .batch = 8, .group_by_type = true};
+    CmdQueue* q = cmd_queue_create(cmd_table, CMD_MAX, &opts);
+    if (!q) {
+        printf("命令队列创建失败\n");
+        return;
+    }
+    atomic_int done;
+    atomic_init(&done, 0);
+    const char* files[] = {"a.cfg", "b.cfg"};
+    for (int i = 0; i < 2; i++) {
+        CmdRequest load = {CMD_LOAD, files[i], cmd_key_of(files[i]), on_cmd_done, &done};
+        CmdRequest save = {CMD_SAVE, files[i], cmd_key_of(files[i]), on_cmd_done, &done};
+        cmd_queue_submit(q, &load);
+        cmd_queue_submit(q, &save);
+    }
+    CmdRequest help = {CMD_HELP, "--queue", 0, on_cmd_done, &done};
+    cmd_queue_submit(q, &help);
+    cmd_queue_wait(q);
+    printf("命令队列 (%d 个工作线程): %d 条命令已完成，同一文件的 load 总在 save 之前"
+           " (与同步 dispatch 的对比见 --bench cmdqueue)\n",
+           cmd_queue_workers(q), atomic_load(&done));
+    cmd_queue_report(q, cmd_names, stdout);
+    cmd_queue_destroy(q);
+}
+#endif
+
 void test_pointer_advanced() {
     printf("\n--- 2. 指针高级用法示例 ---\n");
     dispatch(CMD_LOAD, "config.json");
     dispatch(CMD_HELP, "--verbose");
     dispatch(CMD_SAVE, "data.bin");
+
+    // 命令名来自“线上”的一行文本：按空格切出名字，长度已知，不需要 '\0'
+    const char* line = "load settings.ini";
+    const char* space = strchr(line, ' ');
+    dispatch_name(line, (size_t)(space - line), space + 1);
+    dispatch_name("reboot", 6, "now");
+
+    const CmdCall calls[] = {
+        {"help", 4, "dispatch_many"},
+        {"save", 4, "out.bin"},
+        {"lod", 3, "typo.txt"},
+        {"load", 4, "in.bin"},
+    };
+    size_t ok = dispatch_many(calls, sizeof(calls) / sizeof(calls[0]));
+    printf("dispatch_many: %zu/%zu 条命令已执行 (名字到处理函数的查找速度见 --bench cmdhash)\n", ok,
+           sizeof(calls) / sizeof(calls[0]));
+
+#if HAS_THREADS
+    demo_cmd_queue();
+#endif
 }
 
 /* ========================================================================== */
@@ -222,8 +405,7 @@ void test_preprocessor() {
 /*                             四、位操作进阶                                */
 /* ========================================================================== */
 
-#define IS_POWER_OF_2(x) (((x) > 0) && (((x) & ((x) - 1)) == 0))
-#define ALIGN_UP(x, align) (((x) + (align) - 1) & ~((align) - 1))
+/* IS_POWER_OF_2 / ALIGN_UP 定义在 common.h 中，内存池等模块也会用到 */
 
 /* 交换两数（无临时变量） - 仅作演示，实际推荐用临时变量更清晰 */
 void swap_xor(int* a, int* b) {
@@ -270,8 +452,19 @@ void test_bitwise() {
 /* ========================================================================== */
 
 void log_printf(const char* level, const char* fmt, ...) {
+    // 级别过滤放在最前面，被过滤掉的日志不做任何格式化
+    if (!log_level_enabled(log_level_from_name(level))) return;
+
     va_list args;
     va_start(args, fmt);
+#if HAS_THREADS
+    // 异步模式：只把参数拷进本线程的缓冲区，格式化和输出交给后台线程（见 async_log.h）
+    if (async_log_running()) {
+        async_log_vwrite(level, fmt, args);
+        va_end(args);
+        return;
+    }
+#endif
     
     fprintf(stdout, "[%s] ", level);
     vfprintf(stdout, fmt, args);
@@ -282,27 +475,97 @@ void log_printf(const char* level, const char* fmt, ...) {
 
 #if HAS_THREADS
 
+typedef struct {
+    int id;
+    int cpu; /* 要绑定的逻辑 CPU，-1 表示交给操作系统调度 */
+} WorkerArg;
+
 int worker_thread(void* arg) {
-    int id = *(int*)arg;
-    printf("线程 %d 正在运行...\n", id);
+    WorkerArg* w = (WorkerArg*)arg;
+    bool pinned = w->cpu >= 0 && cpu_pin_current(w->cpu);
+    printf("线程 %d 正在运行 (CPU %d%s)...\n", w->id, cpu_current(), pinned ? ", 已绑定" : "");
+    return 0;
+}
+
+/* 每个线程通过自己的 TcCache 从共享的线程缓存池中分配，快路径不加锁 */
+int tc_pool_worker(void* arg) {
+    TcPool* tp = (TcPool*)arg;
+    TcCache* cache = tc_cache_create(tp);
+    if (!cache) return 1;
+    void* blocks[100];
+    for (int i = 0; i < 100; i++) blocks[i] = tc_alloc(cache);
+    for (int i = 0; i < 100; i++) tc_free(cache, blocks[i]);
+    tc_cache_destroy(cache);
     return 0;
 }
 
+/* 线程池任务：参数指向调用者栈上的数据，ws_wait 返回前它一直有效 */
+static void square_task(void* arg) {
+    int* x = (int*)arg;
+    *x = *x * *x;
+}
+
+/* 与 09_struct_union 中的 Student 相同的记录，用来演示并行统计 */
 typedef struct {
-    atomic_int counter;
-    atomic_flag lock;
-} ThreadSafeCounter;
-
-void safe_increment(ThreadSafeCounter* c) {
-    // 自旋锁保护 (仅作演示，原子操作本身不需要锁，这里演示复合操作或锁机制)
-    while (atomic_flag_test_and_set(&c->lock)) {
-        // 自旋等待
+    int id;
+    char name[20];
+    float score;
+} ParStudent;
+
+typedef struct {
+    double sum;
+    float best;
+} ScoreStats;
+
+/* parallel_reduce 的累加函数：只处理 [begin, end) 这一段 */
+static void score_body(size_t begin, size_t end, void* acc, void* ctx) {
+    const ParStudent* s = (const ParStudent*)ctx;
+    ScoreStats* st = (ScoreStats*)acc;
+    for (size_t i = begin; i < end; i++) {
+        st->sum += s[i].score;
+        if (s[i].score > st->best) st->best = s[i].score;
     }
-    
-    // 临界区
-    atomic_fetch_add(&c->counter, 1);
-    
-    atomic_flag_clear(&c->lock);
+}
+
+static void score_combine(void* acc, const void* other, void* ctx) {
+    (void)ctx;
+    ScoreStats* a = (ScoreStats*)acc;
+    const ScoreStats* b = (const ScoreStats*)other;
+    a->sum += b->sum;
+    if (b->best > a->best) a->best = b->best;
+}
+
+/* parallel_for 的块函数：每块独立地给成绩加 5 分 */
+static void curve_scores(size_t begin, size_t end, void* ctx) {
+    ParStudent* s = (ParStudent*)ctx;
+    for (size_t i = begin; i < end; i++) s[i].score += 5.0f;
+}
+
+/* 异步日志演示：多个线程同时写日志，每个线程只写自己的缓冲区 */
+int log_worker_thread(void* arg) {
+    int id = *(int*)arg;
+    log_printf("INFO", "线程 %d 写入异步日志, 名字=%s, 比例=%.2f", id, "worker", id * 0.5);
+    return 0;
+}
+
+/* 生产者线程：通过无锁队列把 1..100 持续交给消费者，而不是只在创建时传一个 arg */
+int queue_producer_thread(void* arg) {
+    MpmcQueue* q = (MpmcQueue*)arg;
+    for (uintptr_t i = 1; i <= 100; i++) {
+        while (!mpmc_push(q, (void*)i)) thrd_yield(); /* 队列满就稍等 */
+    }
+    return 0;
+}
+
+/*
+ * 线程安全计数器：早期版本用 atomic_flag 自旋锁包住 atomic_fetch_add，
+ * 锁和计数值两条缓存行在核心间来回传递；现在改用分片计数器（见 sharded_counter.h），
+ * 每个线程只对自己的分片做无竞争的原子加，读取时再求和。两者的对比见 --bench counter。
+ */
+int counter_worker(void* arg) {
+    ShardedCounter* c = (ShardedCounter*)arg;
+    for (int i = 0; i < 1000; i++) sharded_counter_inc(c);
+    return 0;
 }
 
 #endif
@@ -314,22 +577,125 @@ void test_threads_variadic() {
     log_printf("ERROR", "发生错误，代码=%d", 404);
 
 #if HAS_THREADS
+    // 异步日志：DEBUG 被级别过滤掉，其余由后台线程格式化后批量写出
+    log_set_level(LOG_LEVEL_INFO);
+    if (async_log_start(1, 0, LOG_FULL_BLOCK)) {
+        log_printf("DEBUG", "这条会被过滤掉");
+        log_printf("WARN", "异步日志已启动, 缓冲区满时阻塞等待 (耗时对比见 --bench log)");
+        thrd_t log_threads[2];
+        int log_ids[2] = {1, 2};
+        int log_started = 0;
+        while (log_started < 2 && thrd_create(&log_threads[log_started], log_worker_thread,
+                                              &log_ids[log_started]) == thrd_success) {
+            log_started++;
+        }
+        for (int i = 0; i < log_started; i++) thrd_join(log_threads[i], NULL);
+        async_log_stop(); /* 写完所有缓冲区后才返回 */
+    }
+    log_set_level(LOG_LEVEL_DEBUG);
+
     printf("启动 C11 线程测试...\n");
+    // 读取 CPU 拓扑，把演示线程绑到最后一个逻辑 CPU 上
+    CpuTopo* topo = cpu_topo_load();
+    if (topo) cpu_topo_print(topo, stdout);
     thrd_t threads[2];
-    int ids[2] = {1, 2};
+    WorkerArg worker_args[2] = {{1, topo ? topo->cpus[topo->ncpus - 1].cpu : -1}, {2, -1}};
+    cpu_topo_free(topo);
     
-    if (thrd_create(&threads[0], worker_thread, &ids[0]) == thrd_success) {
+    if (thrd_create(&threads[0], worker_thread, &worker_args[0]) == thrd_success) {
         thrd_join(threads[0], NULL);
     } else {
         printf("线程创建失败\n");
     }
     
-    ThreadSafeCounter counter;
-    atomic_init(&counter.counter, 0);
-    atomic_flag_clear(&counter.lock);
-    
-    safe_increment(&counter);
-    printf("线程安全计数器值: %d\n", atomic_load(&counter.counter));
+    ShardedCounter counter;
+    sharded_counter_init(&counter);
+    thrd_t counter_threads[4];
+    int counter_started = 0;
+    while (counter_started < 4 && thrd_create(&counter_threads[counter_started], counter_worker,
+                                              &counter) == thrd_success) {
+        counter_started++;
+    }
+    for (int i = 0; i < counter_started; i++) thrd_join(counter_threads[i], NULL);
+    printf("线程安全计数器值: %ld (%d 个线程各加 1000 次)\n", sharded_counter_read(&counter),
+           counter_started);
+
+    // 无锁 MPMC 队列：线程之间持续传递数据
+    MpmcQueue queue;
+    thrd_t producer;
+    if (!mpmc_init(&queue, 16)) {
+        printf("无锁队列创建失败\n");
+    } else if (thrd_create(&producer, queue_producer_thread, &queue) != thrd_success) {
+        printf("线程创建失败\n");
+        mpmc_destroy(&queue);
+    } else {
+        uintptr_t sum = 0;
+        for (int received = 0; received < 100;) {
+            void* item;
+            if (mpmc_pop(&queue, &item)) {
+                sum += (uintptr_t)item;
+                received++;
+            } else {
+                thrd_yield();
+            }
+        }
+        thrd_join(producer, NULL);
+        mpmc_destroy(&queue);
+        printf("无锁队列: 从生产者线程收到 100 条消息, 总和 %zu (吞吐/延迟见 --bench queue)\n",
+               (size_t)sum);
+    }
+
+    // 线程缓存内存池：两个线程并发分配/释放
+    TcPool* tp = tc_pool_create(32, 1024);
+    if (tp) {
+        thrd_t tc_threads[2];
+        int tc_started = 0, tc_ok = 0;
+        while (tc_started < 2 &&
+               thrd_create(&tc_threads[tc_started], tc_pool_worker, tp) == thrd_success) {
+            tc_started++;
+        }
+        for (int i = 0; i < tc_started; i++) {
+            int rc = 1;
+            thrd_join(tc_threads[i], &rc);
+            if (rc == 0) tc_ok++;
+        }
+        printf("线程缓存池: %d 个线程各分配/释放 100 块完成 (多线程吞吐对比见 --bench mt)\n",
+               tc_ok);
+        tc_pool_destroy(tp);
+    }
+
+    // 常驻工作线程池：提交任务不再创建线程，等待组统计完成情况；工作线程按紧凑策略绑定 CPU
+    WsPool* ws = ws_pool_create_ex(&(WsPoolOptions){.nthreads = 0, .placement = CPU_PLACE_COMPACT});
+    if (ws) {
+        int squares[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        WsWaitGroup wg;
+        ws_wait_group_init(&wg);
+        for (int i = 0; i < 8; i++) ws_submit(ws, &wg, square_task, &squares[i]);
+        ws_wait(ws, &wg);
+        printf("工作窃取线程池 (%d 线程, 0 号绑定在 CPU %d): 8 个平方任务完成, 最后一个 = %d "
+               "(对比见 --bench ws, 跨插槽代价见 --bench topo)\n",
+               ws_pool_size(ws), ws_pool_worker_cpu(ws, 0), squares[7]);
+        ws_pool_destroy(ws);
+    }
+
+    // 数据并行：循环按块分给默认线程池，调用线程也参与
+    enum { STUDENT_COUNT = 10000 };
+    ParStudent* students = (ParStudent*)malloc(STUDENT_COUNT * sizeof(ParStudent));
+    if (students) {
+        for (int i = 0; i < STUDENT_COUNT; i++) {
+            students[i].id = i + 1;
+            snprintf(students[i].name, sizeof(students[i].name), "学生%d", i + 1);
+            students[i].score = (float)(i % 91);
+        }
+        parallel_for(0, STUDENT_COUNT, 0, curve_scores, students);
+        ScoreStats stats = {0.0, 0.0f}; /* 单位元 */
+        parallel_reduce(0, STUDENT_COUNT, 0, &stats, sizeof(stats), score_body, score_combine,
+                        students, PARALLEL_DETERMINISTIC);
+        printf("并行统计 %d 名学生: 平均分 %.2f, 最高分 %.1f (加速比见 --bench parallel)\n",
+               STUDENT_COUNT, stats.sum / STUDENT_COUNT, (double)stats.best);
+        free(students);
+    }
+    parallel_shutdown();
 #else
     printf("当前环境不支持 C11 <threads.h>，跳过线程测试。\n");
 #endif
@@ -339,7 +705,12 @@ void test_threads_variadic() {
 /*                             六、主函数                                    */
 /* ========================================================================== */
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --bench [名称]：运行基准测试而不是功能演示
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return bench_main(argc > 2 ? argv[2] : NULL);
+    }
+
     printf("==========================================\n");
     printf("      C 语言进阶特性综合演示 (Advanced C)  \n");
     printf("==========================================\n");
@@ -0,0 +1,116 @@
+/**
+ * @file mem_align.c
+ * @brief 对齐分配的实现
+ */
+
+/* 严格 C11 模式下 mmap 的 MAP_ANONYMOUS 和 syscall 需要打开 POSIX/BSD 扩展 */
+#define _DEFAULT_SOURCE
+
+#include "mem_align.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+  #include <malloc.h>
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <linux/mempolicy.h>
+  #include <sys/syscall.h>
+#endif
+
+void* mem_aligned_alloc(size_t size, size_t align) {
+    if (!IS_POWER_OF_2(align)) return NULL;
+    if (align < sizeof(void*)) align = sizeof(void*);
+    if (size == 0) size = 1;
+    if (size > SIZE_MAX - align) return NULL;
+#if defined(_WIN32)
+    return _aligned_malloc(size, align);
+#else
+    // C11 aligned_alloc 要求 size 是 align 的整数倍
+    return aligned_alloc(align, ALIGN_UP(size, align));
+#endif
+}
+
+void mem_aligned_free(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+size_t mem_page_size(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+void* mem_alloc_pages(size_t size) {
+    size_t page = mem_page_size();
+    if (size == 0 || size > SIZE_MAX - page) return NULL;
+    size = ALIGN_UP(size, page);
+#if defined(_WIN32)
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+#endif
+}
+
+void mem_free_pages(void* ptr, size_t size) {
+    if (!ptr) return;
+#if defined(_WIN32)
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, ALIGN_UP(size, mem_page_size()));
+#endif
+}
+
+int mem_numa_node_count(void) {
+#if defined(__linux__)
+    // 内容形如 "0" 或 "0-3"，取最后一个数字 + 1
+    FILE* f = fopen("/sys/devices/system/node/online", "r");
+    if (!f) return 1;
+    int first = 0, last = -1;
+    int n = fscanf(f, "%d-%d", &first, &last);
+    fclose(f);
+    if (n < 1) return 1;
+    return (n == 2 ? last : first) + 1;
+#else
+    return 1;
+#endif
+}
+
+bool mem_bind_node(void* ptr, size_t size, int node) {
+#if defined(__linux__) && defined(__NR_mbind)
+    unsigned long mask = 0;
+    if (node < 0 || node >= (int)(sizeof(mask) * 8)) return false;
+    mask = 1ul << node;
+    // 不依赖 libnuma，直接调用系统调用；maxnode 按内核约定传位数 + 1
+    long rc = syscall(__NR_mbind, ptr, ALIGN_UP(size, mem_page_size()), MPOL_BIND, &mask,
+                      sizeof(mask) * 8 + 1, 0);
+    return rc == 0;
+#else
+    (void)ptr;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+
+void* mem_alloc_on_node(size_t size, int node) {
+    void* p = mem_alloc_pages(size);
+    if (p) mem_bind_node(p, size, node); /* 刚映射还没缺页，绑定后首次访问即在目标节点分配 */
+    return p;
+}
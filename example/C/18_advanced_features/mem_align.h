@@ -0,0 +1,43 @@
+/**
+ * @file mem_align.h
+ * @brief 缓存行 / 页 / NUMA 节点对齐的内存分配
+ *
+ * common.h 里的 ALIGN_UP / IS_POWER_OF_2 只能算地址，这里提供真正的分配接口：
+ * 1. mem_aligned_alloc：任意 2 的幂对齐（常用 CACHE_LINE_SIZE），避免两个线程的数据挤在同一缓存行上伪共享。
+ * 2. mem_alloc_pages：直接向操作系统按页申请，起始地址页对齐，内容为 0。
+ * 3. mem_bind_node / mem_alloc_on_node：在多路服务器上把页绑定到指定 NUMA 节点（Linux mbind 系统调用），
+ *    让线程访问离自己最近的内存；单节点机器或非 Linux 平台上绑定会失败，但内存照常可用。
+ */
+
+#ifndef MEM_ALIGN_H
+#define MEM_ALIGN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h" /* CACHE_LINE_SIZE */
+
+/* align 必须是 2 的幂，否则返回 NULL；必须用 mem_aligned_free 释放 */
+void* mem_aligned_alloc(size_t size, size_t align);
+void mem_aligned_free(void* ptr);
+
+/* 按缓存行对齐 */
+#define mem_alloc_cacheline(size) mem_aligned_alloc((size), CACHE_LINE_SIZE)
+
+/* 系统页大小（通常 4096） */
+size_t mem_page_size(void);
+
+/* 按页申请并清零，size 会向上取整到整页；释放时传入相同的 size */
+void* mem_alloc_pages(size_t size);
+void mem_free_pages(void* ptr, size_t size);
+
+/* 在线 NUMA 节点数，取不到时返回 1 */
+int mem_numa_node_count(void);
+
+/* 把 [ptr, ptr+size) 的页绑定到 node 节点，ptr 必须页对齐；尚未缺页的页会在首次访问时从该节点分配 */
+bool mem_bind_node(void* ptr, size_t size, int node);
+
+/* mem_alloc_pages + mem_bind_node，绑定失败时仍返回（未绑定的）内存 */
+void* mem_alloc_on_node(size_t size, int node);
+
+#endif /* MEM_ALIGN_H */
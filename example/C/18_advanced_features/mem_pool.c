@@ -0,0 +1,468 @@
+/**
+ * @file mem_pool.c
+ * @brief 固定块大小内存池的实现
+ */
+
+/* 严格 C11 模式下需要显式打开 POSIX/BSD 扩展才能使用 mmap/madvise */
+#define _DEFAULT_SOURCE
+
+#include "mem_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "mem_align.h"
+
+/* x86 上的 GCC/Clang 可以单独为某个函数开启 AVX2，并在运行时检测 CPU 是否支持 */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define POOL_HAS_AVX2_SCAN 1
+#else
+  #define POOL_HAS_AVX2_SCAN 0
+#endif
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define POOL_HAS_MMAP 1
+#else
+  #define POOL_HAS_MMAP 0
+#endif
+
+#if HAS_THREADS
+  #define STAT_LOAD(c)     atomic_load_explicit(&(c), memory_order_relaxed)
+  #define STAT_STORE(c, v) atomic_store_explicit(&(c), (v), memory_order_relaxed)
+#else
+  #define STAT_LOAD(c)     (c)
+  #define STAT_STORE(c, v) ((c) = (v))
+#endif
+/* 单写者计数器，见 mem_pool.h 中 PoolCounter 的说明 */
+#define STAT_INC(c) STAT_STORE(c, STAT_LOAD(c) + 1)
+
+#define WORD_BITS      64
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+/* ========================================================================== */
+/*                              位图辅助函数                                  */
+/* ========================================================================== */
+
+/* 在 words[from, n) 中找第一个不是全 1 的字，找不到返回 n */
+static size_t find_not_full_scalar(const uint64_t* words, size_t from, size_t n) {
+    for (size_t i = from; i < n; i++) {
+        if (words[i] != UINT64_MAX) return i;
+    }
+    return n;
+}
+
+#if POOL_HAS_AVX2_SCAN
+/* 一次比较 4 个字（256 位），全满时直接跳过 */
+__attribute__((target("avx2"))) static size_t find_not_full_avx2(const uint64_t* words,
+                                                                  size_t from, size_t n) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = from;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(const void*)(words + i));
+        if (!_mm256_testc_si256(v, ones)) break; /* 这 4 个字里至少有一个空位 */
+    }
+    return find_not_full_scalar(words, i, n);
+}
+#endif
+
+static size_t find_not_full(const uint64_t* words, size_t from, size_t n) {
+#if POOL_HAS_AVX2_SCAN
+    if (n - from >= 8 && __builtin_cpu_supports("avx2")) {
+        return find_not_full_avx2(words, from, n);
+    }
+#endif
+    return find_not_full_scalar(words, from, n);
+}
+
+/* 清空位图；超出 block_count 的尾部位预先标记为“已占用”，保证永远不会被分配 */
+static void pool_bitmap_init(MemPool* p) {
+    memset(p->used_map, 0, p->word_count * sizeof(uint64_t));
+    memset(p->summary_map, 0, p->summary_count * sizeof(uint64_t));
+
+    size_t tail = p->block_count % WORD_BITS;
+    if (tail) {
+        p->used_map[p->word_count - 1] = UINT64_MAX << tail;
+    }
+    size_t summary_tail = p->word_count % WORD_BITS;
+    if (summary_tail) {
+        p->summary_map[p->summary_count - 1] = UINT64_MAX << summary_tail;
+    }
+    p->search_hint = 0;
+}
+
+/* ========================================================================== */
+/*                              mmap 后备内存                                 */
+/* ========================================================================== */
+
+#if POOL_HAS_MMAP
+static void* pool_map(MemPool* p, size_t bytes) {
+    bool huge = p->flags & POOL_FLAG_HUGEPAGE;
+    size_t align = huge ? HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = ALIGN_UP(bytes, align);
+    size_t span = huge ? size + HUGE_PAGE_SIZE : size; /* 大页需要多映射一段用来对齐 */
+
+    // 不走大页时可以直接让内核 MAP_POPULATE；大页必须先 madvise 再缺页，否则拿到的还是 4KB 页
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (!huge && (p->flags & POOL_FLAG_POPULATE)) map_flags |= MAP_POPULATE;
+    void* raw_map = mmap(NULL, span, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (raw_map == MAP_FAILED) return NULL;
+
+    char* raw = (char*)raw_map;
+    char* mem = raw;
+    if (huge) {
+        mem = (char*)ALIGN_UP((uintptr_t)raw, (uintptr_t)HUGE_PAGE_SIZE);
+        size_t head = (size_t)(mem - raw);
+        if (head) munmap(raw, head);
+        if (span - head - size) munmap(mem + size, span - head - size);
+        madvise(mem, size, MADV_HUGEPAGE); /* 内核不支持 THP 时失败也无妨，退化为普通页 */
+        if (p->flags & POOL_FLAG_POPULATE) {
+            for (size_t off = 0; off < size; off += 4096) mem[off] = 0;
+        }
+    }
+    if ((p->flags & POOL_FLAG_LOCK) && mlock(mem, size) != 0) {
+        p->flags &= ~(unsigned)POOL_FLAG_LOCK; /* 通常是超出了 RLIMIT_MEMLOCK */
+    }
+    p->mapped_size = size;
+    return mem;
+}
+
+/* [first, last] 范围内的块是否全部空闲 */
+static bool bitmap_range_free(const MemPool* p, size_t first, size_t last) {
+    for (size_t w = first / WORD_BITS; w <= last / WORD_BITS; w++) {
+        uint64_t mask = UINT64_MAX;
+        if (w == first / WORD_BITS) mask &= UINT64_MAX << (first % WORD_BITS);
+        if (w == last / WORD_BITS && last % WORD_BITS != WORD_BITS - 1) {
+            mask &= ~(UINT64_MAX << (last % WORD_BITS + 1));
+        }
+        if (p->used_map[w] & mask) return false;
+    }
+    return true;
+}
+
+/* 与 [off, off+len) 重叠的块是否都空闲（块可能跨页，所以要看首尾两块） */
+static bool page_is_free(const MemPool* p, size_t off, size_t len) {
+    size_t pool_bytes = p->block_size * p->block_count;
+    if (off >= pool_bytes) return true; /* 映射尾部的对齐填充 */
+    size_t end = off + len < pool_bytes ? off + len : pool_bytes;
+    size_t first = off / p->block_size;
+    size_t last = (end - 1) / p->block_size;
+    if (p->mode == POOL_MODE_FREELIST) return first >= p->bump_index;
+    return bitmap_range_free(p, first, last);
+}
+#endif
+
+size_t pool_release_free(MemPool* p) {
+#if POOL_HAS_MMAP
+    if (!p->mapped_size) return 0;
+
+    // 大页池按 2MB 整页释放：对大页中的一段 4KB 做 MADV_DONTNEED 会把它拆回普通页
+    size_t page = p->flags & POOL_FLAG_HUGEPAGE ? HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    size_t npages = p->mapped_size / page;
+    size_t released = 0;
+    size_t run_start = SIZE_MAX;
+    // 把连续的空闲页合并成一次 madvise 调用
+    for (size_t pg = 0; pg <= npages; pg++) {
+        if (pg < npages && page_is_free(p, pg * page, page)) {
+            if (run_start == SIZE_MAX) run_start = pg;
+            continue;
+        }
+        if (run_start != SIZE_MAX) {
+            size_t len = (pg - run_start) * page;
+            if (madvise((char*)p->memory + run_start * page, len, MADV_DONTNEED) == 0) {
+                released += len;
+            }
+            run_start = SIZE_MAX;
+        }
+    }
+    return released;
+#else
+    (void)p;
+    return 0;
+#endif
+}
+
+/* ========================================================================== */
+/*                              创建与销毁                                    */
+/* ========================================================================== */
+
+MemPool* pool_create(size_t block_size, size_t count) {
+    return pool_create_ex(block_size, count, POOL_MODE_FREELIST, 0);
+}
+
+/* 公共初始化：external 为 NULL 时自己申请内存 */
+static bool pool_init(MemPool* p, void* external, size_t block_size, size_t count, PoolMode mode,
+                      unsigned flags) {
+    memset(p, 0, sizeof(*p));
+    if (block_size == 0 || count == 0) return false;
+
+    // 空闲链表要把 next 指针存进块里，所以块至少要能放下一个指针并按指针对齐
+    if (mode == POOL_MODE_FREELIST) {
+        if (block_size < sizeof(PoolNode)) block_size = sizeof(PoolNode);
+        block_size = ALIGN_UP(block_size, sizeof(void*));
+    }
+
+    if (flags & POOL_FLAG_CACHE_ALIGN) {
+        if (block_size > SIZE_MAX - CACHE_LINE_SIZE) return false;
+        block_size = ALIGN_UP(block_size, (size_t)CACHE_LINE_SIZE);
+    }
+
+    // 防止 block_size * count 溢出
+    if (count > SIZE_MAX / block_size) return false;
+
+    p->owns_memory = external == NULL;
+    p->block_size = block_size;
+    p->block_count = count;
+    p->mode = mode;
+#if POOL_HAS_MMAP
+    if (!external && (flags & POOL_FLAGS_NEED_MMAP)) {
+        p->flags = flags | POOL_FLAG_MMAP;
+        p->memory = pool_map(p, block_size * count);
+    } else
+#endif
+    if (external) {
+        p->memory = external;
+    } else {
+        // 没有走 mmap（未请求或平台不支持），只保留对 malloc 后备有效的标志
+        p->flags = flags & ~(unsigned)POOL_FLAGS_NEED_MMAP;
+        p->memory = (p->flags & POOL_FLAG_CACHE_ALIGN)
+                        ? mem_aligned_alloc(block_size * count, CACHE_LINE_SIZE)
+                        : malloc(block_size * count);
+    }
+
+    if (mode == POOL_MODE_BITMAP) {
+        // 每块 1 位，而不是每块 1 个 bool (8 位)
+        p->word_count = (count + WORD_BITS - 1) / WORD_BITS;
+        p->summary_count = (p->word_count + WORD_BITS - 1) / WORD_BITS;
+        p->used_map = (uint64_t*)malloc(p->word_count * sizeof(uint64_t));
+        p->summary_map = (uint64_t*)malloc(p->summary_count * sizeof(uint64_t));
+    }
+
+    // 简单的错误处理
+    if (!p->memory || (mode == POOL_MODE_BITMAP && (!p->used_map || !p->summary_map))) {
+        pool_deinit(p);
+        return false;
+    }
+    if (mode == POOL_MODE_BITMAP) pool_bitmap_init(p);
+    return true;
+}
+
+MemPool* pool_create_ex(size_t block_size, size_t count, PoolMode mode, unsigned flags) {
+    MemPool* p = (MemPool*)malloc(sizeof(MemPool));
+    if (!p) return NULL;
+    if (!pool_init(p, NULL, block_size, count, mode, flags)) {
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+bool pool_init_in(MemPool* p, void* memory, size_t block_size, size_t count, PoolMode mode) {
+    if (!memory) return false;
+    return pool_init(p, memory, block_size, count, mode, 0);
+}
+
+void pool_deinit(MemPool* p) {
+#if POOL_HAS_MMAP
+    if (p->mapped_size) {
+        if (p->memory) munmap(p->memory, p->mapped_size);
+    } else
+#endif
+    if (p->owns_memory) {
+        if (p->flags & POOL_FLAG_CACHE_ALIGN) mem_aligned_free(p->memory);
+        else free(p->memory);
+    }
+    free(p->used_map);
+    free(p->summary_map);
+    p->memory = NULL;
+    p->used_map = NULL;
+    p->summary_map = NULL;
+}
+
+void pool_destroy(MemPool* p) {
+    if (!p) return;
+    pool_deinit(p);
+    free(p);
+}
+
+void pool_reset(MemPool* p) {
+    STAT_STORE(p->counters.live, 0);
+    if (p->mode == POOL_MODE_FREELIST) {
+        p->free_list = NULL;
+        p->bump_index = 0;
+    } else {
+        pool_bitmap_init(p);
+    }
+}
+
+/* ========================================================================== */
+/*                              分配与释放                                    */
+/* ========================================================================== */
+
+/* 先在摘要层找到一个没满的字，再在该字里用 ctz 找第一个空位，整字整字地跳过已满区域 */
+static void* pool_alloc_bitmap(MemPool* p) {
+    size_t s = find_not_full(p->summary_map, p->search_hint, p->summary_count);
+    p->search_hint = s;
+    if (s == p->summary_count) return NULL; /* 池满 */
+
+    size_t w = s * WORD_BITS + bit_ctz64(~p->summary_map[s]);
+    unsigned bit = bit_ctz64(~p->used_map[w]);
+    p->used_map[w] |= (uint64_t)1 << bit;
+    if (p->used_map[w] == UINT64_MAX) {
+        p->summary_map[s] |= (uint64_t)1 << (w % WORD_BITS);
+    }
+    return (char*)p->memory + (w * WORD_BITS + bit) * p->block_size;
+}
+
+/* O(1)：优先复用最近释放的块（缓存里还是热的），其次切一块从未用过的 */
+static void* pool_alloc_freelist(MemPool* p) {
+    PoolNode* node = p->free_list;
+    if (node) {
+        p->free_list = node->next;
+        return node;
+    }
+    if (p->bump_index < p->block_count) {
+        return (char*)p->memory + (p->bump_index++) * p->block_size;
+    }
+    return NULL; /* 池满 */
+}
+
+/* 清掉第 idx 块的占用位，重复释放时报错并返回 false */
+static bool pool_free_bitmap(MemPool* p, size_t idx) {
+    size_t w = idx / WORD_BITS;
+    uint64_t mask = (uint64_t)1 << (idx % WORD_BITS);
+    if (!(p->used_map[w] & mask)) {
+        printf("错误: 重复释放内存池中的块\n");
+        return false;
+    }
+    p->used_map[w] &= ~mask;
+
+    size_t s = w / WORD_BITS;
+    p->summary_map[s] &= ~((uint64_t)1 << (w % WORD_BITS));
+    if (s < p->search_hint) p->search_hint = s;
+    return true;
+}
+
+void* pool_alloc(MemPool* p) {
+    void* ptr = p->mode == POOL_MODE_FREELIST ? pool_alloc_freelist(p) : pool_alloc_bitmap(p);
+    if (!ptr) {
+        STAT_INC(p->counters.failed);
+        return NULL;
+    }
+    size_t live = STAT_LOAD(p->counters.live) + 1;
+    STAT_STORE(p->counters.live, live);
+    STAT_INC(p->counters.allocs);
+    if (live > STAT_LOAD(p->counters.high_water)) STAT_STORE(p->counters.high_water, live);
+    return ptr;
+}
+
+void pool_free(MemPool* p, void* ptr) {
+    // 检查指针是否在池内
+    char* start = (char*)p->memory;
+    char* end = start + (p->block_size * p->block_count);
+    if ((char*)ptr < start || (char*)ptr >= end) {
+        printf("错误: 释放了不属于该内存池的指针\n");
+        return;
+    }
+    // 指向块中间的指针放进空闲链表会让之后的分配互相重叠，位图模式也会误释放所在的块
+    size_t off = (size_t)((char*)ptr - start);
+    if (off % p->block_size != 0) {
+        printf("错误: 释放的指针不是内存池中块的起始地址\n");
+        return;
+    }
+
+    if (p->mode == POOL_MODE_FREELIST) {
+        // 头插法：把块自己变成链表节点。注意该模式无法检测重复释放
+        PoolNode* node = (PoolNode*)ptr;
+        node->next = p->free_list;
+        p->free_list = node;
+    } else if (!pool_free_bitmap(p, off / p->block_size)) {
+        return;
+    }
+    STAT_STORE(p->counters.live, STAT_LOAD(p->counters.live) - 1);
+    STAT_INC(p->counters.frees);
+}
+
+/* ========================================================================== */
+/*                              遍历与报告                                    */
+/* ========================================================================== */
+
+size_t pool_foreach_live(const MemPool* p, PoolVisitFn fn, void* ctx) {
+    if (p->mode != POOL_MODE_BITMAP) {
+        printf("错误: 只有位图模式的内存池才能遍历存活块\n");
+        return 0;
+    }
+
+    size_t visited = 0;
+    for (size_t w = 0; w < p->word_count; w++) {
+        uint64_t bits = p->used_map[w];
+        while (bits) {
+            size_t idx = w * WORD_BITS + bit_ctz64(bits);
+            if (idx >= p->block_count) break; /* 尾部填充位 */
+            fn((char*)p->memory + idx * p->block_size, ctx);
+            visited++;
+            bits &= bits - 1; /* 清掉最低位的 1 */
+        }
+    }
+    return visited;
+}
+
+PoolOccupancy pool_occupancy(const MemPool* p) {
+    PoolOccupancy occ = {0, 0, 0, 0};
+    if (p->mode != POOL_MODE_BITMAP) {
+        printf("错误: 只有位图模式的内存池才能统计占用情况\n");
+        return occ;
+    }
+
+    occ.total_words = p->word_count;
+    for (size_t w = 0; w < p->word_count; w++) {
+        uint64_t bits = p->used_map[w];
+        if (w == p->word_count - 1 && p->block_count % WORD_BITS) {
+            bits &= ~(UINT64_MAX << (p->block_count % WORD_BITS)); /* 去掉尾部填充位 */
+        }
+        if (!bits) {
+            occ.empty_words++;
+            continue;
+        }
+        occ.live_blocks += bit_popcount64(bits);
+        occ.live_span = w * WORD_BITS + (WORD_BITS - bit_clz64(bits));
+    }
+    return occ;
+}
+
+/* ========================================================================== */
+/*                              统计                                          */
+/* ========================================================================== */
+
+PoolStats pool_stats(const MemPool* p) {
+    PoolStats st;
+    st.block_size = p->block_size;
+    st.block_count = p->block_count;
+    st.live = STAT_LOAD(p->counters.live);
+    st.high_water = STAT_LOAD(p->counters.high_water);
+    st.allocs = STAT_LOAD(p->counters.allocs);
+    st.frees = STAT_LOAD(p->counters.frees);
+    st.failed = STAT_LOAD(p->counters.failed);
+
+    size_t touched = p->bump_index;
+    size_t live = st.live;
+    if (p->mode == POOL_MODE_BITMAP) {
+        PoolOccupancy occ = pool_occupancy(p);
+        touched = occ.live_span;
+        live = occ.live_blocks;
+    }
+    st.fragmentation = touched ? (double)(touched - live) / (double)touched : 0.0;
+    return st;
+}
+
+void pool_stats_dump(FILE* out, const char* name, const PoolStats* st) {
+    fprintf(out,
+            "pool name=%s block_size=%zu blocks=%zu live=%zu high_water=%zu allocs=%zu frees=%zu "
+            "failed=%zu frag=%.3f\n",
+            name ? name : "-", st->block_size, st->block_count, st->live, st->high_water,
+            st->allocs, st->frees, st->failed, st->fragmentation);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file mem_pool.h
+ * @brief 固定块大小的内存池
+ *
+ * 支持两种空闲块管理策略：
+ * 1. POOL_MODE_FREELIST：把空闲链表“寄生”在空闲块内部，alloc/free 都是 O(1)。
+ * 2. POOL_MODE_BITMAP：按 64 位字打包的占用位图 + 一层摘要位图，
+ *    用 ctz 指令直接定位空位，并且可以遍历所有存活块（批量析构、碎片报告）。
+ *
+ * 后备内存默认来自 malloc；GB 级的大池可以通过 POOL_FLAG_* 改为 mmap 映射 + 透明大页，
+ * 减少 4KB 页带来的 TLB 缺失（目前仅 Linux 支持，其他平台会忽略这些标志退回 malloc）。
+ *
+ * 每个池都带有常开的统计计数器（存活数、峰值、分配/释放总数、失败次数），
+ * 用 pool_stats 取快照、pool_stats_dump 输出一行 key=value，便于调 block_size 和 block_count。
+ */
+
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "common.h" /* HAS_THREADS */
+
+/* 空闲块管理策略 */
+typedef enum {
+    POOL_MODE_FREELIST, /* 侵入式空闲链表（默认） */
+    POOL_MODE_BITMAP,   /* 分层占用位图 */
+} PoolMode;
+
+/* 创建标志，可按位或组合 */
+enum {
+    POOL_FLAG_MMAP = 1u << 0,     /* 用 mmap 直接向内核申请后备内存 */
+    POOL_FLAG_HUGEPAGE = 1u << 1, /* 按 2MB 对齐并 madvise(MADV_HUGEPAGE) 申请透明大页（隐含 MMAP） */
+    POOL_FLAG_POPULATE = 1u << 2, /* 创建时预先缺页，运行时不再有首次访问开销（隐含 MMAP） */
+    POOL_FLAG_LOCK = 1u << 3,     /* mlock 锁在物理内存中不被换出，失败时该位会被清除（隐含 MMAP） */
+    /* 块大小向上补齐到 CACHE_LINE_SIZE 且起始地址按缓存行对齐，不同线程持有的相邻块不会伪共享 */
+    POOL_FLAG_CACHE_ALIGN = 1u << 4,
+};
+
+#define POOL_FLAGS_NEED_MMAP (POOL_FLAG_MMAP | POOL_FLAG_HUGEPAGE | POOL_FLAG_POPULATE | POOL_FLAG_LOCK)
+
+/* 空闲链表节点：直接复用空闲块的前 sizeof(void*) 字节，不额外占用内存 */
+typedef struct PoolNode {
+    struct PoolNode* next;
+} PoolNode;
+
+/*
+ * 统计计数器只由持有该池的线程写入，所以用 relaxed 原子 load + store 而不是 fetch_add：
+ * 在 x86/ARM 上就是普通的读写指令，没有 lock 前缀；其他线程随时可以读到不撕裂的值。
+ */
+#if HAS_THREADS
+typedef atomic_size_t PoolCounter;
+#else
+typedef size_t PoolCounter;
+#endif
+
+typedef struct {
+    PoolCounter live;       /* 当前存活块数 */
+    PoolCounter high_water; /* 存活块数的历史峰值 */
+    PoolCounter allocs;     /* 成功分配总次数 */
+    PoolCounter frees;      /* 释放总次数（不含 pool_reset） */
+    PoolCounter failed;     /* 池满导致的分配失败次数 */
+} PoolCounters;
+
+typedef struct {
+    void* memory;
+    bool owns_memory; /* memory 是否由内存池自己申请（决定 pool_destroy 是否释放它） */
+    size_t block_size;
+    size_t block_count;
+    PoolMode mode;
+    unsigned flags;        /* 实际生效的 POOL_FLAG_* */
+    size_t mapped_size;    /* mmap 后备时映射的字节数，0 表示来自 malloc 或调用者 */
+    uint64_t* used_map;    /* BITMAP 模式：第 i 位为 1 表示第 i 块已占用 */
+    uint64_t* summary_map; /* BITMAP 模式：第 w 位为 1 表示 used_map[w] 已全部占满 */
+    size_t word_count;     /* used_map 的字数 */
+    size_t summary_count;  /* summary_map 的字数 */
+    size_t search_hint;    /* summary_map 中第一个可能有空位的字，之前的字都已满 */
+    PoolNode* free_list;   /* FREELIST 模式：被释放过的块组成的单链表 */
+    size_t bump_index;     /* FREELIST 模式：从未分配过的块从这里开始，避免创建时遍历整个池 */
+    PoolCounters counters;
+} MemPool;
+
+/* 使用默认策略 (FREELIST) 创建内存池 */
+MemPool* pool_create(size_t block_size, size_t count);
+
+/* 指定策略和 POOL_FLAG_* 创建内存池；FREELIST 模式下块大小会向上对齐到指针大小 */
+MemPool* pool_create_ex(size_t block_size, size_t count, PoolMode mode, unsigned flags);
+
+/*
+ * 在调用者提供的 MemPool 结构和内存上就地建池（例如嵌入 slab 分配器的对齐页头部），
+ * 不申请 MemPool 本身；用 pool_deinit 清理，它不会释放 memory。
+ */
+bool pool_init_in(MemPool* p, void* memory, size_t block_size, size_t count, PoolMode mode);
+void pool_deinit(MemPool* p);
+
+void* pool_alloc(MemPool* p);
+void pool_free(MemPool* p, void* ptr);
+void pool_destroy(MemPool* p);
+
+/* 一次性归还所有块（不逐个调用 pool_free），适合请求结束时整体清空 */
+void pool_reset(MemPool* p);
+
+/*
+ * 把完全空闲的整页用 madvise(MADV_DONTNEED) 还给内核（仅 mmap 后备的池），返回处理的字节数。
+ * POOL_FLAG_HUGEPAGE 的池只释放完全空闲的 2MB 大页，不会把大页拆成 4KB 页。
+ * BITMAP 模式按占用位图判断；FREELIST 模式只能释放从未分配过的区域（如 pool_reset 之后）。
+ * 这些页下次访问时会重新缺页并清零。
+ */
+size_t pool_release_free(MemPool* p);
+
+/* 遍历所有存活块（仅 BITMAP 模式），返回访问的块数。可用于批量析构 */
+typedef void (*PoolVisitFn)(void* block, void* ctx);
+size_t pool_foreach_live(const MemPool* p, PoolVisitFn fn, void* ctx);
+
+/* 占用情况报告（仅 BITMAP 模式），用于判断是否值得做压缩/调整池大小 */
+typedef struct {
+    size_t live_blocks; /* 存活块数 */
+    size_t live_span;   /* 最高存活块下标 + 1，压缩后最多可收缩 live_span - live_blocks 块 */
+    size_t empty_words; /* 完全空闲的 64 块分组数 */
+    size_t total_words; /* 64 块分组总数 */
+} PoolOccupancy;
+PoolOccupancy pool_occupancy(const MemPool* p);
+
+/* 统计快照 */
+typedef struct {
+    size_t block_size;
+    size_t block_count;
+    size_t live;
+    size_t high_water;
+    size_t allocs;
+    size_t frees;
+    size_t failed;
+    /*
+     * 碎片率：已触及区域中空闲块所占比例，0 表示存活块紧密排在前面。
+     * 已触及区域在 BITMAP 模式下是 [0, 最高存活块]，FREELIST 模式下是 [0, bump_index)。
+     */
+    double fragmentation;
+} PoolStats;
+
+/*
+ * 计数器部分可以在任意线程读取；碎片率需要扫描池结构（BITMAP 模式为 O(块数/64)），
+ * 只有在持有该池的线程上调用时才是准确的。
+ */
+PoolStats pool_stats(const MemPool* p);
+
+/* 输出一行可被脚本解析的统计，例如：pool name=demo block_size=32 blocks=100 ... frag=0.250 */
+void pool_stats_dump(FILE* out, const char* name, const PoolStats* stats);
+
+#endif /* MEM_POOL_H */
@@ -0,0 +1,429 @@
+/**
+ * @file mem_track.c
+ * @brief 内存分配追踪器的实现
+ */
+
+#include "mem_track.h"
+
+#if HAS_THREADS
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACK_SHARD_BITS   6
+#define TRACK_SHARD_COUNT  (1u << TRACK_SHARD_BITS)
+#define TRACK_INITIAL_CAP  1024
+#define TRACK_MAX_SITES    4096
+#define TRACK_SITE_SLOTS   (TRACK_MAX_SITES * 2) /* 开放寻址表保持半满以内 */
+
+/* ========================================================================== */
+/*                              调用点聚合                                    */
+/* ========================================================================== */
+
+typedef struct {
+    const char* file;
+    int line;
+    atomic_size_t alloc_count; /* 累计分配次数 */
+    atomic_size_t alloc_bytes; /* 累计分配字节 */
+    atomic_size_t live_count;  /* 当前存活数 */
+    atomic_size_t live_bytes;  /* 当前存活字节 */
+} TrackSite;
+
+static TrackSite sites[TRACK_MAX_SITES];
+static atomic_size_t site_count;
+/* 调用点哈希表：槽位一旦发布就不再改变，所以查找完全无锁 */
+static _Atomic(TrackSite*) site_slots[TRACK_SITE_SLOTS];
+/* 调用点太多时统一记到这里 */
+static TrackSite overflow_site = {"(调用点过多)", 0, 0, 0, 0, 0};
+
+static uint64_t hash_u64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDu;
+    x ^= x >> 33;
+    return x;
+}
+
+/*
+ * 同一文件在不同翻译单元中的 __FILE__ 地址可能不同，所以按文件名内容（FNV-1a）而不是地址取哈希，
+ * 同一 file:line 总是从同一个槽开始探测；比较时地址相等直接命中，不等再比较内容。
+ */
+static uint64_t site_hash(const char* file, int line) {
+    uint64_t h = 0xCBF29CE484222325u;
+    for (const unsigned char* p = (const unsigned char*)file; *p; p++) {
+        h = (h ^ *p) * 0x100000001B3u;
+    }
+    return hash_u64(h ^ ((uint64_t)(unsigned)line << 48));
+}
+
+static bool site_matches(const TrackSite* s, const char* file, int line) {
+    return s->line == line && (s->file == file || strcmp(s->file, file) == 0);
+}
+
+static TrackSite* site_lookup(const char* file, int line) {
+    size_t h = (size_t)site_hash(file, line);
+    for (size_t probe = 0; probe < TRACK_SITE_SLOTS; probe++) {
+        size_t idx = (h + probe) % TRACK_SITE_SLOTS;
+        TrackSite* s = atomic_load_explicit(&site_slots[idx], memory_order_acquire);
+        if (s) {
+            if (site_matches(s, file, line)) return s;
+            continue;
+        }
+
+        // 空槽：先占一个调用点记录，填好后用 CAS 发布
+        size_t n = atomic_fetch_add_explicit(&site_count, 1, memory_order_relaxed);
+        if (n >= TRACK_MAX_SITES) return &overflow_site;
+        TrackSite* fresh = &sites[n];
+        fresh->file = file;
+        fresh->line = line;
+
+        TrackSite* expected = NULL;
+        if (atomic_compare_exchange_strong_explicit(&site_slots[idx], &expected, fresh,
+                                                    memory_order_release, memory_order_acquire)) {
+            return fresh;
+        }
+        // 其他线程抢先发布了这个槽；如果正好是同一调用点就直接用，否则继续探测
+        // （占用的 fresh 记录作废，调用点总数很少，浪费可以接受）
+        if (site_matches(expected, file, line)) return expected;
+    }
+    return &overflow_site;
+}
+
+/* ========================================================================== */
+/*                              分片存活表                                    */
+/* ========================================================================== */
+
+typedef struct {
+    void* ptr; /* NULL 表示空槽 */
+    size_t size;
+    TrackSite* site;
+} TrackEntry;
+
+/* 每个分片独占缓存行，避免不同分片的锁互相伪共享 */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_flag lock;
+    size_t count;
+    size_t cap; /* 2 的幂 */
+    TrackEntry* slots;
+} TrackShard;
+
+/*
+ * 每个块前面放一个头部，记下这次分配有没有被采样进存活表。
+ * 没被采样的块释放时看一眼头部就直接 free，不查表也不碰分片锁；头部按 max_align_t 对齐，
+ * 返回给调用者的地址对齐方式与 malloc 相同。
+ */
+typedef union {
+    max_align_t align;
+    uint64_t tag;
+} TrackHeader;
+
+#define TRACK_TAG_PLAIN   0x54524B30504C4E00u /* 未采样 */
+#define TRACK_TAG_SAMPLED 0x54524B3053414D00u /* 已记录在存活表中 */
+
+static TrackShard shards[TRACK_SHARD_COUNT];
+static atomic_uint sample_rate = 1;
+static atomic_size_t dropped; /* 因内存不足没能记录的分配 */
+
+/* 每个线程自己的采样倒计数，不共享 */
+static _Thread_local unsigned sample_countdown;
+
+static void shard_lock(TrackShard* sh) {
+    while (atomic_flag_test_and_set_explicit(&sh->lock, memory_order_acquire)) {
+    }
+}
+
+static void shard_unlock(TrackShard* sh) {
+    atomic_flag_clear_explicit(&sh->lock, memory_order_release);
+}
+
+static uint64_t ptr_hash(const void* ptr) {
+    return hash_u64((uint64_t)(uintptr_t)ptr);
+}
+
+static TrackShard* shard_of(uint64_t h) {
+    return &shards[h >> (64 - TRACK_SHARD_BITS)];
+}
+
+/* 把现有记录搬到 fresh（new_cap 个已清零的槽）中，返回旧数组，由调用者在解锁后释放 */
+static TrackEntry* shard_rehash(TrackShard* sh, TrackEntry* fresh, size_t new_cap) {
+    for (size_t i = 0; i < sh->cap; i++) {
+        if (!sh->slots[i].ptr) continue;
+        size_t j = (size_t)ptr_hash(sh->slots[i].ptr) & (new_cap - 1);
+        while (fresh[j].ptr) j = (j + 1) & (new_cap - 1);
+        fresh[j] = sh->slots[i];
+    }
+    TrackEntry* old = sh->slots;
+    sh->slots = fresh;
+    sh->cap = new_cap;
+    return old;
+}
+
+/*
+ * 扩容时的 calloc/free 都放在锁外：持锁期间调用分配器会让同分片的其他线程一直空转。
+ * 解锁申请期间别的线程可能已经扩过容，重新加锁后按当时的容量再判断一次。
+ */
+static bool shard_insert(void* ptr, size_t size, TrackSite* site) {
+    uint64_t h = ptr_hash(ptr);
+    TrackShard* sh = shard_of(h);
+    TrackEntry* spare = NULL;
+    size_t spare_cap = 0;
+    TrackEntry* old = NULL;
+    for (;;) {
+        shard_lock(sh);
+        if ((sh->count + 1) * 2 <= sh->cap) break;
+        size_t new_cap = sh->cap ? sh->cap * 2 : TRACK_INITIAL_CAP;
+        if (spare && spare_cap == new_cap) {
+            old = shard_rehash(sh, spare, new_cap);
+            spare = NULL;
+            break;
+        }
+        shard_unlock(sh);
+        free(spare);
+        spare = (TrackEntry*)calloc(new_cap, sizeof(TrackEntry));
+        if (!spare) return false;
+        spare_cap = new_cap;
+    }
+    size_t mask = sh->cap - 1;
+    size_t i = (size_t)h & mask;
+    while (sh->slots[i].ptr) i = (i + 1) & mask;
+    sh->slots[i] = (TrackEntry){ptr, size, site};
+    sh->count++;
+    shard_unlock(sh);
+    free(old);
+    free(spare); /* 别的线程已经扩过容时没用上 */
+    return true;
+}
+
+/* 找到并删除 ptr 的记录；线性探测用“回移”删除，不留墓碑 */
+static bool shard_remove(void* ptr, TrackEntry* out) {
+    uint64_t h = ptr_hash(ptr);
+    TrackShard* sh = shard_of(h);
+    shard_lock(sh);
+    if (sh->count == 0) {
+        shard_unlock(sh);
+        return false;
+    }
+
+    size_t mask = sh->cap - 1;
+    size_t i = (size_t)h & mask;
+    while (sh->slots[i].ptr != ptr) {
+        if (!sh->slots[i].ptr) {
+            shard_unlock(sh);
+            return false; /* 未被追踪（头部标记与存活表不一致时才会走到） */
+        }
+        i = (i + 1) & mask;
+    }
+    *out = sh->slots[i];
+
+    for (size_t j = (i + 1) & mask; sh->slots[j].ptr; j = (j + 1) & mask) {
+        size_t home = (size_t)ptr_hash(sh->slots[j].ptr) & mask;
+        // home 不在 (i, j] 区间内的元素才需要回移到空出的位置 i
+        bool in_range = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!in_range) {
+            sh->slots[i] = sh->slots[j];
+            i = j;
+        }
+    }
+    sh->slots[i].ptr = NULL;
+    sh->count--;
+    shard_unlock(sh);
+    return true;
+}
+
+/* ========================================================================== */
+/*                              对外接口                                      */
+/* ========================================================================== */
+
+void track_set_sample_rate(unsigned rate) {
+    atomic_store_explicit(&sample_rate, rate, memory_order_relaxed);
+}
+
+/* 采样判断只用线程局部计数，不碰任何共享数据 */
+static bool should_sample(void) {
+    unsigned rate = atomic_load_explicit(&sample_rate, memory_order_relaxed);
+    if (rate <= 1) return rate == 1;
+    if (sample_countdown == 0 || sample_countdown > rate) sample_countdown = rate;
+    return --sample_countdown == 0;
+}
+
+/* 同一线程连续从同一调用点分配很常见（循环里），命中时省掉文件名哈希和探测 */
+static _Thread_local struct {
+    const char* file;
+    int line;
+    TrackSite* site;
+} last_site;
+
+static bool record(void* ptr, size_t size, const char* file, int line) {
+    TrackSite* site = last_site.site;
+    if (!site || last_site.file != file || last_site.line != line) {
+        site = site_lookup(file, line);
+        last_site.file = file;
+        last_site.line = line;
+        last_site.site = site;
+    }
+    if (!shard_insert(ptr, size, site)) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    atomic_fetch_add_explicit(&site->alloc_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->alloc_bytes, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->live_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->live_bytes, size, memory_order_relaxed);
+    return true;
+}
+
+static void forget(void* ptr) {
+    TrackEntry e;
+    if (!shard_remove(ptr, &e)) return;
+    atomic_fetch_sub_explicit(&e.site->live_count, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&e.site->live_bytes, e.size, memory_order_relaxed);
+}
+
+static TrackHeader* header_of(void* ptr) {
+    return (TrackHeader*)ptr - 1;
+}
+
+/* 给刚分配的块打上标记，采样到的才写进存活表；记录失败时按未采样处理 */
+static void* track_block(TrackHeader* h, size_t size, const char* file, int line) {
+    void* ptr = h + 1;
+    h->tag = TRACK_TAG_PLAIN;
+    if (should_sample() && record(ptr, size, file, line)) h->tag = TRACK_TAG_SAMPLED;
+    return ptr;
+}
+
+void* track_malloc(size_t size, const char* file, int line) {
+    if (size > SIZE_MAX - sizeof(TrackHeader)) return NULL;
+    TrackHeader* h = (TrackHeader*)malloc(sizeof(TrackHeader) + size);
+    return h ? track_block(h, size, file, line) : NULL;
+}
+
+void* track_calloc(size_t count, size_t size, const char* file, int line) {
+    if (size && count > (SIZE_MAX - sizeof(TrackHeader)) / size) return NULL;
+    TrackHeader* h = (TrackHeader*)calloc(1, sizeof(TrackHeader) + count * size);
+    return h ? track_block(h, count * size, file, line) : NULL;
+}
+
+void* track_realloc(void* ptr, size_t size, const char* file, int line) {
+    if (!ptr) return track_malloc(size, file, line);
+    if (size > SIZE_MAX - sizeof(TrackHeader)) return NULL;
+
+    // 先摘掉旧记录：realloc 之后旧指针就不能再用了（哪怕只是当作哈希键）
+    TrackHeader* h = header_of(ptr);
+    TrackEntry old;
+    bool had = h->tag == TRACK_TAG_SAMPLED && shard_remove(ptr, &old);
+
+    TrackHeader* fresh = (TrackHeader*)realloc(h, sizeof(TrackHeader) + size);
+    if (!fresh) {
+        if (had && !shard_insert(ptr, old.size, old.site)) { /* 失败时原块不变，记录放回去 */
+            h->tag = TRACK_TAG_PLAIN;
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        }
+        return NULL;
+    }
+    if (had) {
+        atomic_fetch_sub_explicit(&old.site->live_count, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&old.site->live_bytes, old.size, memory_order_relaxed);
+    }
+    return track_block(fresh, size, file, line);
+}
+
+void track_free(void* ptr) {
+    if (!ptr) return;
+    TrackHeader* h = header_of(ptr);
+    if (h->tag == TRACK_TAG_SAMPLED) forget(ptr);
+    h->tag = 0; /* 重复释放时不会再按已采样处理 */
+    free(h);
+}
+
+size_t track_live_count(void) {
+    size_t n = 0;
+    for (size_t i = 0; i < TRACK_SHARD_COUNT; i++) {
+        shard_lock(&shards[i]);
+        n += shards[i].count;
+        shard_unlock(&shards[i]);
+    }
+    return n;
+}
+
+size_t track_live_bytes(void) {
+    size_t n = atomic_load_explicit(&site_count, memory_order_relaxed);
+    if (n > TRACK_MAX_SITES) n = TRACK_MAX_SITES;
+    size_t bytes = atomic_load_explicit(&overflow_site.live_bytes, memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+        bytes += atomic_load_explicit(&sites[i].live_bytes, memory_order_relaxed);
+    }
+    return bytes;
+}
+
+/* ========================================================================== */
+/*                              报告                                          */
+/* ========================================================================== */
+
+static int cmp_live_bytes_desc(const void* a, const void* b) {
+    size_t x = atomic_load_explicit(&(*(TrackSite* const*)a)->live_bytes, memory_order_relaxed);
+    size_t y = atomic_load_explicit(&(*(TrackSite* const*)b)->live_bytes, memory_order_relaxed);
+    return (x < y) - (x > y);
+}
+
+static int cmp_alloc_count_desc(const void* a, const void* b) {
+    size_t x = atomic_load_explicit(&(*(TrackSite* const*)a)->alloc_count, memory_order_relaxed);
+    size_t y = atomic_load_explicit(&(*(TrackSite* const*)b)->alloc_count, memory_order_relaxed);
+    return (x < y) - (x > y);
+}
+
+void track_report(FILE* out, size_t top_n) {
+    size_t n = atomic_load_explicit(&site_count, memory_order_relaxed);
+    if (n > TRACK_MAX_SITES) n = TRACK_MAX_SITES;
+    TrackSite** list = (TrackSite**)malloc((n + 1) * sizeof(TrackSite*));
+    if (!list) return;
+
+    // 只收集已发布的调用点（作废的记录 file 也可能非空，但 alloc_count 为 0）
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (atomic_load_explicit(&sites[i].alloc_count, memory_order_relaxed)) {
+            list[m++] = &sites[i];
+        }
+    }
+    if (atomic_load_explicit(&overflow_site.alloc_count, memory_order_relaxed)) {
+        list[m++] = &overflow_site;
+    }
+
+    unsigned rate = atomic_load_explicit(&sample_rate, memory_order_relaxed);
+    fprintf(out, "==== 内存追踪报告 (采样率 1/%u, 丢弃 %zu 条) ====\n", rate ? rate : 1,
+            atomic_load_explicit(&dropped, memory_order_relaxed));
+
+    qsort(list, m, sizeof(TrackSite*), cmp_live_bytes_desc);
+    fprintf(out, "[疑似泄漏] 按存活字节排序:\n");
+    size_t shown = 0;
+    for (size_t i = 0; i < m && shown < top_n; i++) {
+        size_t live = atomic_load_explicit(&list[i]->live_count, memory_order_relaxed);
+        if (!live) break;
+        fprintf(out, "  %10zu 字节 %8zu 块  %s:%d\n",
+                atomic_load_explicit(&list[i]->live_bytes, memory_order_relaxed), live,
+                list[i]->file, list[i]->line);
+        shown++;
+    }
+    if (!shown) fprintf(out, "  (无)\n");
+
+    qsort(list, m, sizeof(TrackSite*), cmp_alloc_count_desc);
+    fprintf(out, "[热点调用点] 按分配次数排序:\n");
+    for (size_t i = 0; i < m && i < top_n; i++) {
+        fprintf(out, "  %10zu 次 %12zu 字节  %s:%d\n",
+                atomic_load_explicit(&list[i]->alloc_count, memory_order_relaxed),
+                atomic_load_explicit(&list[i]->alloc_bytes, memory_order_relaxed),
+                list[i]->file, list[i]->line);
+    }
+    free(list);
+}
+
+static void report_to_stdout(void) {
+    track_report(stdout, 10);
+}
+
+void track_report_at_exit(void) {
+    atexit(report_to_stdout);
+}
+
+#endif /* HAS_THREADS */
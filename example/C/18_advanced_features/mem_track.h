@@ -0,0 +1,45 @@
+/**
+ * @file mem_track.h
+ * @brief 低开销内存分配追踪器
+ *
+ * 与逐条 printf 的 _debug_malloc 不同，这里只记账不打印：
+ * 1. 每个存活分配 (指针, 大小, 调用点) 记录在分片哈希表中，64 个分片各有一把自旋锁，线程间很少冲突。
+ * 2. 按 __FILE__/__LINE__ 聚合每个调用点的分配次数、字节数、存活数，计数器都是 relaxed 原子量。
+ * 3. 支持 1/N 采样，生产环境可以只追踪一小部分分配。每块前有一个小头部标记是否被采样，
+ *    未采样块的释放不查表、不加锁。
+ * 4. 随时或退出时输出“泄漏报告”（按存活字节排序）和“热点调用点”（按分配次数排序）。
+ *
+ * 通常通过 main.c 中的 MY_MALLOC/MY_FREE 宏接入（编译时定义 DEBUG_MEM）。
+ */
+
+#ifndef MEM_TRACK_H
+#define MEM_TRACK_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* sample_rate = 1 追踪全部分配，N 表示每个线程每 N 次分配追踪 1 次；0 关闭追踪 */
+void track_set_sample_rate(unsigned sample_rate);
+
+void* track_malloc(size_t size, const char* file, int line);
+void* track_calloc(size_t count, size_t size, const char* file, int line);
+/* ptr 必须来自 track_malloc/track_calloc/track_realloc（块前有头部），不能混用 malloc/free */
+void* track_realloc(void* ptr, size_t size, const char* file, int line);
+void track_free(void* ptr);
+
+/* 当前被追踪的存活分配数与字节数 */
+size_t track_live_count(void);
+size_t track_live_bytes(void);
+
+/* 输出泄漏报告和热点调用点，各取前 top_n 个 */
+void track_report(FILE* out, size_t top_n);
+/* 注册 atexit，在程序退出时自动输出报告 */
+void track_report_at_exit(void);
+
+#endif /* HAS_THREADS */
+
+#endif /* MEM_TRACK_H */
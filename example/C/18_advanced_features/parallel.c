@@ -0,0 +1,169 @@
+/**
+ * @file parallel.c
+ * @brief parallel_for / parallel_reduce 的实现
+ *
+ * 每次调用只向线程池提交 (线程数) 个“领块”任务，而不是每块一个任务：
+ * 块数再多也只有几次 malloc 和入队，调用线程自己也领块执行，最后 ws_wait 等其余任务结束。
+ */
+
+#include "parallel.h"
+
+#if HAS_THREADS
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_align.h"
+
+static once_flag default_pool_once = ONCE_FLAG_INIT;
+static WsPool* default_pool;
+static _Atomic(WsPool*) user_pool;
+
+static void default_pool_create(void) {
+    default_pool = ws_pool_create(0);
+}
+
+void parallel_set_pool(WsPool* pool) {
+    atomic_store(&user_pool, pool);
+}
+
+WsPool* parallel_pool(void) {
+    WsPool* pool = atomic_load(&user_pool);
+    if (pool) return pool;
+    call_once(&default_pool_once, default_pool_create);
+    return default_pool;
+}
+
+void parallel_shutdown(void) {
+    call_once(&default_pool_once, default_pool_create); /* 保证之后不会再创建 */
+    if (default_pool) ws_pool_destroy(default_pool);
+    default_pool = NULL;
+}
+
+size_t parallel_grain(size_t n, size_t grain, unsigned flags) {
+    if (grain) return grain;
+    size_t chunks = PARALLEL_DETERMINISTIC_CHUNKS;
+    if (!(flags & PARALLEL_DETERMINISTIC)) {
+        WsPool* pool = parallel_pool();
+        int threads = pool ? ws_pool_size(pool) + 1 : 1; /* 调用线程也参与 */
+        chunks = (size_t)threads * PARALLEL_CHUNKS_PER_THREAD;
+    }
+    grain = (n + chunks - 1) / chunks;
+    return grain ? grain : 1;
+}
+
+/* ========================================================================== */
+/*                              领块执行                                      */
+/* ========================================================================== */
+
+typedef struct {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    size_t nchunks;
+    atomic_size_t next_chunk;
+    atomic_size_t next_runner;
+    ParallelForFn for_fn;    /* parallel_for 时非 NULL */
+    ParallelReduceFn body;   /* parallel_reduce 时非 NULL */
+    void* ctx;
+    char* partials;          /* 确定性模式每块一个，否则每个执行者一个 */
+    size_t stride;           /* 部分结果之间的间距，按缓存行对齐避免伪共享 */
+    bool per_chunk;
+} ParallelJob;
+
+static void run_chunks(void* arg) {
+    ParallelJob* job = (ParallelJob*)arg;
+    char* acc = NULL;
+    if (job->body && !job->per_chunk) {
+        size_t runner = atomic_fetch_add_explicit(&job->next_runner, 1, memory_order_relaxed);
+        acc = job->partials + runner * job->stride;
+    }
+    for (;;) {
+        size_t c = atomic_fetch_add_explicit(&job->next_chunk, 1, memory_order_relaxed);
+        if (c >= job->nchunks) break;
+        size_t b = job->begin + c * job->grain;
+        size_t e = job->end - b > job->grain ? b + job->grain : job->end;
+        if (job->for_fn) {
+            job->for_fn(b, e, job->ctx);
+        } else {
+            job->body(b, e, job->per_chunk ? job->partials + c * job->stride : acc, job->ctx);
+        }
+    }
+}
+
+/* 参与执行的线程数（含调用线程），不超过块数 */
+static size_t runner_count(WsPool* pool, size_t nchunks) {
+    size_t runners = pool ? (size_t)ws_pool_size(pool) + 1 : 1;
+    return runners < nchunks ? runners : nchunks;
+}
+
+/* 提交 runners - 1 个领块任务，调用线程也领块，返回前全部完成 */
+static void run_job(WsPool* pool, ParallelJob* job, size_t runners) {
+    WsWaitGroup wg;
+    ws_wait_group_init(&wg);
+    for (size_t i = 1; i < runners; i++) {
+        if (!ws_submit(pool, &wg, run_chunks, job)) break; /* 提交失败就少几个帮手，块照样会被领完 */
+    }
+    run_chunks(job);
+    if (runners > 1) ws_wait(pool, &wg);
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain, ParallelForFn fn, void* ctx) {
+    if (begin >= end) return;
+    size_t n = end - begin;
+    grain = parallel_grain(n, grain, 0);
+    size_t nchunks = (n - 1) / grain + 1;
+    WsPool* pool = parallel_pool();
+    size_t runners = runner_count(pool, nchunks);
+    if (runners <= 1) {
+        fn(begin, end, ctx); /* 只有一块或没有线程池，直接在本线程跑完 */
+        return;
+    }
+
+    ParallelJob job = {.begin = begin, .end = end, .grain = grain, .nchunks = nchunks,
+                       .for_fn = fn, .ctx = ctx};
+    atomic_init(&job.next_chunk, 0);
+    atomic_init(&job.next_runner, 0);
+    run_job(pool, &job, runners);
+}
+
+bool parallel_reduce(size_t begin, size_t end, size_t grain, void* result, size_t result_size,
+                     ParallelReduceFn body, ParallelCombineFn combine, void* ctx, unsigned flags) {
+    if (begin >= end) return true;
+    size_t n = end - begin;
+    bool deterministic = (flags & PARALLEL_DETERMINISTIC) != 0;
+    grain = parallel_grain(n, grain, flags);
+    size_t nchunks = (n - 1) / grain + 1;
+    WsPool* pool = parallel_pool();
+    size_t runners = runner_count(pool, nchunks);
+    if (runners <= 1 && !deterministic) {
+        body(begin, end, result, ctx);
+        return true;
+    }
+
+    size_t stride = ALIGN_UP(result_size, (size_t)CACHE_LINE_SIZE);
+    size_t count = deterministic ? nchunks : runners;
+    if (count > SIZE_MAX / stride) return false;
+    char* partials = (char*)mem_alloc_cacheline(count * stride);
+    if (!partials) return false;
+    for (size_t i = 0; i < count; i++) memcpy(partials + i * stride, result, result_size);
+
+    ParallelJob job = {.begin = begin, .end = end, .grain = grain, .nchunks = nchunks,
+                       .body = body, .ctx = ctx, .partials = partials, .stride = stride,
+                       .per_chunk = deterministic};
+    atomic_init(&job.next_chunk, 0);
+    atomic_init(&job.next_runner, 0);
+    if (runners > 1) {
+        run_job(pool, &job, runners);
+    } else {
+        run_chunks(&job);
+    }
+
+    // 确定性模式按块下标合并；否则按执行者编号合并，而“谁是几号”取决于调度
+    for (size_t i = 0; i < count; i++) combine(result, partials + i * stride, ctx);
+    mem_aligned_free(partials);
+    return true;
+}
+
+#endif /* HAS_THREADS */
@@ -0,0 +1,66 @@
+/**
+ * @file parallel.h
+ * @brief parallel_for / parallel_reduce：把下标区间上的循环分给多个核心
+ *
+ * 06_arrays 里的求和、前缀和，09_struct_union 里对 Student 数组的成绩统计，都是一个线程从头跑到尾。
+ * 这里在工作窃取线程池 (ws_pool.h) 之上提供两个数据并行原语：
+ * 1. 区间 [begin, end) 按 grain 切成若干块，调用线程和池中线程用一个原子计数器“领块”执行，
+ *    先做完的线程自动多领几块，负载不均时也不会有人空等。
+ * 2. grain 为 0 时自动选择：每个线程大约分到 PARALLEL_CHUNKS_PER_THREAD 块，
+ *    既摊薄了领块的开销，又给负载均衡留了余地。
+ * 3. parallel_reduce 默认每个线程先在私有的部分结果上累加，最后合并，合并顺序取决于调度；
+ *    浮点加法不满足结合律，每次运行的结果可能在最后几位上不同。
+ *    传入 PARALLEL_DETERMINISTIC 时分块方式只由区间长度决定（与线程数无关），
+ *    每块有自己的部分结果并按下标顺序合并，任何线程数下结果都逐位相同。
+ *
+ * 默认使用一个按 CPU 核心数创建的全局线程池，首次调用时创建；也可以用 parallel_set_pool 指定。
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ws_pool.h"
+
+#define PARALLEL_CHUNKS_PER_THREAD 8   /* 自动 grain 时每个线程的目标块数 */
+#define PARALLEL_DETERMINISTIC_CHUNKS 256 /* 确定性模式自动 grain 时的总块数 */
+
+/* parallel_reduce 的选项 */
+#define PARALLEL_DETERMINISTIC (1u << 0)
+
+/* 处理 [begin, end) 这一块 */
+typedef void (*ParallelForFn)(size_t begin, size_t end, void* ctx);
+/* 把 [begin, end) 累加进 acc（acc 的初值是单位元） */
+typedef void (*ParallelReduceFn)(size_t begin, size_t end, void* acc, void* ctx);
+/* acc = acc ⊕ other，必须满足结合律 */
+typedef void (*ParallelCombineFn)(void* acc, const void* other, void* ctx);
+
+/* 指定后续调用使用的线程池，传 NULL 恢复默认线程池 */
+void parallel_set_pool(WsPool* pool);
+/* 当前使用的线程池（必要时创建默认线程池），创建失败返回 NULL，此时所有调用串行执行 */
+WsPool* parallel_pool(void);
+/* 回收默认线程池，之后的调用串行执行；程序退出前调用 */
+void parallel_shutdown(void);
+
+/* 实际使用的块大小：grain 非 0 时原样返回 */
+size_t parallel_grain(size_t n, size_t grain, unsigned flags);
+
+/* 对 [begin, end) 的每一块调用 fn，全部完成后返回；fn 可以再次调用 parallel_for（嵌套） */
+void parallel_for(size_t begin, size_t end, size_t grain, ParallelForFn fn, void* ctx);
+
+/*
+ * 归约：result 进入时存放单位元（如求和时的 0），返回时存放结果，大小为 result_size 字节。
+ * 部分结果从单位元按字节拷贝得到。内存不足时返回 false，result 保持不变。
+ */
+bool parallel_reduce(size_t begin, size_t end, size_t grain, void* result, size_t result_size,
+                     ParallelReduceFn body, ParallelCombineFn combine, void* ctx, unsigned flags);
+
+#endif /* HAS_THREADS */
+
+#endif /* PARALLEL_H */
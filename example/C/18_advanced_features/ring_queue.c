@@ -0,0 +1,167 @@
+/**
+ * @file ring_queue.c
+ * @brief 有界无锁环形队列的实现
+ */
+
+#include "ring_queue.h"
+
+#if HAS_THREADS
+
+#include <stdint.h>
+
+#include "mem_align.h"
+
+/* ========================================================================== */
+/*                              MPMC                                          */
+/* ========================================================================== */
+
+bool mpmc_init(MpmcQueue* q, size_t capacity) {
+    if (capacity < 2 || !IS_POWER_OF_2(capacity)) return false;
+    q->cells = (MpmcCell*)mem_alloc_cacheline(capacity * sizeof(MpmcCell));
+    if (!q->cells) return false;
+    q->mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++) atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    return true;
+}
+
+void mpmc_destroy(MpmcQueue* q) {
+    mem_aligned_free(q->cells);
+    q->cells = NULL;
+}
+
+/*
+ * 从 pos 开始数有多少个连续槽位处于期望状态 (seq == pos + i + ready_offset)，最多数 count 个。
+ * 生产者 ready_offset 为 0（空槽），消费者为 1（有数据）。
+ * 返回 0 时通过 *behind 告知第一个槽位是否落后于 pos（即队列满/空），否则说明别人抢先了。
+ */
+static size_t mpmc_count_ready(MpmcQueue* q, size_t pos, size_t count, size_t ready_offset,
+                               bool* behind) {
+    size_t n = 0;
+    for (; n < count; n++) {
+        MpmcCell* cell = &q->cells[(pos + n) & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + n + ready_offset);
+        if (diff != 0) {
+            if (n == 0) *behind = diff < 0;
+            break;
+        }
+    }
+    return n;
+}
+
+/* 抢占最多 count 个连续位置，返回起始位置和个数；0 表示满/空 */
+static size_t mpmc_claim(MpmcQueue* q, atomic_size_t* cursor, size_t count, size_t ready_offset,
+                         size_t* out_pos) {
+    size_t pos = atomic_load_explicit(cursor, memory_order_relaxed);
+    for (;;) {
+        bool behind = false;
+        size_t n = mpmc_count_ready(q, pos, count, ready_offset, &behind);
+        if (n == 0) {
+            if (behind) return 0;
+            pos = atomic_load_explicit(cursor, memory_order_relaxed); /* 被别人抢了，重读 */
+            continue;
+        }
+        // 观察到的 n 个槽位只有抢到这些位置的线程才能改动，CAS 成功后它们就归我们了
+        if (atomic_compare_exchange_weak_explicit(cursor, &pos, pos + n, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            *out_pos = pos;
+            return n;
+        }
+    }
+}
+
+size_t mpmc_push_batch(MpmcQueue* q, void* const* items, size_t count) {
+    size_t pos;
+    size_t n = mpmc_claim(q, &q->enqueue_pos, count, 0, &pos);
+    for (size_t i = 0; i < n; i++) {
+        MpmcCell* cell = &q->cells[(pos + i) & q->mask];
+        cell->data = items[i];
+        atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release); /* 发布：可读 */
+    }
+    return n;
+}
+
+size_t mpmc_pop_batch(MpmcQueue* q, void** items, size_t count) {
+    size_t pos;
+    size_t n = mpmc_claim(q, &q->dequeue_pos, count, 1, &pos);
+    for (size_t i = 0; i < n; i++) {
+        MpmcCell* cell = &q->cells[(pos + i) & q->mask];
+        items[i] = cell->data;
+        // 下一轮 (pos + 容量) 的生产者看到这个序号才会写入
+        atomic_store_explicit(&cell->seq, pos + i + q->mask + 1, memory_order_release);
+    }
+    return n;
+}
+
+bool mpmc_push(MpmcQueue* q, void* item) {
+    return mpmc_push_batch(q, &item, 1) == 1;
+}
+
+bool mpmc_pop(MpmcQueue* q, void** item) {
+    return mpmc_pop_batch(q, item, 1) == 1;
+}
+
+bool mpmc_empty(const MpmcQueue* q) {
+    return atomic_load(&q->enqueue_pos) == atomic_load(&q->dequeue_pos);
+}
+
+/* ========================================================================== */
+/*                              SPSC                                          */
+/* ========================================================================== */
+
+bool spsc_init(SpscQueue* q, size_t capacity) {
+    if (capacity < 2 || !IS_POWER_OF_2(capacity)) return false;
+    q->slots = (void**)mem_alloc_cacheline(capacity * sizeof(void*));
+    if (!q->slots) return false;
+    q->mask = capacity - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->cached_head = 0;
+    q->cached_tail = 0;
+    return true;
+}
+
+void spsc_destroy(SpscQueue* q) {
+    mem_aligned_free(q->slots);
+    q->slots = NULL;
+}
+
+size_t spsc_push_batch(SpscQueue* q, void* const* items, size_t count) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t capacity = q->mask + 1;
+    size_t free_slots = capacity - (tail - q->cached_head);
+    if (free_slots < count) {
+        // 看起来空间不够，才去读消费者的 head
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        free_slots = capacity - (tail - q->cached_head);
+    }
+    size_t n = count < free_slots ? count : free_slots;
+    for (size_t i = 0; i < n; i++) q->slots[(tail + i) & q->mask] = items[i];
+    if (n) atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+size_t spsc_pop_batch(SpscQueue* q, void** items, size_t count) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t avail = q->cached_tail - head;
+    if (avail < count) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->cached_tail - head;
+    }
+    size_t n = count < avail ? count : avail;
+    for (size_t i = 0; i < n; i++) items[i] = q->slots[(head + i) & q->mask];
+    if (n) atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
+
+bool spsc_push(SpscQueue* q, void* item) {
+    return spsc_push_batch(q, &item, 1) == 1;
+}
+
+bool spsc_pop(SpscQueue* q, void** item) {
+    return spsc_pop_batch(q, item, 1) == 1;
+}
+
+#endif /* HAS_THREADS */
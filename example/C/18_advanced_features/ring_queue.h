@@ -0,0 +1,78 @@
+/**
+ * @file ring_queue.h
+ * @brief 有界无锁环形队列：多生产者多消费者 (MPMC) 与单生产者单消费者 (SPSC)
+ *
+ * 第五节的线程只能在创建时通过 void* arg 拿到数据，这里提供线程之间持续传递数据的通道。
+ * 元素类型是 void*，可以传指针，也可以把整数直接塞进 uintptr_t。
+ *
+ * MpmcQueue（Dmitry Vyukov 的有界 MPMC 队列）：
+ * 1. 每个槽位带一个序号 seq：seq == pos 表示空、可以写；seq == pos + 1 表示有数据、可以读。
+ * 2. 生产者/消费者各自用 CAS 抢 enqueue_pos / dequeue_pos，抢到后只操作自己的槽位，不需要锁。
+ * 3. 容量必须是 2 的幂（IS_POWER_OF_2 检查），下标用 pos & mask 代替取模。
+ *
+ * SpscQueue：只有一个生产者和一个消费者时不需要 CAS，只靠 acquire/release 读写各自的下标；
+ * 每一方还缓存对方的下标，只有看起来满/空时才去读对方那条缓存行。
+ *
+ * 两者都支持批量操作：一次 CAS（或一次下标发布）搬运多个元素，摊薄同步开销。
+ */
+
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    atomic_size_t seq;
+    void* data;
+} MpmcCell;
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos;
+    _Alignas(CACHE_LINE_SIZE) MpmcCell* cells; /* 只读字段与两个下标分开，避免伪共享 */
+    size_t mask;
+} MpmcQueue;
+
+/* capacity 必须是不小于 2 的 2 的幂 */
+bool mpmc_init(MpmcQueue* q, size_t capacity);
+void mpmc_destroy(MpmcQueue* q);
+
+/* 满/空时立即返回 false，不阻塞 */
+bool mpmc_push(MpmcQueue* q, void* item);
+bool mpmc_pop(MpmcQueue* q, void** item);
+
+/* 批量版本返回实际搬运的个数（0 表示满/空），顺序与 items 一致 */
+size_t mpmc_push_batch(MpmcQueue* q, void* const* items, size_t count);
+size_t mpmc_pop_batch(MpmcQueue* q, void** items, size_t count);
+
+/* 队列是否为空。并发读写时只是瞬时快照，适合“休眠前复查一遍”这类判断 */
+bool mpmc_empty(const MpmcQueue* q);
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head; /* 消费者写：下一个要读的位置 */
+    size_t cached_tail;                           /* 消费者私有：上次看到的 tail */
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail; /* 生产者写：下一个要写的位置 */
+    size_t cached_head;                           /* 生产者私有：上次看到的 head */
+    _Alignas(CACHE_LINE_SIZE) void** slots;
+    size_t mask;
+} SpscQueue;
+
+bool spsc_init(SpscQueue* q, size_t capacity);
+void spsc_destroy(SpscQueue* q);
+
+/* 只能由唯一的生产者调用 */
+bool spsc_push(SpscQueue* q, void* item);
+size_t spsc_push_batch(SpscQueue* q, void* const* items, size_t count);
+
+/* 只能由唯一的消费者调用 */
+bool spsc_pop(SpscQueue* q, void** item);
+size_t spsc_pop_batch(SpscQueue* q, void** items, size_t count);
+
+#endif /* HAS_THREADS */
+
+#endif /* RING_QUEUE_H */
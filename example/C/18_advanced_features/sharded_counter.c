@@ -0,0 +1,32 @@
+/**
+ * @file sharded_counter.c
+ * @brief 分片计数器的实现
+ */
+
+#include "sharded_counter.h"
+
+#if HAS_THREADS
+
+_Thread_local unsigned sharded_counter_tls_slot;
+static atomic_uint next_slot;
+
+void sharded_counter_init(ShardedCounter* c) {
+    for (int i = 0; i < SHARDED_COUNTER_SHARDS; i++) atomic_init(&c->shards[i].value, 0);
+}
+
+unsigned sharded_counter_assign_slot(void) {
+    unsigned n = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed);
+    unsigned slot = n & (SHARDED_COUNTER_SHARDS - 1);
+    sharded_counter_tls_slot = slot + 1;
+    return slot;
+}
+
+long sharded_counter_read(const ShardedCounter* c) {
+    long sum = 0;
+    for (int i = 0; i < SHARDED_COUNTER_SHARDS; i++) {
+        sum += atomic_load_explicit(&c->shards[i].value, memory_order_relaxed);
+    }
+    return sum;
+}
+
+#endif /* HAS_THREADS */
@@ -0,0 +1,56 @@
+/**
+ * @file sharded_counter.h
+ * @brief 分片计数器：多线程高频自增的统计量
+ *
+ * 第五节的 ThreadSafeCounter 每次自增都要先抢 atomic_flag 自旋锁再 fetch_add，
+ * 锁和计数值两条缓存行在所有核心之间来回传递，线程越多越慢。这里换一种思路：
+ * 1. 计数器拆成 SHARDED_COUNTER_SHARDS 个分片，每个分片独占一条缓存行。
+ * 2. 每个线程第一次使用时分到一个固定分片，之后只对它做 relaxed 原子加，线程数不超过分片数时互不竞争。
+ * 3. 读取时把所有分片加起来。并发写入时读到的是某个中间值（不会撕裂，但不是同一时刻的精确快照），
+ *    写入全部结束后读到的就是精确值——正好适合监控指标这类“写多读少”的场景。
+ */
+
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#define SHARDED_COUNTER_SHARDS 32 /* 2 的幂，每个计数器占 32 * 64 = 2KB */
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_long value;
+} CounterShard;
+
+typedef struct {
+    CounterShard shards[SHARDED_COUNTER_SHARDS];
+} ShardedCounter;
+
+void sharded_counter_init(ShardedCounter* c);
+
+/* 当前线程的分片下标 + 1，0 表示尚未分配（_Thread_local 的零初始化即“未分配”） */
+extern _Thread_local unsigned sharded_counter_tls_slot;
+unsigned sharded_counter_assign_slot(void);
+
+/* 当前线程的分片下标，首次调用时按轮转方式分配 */
+static inline unsigned sharded_counter_slot(void) {
+    unsigned slot = sharded_counter_tls_slot;
+    return slot ? slot - 1 : sharded_counter_assign_slot();
+}
+
+static inline void sharded_counter_add(ShardedCounter* c, long delta) {
+    atomic_fetch_add_explicit(&c->shards[sharded_counter_slot()].value, delta,
+                              memory_order_relaxed);
+}
+
+static inline void sharded_counter_inc(ShardedCounter* c) {
+    sharded_counter_add(c, 1);
+}
+
+/* 所有分片求和 */
+long sharded_counter_read(const ShardedCounter* c);
+
+#endif /* HAS_THREADS */
+
+#endif /* SHARDED_COUNTER_H */
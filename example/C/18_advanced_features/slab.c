@@ -0,0 +1,239 @@
+/**
+ * @file slab.c
+ * @brief 分级 slab 分配器的实现
+ */
+
+/* 严格 C11 模式下需要显式打开 POSIX/BSD 扩展才能使用 mmap 的 MAP_ANONYMOUS */
+#define _DEFAULT_SOURCE
+
+#include "slab.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "mem_pool.h"
+
+#if defined(_WIN32)
+  #include <malloc.h>
+#else
+  #include <sys/mman.h>
+#endif
+
+typedef enum { SLAB_KIND_SMALL, SLAB_KIND_LARGE } SlabKind;
+
+struct SizeClass;
+
+/* 每个 64KB 对齐区块开头的头部，小块 slab 和大块共用 */
+typedef struct Slab {
+    SlabKind kind;
+    size_t chunk_size;      /* 向系统申请的字节数 */
+    struct SizeClass* cls;  /* SMALL：所属尺寸等级 */
+    MemPool pool;           /* SMALL：头部之后的空间交给内嵌的 MemPool 管理 */
+    size_t live;            /* SMALL：已分配出去的块数 */
+    bool in_partial;        /* SMALL：是否在“有空位”链表中 */
+    struct Slab* prev;
+    struct Slab* next;
+} Slab;
+
+typedef struct SizeClass {
+    size_t block_size;
+    Slab* partial; /* 还有空位的 slab，双向链表，优先从表头分配 */
+    Slab* spare;   /* 保留的一个完全空闲 slab，避免在边界上反复向系统申请/归还 */
+} SizeClass;
+
+#define SLAB_HEADER_SIZE ALIGN_UP(sizeof(Slab), (size_t)CACHE_LINE_SIZE)
+
+/* 8/16/24 之后按 2^k 与 1.5*2^k 交替增长，内部碎片不超过 33% */
+static SizeClass slab_classes[SLAB_CLASS_COUNT] = {
+    {8, NULL, NULL},    {16, NULL, NULL},   {24, NULL, NULL},   {32, NULL, NULL},
+    {48, NULL, NULL},   {64, NULL, NULL},   {96, NULL, NULL},   {128, NULL, NULL},
+    {192, NULL, NULL},  {256, NULL, NULL},  {384, NULL, NULL},  {512, NULL, NULL},
+    {768, NULL, NULL},  {1024, NULL, NULL}, {1536, NULL, NULL}, {2048, NULL, NULL},
+    {3072, NULL, NULL}, {4096, NULL, NULL},
+};
+
+static size_t os_chunk_count;
+
+/* ========================================================================== */
+/*                              系统内存接口                                  */
+/* ========================================================================== */
+
+/* 申请 size 字节并按 SLAB_SIZE 对齐；POSIX 下多映射一个 SLAB_SIZE 再把首尾多余部分还回去 */
+static void* os_alloc_aligned(size_t size) {
+#if defined(_WIN32)
+    void* p = _aligned_malloc(size, SLAB_SIZE);
+#else
+    size_t span = size + SLAB_SIZE;
+    void* raw_map = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw_map == MAP_FAILED) return NULL;
+
+    char* raw = (char*)raw_map;
+    char* p = (char*)ALIGN_UP((uintptr_t)raw, (uintptr_t)SLAB_SIZE);
+    size_t head = (size_t)(p - raw);
+    if (head) munmap(raw, head);
+    if (span - head - size) munmap(p + size, span - head - size);
+#endif
+    if (p) os_chunk_count++;
+    return p;
+}
+
+static void os_free_aligned(void* p, size_t size) {
+    os_chunk_count--;
+#if defined(_WIN32)
+    (void)size;
+    _aligned_free(p);
+#else
+    munmap(p, size);
+#endif
+}
+
+/* ========================================================================== */
+/*                              尺寸等级与 slab 链表                          */
+/* ========================================================================== */
+
+/* size 必须在 [1, SLAB_MAX_SMALL] 内 */
+static size_t slab_class_index(size_t size) {
+    if (size <= 8) return 0;
+    if (size <= 16) return 1;
+    // 2^(k-1) < size <= 2^k，在 3*2^(k-2) 与 2^k 两个等级中选一个
+    size_t k = 64 - bit_clz64((uint64_t)(size - 1));
+    size_t base = 2 * (k - 5) + 2;
+    return size <= ((size_t)3 << (k - 2)) ? base : base + 1;
+}
+
+static Slab* slab_of(const void* ptr) {
+    return (Slab*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+static void partial_push(SizeClass* cls, Slab* s) {
+    s->prev = NULL;
+    s->next = cls->partial;
+    if (cls->partial) cls->partial->prev = s;
+    cls->partial = s;
+    s->in_partial = true;
+}
+
+static void partial_remove(SizeClass* cls, Slab* s) {
+    if (s->prev) s->prev->next = s->next;
+    else cls->partial = s->next;
+    if (s->next) s->next->prev = s->prev;
+    s->in_partial = false;
+}
+
+static Slab* slab_new(SizeClass* cls) {
+    Slab* s = (Slab*)os_alloc_aligned(SLAB_SIZE);
+    if (!s) return NULL;
+
+    size_t count = (SLAB_SIZE - SLAB_HEADER_SIZE) / cls->block_size;
+    s->kind = SLAB_KIND_SMALL;
+    s->chunk_size = SLAB_SIZE;
+    s->cls = cls;
+    s->live = 0;
+    if (!pool_init_in(&s->pool, (char*)s + SLAB_HEADER_SIZE, cls->block_size, count,
+                      POOL_MODE_FREELIST)) {
+        os_free_aligned(s, SLAB_SIZE);
+        return NULL;
+    }
+    partial_push(cls, s);
+    return s;
+}
+
+static void slab_release(SizeClass* cls, Slab* s) {
+    if (s->in_partial) partial_remove(cls, s);
+    pool_deinit(&s->pool);
+    os_free_aligned(s, s->chunk_size);
+}
+
+/* ========================================================================== */
+/*                              大块路径                                      */
+/* ========================================================================== */
+
+static void* large_alloc(size_t size) {
+    if (size > SIZE_MAX - SLAB_HEADER_SIZE - SLAB_SIZE) return NULL;
+    size_t chunk = ALIGN_UP(SLAB_HEADER_SIZE + size, (size_t)4096);
+    Slab* s = (Slab*)os_alloc_aligned(chunk);
+    if (!s) return NULL;
+    s->kind = SLAB_KIND_LARGE;
+    s->chunk_size = chunk;
+    return (char*)s + SLAB_HEADER_SIZE;
+}
+
+/* ========================================================================== */
+/*                              malloc 兼容接口                               */
+/* ========================================================================== */
+
+void* slab_malloc(size_t size) {
+    if (size == 0) size = 1;
+    if (size > SLAB_MAX_SMALL) return large_alloc(size);
+
+    SizeClass* cls = &slab_classes[slab_class_index(size)];
+    Slab* s = cls->partial;
+    if (!s) {
+        s = slab_new(cls); /* 自动增长 */
+        if (!s) return NULL;
+    }
+    if (s == cls->spare) cls->spare = NULL;
+
+    void* ptr = pool_alloc(&s->pool); /* partial 链表里的 slab 一定还有空位 */
+    if (++s->live == s->pool.block_count) partial_remove(cls, s);
+    return ptr;
+}
+
+void slab_free(void* ptr) {
+    if (!ptr) return;
+    Slab* s = slab_of(ptr);
+    if (s->kind == SLAB_KIND_LARGE) {
+        os_free_aligned(s, s->chunk_size);
+        return;
+    }
+
+    SizeClass* cls = s->cls;
+    pool_free(&s->pool, ptr);
+    if (!s->in_partial) partial_push(cls, s); /* 从“满”变回“有空位” */
+
+    if (--s->live == 0) {
+        if (!cls->spare) {
+            cls->spare = s;
+        } else {
+            slab_release(cls, s); /* 已经有备用的了，这个直接还给系统 */
+        }
+    }
+}
+
+void* slab_calloc(size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void* ptr = slab_malloc(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* slab_realloc(void* ptr, size_t size) {
+    if (!ptr) return slab_malloc(size);
+    if (size == 0) {
+        slab_free(ptr);
+        return NULL;
+    }
+
+    // 当前块还装得下就原地返回，不搬家
+    size_t old_size = slab_usable_size(ptr);
+    if (size <= old_size) return ptr;
+
+    void* fresh = slab_malloc(size);
+    if (!fresh) return NULL; /* 与 realloc 一致：失败时原块保持不变 */
+    memcpy(fresh, ptr, old_size);
+    slab_free(ptr);
+    return fresh;
+}
+
+size_t slab_usable_size(const void* ptr) {
+    if (!ptr) return 0;
+    const Slab* s = slab_of(ptr);
+    if (s->kind == SLAB_KIND_LARGE) return s->chunk_size - SLAB_HEADER_SIZE;
+    return s->cls->block_size;
+}
+
+size_t slab_os_chunks(void) {
+    return os_chunk_count;
+}
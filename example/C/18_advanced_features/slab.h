@@ -0,0 +1,34 @@
+/**
+ * @file slab.h
+ * @brief 基于 MemPool 的分级 (size-class) slab 分配器
+ *
+ * 1. 8 ~ 4096 字节划分为 18 个尺寸等级，每个等级由一串 slab 组成，每个 slab 是一个 64KB 的 MemPool。
+ * 2. slab 用满后自动追加新 slab；某个 slab 完全空闲时归还给操作系统（每级保留一个备用，防止抖动）。
+ * 3. slab 按 64KB 对齐，释放时用 ptr & ~(SLAB_SIZE-1) 就能找到所属 slab，所以 slab_free 不需要传大小。
+ * 4. 超过 4096 字节的请求走“大块”路径，直接向系统申请。
+ *
+ * 接口与 malloc/free/calloc/realloc 一一对应，可以整体替换（见 main.c 中的 MY_MALLOC）。
+ * 注意：与 MemPool 一样不是线程安全的，多线程场景请参考 tc_pool.h 的线程缓存方案。
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+#define SLAB_SIZE        ((size_t)64 * 1024)
+#define SLAB_MAX_SMALL   4096
+#define SLAB_CLASS_COUNT 18
+
+void* slab_malloc(size_t size);
+void slab_free(void* ptr);
+void* slab_calloc(size_t count, size_t size);
+void* slab_realloc(void* ptr, size_t size);
+
+/* 该块实际可用的字节数（即所在尺寸等级的大小） */
+size_t slab_usable_size(const void* ptr);
+
+/* 当前向系统申请的 slab 总数（小块 slab + 大块），用于观察增长与回收 */
+size_t slab_os_chunks(void);
+
+#endif /* SLAB_H */
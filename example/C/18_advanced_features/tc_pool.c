@@ -0,0 +1,183 @@
+/**
+ * @file tc_pool.c
+ * @brief 线程缓存内存池的实现
+ */
+
+#include "tc_pool.h"
+
+#if HAS_THREADS
+
+#include "mem_align.h"
+
+static Magazine* magazine_new(void) {
+    // 按缓存行对齐，避免不同线程的弹匣/缓存落在同一缓存行上产生伪共享
+    Magazine* m = (Magazine*)mem_alloc_cacheline(sizeof(Magazine));
+    if (m) {
+        m->next = NULL;
+        m->count = 0;
+    }
+    return m;
+}
+
+static void magazine_push(Magazine** stack, Magazine* m) {
+    m->next = *stack;
+    *stack = m;
+}
+
+static Magazine* magazine_pop(Magazine** stack) {
+    Magazine* m = *stack;
+    if (m) *stack = m->next;
+    return m;
+}
+
+static void magazine_free_all(Magazine* m) {
+    while (m) {
+        Magazine* next = m->next;
+        mem_aligned_free(m);
+        m = next;
+    }
+}
+
+/* ========================================================================== */
+/*                              仓库 (depot)                                  */
+/* ========================================================================== */
+
+TcPool* tc_pool_create(size_t block_size, size_t count) {
+    TcPool* tp = (TcPool*)mem_alloc_cacheline(sizeof(TcPool));
+    if (!tp) return NULL;
+
+    tp->pool = pool_create(block_size, count);
+    tp->full = NULL;
+    tp->empty = NULL;
+    if (!tp->pool || mtx_init(&tp->lock, mtx_plain) != thrd_success) {
+        pool_destroy(tp->pool);
+        mem_aligned_free(tp);
+        return NULL;
+    }
+    return tp;
+}
+
+void tc_pool_destroy(TcPool* tp) {
+    if (!tp) return;
+    magazine_free_all(tp->full);
+    magazine_free_all(tp->empty);
+    pool_destroy(tp->pool);
+    mtx_destroy(&tp->lock);
+    mem_aligned_free(tp);
+}
+
+/* ========================================================================== */
+/*                              线程缓存                                      */
+/* ========================================================================== */
+
+TcCache* tc_cache_create(TcPool* tp) {
+    TcCache* c = (TcCache*)mem_alloc_cacheline(sizeof(TcCache));
+    if (!c) return NULL;
+
+    c->owner = tp;
+    c->loaded = magazine_new();
+    c->previous = magazine_new();
+    if (!c->loaded || !c->previous) {
+        mem_aligned_free(c->loaded);
+        mem_aligned_free(c->previous);
+        mem_aligned_free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void tc_cache_destroy(TcCache* c) {
+    if (!c) return;
+    TcPool* tp = c->owner;
+    Magazine* mags[2] = {c->loaded, c->previous};
+
+    mtx_lock(&tp->lock);
+    for (int i = 0; i < 2; i++) {
+        while (mags[i]->count > 0) {
+            pool_free(tp->pool, mags[i]->rounds[--mags[i]->count]);
+        }
+        magazine_push(&tp->empty, mags[i]);
+    }
+    mtx_unlock(&tp->lock);
+    mem_aligned_free(c);
+}
+
+/* 两个弹匣都空：把空弹匣交给仓库换一个满的；仓库也没有时，直接从底层池批量装填 */
+static void* tc_alloc_slow(TcCache* c) {
+    if (c->previous->count > 0) {
+        Magazine* tmp = c->loaded;
+        c->loaded = c->previous;
+        c->previous = tmp;
+        return c->loaded->rounds[--c->loaded->count];
+    }
+
+    TcPool* tp = c->owner;
+    mtx_lock(&tp->lock);
+    Magazine* full = magazine_pop(&tp->full);
+    if (full) {
+        magazine_push(&tp->empty, c->previous);
+        c->previous = c->loaded;
+        c->loaded = full;
+    } else {
+        Magazine* m = c->loaded;
+        while (m->count < TC_MAGAZINE_SIZE) {
+            void* block = pool_alloc(tp->pool);
+            if (!block) break;
+            m->rounds[m->count++] = block;
+        }
+    }
+    mtx_unlock(&tp->lock);
+
+    if (c->loaded->count == 0) return NULL; /* 底层池也用完了 */
+    return c->loaded->rounds[--c->loaded->count];
+}
+
+void* tc_alloc(TcCache* c) {
+    Magazine* m = c->loaded;
+    if (m->count > 0) return m->rounds[--m->count];
+    return tc_alloc_slow(c);
+}
+
+/* 两个弹匣都满：把一个满弹匣交给仓库，换一个空的回来 */
+static void tc_free_slow(TcCache* c, void* ptr) {
+    if (c->previous->count == 0) {
+        Magazine* tmp = c->loaded;
+        c->loaded = c->previous;
+        c->previous = tmp;
+        c->loaded->rounds[c->loaded->count++] = ptr;
+        return;
+    }
+
+    TcPool* tp = c->owner;
+    mtx_lock(&tp->lock);
+    Magazine* empty = magazine_pop(&tp->empty);
+    if (empty) magazine_push(&tp->full, c->previous);
+    mtx_unlock(&tp->lock);
+
+    if (!empty) {
+        empty = magazine_new(); /* 在锁外分配，缩短临界区 */
+        mtx_lock(&tp->lock);
+        if (empty) {
+            magazine_push(&tp->full, c->previous);
+        } else {
+            pool_free(tp->pool, ptr); /* 连弹匣都分配不出来时，退化为直接还给底层池 */
+        }
+        mtx_unlock(&tp->lock);
+        if (!empty) return;
+    }
+
+    c->previous = c->loaded;
+    c->loaded = empty;
+    c->loaded->rounds[c->loaded->count++] = ptr;
+}
+
+void tc_free(TcCache* c, void* ptr) {
+    Magazine* m = c->loaded;
+    if (m->count < TC_MAGAZINE_SIZE) {
+        m->rounds[m->count++] = ptr;
+        return;
+    }
+    tc_free_slow(c, ptr);
+}
+
+#endif /* HAS_THREADS */
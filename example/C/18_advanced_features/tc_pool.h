@@ -0,0 +1,61 @@
+/**
+ * @file tc_pool.h
+ * @brief 线程缓存内存池 (Thread-Caching Pool)
+ *
+ * 思路来自 Bonwick 的 Magazine 分配器：
+ * 1. 每个线程持有一个 TcCache，里面有两个“弹匣”(Magazine)，每个最多装 TC_MAGAZINE_SIZE 个空闲块。
+ * 2. 绝大多数 alloc/free 只操作自己弹匣里的数组，不加锁、不碰共享缓存行。
+ * 3. 两个弹匣都空（或都满）时，才持锁到共享“仓库”(depot) 整匣交换，一次搬运一批块。
+ *
+ * 注意：块可能暂存在其他线程的弹匣里，所以池未真正用完时 tc_alloc 也可能返回 NULL。
+ */
+
+#ifndef TC_POOL_H
+#define TC_POOL_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stddef.h>
+
+#include "mem_pool.h"
+
+#define TC_MAGAZINE_SIZE 64
+
+typedef struct Magazine {
+    struct Magazine* next; /* 在仓库中串成栈 */
+    size_t count;          /* 当前装了多少个块 */
+    void* rounds[TC_MAGAZINE_SIZE];
+} Magazine;
+
+/* 共享仓库：所有字段只在持有 lock 时访问 */
+typedef struct {
+    mtx_t lock;
+    MemPool* pool;   /* 底层内存池，本身不是线程安全的 */
+    Magazine* full;  /* 装满块的弹匣 */
+    Magazine* empty; /* 空弹匣，留着复用 */
+} TcPool;
+
+/* 线程私有缓存：只能由创建它的那个线程使用 */
+typedef struct {
+    TcPool* owner;
+    Magazine* loaded;   /* 当前使用的弹匣 */
+    Magazine* previous; /* 备用弹匣，与 loaded 交换可避免在边界上来回访问仓库 */
+} TcCache;
+
+TcPool* tc_pool_create(size_t block_size, size_t count);
+/* 销毁前必须先销毁所有 TcCache */
+void tc_pool_destroy(TcPool* tp);
+
+/* 每个线程调用一次，获得自己的缓存 */
+TcCache* tc_cache_create(TcPool* tp);
+/* 线程退出前调用：把缓存里的块归还底层内存池 */
+void tc_cache_destroy(TcCache* c);
+
+void* tc_alloc(TcCache* c);
+void tc_free(TcCache* c, void* ptr);
+
+#endif /* HAS_THREADS */
+
+#endif /* TC_POOL_H */
@@ -0,0 +1,266 @@
+/**
+ * @file cmd_hash_gen.c
+ * @brief 构建时运行的生成器：为已知的命令集合找完美哈希，输出 cmd_hash_tables.h/.c
+ *
+ * 用法：cmd_hash_gen <输出 .h> <输出 .c>（由 CMakeLists.txt 中的 add_custom_command 调用）
+ *
+ * 生成的集合：
+ *   commands  commands.h 中 COMMAND_LIST 的命令，编号就是 CommandType
+ *   bench50   基准用的 50 个命令名（动词_名词），编号是在 cmd_bench50_names 中的下标
+ *   bench500  基准用的 500 个命令名，前 50 个与 bench50 相同
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_hash.h"
+#include "commands.h"
+
+#define GEN_MAX_KEYS  32768 /* 槽数不超过 65536，位移才能放进 uint16_t */
+#define GEN_MAX_SEEDS 1000
+#define GEN_NAME_MAX  64
+
+typedef struct {
+    const char* name;
+    size_t len;
+    int value;
+    uint64_t h;
+} Key;
+
+typedef struct {
+    uint64_t seed;
+    uint32_t slot_mask;
+    uint32_t bucket_mask;
+    uint16_t* disp;
+    int* owner; /* 每个槽放的是哪个 key，空槽为 -1 */
+} Layout;
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15u;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9u;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBu;
+    return x ^ (x >> 31);
+}
+
+static uint32_t next_pow2(size_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static uint32_t bucket_of(const Layout* lay, const Key* k) {
+    return (uint32_t)(k->h >> 32) & lay->bucket_mask;
+}
+
+static uint32_t slot_of(const Layout* lay, const Key* k, uint32_t d) {
+    return ((uint32_t)k->h ^ d) & lay->slot_mask;
+}
+
+/* 桶按大小降序：大桶约束多，先趁空槽多的时候放 */
+static const size_t* g_bucket_sizes;
+static int compare_bucket_size(const void* a, const void* b) {
+    size_t sa = g_bucket_sizes[*(const uint32_t*)a], sb = g_bucket_sizes[*(const uint32_t*)b];
+    return (sa < sb) - (sa > sb);
+}
+
+/* 用当前 seed 为每个桶找位移，成功返回 true */
+static bool try_seed(Key* keys, size_t n, Layout* lay) {
+    uint32_t nbuckets = lay->bucket_mask + 1, nslots = lay->slot_mask + 1;
+    size_t* sizes = calloc(nbuckets, sizeof(size_t));
+    uint32_t* order = malloc(nbuckets * sizeof(uint32_t));
+    size_t* members = malloc(n * sizeof(size_t));
+    size_t* start = calloc((size_t)nbuckets + 1, sizeof(size_t));
+    if (!sizes || !order || !members || !start) {
+        fprintf(stderr, "cmd_hash_gen: 内存不足\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) {
+        keys[i].h = cmd_hash_bytes(lay->seed, keys[i].name, keys[i].len);
+        sizes[bucket_of(lay, &keys[i])]++;
+    }
+    for (uint32_t b = 0; b < nbuckets; b++) {
+        start[b + 1] = start[b] + sizes[b];
+        order[b] = b;
+    }
+    size_t* fill = calloc(nbuckets, sizeof(size_t));
+    if (!fill) exit(1);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t b = bucket_of(lay, &keys[i]);
+        members[start[b] + fill[b]++] = i;
+    }
+    free(fill);
+    g_bucket_sizes = sizes;
+    qsort(order, nbuckets, sizeof(uint32_t), compare_bucket_size);
+
+    for (uint32_t s = 0; s < nslots; s++) lay->owner[s] = -1;
+    memset(lay->disp, 0, nbuckets * sizeof(uint16_t));
+    bool ok = true;
+    for (uint32_t o = 0; o < nbuckets && ok; o++) {
+        uint32_t b = order[o];
+        if (sizes[b] == 0) break;
+        bool placed = false;
+        for (uint32_t d = 0; d < nslots && !placed; d++) {
+            size_t k = 0;
+            for (; k < sizes[b]; k++) {
+                size_t key = members[start[b] + k];
+                uint32_t slot = slot_of(lay, &keys[key], d);
+                if (lay->owner[slot] != -1) break;
+                lay->owner[slot] = (int)key;
+            }
+            if (k == sizes[b]) {
+                lay->disp[b] = (uint16_t)d;
+                placed = true;
+                break;
+            }
+            while (k-- > 0) lay->owner[slot_of(lay, &keys[members[start[b] + k]], d)] = -1;
+        }
+        ok = placed;
+    }
+    free(sizes);
+    free(order);
+    free(members);
+    free(start);
+    return ok;
+}
+
+static void write_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/* 为一组命令找完美哈希并写出定义；names_symbol 非 NULL 时同时输出名字数组 */
+static void emit_set(FILE* h, FILE* c, const char* set, Key* keys, size_t n,
+                     const char* names_symbol) {
+    if (n == 0 || n > GEN_MAX_KEYS) {
+        fprintf(stderr, "cmd_hash_gen: 集合 %s 的命令数 %zu 不在 1..%d 之间\n", set, n,
+                GEN_MAX_KEYS);
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (keys[i].len == keys[j].len &&
+                memcmp(keys[i].name, keys[j].name, keys[i].len) == 0) {
+                fprintf(stderr, "cmd_hash_gen: 集合 %s 中命令名 %s 重复\n", set, keys[i].name);
+                exit(1);
+            }
+        }
+    }
+
+    Layout lay;
+    uint32_t nslots = next_pow2(2 * n);
+    uint32_t nbuckets = next_pow2(n / 2 > 0 ? n / 2 : 1);
+    lay.slot_mask = nslots - 1;
+    lay.bucket_mask = nbuckets - 1;
+    lay.disp = malloc(nbuckets * sizeof(uint16_t));
+    lay.owner = malloc(nslots * sizeof(int));
+    if (!lay.disp || !lay.owner) exit(1);
+    bool ok = false;
+    for (uint64_t attempt = 1; attempt <= GEN_MAX_SEEDS && !ok; attempt++) {
+        lay.seed = splitmix64(attempt);
+        ok = try_seed(keys, n, &lay);
+    }
+    if (!ok) {
+        fprintf(stderr, "cmd_hash_gen: 集合 %s 在 %d 个 seed 内没有找到完美哈希\n", set,
+                GEN_MAX_SEEDS);
+        exit(1);
+    }
+
+    fprintf(h, "extern const CmdHashTable cmd_hash_%s;\n", set);
+    fprintf(c, "\nstatic const uint16_t cmd_hash_%s_disp[%u] = {", set, nbuckets);
+    for (uint32_t b = 0; b < nbuckets; b++) {
+        fprintf(c, "%s%u", b == 0 ? "\n    " : b % 16 ? ", " : ",\n    ", lay.disp[b]);
+    }
+    fprintf(c, "\n};\n\nstatic const CmdHashSlot cmd_hash_%s_slots[%u] = {\n", set, nslots);
+    for (uint32_t s = 0; s < nslots; s++) {
+        int k = lay.owner[s];
+        fprintf(c, "    {");
+        write_string(c, k < 0 ? "" : keys[k].name);
+        fprintf(c, ", %zu, %d},\n", k < 0 ? (size_t)0 : keys[k].len, k < 0 ? -1 : keys[k].value);
+    }
+    fprintf(c, "};\n\nconst CmdHashTable cmd_hash_%s = {\n", set);
+    fprintf(c, "    0x%016llXu, %uu, %uu, cmd_hash_%s_disp, cmd_hash_%s_slots, %zu,\n};\n",
+            (unsigned long long)lay.seed, lay.slot_mask, lay.bucket_mask, set, set, n);
+
+    if (names_symbol) {
+        fprintf(h, "extern const char* const %s[%zu];\n", names_symbol, n);
+        fprintf(c, "\nconst char* const %s[%zu] = {\n", names_symbol, n);
+        for (size_t i = 0; i < n; i++) {
+            fprintf(c, "    ");
+            write_string(c, keys[i].name);
+            fprintf(c, ",\n");
+        }
+        fprintf(c, "};\n");
+    }
+    free(lay.disp);
+    free(lay.owner);
+}
+
+/* 基准用的命令名：动词_名词，第 i 个是 verbs[i % 10] 与 nouns[i / 10] 的组合 */
+static const char* const verbs[10] = {
+    "get", "set", "del", "list", "add", "update", "sync", "load", "save", "watch",
+};
+static const char* const nouns[50] = {
+    "user",     "group",    "role",     "session",  "token",    "config",   "file",     "dir",
+    "volume",   "snapshot", "backup",   "image",    "node",     "cluster",  "pod",      "service",
+    "route",    "policy",   "secret",   "key",      "cert",     "quota",    "metric",   "alert",
+    "event",    "log",      "trace",    "job",      "task",     "queue",    "topic",    "stream",
+    "table",    "index",    "view",     "schema",   "account",  "invoice",  "order",    "cart",
+    "product",  "price",    "stock",    "shipment", "address",  "device",   "sensor",   "firmware",
+    "license",  "plugin",
+};
+
+static void make_bench_keys(Key* keys, char (*buf)[GEN_NAME_MAX], size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int len = snprintf(buf[i], GEN_NAME_MAX, "%s_%s", verbs[i % 10], nouns[i / 10]);
+        keys[i].name = buf[i];
+        keys[i].len = (size_t)len;
+        keys[i].value = (int)i;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "用法: %s <输出 .h> <输出 .c>\n", argv[0]);
+        return 1;
+    }
+    FILE* h = fopen(argv[1], "w");
+    FILE* c = fopen(argv[2], "w");
+    if (!h || !c) {
+        fprintf(stderr, "cmd_hash_gen: 无法写入输出文件\n");
+        return 1;
+    }
+    fprintf(h, "/* 由 tools/cmd_hash_gen.c 在构建时生成，不要手工修改 */\n\n"
+               "#ifndef CMD_HASH_TABLES_H\n#define CMD_HASH_TABLES_H\n\n"
+               "#include \"cmd_hash.h\"\n\n");
+    fprintf(c, "/* 由 tools/cmd_hash_gen.c 在构建时生成，不要手工修改 */\n\n"
+               "#include \"cmd_hash_tables.h\"\n");
+
+    Key commands[] = {
+#define COMMAND_KEY(id, name) {name, sizeof(name) - 1, id, 0},
+        COMMAND_LIST(COMMAND_KEY)
+#undef COMMAND_KEY
+    };
+    emit_set(h, c, "commands", commands, sizeof(commands) / sizeof(commands[0]), NULL);
+
+    static Key bench[500];
+    static char names[500][GEN_NAME_MAX];
+    make_bench_keys(bench, names, 500);
+    emit_set(h, c, "bench50", bench, 50, "cmd_bench50_names");
+    emit_set(h, c, "bench500", bench, 500, "cmd_bench500_names");
+
+    fprintf(h, "\n#endif /* CMD_HASH_TABLES_H */\n");
+    bool failed = ferror(h) || ferror(c);
+    failed |= fclose(h) != 0;
+    failed |= fclose(c) != 0;
+    if (failed) {
+        fprintf(stderr, "cmd_hash_gen: 写入输出文件失败\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file vec.c
+ * @brief 动态数组与类型无关的扩容/收缩实现
+ */
+
+#include "vec.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* 堆模式下 storage 的前 sizeof(void*) 字节就是堆指针（union 的 heap 成员） */
+static void* heap_ptr(const void* storage) {
+    void* p;
+    memcpy(&p, storage, sizeof(p));
+    return p;
+}
+
+static void set_heap_ptr(void* storage, void* p) {
+    memcpy(storage, &p, sizeof(p));
+}
+
+bool vec_raw_reserve(void* storage, size_t* capacity, size_t size, size_t elem_size,
+                     size_t inline_cap, size_t min_cap) {
+    if (min_cap <= *capacity) return true;
+
+    // 至少翻倍：n 次 push 总共只搬运 O(n) 个元素
+    size_t new_cap = *capacity > SIZE_MAX / 2 ? SIZE_MAX : *capacity * 2;
+    if (new_cap < min_cap) new_cap = min_cap;
+    if (new_cap > SIZE_MAX / elem_size) {
+        if (min_cap > SIZE_MAX / elem_size) return false;
+        new_cap = SIZE_MAX / elem_size;
+    }
+
+    void* fresh;
+    if (*capacity > inline_cap) {
+        // 已经在堆上：交给 realloc，大块时 glibc 还能用 mremap 免拷贝
+        fresh = realloc(heap_ptr(storage), new_cap * elem_size);
+        if (!fresh) return false; /* 原数组保持不变 */
+    } else {
+        // 第一次离开内部缓冲区：把已有元素搬到堆上
+        fresh = malloc(new_cap * elem_size);
+        if (!fresh) return false;
+        memcpy(fresh, storage, size * elem_size);
+    }
+    set_heap_ptr(storage, fresh);
+    *capacity = new_cap;
+    return true;
+}
+
+bool vec_raw_shrink(void* storage, size_t* capacity, size_t size, size_t elem_size,
+                    size_t inline_cap) {
+    if (*capacity <= inline_cap || size == *capacity) return true;
+
+    void* heap = heap_ptr(storage);
+    if (size <= inline_cap) {
+        // 放得回内部缓冲区：拷回去后释放堆内存
+        memcpy(storage, heap, size * elem_size);
+        free(heap);
+        *capacity = inline_cap;
+        return true;
+    }
+    void* fresh = realloc(heap, size * elem_size);
+    if (!fresh) return false;
+    set_heap_ptr(storage, fresh);
+    *capacity = size;
+    return true;
+}
+
+void vec_raw_free(void* storage, size_t capacity, size_t inline_cap) {
+    if (capacity > inline_cap) free(heap_ptr(storage));
+}
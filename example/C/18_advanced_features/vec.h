@@ -0,0 +1,107 @@
+/**
+ * @file vec.h
+ * @brief 类型泛型的动态数组（带小缓冲区优化）
+ *
+ * 11_memory 用一次 realloc 把数组从 2 扩到 100，06_arrays 到处传 int arr[] + size；
+ * 这里把两者封装成可复用的容器：
+ * 1. 容量按 2 倍几何增长，push 的均摊代价是 O(1)，不会每个元素都 realloc 一次。
+ * 2. 前 N 个元素放在结构体内部的缓冲区里，小数组完全不碰堆。
+ * 3. reserve 预留容量、shrink_to_fit 收缩（缩回 N 以内时重新放回内部缓冲区）、append 用 memcpy 批量追加。
+ *
+ * 用 VEC_DEFINE(名字, 元素类型, 内部容量) 生成具体类型，例如：
+ *     VEC_DEFINE(IntVec, int, 16)
+ *     IntVec v;
+ *     IntVec_init(&v);
+ *     IntVec_push(&v, 42);
+ *     int* data = IntVec_data(&v);
+ *     IntVec_free(&v);
+ *
+ * 内部缓冲区与堆指针共用一个 union，结构体里没有指向自身的指针，所以可以直接按值拷贝/搬移
+ * （拷贝后只能保留一份使用，否则堆内存会被释放两次）。
+ * 元素按字节拷贝，只适合不需要析构的“平凡”类型。
+ */
+
+#ifndef VEC_H
+#define VEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * 与类型无关的扩容/收缩实现（见 vec.c），宏生成的函数只负责把类型信息传进来。
+ * storage 指向 union 的起始地址：内部模式下它就是元素数组，堆模式下它存着堆指针。
+ * 容量大于 inline_cap 即表示处于堆模式。
+ */
+bool vec_raw_reserve(void* storage, size_t* capacity, size_t size, size_t elem_size,
+                     size_t inline_cap, size_t min_cap);
+bool vec_raw_shrink(void* storage, size_t* capacity, size_t size, size_t elem_size,
+                    size_t inline_cap);
+void vec_raw_free(void* storage, size_t capacity, size_t inline_cap);
+
+/* N 至少为 1（C 不允许零长数组） */
+#define VEC_DEFINE(Name, T, N)                                                                     \
+    typedef struct {                                                                               \
+        size_t size;                                                                               \
+        size_t capacity;                                                                           \
+        union {                                                                                    \
+            T* heap;                                                                               \
+            T buf[N];                                                                              \
+        } u;                                                                                       \
+    } Name;                                                                                        \
+                                                                                                   \
+    static inline void Name##_init(Name* v) {                                                      \
+        v->size = 0;                                                                               \
+        v->capacity = (N);                                                                         \
+    }                                                                                              \
+                                                                                                   \
+    static inline void Name##_free(Name* v) {                                                      \
+        vec_raw_free(&v->u, v->capacity, (N));                                                     \
+        Name##_init(v);                                                                            \
+    }                                                                                              \
+                                                                                                   \
+    static inline T* Name##_data(Name* v) {                                                        \
+        return v->capacity > (N) ? v->u.heap : v->u.buf;                                           \
+    }                                                                                              \
+                                                                                                   \
+    static inline bool Name##_reserve(Name* v, size_t cap) {                                       \
+        return cap <= v->capacity ||                                                               \
+               vec_raw_reserve(&v->u, &v->capacity, v->size, sizeof(T), (N), cap);                 \
+    }                                                                                              \
+                                                                                                   \
+    static inline bool Name##_shrink_to_fit(Name* v) {                                             \
+        return vec_raw_shrink(&v->u, &v->capacity, v->size, sizeof(T), (N));                       \
+    }                                                                                              \
+                                                                                                   \
+    /* 快路径只有一次比较和一次写入，扩容放在 vec.c 里不内联 */                                    \
+    static inline bool Name##_push(Name* v, T value) {                                             \
+        if (v->size == v->capacity &&                                                              \
+            !vec_raw_reserve(&v->u, &v->capacity, v->size, sizeof(T), (N), v->size + 1)) {         \
+            return false;                                                                          \
+        }                                                                                          \
+        Name##_data(v)[v->size++] = value;                                                         \
+        return true;                                                                               \
+    }                                                                                              \
+                                                                                                   \
+    static inline bool Name##_append(Name* v, const T* src, size_t count) {                        \
+        if (count > v->capacity - v->size &&                                                       \
+            (count > (size_t)-1 - v->size ||                                                       \
+             !vec_raw_reserve(&v->u, &v->capacity, v->size, sizeof(T), (N), v->size + count))) {  \
+            return false;                                                                          \
+        }                                                                                          \
+        if (count) memcpy(Name##_data(v) + v->size, src, count * sizeof(T));                       \
+        v->size += count;                                                                          \
+        return true;                                                                               \
+    }                                                                                              \
+                                                                                                   \
+    /* 调用者保证 size > 0 */                                                                      \
+    static inline T Name##_pop(Name* v) {                                                          \
+        return Name##_data(v)[--v->size];                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /* 只清空元素，保留容量 */                                                                     \
+    static inline void Name##_clear(Name* v) {                                                    \
+        v->size = 0;                                                                               \
+    }
+
+#endif /* VEC_H */
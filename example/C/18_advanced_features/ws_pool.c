@@ -0,0 +1,473 @@
+/**
+ * @file ws_pool.c
+ * @brief 工作窃取线程池的实现
+ *
+ * 双端队列按 Lê 等人《Correct and Efficient Work-Stealing for Weak Memory Models》(PPoPP 2013)
+ * 给出的 C11 内存序实现。
+ */
+
+#include "ws_pool.h"
+
+#if HAS_THREADS
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "mem_align.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <unistd.h>
+#endif
+
+#define WS_DEQUE_INITIAL_CAP 1024 /* 必须是 2 的幂 */
+#define WS_SPIN_ROUNDS       64   /* 休眠前让出 CPU 重试的次数 */
+
+typedef struct WsTask {
+    WsTaskFn fn;
+    void* arg;
+    WsWaitGroup* wg;
+    struct WsTask* next; /* 注入队列中的链接 */
+} WsTask;
+
+/* 环形数组，扩容后旧数组可能仍被窃取者读取，所以挂到 retired 链上，销毁线程池时统一释放 */
+typedef struct WsArray {
+    int64_t cap; /* 2 的幂 */
+    struct WsArray* retired;
+    _Atomic(WsTask*) slots[];
+} WsArray;
+
+/* top 被窃取者 CAS，bottom 只被所有者写，分开放在两条缓存行上 */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic int64_t top;
+    _Alignas(CACHE_LINE_SIZE) _Atomic int64_t bottom;
+    _Atomic(WsArray*) array;
+    uint64_t rng; /* 选择窃取对象的随机数状态，只由所有者使用 */
+} WsDeque;
+
+typedef struct {
+    WsDeque deque;
+    WsPool* pool;
+    int index;
+    int cpu;      /* 绑定的逻辑 CPU，-1 表示不绑定 */
+    int* victims; /* 其他工作线程的下标，同一 L3 域的排在前面 */
+    int near;     /* victims 中同一 L3 域的个数 */
+    atomic_long steals_near; /* 只由所有者写 */
+    atomic_long steals_far;
+    thrd_t thread;
+} WsWorker;
+
+struct WsPool {
+    WsWorker* workers;
+    int nthreads; /* 队列数，工作线程启动前就确定，窃取时按它取模 */
+    int started;  /* 实际启动成功的线程数 */
+    int* everyone; /* 0..nthreads-1，外部线程窃取时用 */
+    int* victim_buf;
+
+    // 注入队列和休眠都用这把锁
+    mtx_t lock;
+    cnd_t wake;
+    WsTask* inject_head;
+    WsTask* inject_tail;
+    atomic_long inject_count;
+    atomic_int sleepers;
+    atomic_bool stop;
+};
+
+/* 当前线程所属的工作线程，非工作线程为 NULL */
+static _Thread_local WsWorker* tls_worker;
+
+/* ========================================================================== */
+/*                              Chase-Lev 双端队列                            */
+/* ========================================================================== */
+
+static WsArray* ws_array_new(int64_t cap) {
+    WsArray* a = (WsArray*)malloc(sizeof(WsArray) + (size_t)cap * sizeof(_Atomic(WsTask*)));
+    if (!a) return NULL;
+    a->cap = cap;
+    a->retired = NULL;
+    return a;
+}
+
+static WsTask* slot_load(WsArray* a, int64_t i) {
+    return atomic_load_explicit(&a->slots[i & (a->cap - 1)], memory_order_relaxed);
+}
+
+static void slot_store(WsArray* a, int64_t i, WsTask* t) {
+    atomic_store_explicit(&a->slots[i & (a->cap - 1)], t, memory_order_relaxed);
+}
+
+static bool deque_init(WsDeque* d, uint64_t seed) {
+    WsArray* a = ws_array_new(WS_DEQUE_INITIAL_CAP);
+    if (!a) return false;
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, a);
+    d->rng = seed | 1;
+    return true;
+}
+
+static void deque_destroy(WsDeque* d) {
+    WsArray* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    while (a) {
+        WsArray* next = a->retired;
+        free(a);
+        a = next;
+    }
+}
+
+/* 只能由所有者调用 */
+static bool deque_push(WsDeque* d, WsTask* t) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&d->top, memory_order_acquire);
+    WsArray* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    if (b - top > a->cap - 1) {
+        // 满了：容量翻倍，把 [top, b) 搬过去
+        WsArray* bigger = ws_array_new(a->cap * 2);
+        if (!bigger) return false;
+        for (int64_t i = top; i < b; i++) slot_store(bigger, i, slot_load(a, i));
+        bigger->retired = a;
+        atomic_store_explicit(&d->array, bigger, memory_order_release);
+        a = bigger;
+    }
+    slot_store(a, b, t);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+/* 只能由所有者调用：从底部取最近 push 的任务 (LIFO，缓存更热) */
+static WsTask* deque_take(WsDeque* d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    WsArray* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (top > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed); /* 本来就是空的 */
+        return NULL;
+    }
+    WsTask* t = slot_load(a, b);
+    if (top == b) {
+        // 只剩最后一个：和窃取者抢 top
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            t = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+/* 任何线程都可以调用：从顶部偷最早 push 的任务 (FIFO，通常是较大的子问题) */
+static WsTask* deque_steal(WsDeque* d) {
+    int64_t top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= b) return NULL;
+
+    WsArray* a = atomic_load_explicit(&d->array, memory_order_acquire);
+    WsTask* t = slot_load(a, top);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL; /* 被别人抢先，调用方换个目标再试 */
+    }
+    return t;
+}
+
+static bool deque_maybe_nonempty(WsDeque* d) {
+    return atomic_load_explicit(&d->top, memory_order_relaxed) <
+           atomic_load_explicit(&d->bottom, memory_order_relaxed);
+}
+
+/* ========================================================================== */
+/*                              找任务与执行                                  */
+/* ========================================================================== */
+
+static WsTask* inject_pop(WsPool* pool) {
+    if (atomic_load_explicit(&pool->inject_count, memory_order_relaxed) == 0) return NULL;
+    mtx_lock(&pool->lock);
+    WsTask* t = pool->inject_head;
+    if (t) {
+        pool->inject_head = t->next;
+        if (!pool->inject_head) pool->inject_tail = NULL;
+        atomic_fetch_sub_explicit(&pool->inject_count, 1, memory_order_relaxed);
+    }
+    mtx_unlock(&pool->lock);
+    return t;
+}
+
+/* 从随机位置开始把 victims[0..n) 轮询一圈，避免所有空闲线程同时盯着同一个受害者 */
+static WsTask* steal_round(WsPool* pool, const int* victims, int n, uint64_t r) {
+    if (n <= 0) return NULL;
+    int start = (int)(r % (uint64_t)n);
+    for (int i = 0; i < n; i++) {
+        WsTask* t = deque_steal(&pool->workers[victims[(start + i) % n]].deque);
+        if (t) return t;
+    }
+    return NULL;
+}
+
+static void count_steal(atomic_long* counter) {
+    long v = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, v + 1, memory_order_relaxed);
+}
+
+/* self 为 NULL 表示外部线程，只能偷和取注入队列 */
+static WsTask* find_task(WsPool* pool, WsWorker* self) {
+    if (self) {
+        WsTask* t = deque_take(&self->deque);
+        if (t) return t;
+    }
+
+    static _Thread_local uint64_t outsider_rng = 0x9E3779B97F4A7C15u;
+    uint64_t* rng = self ? &self->deque.rng : &outsider_rng;
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    if (!self) {
+        WsTask* t = steal_round(pool, pool->everyone, pool->nthreads, *rng);
+        return t ? t : inject_pop(pool);
+    }
+
+    // 先偷同一 L3 域的，任务的数据多半还在共享的 L3 里；不绑定 CPU 时所有线程都算同一个域
+    WsTask* t = steal_round(pool, self->victims, self->near, *rng);
+    if (t) {
+        count_steal(&self->steals_near);
+        return t;
+    }
+    t = steal_round(pool, self->victims + self->near, pool->nthreads - 1 - self->near, *rng);
+    if (t) {
+        count_steal(&self->steals_far);
+        return t;
+    }
+    return inject_pop(pool);
+}
+
+static bool has_work(WsPool* pool) {
+    if (atomic_load(&pool->inject_count) > 0) return true;
+    for (int i = 0; i < pool->nthreads; i++) {
+        if (deque_maybe_nonempty(&pool->workers[i].deque)) return true;
+    }
+    return false;
+}
+
+static void run_task(WsTask* t) {
+    t->fn(t->arg);
+    if (t->wg) atomic_fetch_sub_explicit(&t->wg->pending, 1, memory_order_release);
+    free(t);
+}
+
+static int worker_main(void* arg) {
+    WsWorker* self = (WsWorker*)arg;
+    WsPool* pool = self->pool;
+    tls_worker = self;
+    if (self->cpu >= 0) cpu_pin_current(self->cpu);
+
+    for (;;) {
+        WsTask* t = find_task(pool, self);
+        for (int spin = 0; !t && spin < WS_SPIN_ROUNDS; spin++) {
+            thrd_yield();
+            t = find_task(pool, self);
+        }
+        if (t) {
+            run_task(t);
+            continue;
+        }
+
+        // 先登记自己要睡了再复查一遍；与 ws_submit 中“先发布任务再检查 sleepers”配对，不会漏掉唤醒
+        mtx_lock(&pool->lock);
+        atomic_fetch_add(&pool->sleepers, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        while (!atomic_load(&pool->stop) && !has_work(pool)) cnd_wait(&pool->wake, &pool->lock);
+        atomic_fetch_sub(&pool->sleepers, 1);
+        bool done = atomic_load(&pool->stop) && !has_work(pool);
+        mtx_unlock(&pool->lock);
+        if (done) break;
+    }
+    tls_worker = NULL;
+    return 0;
+}
+
+/* ========================================================================== */
+/*                              对外接口                                      */
+/* ========================================================================== */
+
+/*
+ * 给每个工作线程分配 CPU，并排好窃取顺序：同一 L3 域的在前（near 个），其余在后。
+ * 不绑定时所有线程视为同一个域，等价于在全部线程里随机挑。
+ */
+static bool assign_cpus(WsPool* pool, CpuPlacement placement) {
+    int n = pool->nthreads;
+    int* l3 = (int*)calloc((size_t)n, sizeof(int));
+    pool->everyone = (int*)malloc((size_t)n * sizeof(int));
+    pool->victim_buf = (int*)malloc((size_t)n * (size_t)(n > 1 ? n - 1 : 1) * sizeof(int));
+    if (!l3 || !pool->everyone || !pool->victim_buf) {
+        free(l3);
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        pool->everyone[i] = i;
+        pool->workers[i].cpu = -1;
+    }
+
+    CpuTopo* topo = placement != CPU_PLACE_NONE ? cpu_topo_load() : NULL;
+    int* order = topo ? (int*)malloc((size_t)topo->ncpus * sizeof(int)) : NULL;
+    if (order) {
+        cpu_topo_order(topo, placement, order);
+        for (int i = 0; i < n; i++) {
+            const CpuInfo* c = &topo->cpus[order[i % topo->ncpus]];
+            pool->workers[i].cpu = c->cpu;
+            l3[i] = c->l3;
+        }
+    }
+    free(order);
+    cpu_topo_free(topo);
+
+    for (int i = 0; i < n; i++) {
+        WsWorker* w = &pool->workers[i];
+        w->victims = pool->victim_buf + (size_t)i * (size_t)(n - 1);
+        int k = 0;
+        for (int j = 0; j < n; j++) {
+            if (j != i && l3[j] == l3[i]) w->victims[k++] = j;
+        }
+        w->near = k;
+        for (int j = 0; j < n; j++) {
+            if (j != i && l3[j] != l3[i]) w->victims[k++] = j;
+        }
+    }
+    free(l3);
+    return true;
+}
+
+WsPool* ws_pool_create(int nthreads) {
+    WsPoolOptions opts = {.nthreads = nthreads, .placement = CPU_PLACE_NONE};
+    return ws_pool_create_ex(&opts);
+}
+
+WsPool* ws_pool_create_ex(const WsPoolOptions* opts) {
+    int nthreads = opts->nthreads;
+    if (nthreads <= 0) {
+#if defined(_SC_NPROCESSORS_ONLN)
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (nthreads <= 0) nthreads = 1;
+    }
+
+    WsPool* pool = (WsPool*)calloc(1, sizeof(WsPool));
+    if (!pool) return NULL;
+    // 每个工作线程的队列头尾各占一条缓存行，按缓存行对齐分配
+    pool->workers = (WsWorker*)mem_alloc_cacheline((size_t)nthreads * sizeof(WsWorker));
+    if (!pool->workers || mtx_init(&pool->lock, mtx_plain) != thrd_success) {
+        mem_aligned_free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    cnd_init(&pool->wake);
+    atomic_init(&pool->inject_count, 0);
+    atomic_init(&pool->sleepers, 0);
+    atomic_init(&pool->stop, false);
+
+    // 先建好所有队列再启动线程，工作线程一启动就可能去偷别人的队列
+    for (int i = 0; i < nthreads; i++) {
+        WsWorker* w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        atomic_init(&w->steals_near, 0);
+        atomic_init(&w->steals_far, 0);
+        if (!deque_init(&w->deque, 0x2545F4914F6CDD1Du * (uint64_t)(i + 1))) break;
+        pool->nthreads = i + 1;
+    }
+    bool ready = pool->nthreads == nthreads && assign_cpus(pool, opts->placement);
+    // 没启动起来的线程的队列始终为空（只有所有者会往里 push），不影响正确性
+    while (ready && pool->started < nthreads &&
+           thrd_create(&pool->workers[pool->started].thread, worker_main,
+                       &pool->workers[pool->started]) == thrd_success) {
+        pool->started++;
+    }
+    if (pool->started == 0) {
+        ws_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void ws_pool_destroy(WsPool* pool) {
+    if (!pool) return;
+    mtx_lock(&pool->lock);
+    atomic_store(&pool->stop, true);
+    cnd_broadcast(&pool->wake);
+    mtx_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->started; i++) thrd_join(pool->workers[i].thread, NULL);
+    for (int i = 0; i < pool->nthreads; i++) deque_destroy(&pool->workers[i].deque);
+    cnd_destroy(&pool->wake);
+    mtx_destroy(&pool->lock);
+    free(pool->everyone);
+    free(pool->victim_buf);
+    mem_aligned_free(pool->workers);
+    free(pool);
+}
+
+int ws_pool_size(const WsPool* pool) {
+    return pool->started;
+}
+
+int ws_pool_worker_cpu(const WsPool* pool, int i) {
+    return i >= 0 && i < pool->started ? pool->workers[i].cpu : -1;
+}
+
+WsPoolStats ws_pool_stats(const WsPool* pool) {
+    WsPoolStats st = {0, 0};
+    for (int i = 0; i < pool->started; i++) {
+        st.steals_near += atomic_load_explicit(&pool->workers[i].steals_near, memory_order_relaxed);
+        st.steals_far += atomic_load_explicit(&pool->workers[i].steals_far, memory_order_relaxed);
+    }
+    return st;
+}
+
+void ws_wait_group_init(WsWaitGroup* wg) {
+    atomic_init(&wg->pending, 0);
+}
+
+bool ws_submit(WsPool* pool, WsWaitGroup* wg, WsTaskFn fn, void* arg) {
+    WsTask* t = (WsTask*)malloc(sizeof(WsTask));
+    if (!t) return false;
+    t->fn = fn;
+    t->arg = arg;
+    t->wg = wg;
+    t->next = NULL;
+    if (wg) atomic_fetch_add_explicit(&wg->pending, 1, memory_order_relaxed);
+
+    WsWorker* self = tls_worker;
+    if (self && self->pool == pool && deque_push(&self->deque, t)) {
+        // 快路径：放进自己的队列，不加锁
+    } else {
+        mtx_lock(&pool->lock);
+        if (pool->inject_tail) pool->inject_tail->next = t;
+        else pool->inject_head = t;
+        pool->inject_tail = t;
+        atomic_fetch_add(&pool->inject_count, 1);
+        mtx_unlock(&pool->lock);
+    }
+
+    // 任务已经发布，再看有没有人在睡；和 worker_main 的“先登记再复查”构成 Dekker 式配对
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pool->sleepers, memory_order_relaxed) > 0) {
+        mtx_lock(&pool->lock);
+        cnd_signal(&pool->wake);
+        mtx_unlock(&pool->lock);
+    }
+    return true;
+}
+
+void ws_wait(WsPool* pool, WsWaitGroup* wg) {
+    WsWorker* self = tls_worker && tls_worker->pool == pool ? tls_worker : NULL;
+    while (atomic_load_explicit(&wg->pending, memory_order_acquire) > 0) {
+        WsTask* t = find_task(pool, self);
+        if (t) run_task(t);
+        else thrd_yield();
+    }
+}
+
+#endif /* HAS_THREADS */
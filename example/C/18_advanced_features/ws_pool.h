@@ -0,0 +1,71 @@
+/**
+ * @file ws_pool.h
+ * @brief 工作窃取 (work-stealing) 线程池
+ *
+ * 第五节的线程演示每个任务 thrd_create 一次再 thrd_join，创建/回收线程要几十微秒，
+ * 任务本身往往只有几百纳秒。这里改为常驻线程池：
+ * 1. 每个工作线程有一个 Chase-Lev 双端队列：自己从底部 push/pop（无锁、几乎无竞争），
+ *    空闲的线程随机挑一个“受害者”从顶部偷任务，最近提交的任务留在本线程缓存里，最老的被偷走。
+ * 2. 线程池外部的线程提交的任务进入一个带锁的注入队列，由工作线程取走。
+ * 3. 找不到任务的线程先让出几次 CPU，再在条件变量上休眠（glibc 的 cnd_wait 底层就是 futex），
+ *    提交任务时只有确实有人在睡才去唤醒。
+ * 4. 等待组 (WsWaitGroup) 统计尚未完成的任务；ws_wait 在等待期间会帮忙执行任务，
+ *    所以任务里可以递归地提交子任务再等待（fork-join），不会把线程池卡死。
+ * 5. ws_pool_create_ex 可以按 CPU 拓扑（见 cpu_topo.h）把工作线程绑到固定的 CPU 上；
+ *    绑定后窃取时先找同一 L3 域的线程，偷来的任务的数据多半还在共享的 L3 里，找不到再跨域。
+ */
+
+#ifndef WS_POOL_H
+#define WS_POOL_H
+
+#include "common.h"
+
+#if HAS_THREADS
+
+#include <stdbool.h>
+
+#include "cpu_topo.h"
+
+typedef void (*WsTaskFn)(void* arg);
+
+typedef struct WsPool WsPool;
+
+/* 等待组：可以放在栈上，ws_wait 返回前不能销毁 */
+typedef struct {
+    atomic_long pending;
+} WsWaitGroup;
+
+typedef struct {
+    int nthreads;           /* 0 表示在线 CPU 核心数 */
+    CpuPlacement placement; /* CPU_PLACE_NONE 时不绑定，由操作系统调度 */
+} WsPoolOptions;
+
+/* 窃取次数统计：near 是从同一 L3 域的线程偷到的 */
+typedef struct {
+    long steals_near;
+    long steals_far;
+} WsPoolStats;
+
+/* nthreads 为 0 时使用在线 CPU 核心数，工作线程不绑定 CPU */
+WsPool* ws_pool_create(int nthreads);
+/* 线程数超过 CPU 数时按放置顺序循环使用；绑定失败的线程照常运行，只是不固定位置 */
+WsPool* ws_pool_create_ex(const WsPoolOptions* opts);
+/* 等待已提交的任务全部执行完后回收所有工作线程 */
+void ws_pool_destroy(WsPool* pool);
+int ws_pool_size(const WsPool* pool);
+/* 第 i 个工作线程绑定的逻辑 CPU，没有绑定返回 -1 */
+int ws_pool_worker_cpu(const WsPool* pool, int i);
+/* 累计的窃取次数，只在没有任务执行时读取才是准确值 */
+WsPoolStats ws_pool_stats(const WsPool* pool);
+
+void ws_wait_group_init(WsWaitGroup* wg);
+
+/* 提交任务，wg 可以为 NULL；在工作线程内提交时放进自己的队列，否则进入注入队列 */
+bool ws_submit(WsPool* pool, WsWaitGroup* wg, WsTaskFn fn, void* arg);
+
+/* 等待 wg 中的任务全部完成，期间调用者也参与执行任务 */
+void ws_wait(WsPool* pool, WsWaitGroup* wg);
+
+#endif /* HAS_THREADS */
+
+#endif /* WS_POOL_H */
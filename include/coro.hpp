@@ -0,0 +1,644 @@
+/**
+ * @file coro.hpp
+ * @brief C++20/23 协程：task<T>、调度器与组合子
+ *
+ * 1. task<T> 是惰性的：创建时不执行，被 co_await 时才开始。等待一侧以普通调用启动子协程，
+ *    不用对称转移；子协程同步跑完时直接返回到等待者，中途挂起过的在完成时由 final_suspend
+ *    把执行权转给等待者。循环里 co_await 多少次栈深度都不变（不依赖编译器的尾调用优化）。
+ * 2. 协程帧从线程私有的分级空闲链表分配（FramePool），释放的帧留给下一个协程复用，
+ *    只有超过 kMaxPooledFrame 的大帧才走全局堆。
+ * 3. Scheduler 是执行器接口：co_await sched.schedule() 把当前协程挪到该执行器上继续。
+ *    ThreadPoolScheduler 是多线程执行器；单线程执行器（带定时器和 I/O）见 event_loop.hpp。
+ * 4. when_all 等待全部完成并按顺序收集结果，when_any 返回最先完成的那个（其余的继续跑完）。
+ * 5. sync_wait 在普通函数里阻塞等待一个 task，spawn 把 task 交给执行器后台运行。
+ */
+
+#ifndef CORO_HPP
+#define CORO_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace coro {
+
+/* ========================================================================== */
+/*                              协程帧池                                      */
+/* ========================================================================== */
+
+/*
+ * 帧大小按 64 字节分级，每个线程每级一条空闲链表。池里的块本身也是 ::operator new 得来的，
+ * 所以在 A 线程分配、B 线程释放也没问题（块只是换到 B 的链表上），关闭池时直接还给全局堆。
+ */
+class FramePool {
+public:
+    static constexpr std::size_t kGranule = 64;
+    static constexpr std::size_t kMaxPooledFrame = 1024;
+    static constexpr std::size_t kMaxCachedPerClass = 4096;  // 每级最多缓存的帧数
+
+    /*
+     * 可入池的帧无论池是否开着都按整级大小申请：池在帧存活期间被重新打开时，
+     * 这个帧释放后会进入 class_of(n) 级的链表，之后要能装下该级最大的帧。
+     */
+    static void* allocate(std::size_t n) {
+        std::size_t cls = class_of(n);
+        if (cls >= kClasses) return ::operator new(n);
+        if (enabled_.load(std::memory_order_relaxed)) {
+            Cache& c = cache();
+            if (FreeBlock* b = c.head[cls]) {
+                c.head[cls] = b->next;
+                c.count[cls]--;
+                return b;
+            }
+        }
+        return ::operator new((cls + 1) * kGranule);
+    }
+
+    static void deallocate(void* p, std::size_t n) noexcept {
+        std::size_t cls = class_of(n);
+        if (cls < kClasses && enabled_.load(std::memory_order_relaxed)) {
+            Cache& c = cache();
+            if (c.count[cls] < kMaxCachedPerClass) {
+                auto* b = static_cast<FreeBlock*>(p);
+                b->next = c.head[cls];
+                c.head[cls] = b;
+                c.count[cls]++;
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    /* 关闭后所有帧直接走全局堆，用于基准对比 */
+    static void set_enabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kClasses = kMaxPooledFrame / kGranule;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Cache {
+        std::array<FreeBlock*, kClasses> head{};
+        std::array<std::size_t, kClasses> count{};
+
+        ~Cache() {
+            for (FreeBlock* b : head) {
+                while (b) {
+                    FreeBlock* next = b->next;
+                    ::operator delete(b);
+                    b = next;
+                }
+            }
+        }
+    };
+
+    static std::size_t class_of(std::size_t n) { return n ? (n - 1) / kGranule : 0; }
+
+    static Cache& cache() {
+        thread_local Cache c;
+        return c;
+    }
+
+    static inline std::atomic<bool> enabled_{true};
+};
+
+template <class T = void>
+class task;
+
+namespace detail {
+
+/* ========================================================================== */
+/*                              task 的 promise                               */
+/* ========================================================================== */
+
+struct PromiseBase {
+    static void* operator new(std::size_t n) { return FramePool::allocate(n); }
+    static void operator delete(void* p, std::size_t n) noexcept { FramePool::deallocate(p, n); }
+
+    /*
+     * 完成时停在这里，由持有者销毁。等待者已经挂起（子协程中途异步挂起过）时由这里跳回等待者；
+     * 子协程在 task::Awaiter::await_suspend 的 resume() 里同步跑完时，等待者还没挂起，
+     * 由等待者自己接着执行，见 task::Awaiter。
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) const noexcept {
+            PromiseBase& p = h.promise();
+            if (p.handoff.exchange(true, std::memory_order_acq_rel)) return p.continuation;
+            return std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::atomic<bool> handoff{false};  // 等待者与完成的一方谁先到谁置位，后到的负责继续执行等待者
+    std::exception_ptr error;
+};
+
+template <class T>
+struct Promise : PromiseBase {
+    task<T> get_return_object() noexcept;
+
+    template <class U = T>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+
+    std::optional<T> value;
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+
+    void result() const {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+}  // namespace detail
+
+/* ========================================================================== */
+/*                              task<T>                                       */
+/* ========================================================================== */
+
+template <class T>
+class [[nodiscard]] task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+    using value_type = T;
+
+    task() noexcept = default;
+    explicit task(handle_type h) noexcept : h_(h) {}
+    task(task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (h_) h_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(h_); }
+    bool done() const noexcept { return !h_ || h_.done(); }
+
+    /* co_await task：启动它并在完成后取结果（异常会在这里重新抛出） */
+    auto operator co_await() & noexcept { return Awaiter<false>{h_}; }
+    auto operator co_await() && noexcept { return Awaiter<false>{h_}; }
+
+    /* 只等待完成、不取结果，组合子用它来避免在驱动协程里抛异常 */
+    auto when_ready() noexcept { return Awaiter<true>{h_}; }
+
+    /* 已完成的 task 的结果 */
+    T result() { return h_.promise().result(); }
+
+    handle_type handle() const noexcept { return h_; }
+    handle_type release() noexcept { return std::exchange(h_, {}); }
+
+private:
+    template <bool ReadyOnly>
+    struct Awaiter {
+        handle_type h;
+
+        bool await_ready() const noexcept { return !h || h.done(); }
+        /*
+         * 不用对称转移（返回 h）：它依赖编译器把 resume 编成尾调用，GCC 不开优化时不会这样做，
+         * 循环里 co_await 同步完成的子协程每次都会多压一层栈，几十万次后栈溢出。
+         * 这里以普通调用启动子协程；它同步跑完时返回 false，调用者不挂起直接继续，栈深度不变。
+         */
+        bool await_suspend(std::coroutine_handle<> caller) noexcept {
+            promise_type& p = h.promise();
+            p.continuation = caller;
+            h.resume();
+            return !p.handoff.exchange(true, std::memory_order_acq_rel);
+        }
+        decltype(auto) await_resume() {
+            if constexpr (!ReadyOnly) return h.promise().result();
+        }
+    };
+
+    handle_type h_;
+};
+
+namespace detail {
+
+template <class T>
+task<T> Promise<T>::get_return_object() noexcept {
+    return task<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+
+inline task<void> Promise<void>::get_return_object() noexcept {
+    return task<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+
+/* void 结果在 tuple 里用 monostate 占位 */
+template <class T>
+using non_void_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <class T>
+non_void_t<T> take_result(task<T>& t) {
+    if constexpr (std::is_void_v<T>) {
+        t.result();
+        return {};
+    } else {
+        return t.result();
+    }
+}
+
+/* ========================================================================== */
+/*                              驱动协程                                      */
+/* ========================================================================== */
+
+/* 组合子内部使用：启动一个 task，完成时给计数器减一，最后一个完成的负责唤醒等待者 */
+struct Counter {
+    explicit Counter(std::size_t n) : remaining(n + 1) {}  // 多出的 1 由等待者自己持有
+    std::atomic<std::size_t> remaining;
+    std::coroutine_handle<> parent;
+};
+
+class Driver {
+public:
+    struct promise_type {
+        static void* operator new(std::size_t n) { return FramePool::allocate(n); }
+        static void operator delete(void* p, std::size_t n) noexcept { FramePool::deallocate(p, n); }
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                Counter* c = h.promise().counter;
+                if (c->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) return c->parent;
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Driver get_return_object() noexcept {
+            return Driver{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }  // when_ready 不会抛
+
+        Counter* counter = nullptr;
+    };
+
+    explicit Driver(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+    Driver(Driver&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Driver& operator=(Driver&&) = delete;
+    ~Driver() {
+        if (h_) h_.destroy();
+    }
+
+    void start(Counter& c) {
+        h_.promise().counter = &c;
+        h_.resume();
+    }
+
+private:
+    std::coroutine_handle<promise_type> h_;
+};
+
+template <class T>
+Driver make_driver(task<T>& t) {
+    co_await t.when_ready();
+}
+
+/* 启动全部驱动协程；如果它们在启动过程中就全部完成了，等待者不必挂起 */
+template <class Drivers>
+struct WhenAllAwaiter {
+    Drivers& drivers;
+    Counter& counter;
+
+    bool await_ready() const noexcept { return std::size(drivers) == 0; }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        counter.parent = parent;
+        for (Driver& d : drivers) d.start(counter);
+        return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+/*
+ * when_any 的共享状态：输掉的 task 可能在 when_any 返回后才结束，所以由各驱动协程和 when_any
+ * 共同持有。这里用手动引用计数而不是 shared_ptr 形参：GCC 12 对立即开始的协程的按值形参
+ * 拷贝有提前析构的问题。
+ */
+template <class T>
+struct AnyState {
+    explicit AnyState(std::vector<task<T>> ts) : tasks(std::move(ts)) {}
+    std::vector<task<T>> tasks;
+    std::atomic<bool> decided{false};
+    std::atomic<int> gate{2};  // 胜者和等待者各减一，减到 0 的一方继续执行等待者
+    std::atomic<std::size_t> refs{1};
+    std::size_t winner = 0;
+    std::coroutine_handle<> parent;
+
+    void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+};
+
+/* 自行销毁的后台协程：创建时立即开始，结束时释放帧 */
+struct Detached {
+    struct promise_type {
+        static void* operator new(std::size_t n) { return FramePool::allocate(n); }
+        static void operator delete(void* p, std::size_t n) noexcept { FramePool::deallocate(p, n); }
+
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+template <class T>
+Detached any_driver(AnyState<T>* st, std::size_t i) {
+    co_await st->tasks[i].when_ready();
+    if (!st->decided.exchange(true, std::memory_order_acq_rel)) {
+        st->winner = i;
+        if (st->gate.fetch_sub(1, std::memory_order_acq_rel) == 1) st->parent.resume();
+    }
+    st->release();
+}
+
+template <class T>
+struct WhenAnyAwaiter {
+    AnyState<T>* st;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        st->parent = parent;
+        for (std::size_t i = 0; i < st->tasks.size(); i++) {
+            if (st->decided.load(std::memory_order_acquire)) break;  // 已经有结果，后面的不必启动
+            st->retain();
+            any_driver(st, i);
+        }
+        return st->gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+}  // namespace detail
+
+/* ========================================================================== */
+/*                              组合子                                        */
+/* ========================================================================== */
+
+/* 并发等待多个 task，按参数顺序返回结果；void 结果用 std::monostate 占位 */
+template <class... Ts>
+task<std::tuple<detail::non_void_t<Ts>...>> when_all(task<Ts>... tasks) {
+    detail::Counter counter(sizeof...(Ts));
+    std::array<detail::Driver, sizeof...(Ts)> drivers{detail::make_driver(tasks)...};
+    co_await detail::WhenAllAwaiter<decltype(drivers)>{drivers, counter};
+    co_return std::tuple<detail::non_void_t<Ts>...>{detail::take_result(tasks)...};
+}
+
+/* 并发等待一组同类型的 task；任何一个抛异常时，全部完成后重新抛出第一个（按下标） */
+template <class T>
+task<std::conditional_t<std::is_void_v<T>, void, std::vector<detail::non_void_t<T>>>> when_all(
+    std::vector<task<T>> tasks) {
+    detail::Counter counter(tasks.size());
+    std::vector<detail::Driver> drivers;
+    drivers.reserve(tasks.size());
+    for (auto& t : tasks) drivers.push_back(detail::make_driver(t));
+    co_await detail::WhenAllAwaiter<decltype(drivers)>{drivers, counter};
+    if constexpr (std::is_void_v<T>) {
+        for (auto& t : tasks) t.result();
+    } else {
+        std::vector<T> results;
+        results.reserve(tasks.size());
+        for (auto& t : tasks) results.push_back(t.result());
+        co_return results;
+    }
+}
+
+/* when_any 的结果：最先完成的 task 的下标及其返回值 */
+template <class T>
+struct AnyResult {
+    std::size_t index;
+    T value;
+};
+
+template <>
+struct AnyResult<void> {
+    std::size_t index;
+};
+
+/*
+ * 返回最先完成的 task；其余的 task 不会被取消，会在各自的执行器上跑完后自动释放，
+ * 因此它们引用的对象必须比它们活得更久。tasks 不能为空。
+ */
+template <class T>
+task<AnyResult<T>> when_any(std::vector<task<T>> tasks) {
+    auto* st = new detail::AnyState<T>(std::move(tasks));
+    struct Release {
+        detail::AnyState<T>* st;
+        ~Release() { st->release(); }
+    } guard{st};
+    co_await detail::WhenAnyAwaiter<T>{st};
+    task<T>& w = st->tasks[st->winner];
+    if constexpr (std::is_void_v<T>) {
+        w.result();
+        co_return AnyResult<void>{st->winner};
+    } else {
+        co_return AnyResult<T>{st->winner, w.result()};
+    }
+}
+
+/* ========================================================================== */
+/*                              执行器                                        */
+/* ========================================================================== */
+
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    /* 把协程放进运行队列，可以从任何线程调用 */
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    /* co_await sched.schedule()：挂起当前协程，稍后在该执行器上继续 */
+    auto schedule() noexcept {
+        struct Awaiter {
+            Scheduler& s;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) const { s.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+};
+
+namespace detail {
+
+inline Detached spawn_driver(Scheduler& s, task<void> t) {
+    co_await s.schedule();
+    co_await t;  // 异常会走到 Detached::unhandled_exception -> terminate
+}
+
+}  // namespace detail
+
+/* 在执行器上后台运行 t，不等待结果；t 内的异常会终止程序 */
+inline void spawn(Scheduler& s, task<void> t) {
+    detail::spawn_driver(s, std::move(t));
+}
+
+/* 多线程执行器：N 个线程共享一个运行队列 */
+class ThreadPoolScheduler final : public Scheduler {
+public:
+    explicit ThreadPoolScheduler(unsigned nthreads = 0) {
+        if (nthreads == 0) nthreads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < nthreads; i++) {
+            threads_.emplace_back([this](std::stop_token st) { worker_loop(st); });
+        }
+    }
+
+    /*
+     * 先停掉并 join 工作线程，再在当前线程上把队列里剩下的协程跑到下一个挂起点。
+     * 不直接 destroy 这些句柄：它们的帧多半由上层 task 持有，由持有者销毁才不会重复释放。
+     * 析构开始后就不能再有其他线程往这个执行器里 post。
+     */
+    ~ThreadPoolScheduler() override {
+        for (auto& t : threads_) t.request_stop();
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+        for (;;) {
+            std::coroutine_handle<> h;
+            {
+                std::lock_guard lk(mutex_);
+                if (queue_.empty()) break;
+                h = queue_.front();
+                queue_.pop_front();
+            }
+            h.resume();  // 又 schedule() 回来的会重新入队，继续在这里执行
+        }
+    }
+
+    std::size_t size() const { return threads_.size(); }
+
+    void post(std::coroutine_handle<> h) override {
+        {
+            std::lock_guard lk(mutex_);
+            queue_.push_back(h);
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void worker_loop(std::stop_token st) {
+        std::unique_lock lk(mutex_);
+        for (;;) {
+            if (!cv_.wait(lk, st, [&] { return !queue_.empty(); })) return;
+            std::coroutine_handle<> h = queue_.front();
+            queue_.pop_front();
+            lk.unlock();
+            h.resume();
+            lk.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::deque<std::coroutine_handle<>> queue_;
+    std::vector<std::jthread> threads_;  // 析构函数里已经 join，这里析构时不再等待
+};
+
+namespace detail {
+
+/* 完成通知放在调用者栈上；通知方持锁 notify，等待方拿到锁之前通知方不会再碰它，可以安全销毁 */
+struct SyncWaitState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+struct SyncWaitTask {
+    struct promise_type {
+        SyncWaitTask get_return_object() noexcept {
+            return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct Notify {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                    SyncWaitState* st = h.promise().state;
+                    std::lock_guard lk(st->mutex);
+                    st->done = true;
+                    st->cv.notify_one();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Notify{};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        SyncWaitState* state = nullptr;
+    };
+
+    std::coroutine_handle<promise_type> h;
+};
+
+template <class T>
+SyncWaitTask sync_wait_driver(task<T>& t) {
+    co_await t.when_ready();
+}
+
+}  // namespace detail
+
+/* 在当前线程启动 t 并阻塞到它完成（t 可以中途切换到其他执行器） */
+template <class T>
+T sync_wait(task<T> t) {
+    detail::SyncWaitState state;
+    detail::SyncWaitTask d = detail::sync_wait_driver(t);
+    d.h.promise().state = &state;
+    d.h.resume();
+    {
+        std::unique_lock lk(state.mutex);
+        state.cv.wait(lk, [&] { return state.done; });
+    }
+    d.h.destroy();
+    return t.result();
+}
+
+}  // namespace coro
+
+#endif /* CORO_HPP */
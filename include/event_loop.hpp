@@ -0,0 +1,486 @@
+/**
+ * @file event_loop.hpp
+ * @brief 单线程协程执行器：运行队列 + 定时器 + 异步文件读取
+ *
+ * 所有协程都在调用 run 的那个线程上执行，协程之间不需要加锁：
+ * 1. 运行队列：co_await loop.schedule() 让出执行权，排到队尾。其他线程 post 进来的协程先进
+ *    一个带锁的“远程队列”，再用 eventfd 唤醒事件循环。
+ * 2. 定时器：co_await loop.sleep_for(10ms)。到期时间放在小顶堆里，由 timerfd 在最早的
+ *    到期时间唤醒 epoll，精度不受 epoll_wait 毫秒超时的限制。
+ * 3. 文件读取：co_await loop.read(fd, buf, len, offset)。优先用 io_uring（直接调用
+ *    io_uring_setup/io_uring_enter 系统调用，不依赖 liburing），提交队列在每轮循环末尾
+ *    一次性提交；io_uring 不可用时，管道/套接字用 epoll 等可读再 read，
+ *    普通文件（epoll 不支持）直接 pread。
+ *
+ * run(t) 在 t 完成、并且循环上不再有其他待运行的协程、定时器和 I/O 之后才返回，
+ * 被 when_any 甩在后面的任务也能跑完并释放，不会泄漏协程帧。
+ *
+ * 非 Linux 平台上退化为条件变量实现，只支持运行队列和定时器。
+ */
+
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "coro.hpp"
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace coro {
+
+#if defined(__linux__)
+
+/* 最小的 io_uring 封装：只用到 READ 操作 */
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params p{};
+        long fd = syscall(__NR_io_uring_setup, entries, &p);
+        if (fd < 0) return;  // 内核太老、被 seccomp 禁用等，调用方改用后备方案
+        fd_ = static_cast<int>(fd);
+        if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+            close_all();
+            return;
+        }
+
+        ring_len_ = std::max(p.sq_off.array + p.sq_entries * sizeof(unsigned),
+                             p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+        ring_ = mmap(nullptr, ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                     IORING_OFF_SQ_RING);
+        sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd_, IORING_OFF_SQES);
+        if (ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+            if (sqes != MAP_FAILED) munmap(sqes, sqes_len_);
+            close_all();
+            return;
+        }
+        auto* base = static_cast<char*>(ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(base + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(base + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(base + p.sq_off.array);
+        sq_entries_ = p.sq_entries;
+        cq_head_ = reinterpret_cast<unsigned*>(base + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(base + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(base + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(base + p.cq_off.cqes);
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+    }
+
+    ~IoUring() { close_all(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool ok() const { return sqes_ != nullptr; }
+    int fd() const { return fd_; }
+
+    /*
+     * 填一个 READ 请求；提交队列满时先把已有的提交掉。
+     * 内核暂时不收（完成队列满时 submit 遇到 EAGAIN/EBUSY 会提前返回）就返回 false，
+     * 不能覆盖还没提交的槽位，调用者改走其他读法。
+     */
+    bool prep_read(int fd, void* buf, unsigned len, std::uint64_t offset, std::uint64_t user_data) {
+        unsigned tail = *sq_tail_;
+        if (tail - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+            submit();
+            if (tail - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+                return false;
+            }
+        }
+        unsigned idx = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buf);
+        sqe.len = len;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array_[idx] = idx;
+        std::atomic_ref(*sq_tail_).store(tail + 1, std::memory_order_release);
+        pending_submit_++;
+        return true;
+    }
+
+    /* 把攒下的请求一次性交给内核 */
+    void submit() {
+        while (pending_submit_ > 0) {
+            long n = syscall(__NR_io_uring_enter, fd_, pending_submit_, 0, 0, nullptr, 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EBUSY) return;  // 完成队列满，下一轮收割后再提交
+                return;
+            }
+            pending_submit_ -= static_cast<unsigned>(n);
+        }
+    }
+
+    /* 收割所有已完成的请求 */
+    template <class Fn>
+    void reap(Fn&& fn) {
+        unsigned head = *cq_head_;
+        unsigned tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            fn(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+    }
+
+private:
+    void close_all() {
+        if (sqes_) munmap(sqes_, sqes_len_);
+        if (ring_ && ring_ != MAP_FAILED) munmap(ring_, ring_len_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        ring_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    void* ring_ = nullptr;
+    std::size_t ring_len_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqes_len_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned pending_submit_ = 0;
+};
+
+#endif /* __linux__ */
+
+class EventLoop final : public Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EventLoop() {
+#if defined(__linux__)
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        wakefd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timerfd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        watch(wakefd_, kWakeTag);
+        watch(timerfd_, kTimerTag);
+        if (uring_.ok()) watch(uring_.fd(), kUringTag);
+#endif
+    }
+
+    ~EventLoop() override {
+#if defined(__linux__)
+        ::close(timerfd_);
+        ::close(wakefd_);
+        ::close(epfd_);
+#endif
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /* 可以从任何线程调用；在事件循环线程上调用时不加锁 */
+    void post(std::coroutine_handle<> h) override {
+        if (in_loop_thread()) {
+            ready_.push_back(h);
+            return;
+        }
+        {
+            std::lock_guard lk(remote_mutex_);
+            remote_.push_back(h);
+        }
+        wake();
+    }
+
+    /* 运行 t 直到它和循环上的其他工作全部完成 */
+    template <class T>
+    T run(task<T> t) {
+        bool finished = false;
+        auto driver = drive(t, finished);
+        loop_thread_ = std::this_thread::get_id();
+        post(driver.h);
+        while (!finished || has_work()) run_once(finished);
+        loop_thread_ = std::thread::id{};
+        driver.h.destroy();
+        return t.result();
+    }
+
+    /* 挂起到 deadline 之后；只能在本事件循环上运行的协程里使用 */
+    auto sleep_until(Clock::time_point deadline) {
+        struct Awaiter {
+            EventLoop& loop;
+            Clock::time_point deadline;
+            bool await_ready() const noexcept { return deadline <= Clock::now(); }
+            void await_suspend(std::coroutine_handle<> h) { loop.add_timer(deadline, h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, deadline};
+    }
+
+    auto sleep_for(Clock::duration d) { return sleep_until(Clock::now() + d); }
+
+    /* 等待中的定时器个数 */
+    std::size_t pending_timers() const { return timers_.size(); }
+
+#if defined(__linux__)
+    /* io_uring 是否可用（否则 read 走 epoll/pread 后备路径） */
+    bool uring_enabled() const { return uring_.ok(); }
+
+    /* 从 fd 的 offset 处读 len 字节，结果为读到的字节数，出错时为 -errno */
+    auto read(int fd, void* buf, std::size_t len, std::uint64_t offset) {
+        struct Awaiter {
+            EventLoop& loop;
+            int fd;
+            void* buf;
+            std::size_t len;
+            std::uint64_t offset;
+            std::coroutine_handle<> h;
+            long result = 0;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> caller) {
+                h = caller;
+                unsigned n = len > 0x7fffffffu ? 0x7fffffffu : static_cast<unsigned>(len);
+                auto self = reinterpret_cast<std::uint64_t>(this);
+                if (loop.uring_.ok() && loop.uring_.prep_read(fd, buf, n, offset, self)) {
+                    loop.inflight_++;
+                    return true;
+                }
+                // 后备方案（没有 io_uring 或提交队列满）：能 epoll 的 fd 等可读，普通文件直接读
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.u64 = reinterpret_cast<std::uint64_t>(this);
+                if (epoll_ctl(loop.epfd_, EPOLL_CTL_ADD, fd, &ev) == 0) {
+                    loop.inflight_++;
+                    return true;
+                }
+                do_read();
+                return false;
+            }
+            long await_resume() const noexcept { return result; }
+
+            void do_read() {
+                ssize_t n = pread(fd, buf, len, static_cast<off_t>(offset));
+                if (n < 0 && errno == ESPIPE) n = ::read(fd, buf, len);  // 管道不支持偏移
+                result = n < 0 ? -errno : n;
+            }
+            void on_ready() {  // epoll 报告可读
+                epoll_ctl(loop.epfd_, EPOLL_CTL_DEL, fd, nullptr);
+                do_read();
+            }
+        };
+        return Awaiter{*this, fd, buf, len, offset, {}, 0};
+    }
+#endif
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        std::uint64_t seq;  // 同一时刻到期的按加入顺序唤醒
+        std::coroutine_handle<> h;
+        bool operator>(const Timer& o) const {
+            return deadline != o.deadline ? deadline > o.deadline : seq > o.seq;
+        }
+    };
+
+    struct RunDriver {
+        struct promise_type {
+            RunDriver get_return_object() noexcept {
+                return RunDriver{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+        std::coroutine_handle<promise_type> h;
+    };
+
+    template <class T>
+    static RunDriver drive(task<T>& t, bool& finished) {
+        co_await t.when_ready();
+        finished = true;
+    }
+
+    bool has_work() {
+        std::lock_guard lk(remote_mutex_);
+        return !ready_.empty() || !remote_.empty() || !timers_.empty() || inflight_ > 0;
+    }
+
+    bool in_loop_thread() const { return loop_thread_ == std::this_thread::get_id(); }
+
+    void add_timer(Clock::time_point deadline, std::coroutine_handle<> h) {
+        bool earliest = timers_.empty() || deadline < timers_.top().deadline;
+        timers_.push(Timer{deadline, timer_seq_++, h});
+        if (earliest) arm_timer();
+    }
+
+    /* 一轮循环：跑完当前运行队列，然后等待事件（队列非空时不等待，全部完成时不再等待） */
+    void run_once(const bool& finished) {
+        drain_remote();
+        // 只跑本轮开始时已就绪的协程，它们新 post 的留到下一轮，避免饿死定时器和 I/O
+        std::size_t n = ready_.size();
+        for (std::size_t i = 0; i < n; i++) {
+            std::coroutine_handle<> h = ready_.front();
+            ready_.pop_front();
+            h.resume();
+        }
+        fire_timers();
+        if (finished && !has_work()) return;
+        if (ready_.empty()) {
+            busy_rounds_ = 0;
+            wait_events(false);
+        } else if (++busy_rounds_ >= kBusyPollInterval) {
+            // 一直有就绪协程时不必每轮都进内核，每隔几轮非阻塞地收一次 I/O 和唤醒事件
+            busy_rounds_ = 0;
+            wait_events(true);
+        }
+    }
+
+    void drain_remote() {
+        std::lock_guard lk(remote_mutex_);
+        while (!remote_.empty()) {
+            ready_.push_back(remote_.front());
+            remote_.pop_front();
+        }
+    }
+
+    void fire_timers() {
+        Clock::time_point now = Clock::now();
+        bool fired = false;
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready_.push_back(timers_.top().h);
+            timers_.pop();
+            fired = true;
+        }
+        if (fired) arm_timer();
+    }
+
+    static constexpr unsigned kBusyPollInterval = 16;
+
+#if defined(__linux__)
+    static constexpr std::uint64_t kWakeTag = 1;
+    static constexpr std::uint64_t kTimerTag = 2;
+    static constexpr std::uint64_t kUringTag = 3;
+
+    void watch(int fd, std::uint64_t tag) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = tag;
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void wake() {
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(wakefd_, &one, sizeof(one));
+    }
+
+    void arm_timer() {
+        itimerspec its{};
+        if (!timers_.empty()) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          timers_.top().deadline.time_since_epoch())
+                          .count();
+            if (ns <= 0) ns = 1;  // 全 0 表示解除定时器
+            its.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+            its.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        }
+        // steady_clock 在 Linux 上就是 CLOCK_MONOTONIC，可以直接用绝对时间
+        timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    void wait_events(bool nonblocking) {
+        if (uring_.ok()) uring_.submit();
+        epoll_event events[64];
+        int n = epoll_wait(epfd_, events, 64, nonblocking ? 0 : -1);
+        for (int i = 0; i < n; i++) {
+            std::uint64_t tag = events[i].data.u64;
+            if (tag == kWakeTag || tag == kTimerTag) {
+                std::uint64_t v;
+                [[maybe_unused]] ssize_t r = ::read(tag == kWakeTag ? wakefd_ : timerfd_, &v, sizeof(v));
+            } else if (tag != kUringTag) {
+                using ReadAwaiter = decltype(read(0, nullptr, 0, 0));
+                auto* a = reinterpret_cast<ReadAwaiter*>(tag);
+                a->on_ready();
+                inflight_--;
+                ready_.push_back(a->h);
+            }
+        }
+        if (uring_.ok()) {
+            uring_.reap([&](std::uint64_t user_data, int res) {
+                using ReadAwaiter = decltype(read(0, nullptr, 0, 0));
+                auto* a = reinterpret_cast<ReadAwaiter*>(user_data);
+                a->result = res;
+                inflight_--;
+                ready_.push_back(a->h);
+            });
+        }
+        fire_timers();
+    }
+
+    int epfd_ = -1;
+    int wakefd_ = -1;
+    int timerfd_ = -1;
+    IoUring uring_{256};
+    std::size_t inflight_ = 0;
+#else
+    std::condition_variable remote_cv_;
+    std::size_t inflight_ = 0;  // 没有异步 I/O，恒为 0
+
+    void wake() { remote_cv_.notify_one(); }
+    void arm_timer() {}
+
+    void wait_events(bool nonblocking) {
+        if (nonblocking) return;
+        std::unique_lock lk(remote_mutex_);
+        auto has_remote = [&] { return !remote_.empty(); };
+        if (timers_.empty()) {
+            remote_cv_.wait(lk, has_remote);
+        } else {
+            remote_cv_.wait_until(lk, timers_.top().deadline, has_remote);
+        }
+        lk.unlock();
+        fire_timers();
+    }
+#endif
+
+    std::deque<std::coroutine_handle<>> ready_;
+    std::mutex remote_mutex_;
+    std::deque<std::coroutine_handle<>> remote_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::uint64_t timer_seq_ = 0;
+    unsigned busy_rounds_ = 0;
+    std::atomic<std::thread::id> loop_thread_{};  // 其他线程 post 时会读
+};
+
+}  // namespace coro
+
+#endif /* EVENT_LOOP_HPP */
@@ -0,0 +1,254 @@
+/**
+ * @file parallel.hpp
+ * @brief parallel_for / parallel_reduce：C++ 版本的下标区间数据并行
+ *
+ * 与 example/C/18_advanced_features/parallel.h 的思路相同：
+ * 1. [begin, end) 按 grain 切块，调用线程和常驻工作线程用一个原子计数器领块执行。
+ * 2. grain 为 0 时自动选择，每个线程大约分到 kChunksPerThread 块。
+ * 3. parallel_reduce 默认每个线程一个部分结果，合并顺序取决于调度；
+ *    ReduceOrder::Deterministic 时分块只由区间长度决定、按块下标顺序合并，浮点结果逐位可复现。
+ *
+ * 块函数抛出的第一个异常会在调用线程上重新抛出。块函数里再次调用（嵌套并行）时直接串行执行，
+ * 无论这个块是在工作线程上还是在调用线程上执行的。
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parallel {
+
+inline constexpr std::size_t kChunksPerThread = 8;           // 自动 grain 时每个线程的目标块数
+inline constexpr std::size_t kDeterministicChunks = 256;     // 确定性模式自动 grain 时的总块数
+inline constexpr std::size_t kCacheLine = 64;
+
+enum class ReduceOrder {
+    Unordered,     // 每个线程一个部分结果，最快
+    Deterministic  // 每块一个部分结果，按下标顺序合并
+};
+
+/* 常驻线程池：同一时刻只执行一个“领块”作业，多个调用者排队 */
+class ThreadPool {
+public:
+    /* 块回调：chunk 是块下标，slot 是执行者编号（工作线程 0..size()-1，调用线程 size()） */
+    using ChunkFn = void (*)(void* self, std::size_t chunk, std::size_t slot);
+
+    explicit ThreadPool(unsigned nthreads = 0) {
+        if (nthreads == 0) {
+            unsigned hw = std::thread::hardware_concurrency();
+            nthreads = hw > 1 ? hw - 1 : 1;  // 调用线程也领块，所以少建一个
+        }
+        workers_.reserve(nthreads);
+        for (unsigned i = 0; i < nthreads; i++) {
+            workers_.emplace_back([this, i](std::stop_token st) { worker_loop(st, i); });
+        }
+    }
+
+    ~ThreadPool() {
+        for (auto& w : workers_) w.request_stop();
+        wake_.notify_all();
+    }  // jthread 析构时 join
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /* 工作线程数（不含调用线程） */
+    std::size_t size() const { return workers_.size(); }
+
+    /* 进程内共享的默认线程池 */
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /* 当前线程是否是某个线程池的工作线程 */
+    static bool in_worker() { return tls_in_worker(); }
+
+    /*
+     * 当前线程是否正在执行某个作业的块：工作线程，或者正在 run() 里领块的调用线程。
+     * 此时再提交作业只能串行执行——调用线程还持有 submit_mutex_，再 run() 一次就是重复加锁。
+     */
+    static bool in_job() { return tls_in_worker() || tls_in_run(); }
+
+    /* 执行 nchunks 块，返回前全部完成；块函数抛出的第一个异常在这里重新抛出 */
+    void run(std::size_t nchunks, ChunkFn fn, void* self) {
+        std::lock_guard submit(submit_mutex_);
+        struct RunScope {
+            bool saved = std::exchange(tls_in_run(), true);
+            ~RunScope() { tls_in_run() = saved; }
+        } scope;
+        Job job(fn, self, nchunks);
+        {
+            std::lock_guard lk(mutex_);
+            job_ = &job;
+            pending_workers_ = workers_.size();
+            generation_++;
+        }
+        wake_.notify_all();
+        job.claim(workers_.size());
+
+        // 所有工作线程都离开作业后 job 才能销毁
+        std::unique_lock lk(mutex_);
+        done_.wait(lk, [this] { return pending_workers_ == 0; });
+        job_ = nullptr;
+        lk.unlock();
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+private:
+    struct Job {
+        Job(ChunkFn f, void* s, std::size_t n) : fn(f), self(s), nchunks(n) {}
+
+        ChunkFn fn;
+        void* self;
+        std::size_t nchunks;
+        std::atomic<std::size_t> next{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        void claim(std::size_t slot) {
+            for (;;) {
+                std::size_t c = next.fetch_add(1, std::memory_order_relaxed);
+                if (c >= nchunks) return;
+                try {
+                    fn(self, c, slot);
+                } catch (...) {
+                    std::lock_guard lk(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next.store(nchunks, std::memory_order_relaxed);  // 剩下的块不再执行
+                }
+            }
+        }
+    };
+
+    static bool& tls_in_worker() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    static bool& tls_in_run() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void worker_loop(std::stop_token st, std::size_t slot) {
+        tls_in_worker() = true;
+        std::uint64_t seen = 0;
+        std::unique_lock lk(mutex_);
+        for (;;) {
+            if (!wake_.wait(lk, st, [&] { return generation_ != seen; })) return;  // 收到停止请求
+            seen = generation_;
+            Job* job = job_;
+            lk.unlock();
+            job->claim(slot);
+            lk.lock();
+            if (--pending_workers_ == 0) done_.notify_one();
+        }
+    }
+
+    std::vector<std::jthread> workers_;
+    std::mutex submit_mutex_;  // 同一时刻只允许一个作业
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::condition_variable done_;
+    Job* job_ = nullptr;
+    std::size_t pending_workers_ = 0;
+    std::uint64_t generation_ = 0;
+};
+
+/* 实际使用的块大小：grain 非 0 时原样返回 */
+inline std::size_t auto_grain(std::size_t n, std::size_t grain,
+                              ReduceOrder order = ReduceOrder::Unordered,
+                              ThreadPool& pool = ThreadPool::instance()) {
+    if (grain) return grain;
+    std::size_t chunks = order == ReduceOrder::Deterministic
+                             ? kDeterministicChunks
+                             : (pool.size() + 1) * kChunksPerThread;
+    return std::max<std::size_t>((n + chunks - 1) / chunks, 1);
+}
+
+/* 对 [begin, end) 的每一块调用 fn(block_begin, block_end) */
+template <class Fn>
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Fn&& fn,
+                  ThreadPool& pool = ThreadPool::instance()) {
+    if (begin >= end) return;
+    std::size_t n = end - begin;
+    grain = auto_grain(n, grain, ReduceOrder::Unordered, pool);
+    std::size_t nchunks = (n - 1) / grain + 1;
+    if (nchunks == 1 || pool.size() == 0 || ThreadPool::in_job()) {
+        fn(begin, end);
+        return;
+    }
+
+    struct Ctx {
+        Fn& fn;
+        std::size_t begin, end, grain;
+    } ctx{fn, begin, end, grain};
+    pool.run(nchunks, [](void* self, std::size_t c, std::size_t) {
+        auto& x = *static_cast<Ctx*>(self);
+        std::size_t b = x.begin + c * x.grain;
+        x.fn(b, x.end - b > x.grain ? b + x.grain : x.end);  // b + grain 在 end 接近上限时会回绕
+    }, &ctx);
+}
+
+/*
+ * 归约：body(block_begin, block_end, acc) 返回累加后的新值，combine(a, b) 返回 a ⊕ b（须满足结合律）。
+ * 每个部分结果都从 identity 拷贝开始。
+ */
+template <class T, class Body, class Combine>
+T parallel_reduce(std::size_t begin, std::size_t end, std::size_t grain, T identity, Body&& body,
+                  Combine&& combine, ReduceOrder order = ReduceOrder::Unordered,
+                  ThreadPool& pool = ThreadPool::instance()) {
+    if (begin >= end) return identity;
+    std::size_t n = end - begin;
+    grain = auto_grain(n, grain, order, pool);
+    std::size_t nchunks = (n - 1) / grain + 1;
+    bool serial = pool.size() == 0 || ThreadPool::in_job();
+    if (order == ReduceOrder::Unordered && (nchunks == 1 || serial)) {
+        return body(begin, end, std::move(identity));
+    }
+
+    // 部分结果各占一条缓存行，避免相邻线程的累加互相失效
+    struct alignas(kCacheLine) Slot {
+        T value;
+    };
+    bool per_chunk = order == ReduceOrder::Deterministic;
+    std::vector<Slot> partials(per_chunk ? nchunks : pool.size() + 1, Slot{identity});
+
+    struct Ctx {
+        Body& body;
+        std::vector<Slot>& partials;
+        std::size_t begin, end, grain;
+        bool per_chunk;
+    } ctx{body, partials, begin, end, grain, per_chunk};
+    auto chunk = [](void* self, std::size_t c, std::size_t slot) {
+        auto& x = *static_cast<Ctx*>(self);
+        std::size_t b = x.begin + c * x.grain;
+        T& acc = x.partials[x.per_chunk ? c : slot].value;
+        acc = x.body(b, x.end - b > x.grain ? b + x.grain : x.end, std::move(acc));
+    };
+    if (serial) {
+        for (std::size_t c = 0; c < nchunks; c++) chunk(&ctx, c, 0);
+    } else {
+        pool.run(nchunks, chunk, &ctx);
+    }
+
+    T result = std::move(identity);
+    for (auto& p : partials) result = combine(std::move(result), std::move(p.value));
+    return result;
+}
+
+}  // namespace parallel
+
+#endif /* PARALLEL_HPP */
@@ -0,0 +1,456 @@
+/**
+ * @file pipeline.hpp
+ * @brief 分级流水线：读取 → 解析 → 转换 → 写出这类批处理作业的骨架
+ *
+ * 1. 每一级是一个函数，相邻两级之间用有界队列连接；每一级可以配置若干个工作线程，
+ *    源 (source) 固定一个线程，按产生顺序给条目编号。
+ * 2. 背压：下游处理不过来时队列满，上游 push 阻塞；另外“在途条目数”不超过 max_in_flight，
+ *    源在拿到令牌前不会再读数据，所以内存占用上限约为 max_in_flight × 单个条目的大小，
+ *    与输入文件多大无关。
+ * 3. 输出顺序：Options::ordered 为 true 时，只有一个线程的级（包括汇点 sink）按源的编号顺序
+ *    处理条目，先到的条目在重排缓冲里等待；多线程的级总是乱序处理。
+ *    ordered 为 false 时所有级都按到达顺序处理。
+ * 4. 每一级统计处理的条目数、函数内的工作时间、等待输入（队列空）和等待输出（背压）的时间。
+ *    report 输出一张表，工作时间占比最高的一级就是瓶颈，给它加线程才有用。
+ *
+ * 条目应当是较粗的粒度（例如 1MB 的文本块而不是一行），每个条目要经过几次加锁和取时间。
+ * 任何一级抛出异常时所有队列被关闭，run 在全部线程退出后重新抛出第一个异常。
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::size_t queue_capacity = 8;  // 相邻两级之间的队列能放多少个条目
+    std::size_t max_in_flight = 32;  // 源已产生、汇点尚未处理完的条目上限
+    bool ordered = true;             // 单线程的级是否按源的顺序处理
+};
+
+/* 一级的统计，时间是该级所有线程之和（秒） */
+struct StageStats {
+    std::string name;
+    std::size_t workers = 0;
+    std::uint64_t items = 0;
+    double work_s = 0.0;      // 在用户函数里
+    double wait_in_s = 0.0;   // 输入队列空，等上游
+    double wait_out_s = 0.0;  // 输出队列满或没有令牌，等下游（背压）
+};
+
+/* 有界阻塞队列：满时 push 等待，空时 pop 等待；close 之后 push 失败，pop 取完剩余的再失败 */
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+    bool push(T&& v) {
+        std::unique_lock lk(mutex_);
+        not_full_.wait(lk, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(v));
+        lk.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& out) {
+        std::unique_lock lk(mutex_);
+        not_empty_.wait(lk, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        out = std::move(items_.front());
+        items_.pop_front();
+        lk.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard lk(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+/* 在队列里流动的条目：seq 是源产生的顺序号，用于有序模式下重排 */
+template <class T>
+struct Item {
+    std::uint64_t seq = 0;
+    T value{};
+};
+
+/* 某一级的输出端，作为下一级的输入；由 Pipeline 创建，只能在同一个 Pipeline 里使用 */
+template <class T>
+class Port {
+public:
+    Port() = default;
+
+private:
+    friend class Pipeline;
+    explicit Port(BoundedQueue<Item<T>>* q) : queue_(q) {}
+    BoundedQueue<Item<T>>* queue_ = nullptr;
+};
+
+class Pipeline {
+public:
+    explicit Pipeline(Options opt = {}) : opt_(opt) {
+        if (opt_.max_in_flight == 0) opt_.max_in_flight = 1;
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /* 源：fn(T& out) 填好一个条目返回 true，没有更多数据时返回 false */
+    template <class T, class Fn>
+    Port<T> source(std::string name, Fn fn) {
+        auto* out = make_queue<T>();
+        auto s = std::make_unique<SourceStage<T, Fn>>(*this, std::move(name), std::move(fn), out);
+        stages_.push_back(std::move(s));
+        return Port<T>(out);
+    }
+
+    /* 中间级：workers 个线程对每个条目调用 fn(In&&)，返回值交给下一级 */
+    template <class In, class Fn>
+    auto stage(std::string name, std::size_t workers, Port<In> in, Fn fn)
+        -> Port<std::invoke_result_t<Fn&, In&&>> {
+        using Out = std::invoke_result_t<Fn&, In&&>;
+        auto* out = make_queue<Out>();
+        stages_.push_back(std::make_unique<WorkStage<In, Out, Fn>>(
+            *this, std::move(name), std::max<std::size_t>(workers, 1), std::move(fn), in.queue_,
+            out));
+        return Port<Out>(out);
+    }
+
+    /* 汇点：fn(In&&) 消费条目；单线程时按 Options::ordered 决定是否有序 */
+    template <class In, class Fn>
+    void sink(std::string name, Port<In> in, Fn fn, std::size_t workers = 1) {
+        stages_.push_back(std::make_unique<WorkStage<In, void, Fn>>(
+            *this, std::move(name), std::max<std::size_t>(workers, 1), std::move(fn), in.queue_,
+            nullptr));
+    }
+
+    /* 启动所有级并等待全部处理完；可以对同一条流水线只调用一次 */
+    void run() {
+        start_ = Clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (auto& s : stages_) s->launch(threads);
+        }  // jthread 析构时 join
+        wall_s_ = std::chrono::duration<double>(Clock::now() - start_).count();
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> out;
+        for (auto& s : stages_) out.push_back(s->stats());
+        return out;
+    }
+
+    double wall_seconds() const { return wall_s_; }
+    std::size_t peak_in_flight() const { return peak_in_flight_; }
+
+    /* 每级一行：吞吐量和时间占比（相对该级线程数 × 墙钟时间），工作占比最高的标为瓶颈 */
+    void report(std::FILE* out = stdout) const {
+        std::vector<StageStats> st = stats();
+        std::size_t bottleneck = 0;
+        double best = -1.0;
+        for (std::size_t i = 0; i < st.size(); i++) {
+            double busy = st[i].work_s / (static_cast<double>(st[i].workers) * wall_s_);
+            if (busy > best) {
+                best = busy;
+                bottleneck = i;
+            }
+        }
+        std::fprintf(out, "  级           线程       条目      条目/秒    工作  等输入  等输出\n");
+        for (std::size_t i = 0; i < st.size(); i++) {
+            const StageStats& s = st[i];
+            double cap = static_cast<double>(s.workers) * wall_s_;
+            std::fprintf(out, "  %-12s %4zu %10llu %12.0f %6.1f%% %6.1f%% %6.1f%%%s\n",
+                         s.name.c_str(), s.workers, static_cast<unsigned long long>(s.items),
+                         static_cast<double>(s.items) / wall_s_, 100.0 * s.work_s / cap,
+                         100.0 * s.wait_in_s / cap, 100.0 * s.wait_out_s / cap,
+                         i == bottleneck ? "  <- 瓶颈" : "");
+        }
+        std::fprintf(out, "  墙钟 %.2f s，在途条目峰值 %zu (上限 %zu)\n", wall_s_, peak_in_flight_,
+                     opt_.max_in_flight);
+    }
+
+private:
+    /* ---------------- 内部：各级的公共部分 ---------------- */
+
+    struct QueueBase {
+        virtual ~QueueBase() = default;
+        virtual void close() = 0;
+    };
+
+    template <class T>
+    struct QueueHolder final : QueueBase {
+        explicit QueueHolder(std::size_t cap) : q(cap) {}
+        void close() override { q.close(); }
+        BoundedQueue<Item<T>> q;
+    };
+
+    class StageBase {
+    public:
+        StageBase(Pipeline& p, std::string name, std::size_t workers) : pipe_(p) {
+            stats_.name = std::move(name);
+            stats_.workers = workers;
+        }
+        virtual ~StageBase() = default;
+        virtual void launch(std::vector<std::jthread>& threads) = 0;
+
+        StageStats stats() const {
+            std::lock_guard lk(mutex_);
+            return stats_;
+        }
+
+    protected:
+        // 每个线程先在本地累计，退出时合并一次
+        struct Local {
+            std::uint64_t items = 0;
+            Clock::duration work{}, wait_in{}, wait_out{};
+        };
+
+        void merge(const Local& l) {
+            std::lock_guard lk(mutex_);
+            stats_.items += l.items;
+            stats_.work_s += std::chrono::duration<double>(l.work).count();
+            stats_.wait_in_s += std::chrono::duration<double>(l.wait_in).count();
+            stats_.wait_out_s += std::chrono::duration<double>(l.wait_out).count();
+        }
+
+        Pipeline& pipe_;
+
+    private:
+        mutable std::mutex mutex_;
+        StageStats stats_;
+    };
+
+    template <class T>
+    BoundedQueue<Item<T>>* make_queue() {
+        auto h = std::make_unique<QueueHolder<T>>(opt_.queue_capacity);
+        auto* q = &h->q;
+        queues_.push_back(std::move(h));
+        return q;
+    }
+
+    /* ---------------- 在途令牌：源取、汇点还 ---------------- */
+
+    bool acquire_token() {
+        std::unique_lock lk(token_mutex_);
+        token_cv_.wait(lk, [&] { return failed_ || in_flight_ < opt_.max_in_flight; });
+        if (failed_) return false;
+        in_flight_++;
+        peak_in_flight_ = std::max(peak_in_flight_, in_flight_);
+        return true;
+    }
+
+    void release_token() {
+        {
+            std::lock_guard lk(token_mutex_);
+            in_flight_--;
+        }
+        token_cv_.notify_one();
+    }
+
+    /* 第一个异常：记下来并关闭所有队列，让每个线程尽快退出 */
+    void fail(std::exception_ptr e) {
+        {
+            std::lock_guard lk(token_mutex_);
+            if (failed_) return;
+            failed_ = true;
+            error_ = std::move(e);
+        }
+        failed_flag_.store(true, std::memory_order_relaxed);
+        token_cv_.notify_all();
+        for (auto& q : queues_) q->close();
+    }
+
+    bool failed() const { return failed_flag_.load(std::memory_order_relaxed); }
+
+    /* ---------------- 源 ---------------- */
+
+    template <class T, class Fn>
+    class SourceStage final : public StageBase {
+    public:
+        SourceStage(Pipeline& p, std::string name, Fn fn, BoundedQueue<Item<T>>* out)
+            : StageBase(p, std::move(name), 1), fn_(std::move(fn)), out_(out) {}
+
+        void launch(std::vector<std::jthread>& threads) override {
+            threads.emplace_back([this] { loop(); });
+        }
+
+    private:
+        void loop() {
+            Local l;
+            try {
+                for (std::uint64_t seq = 0;; seq++) {
+                    auto t0 = Clock::now();
+                    if (!this->pipe_.acquire_token()) break;
+                    auto t1 = Clock::now();
+                    l.wait_out += t1 - t0;
+                    Item<T> it{seq, T{}};
+                    bool more = fn_(it.value);
+                    auto t2 = Clock::now();
+                    l.work += t2 - t1;
+                    if (!more) {
+                        this->pipe_.release_token();
+                        break;
+                    }
+                    l.items++;
+                    if (!out_->push(std::move(it))) break;
+                    l.wait_out += Clock::now() - t2;
+                }
+            } catch (...) {
+                this->pipe_.fail(std::current_exception());
+            }
+            out_->close();
+            this->merge(l);
+        }
+
+        Fn fn_;
+        BoundedQueue<Item<T>>* out_;
+    };
+
+    /* ---------------- 中间级与汇点（Out 为 void） ---------------- */
+
+    template <class In, class Out, class Fn>
+    class WorkStage final : public StageBase {
+    public:
+        WorkStage(Pipeline& p, std::string name, std::size_t workers, Fn fn,
+                  BoundedQueue<Item<In>>* in, BoundedQueue<Item<Out>>* out)
+            requires(!std::is_void_v<Out>)
+            : StageBase(p, std::move(name), workers), fn_(std::move(fn)), in_(in), out_{out},
+              live_(workers) {}
+
+        WorkStage(Pipeline& p, std::string name, std::size_t workers, Fn fn,
+                  BoundedQueue<Item<In>>* in, std::nullptr_t)
+            requires std::is_void_v<Out>
+            : StageBase(p, std::move(name), workers), fn_(std::move(fn)), in_(in), live_(workers) {}
+
+        void launch(std::vector<std::jthread>& threads) override {
+            std::size_t n = this->stats().workers;
+            bool ordered = this->pipe_.opt_.ordered && n == 1;
+            for (std::size_t i = 0; i < n; i++) {
+                threads.emplace_back([this, ordered] { loop(ordered); });
+            }
+        }
+
+    private:
+        struct OutQueue {
+            BoundedQueue<Item<Out>>* q = nullptr;
+        };
+        struct NoQueue {};
+
+        // 处理一个条目，返回 false 表示下游已关闭（出错），应当退出
+        bool process(Item<In>&& it, Local& l) {
+            auto t0 = Clock::now();
+            if constexpr (std::is_void_v<Out>) {
+                fn_(std::move(it.value));
+                l.work += Clock::now() - t0;
+                l.items++;
+                this->pipe_.release_token();
+                return true;
+            } else {
+                Item<Out> o{it.seq, fn_(std::move(it.value))};
+                auto t1 = Clock::now();
+                l.work += t1 - t0;
+                l.items++;
+                bool ok = out_.q->push(std::move(o));
+                l.wait_out += Clock::now() - t1;
+                return ok;
+            }
+        }
+
+        void loop(bool ordered) {
+            Local l;
+            std::map<std::uint64_t, In> pending;  // 有序模式下提前到达的条目
+            std::uint64_t next = 0;
+            try {
+                for (;;) {
+                    auto t0 = Clock::now();
+                    Item<In> it;
+                    bool got = in_->pop(it);
+                    l.wait_in += Clock::now() - t0;
+                    if (!got || this->pipe_.failed()) break;
+                    if (!ordered) {
+                        if (!process(std::move(it), l)) break;
+                        continue;
+                    }
+                    if (it.seq != next) {
+                        pending.emplace(it.seq, std::move(it.value));
+                        continue;
+                    }
+                    bool ok = process(std::move(it), l);
+                    next++;
+                    // 接上了：把缓冲里紧随其后的条目依次处理掉
+                    for (auto p = pending.begin(); ok && p != pending.end() && p->first == next;
+                         p = pending.erase(p), next++) {
+                        ok = process(Item<In>{p->first, std::move(p->second)}, l);
+                    }
+                    if (!ok) break;
+                }
+            } catch (...) {
+                this->pipe_.fail(std::current_exception());
+            }
+            if constexpr (!std::is_void_v<Out>) {
+                if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) out_.q->close();
+            }
+            this->merge(l);
+        }
+
+        Fn fn_;
+        BoundedQueue<Item<In>>* in_;
+        std::conditional_t<std::is_void_v<Out>, NoQueue, OutQueue> out_;
+        std::atomic<std::size_t> live_;  // 还没退出的线程数，最后一个关闭输出队列
+    };
+
+    Options opt_;
+    std::vector<std::unique_ptr<QueueBase>> queues_;
+    std::vector<std::unique_ptr<StageBase>> stages_;
+    Clock::time_point start_{};
+    double wall_s_ = 0.0;
+
+    std::mutex token_mutex_;
+    std::condition_variable token_cv_;
+    std::size_t in_flight_ = 0;
+    std::size_t peak_in_flight_ = 0;
+    bool failed_ = false;                   // 受 token_mutex_ 保护，令牌等待用
+    std::atomic<bool> failed_flag_{false};  // 工作线程每个条目检查一次，不加锁
+    std::exception_ptr error_;
+};
+
+}  // namespace pipeline
+
+#endif /* PIPELINE_HPP */
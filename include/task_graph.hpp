@@ -0,0 +1,335 @@
+/**
+ * @file task_graph.hpp
+ * @brief 带依赖的任务图 (DAG) 调度器
+ *
+ * 适合“编译 → 链接”“抽取 → 转换 → 加载”这类有先后关系的流水作业：
+ * 1. 每个任务声明自己的前驱，运行前把“未完成的前驱数”放进原子计数器，
+ *    前驱完成时减一，减到 0 的任务进入就绪队列。
+ * 2. 就绪队列按“关键路径长度”（从该任务到任意终点的最长耗时之和）排序，
+ *    先跑最长链上的任务，避免大量短任务把关键链往后挤。
+ *    耗时先用 add 时给出的估计值，每次运行后换成实测值，同一张图反复运行会越排越准。
+ * 3. Executor 持有固定数量的工作线程，可以反复执行不同的图。
+ * 4. 运行结束后 dump_timing 输出每个任务在哪个线程上、何时开始、耗时多久，
+ *    以及总工作量、关键路径和平均并行度，一眼就能看出墙钟时间花在哪里。
+ *
+ * 图中有环时 run 抛出 std::invalid_argument；任务抛出异常时不再启动新任务，
+ * 已在运行的任务结束后把第一个异常在调用线程上重新抛出。
+ */
+
+#ifndef TASK_GRAPH_HPP
+#define TASK_GRAPH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace taskgraph {
+
+using TaskId = std::size_t;
+using Clock = std::chrono::steady_clock;
+
+/* 就绪任务的出队顺序 */
+enum class Policy {
+    CriticalPath,  // 关键路径最长的先跑
+    Fifo           // 按就绪先后，作为对照
+};
+
+/* 一次运行中某个任务的计时，时间相对于本次运行开始 */
+struct TaskTiming {
+    double start_ms = 0.0;
+    double end_ms = 0.0;
+    unsigned worker = 0;
+    bool ran = false;
+};
+
+class Executor;
+
+class TaskGraph {
+public:
+    /* 添加任务；deps 中的任务必须已经添加过。cost_ms 是首次调度时使用的耗时估计 */
+    TaskId add(std::string name, std::function<void()> fn, std::initializer_list<TaskId> deps = {},
+               double cost_ms = 1.0) {
+        TaskId id = nodes_.size();
+        nodes_.push_back(Node{std::move(name), std::move(fn), {}, 0, cost_ms, 0.0, {}});
+        for (TaskId d : deps) precede(d, id);
+        return id;
+    }
+
+    /* 声明 before 必须在 after 之前完成 */
+    void precede(TaskId before, TaskId after) {
+        if (before >= nodes_.size() || after >= nodes_.size()) {
+            throw std::out_of_range("task graph: unknown task id");
+        }
+        nodes_[before].successors.push_back(after);
+        nodes_[after].npred++;
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+    const std::string& name(TaskId id) const { return nodes_[id].name; }
+    const TaskTiming& timing(TaskId id) const { return nodes_[id].timing; }
+    /* 上一次运行的墙钟时间 (ms) */
+    double wall_ms() const { return wall_ms_; }
+
+    /* 输出上一次运行的逐任务计时（按开始时间排序）和汇总 */
+    void dump_timing(std::FILE* out = stdout) const {
+        std::vector<TaskId> order;
+        for (TaskId i = 0; i < nodes_.size(); i++) {
+            if (nodes_[i].timing.ran) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [&](TaskId a, TaskId b) {
+            return nodes_[a].timing.start_ms < nodes_[b].timing.start_ms;
+        });
+
+        // 沿实测耗时找出关键路径上的任务，用 * 标出
+        std::vector<double> rank = ranks(true);
+        std::vector<bool> critical(nodes_.size(), false);
+        TaskId cur = nodes_.size();
+        double best = -1.0;
+        for (TaskId i = 0; i < nodes_.size(); i++) {
+            if (nodes_[i].npred == 0 && rank[i] > best) {
+                best = rank[i];
+                cur = i;
+            }
+        }
+        while (cur < nodes_.size()) {
+            critical[cur] = true;
+            TaskId next = nodes_.size();
+            best = -1.0;
+            for (TaskId s : nodes_[cur].successors) {
+                if (rank[s] > best) {
+                    best = rank[s];
+                    next = s;
+                }
+            }
+            cur = next;
+        }
+
+        double work = 0.0;
+        std::fprintf(out, "  %-3s %-24s %6s %10s %10s %10s\n", "", "task", "worker", "start ms",
+                     "end ms", "dur ms");
+        for (TaskId i : order) {
+            const TaskTiming& t = nodes_[i].timing;
+            work += t.end_ms - t.start_ms;
+            std::fprintf(out, "  %-3s %-24s %6u %10.2f %10.2f %10.2f\n", critical[i] ? "*" : "",
+                         nodes_[i].name.c_str(), t.worker, t.start_ms, t.end_ms,
+                         t.end_ms - t.start_ms);
+        }
+        double path = 0.0;
+        for (TaskId i = 0; i < nodes_.size(); i++) path = std::max(path, rank[i]);
+        std::fprintf(out,
+                     "  wall %.2f ms, work %.2f ms, critical path %.2f ms (*), "
+                     "average parallelism %.2f\n",
+                     wall_ms_, work, path, wall_ms_ > 0.0 ? work / wall_ms_ : 0.0);
+    }
+
+private:
+    friend class Executor;
+
+    struct Node {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        std::size_t npred;  // 前驱个数（静态）
+        double cost_ms;     // 调度用的耗时：初始为估计值，运行后更新为实测值
+        double rank = 0.0;  // 关键路径长度
+        TaskTiming timing;
+    };
+
+    /* 按逆拓扑序计算每个任务到终点的最长耗时；measured 为 true 时用上一次的实测耗时 */
+    std::vector<double> ranks(bool measured) const {
+        std::vector<TaskId> topo = topo_order();
+        std::vector<double> rank(nodes_.size(), 0.0);
+        for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
+            const Node& n = nodes_[*it];
+            double tail = 0.0;
+            for (TaskId s : n.successors) tail = std::max(tail, rank[s]);
+            double self = measured ? n.timing.end_ms - n.timing.start_ms : n.cost_ms;
+            rank[*it] = self + tail;
+        }
+        return rank;
+    }
+
+    /* Kahn 拓扑排序，有环时抛出异常 */
+    std::vector<TaskId> topo_order() const {
+        std::vector<std::size_t> indeg(nodes_.size());
+        std::vector<TaskId> topo;
+        topo.reserve(nodes_.size());
+        for (TaskId i = 0; i < nodes_.size(); i++) {
+            indeg[i] = nodes_[i].npred;
+            if (indeg[i] == 0) topo.push_back(i);
+        }
+        for (std::size_t k = 0; k < topo.size(); k++) {
+            for (TaskId s : nodes_[topo[k]].successors) {
+                if (--indeg[s] == 0) topo.push_back(s);
+            }
+        }
+        if (topo.size() != nodes_.size()) throw std::invalid_argument("task graph contains a cycle");
+        return topo;
+    }
+
+    std::vector<Node> nodes_;
+    double wall_ms_ = 0.0;
+};
+
+/* 固定大小的工作线程池；同一时刻执行一张图，调用 run 的线程阻塞等待 */
+class Executor {
+public:
+    explicit Executor(unsigned nthreads = 0) {
+        if (nthreads == 0) nthreads = std::max(1u, std::thread::hardware_concurrency());
+        workers_.reserve(nthreads);
+        for (unsigned i = 0; i < nthreads; i++) {
+            workers_.emplace_back([this, i](std::stop_token st) { worker_loop(st, i); });
+        }
+    }
+
+    ~Executor() {
+        for (auto& w : workers_) w.request_stop();
+        wake_.notify_all();
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    std::size_t size() const { return workers_.size(); }
+
+    void run(TaskGraph& graph, Policy policy = Policy::CriticalPath) {
+        std::lock_guard submit(submit_mutex_);
+        std::vector<double> rank = graph.ranks(false);  // 顺带检查有没有环
+        Run r(graph, policy);
+        for (TaskId i = 0; i < graph.nodes_.size(); i++) {
+            auto& n = graph.nodes_[i];
+            n.rank = rank[i];
+            n.timing = TaskTiming{};
+            r.pending[i].store(n.npred, std::memory_order_relaxed);
+        }
+
+        std::unique_lock lk(mutex_);
+        run_ = &r;
+        r.remaining = graph.nodes_.size();
+        r.t0 = Clock::now();
+        for (TaskId i = 0; i < graph.nodes_.size(); i++) {
+            if (graph.nodes_[i].npred == 0) r.push(i);
+        }
+        wake_.notify_all();
+        done_.wait(lk, [&] { return r.remaining == 0 || (r.error && r.running == 0); });
+        run_ = nullptr;
+        graph.wall_ms_ = ms_since(r.t0);
+        lk.unlock();
+
+        // 实测耗时作为下一次运行的调度依据
+        for (auto& n : graph.nodes_) {
+            if (n.timing.ran) n.cost_ms = n.timing.end_ms - n.timing.start_ms;
+        }
+        if (r.error) std::rethrow_exception(r.error);
+    }
+
+private:
+    /* 一次运行的状态；除 pending 外都在 mutex_ 保护下访问 */
+    struct Run {
+        Run(TaskGraph& g, Policy p)
+            : graph(g), policy(p), pending(g.nodes_.size()), seq_of(g.nodes_.size()),
+              ready([this](TaskId a, TaskId b) { return before(b, a); }) {}
+
+        /* a 是否应当先于 b 出队 */
+        bool before(TaskId a, TaskId b) const {
+            if (policy == Policy::Fifo) return seq_of[a] < seq_of[b];
+            double ra = graph.nodes_[a].rank, rb = graph.nodes_[b].rank;
+            return ra != rb ? ra > rb : seq_of[a] < seq_of[b];
+        }
+
+        void push(TaskId id) {
+            seq_of[id] = seq++;
+            ready.push(id);
+        }
+
+        TaskGraph& graph;
+        Policy policy;
+        std::vector<std::atomic<std::size_t>> pending;  // 尚未完成的前驱数
+        std::vector<std::size_t> seq_of;                 // 进入就绪队列的序号
+        std::size_t seq = 0;
+        std::priority_queue<TaskId, std::vector<TaskId>, std::function<bool(TaskId, TaskId)>> ready;
+        std::size_t remaining = 0;
+        std::size_t running = 0;
+        std::exception_ptr error;
+        Clock::time_point t0;
+    };
+
+    static double ms_since(Clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    }
+
+    void worker_loop(std::stop_token st, unsigned worker) {
+        std::unique_lock lk(mutex_);
+        for (;;) {
+            bool woke = wake_.wait(lk, st, [&] {
+                return run_ && !run_->error && !run_->ready.empty();
+            });
+            if (!woke) return;  // 收到停止请求
+            Run& r = *run_;
+            TaskId id = r.ready.top();
+            r.ready.pop();
+            r.running++;
+            lk.unlock();
+
+            auto& node = r.graph.nodes_[id];
+            node.timing.worker = worker;
+            node.timing.start_ms = ms_since(r.t0);
+            std::exception_ptr err;
+            try {
+                if (node.fn) node.fn();
+            } catch (...) {
+                err = std::current_exception();
+            }
+            node.timing.end_ms = ms_since(r.t0);
+            node.timing.ran = true;
+
+            // 先在锁外把后继的计数减掉，减到 0 的再一起放进就绪队列
+            std::vector<TaskId> became_ready;
+            if (!err) {
+                for (TaskId s : node.successors) {
+                    if (r.pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        became_ready.push_back(s);
+                    }
+                }
+            }
+
+            lk.lock();
+            r.running--;
+            r.remaining--;
+            if (err && !r.error) r.error = err;
+            for (TaskId s : became_ready) r.push(s);
+            if (r.remaining == 0 || (r.error && r.running == 0)) {
+                done_.notify_one();
+            } else if (became_ready.size() > 1) {
+                wake_.notify_all();
+            } else if (became_ready.size() == 1) {
+                wake_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::jthread> workers_;
+    std::mutex submit_mutex_;
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::condition_variable done_;
+    Run* run_ = nullptr;
+};
+
+}  // namespace taskgraph
+
+#endif /* TASK_GRAPH_HPP */
@@ -0,0 +1,518 @@
+/**
+ * @file dispatch_bench.cpp
+ * @brief 多态分派基准的 C++ 实现与驱动（C 的 vtable 版本在 dispatch_c.c）
+ */
+
+#include "dispatch_bench.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "dispatch_c.h"
+
+namespace dispatch {
+namespace {
+
+// 约 1.5MB 的对象，能留在缓存里，测到的主要是分派本身而不是访存
+constexpr std::size_t kObjects = 1 << 16;
+constexpr int kRounds = 50;
+constexpr std::size_t kKindCounts[] = {2, 8, 64};
+constexpr std::size_t kConfigs = 2 * std::size(kKindCounts);  // 每种类型数 × 有序/随机
+
+/* ========================================================================== */
+/*                              分支预测失败计数                              */
+/* ========================================================================== */
+
+// 与 example/C/18_advanced_features/bench.c 的 bench_counter_* 相同：只统计用户态，打不开就不可用
+class BranchMissCounter {
+public:
+    BranchMissCounter() {
+#if defined(__linux__) && defined(__NR_perf_event_open)
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        fd_ = fd < 0 ? -1 : static_cast<int>(fd);
+#endif
+    }
+    ~BranchMissCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+    BranchMissCounter(const BranchMissCounter&) = delete;
+    BranchMissCounter& operator=(const BranchMissCounter&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    std::uint64_t stop() {
+        std::uint64_t value = 0;
+#if defined(__linux__)
+        if (fd_ < 0) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+/* ========================================================================== */
+/*                                  工作负载                                  */
+/* ========================================================================== */
+
+// 所有实现都从同一份描述构造：第 i 个对象的类型和两个参数
+struct Workload {
+    std::vector<int> kind;
+    std::vector<double> a;
+    std::vector<double> b;
+
+    std::size_t size() const { return kind.size(); }
+};
+
+// random 为 false 时按类型排好（每种类型一段连续的对象），否则类型均匀随机
+Workload make_workload(std::size_t kinds, bool random) {
+    Workload w;
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < kObjects; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        std::size_t k = random ? seed % kinds : i * kinds / kObjects;
+        w.kind.push_back(static_cast<int>(k));
+        w.a.push_back(1.0 + static_cast<double>(i % 100) * 0.01);
+        w.b.push_back(0.5 + static_cast<double>(i % 37) * 0.02);
+    }
+    return w;
+}
+
+/* ========================================================================== */
+/*                         1. C 手写 vtable（dispatch_c.c）                   */
+/* ========================================================================== */
+
+class CVtableImpl {
+public:
+    explicit CVtableImpl(const Workload& w) : objs_(w.size()), ptrs_(w.size()) {
+        for (std::size_t i = 0; i < w.size(); i++) {
+            cshape_init(&objs_[i], w.kind[i], w.a[i], w.b[i]);
+            ptrs_[i] = &objs_[i];
+        }
+    }
+    void areas(double* out) const { cshape_areas(ptrs_.data(), ptrs_.size(), out); }
+    void draw(DispatchCanvas& canvas) const {
+        cshape_draw_all(ptrs_.data(), ptrs_.size(), &canvas);
+    }
+
+private:
+    std::vector<CShape> objs_;
+    std::vector<CShape*> ptrs_;
+};
+
+/* ========================================================================== */
+/*                         2. C++ virtual 与 6. 按类型批量                    */
+/* ========================================================================== */
+
+struct VShape {
+    VShape(double a_, double b_) : a(a_), b(b_) {}
+    virtual ~VShape() = default;
+    virtual double area() const = 0;
+    virtual void draw(DispatchCanvas& canvas) const = 0;
+    // 批量版：idx 为空时处理 shapes[0..n)，否则处理 shapes[idx[k]]，结果写到同一下标的 out。
+    // 这些对象都是本类型，循环里直接调用本类型的 area，没有间接调用
+    virtual void area_run(const VShape* const* shapes, const std::uint32_t* idx, std::size_t n,
+                          double* out) const = 0;
+
+    double a;
+    double b;
+};
+
+template <std::size_t K>
+struct VPoly final : VShape {
+    using VShape::VShape;
+    double area() const override { return dispatch_shape_area(static_cast<int>(K), a, b); }
+    void draw(DispatchCanvas& canvas) const override {
+        canvas.shapes++;
+        canvas.ink += area();
+    }
+    void area_run(const VShape* const* shapes, const std::uint32_t* idx, std::size_t n,
+                  double* out) const override {
+        // VPoly 是 final，下面的 area 在编译期就确定了目标
+        if (!idx) {
+            for (std::size_t i = 0; i < n; i++) {
+                out[i] = static_cast<const VPoly*>(shapes[i])->area();
+            }
+            return;
+        }
+        for (std::size_t k = 0; k < n; k++) {
+            std::uint32_t i = idx[k];
+            out[i] = static_cast<const VPoly*>(shapes[i])->area();
+        }
+    }
+};
+
+// 所有 VPoly<K> 大小相同，对象依次放进一块连续内存，和 C 版本的内存布局一致
+struct alignas(VPoly<0>) VSlot {
+    std::byte raw[sizeof(VPoly<0>)];
+};
+
+using VMaker = VShape* (*)(void* mem, double a, double b);
+
+template <std::size_t... K>
+constexpr std::array<VMaker, sizeof...(K)> make_vmakers(std::index_sequence<K...>) {
+    static_assert(((sizeof(VPoly<K>) == sizeof(VSlot)) && ...));
+    return {+[](void* mem, double a, double b) -> VShape* {
+        return ::new (mem) VPoly<K>(a, b);
+    }...};
+}
+
+constexpr auto kVMakers = make_vmakers(std::make_index_sequence<DISPATCH_MAX_KINDS>{});
+
+class VirtualImpl {
+public:
+    explicit VirtualImpl(const Workload& w)
+        : slots_(std::make_unique<VSlot[]>(w.size())), ptrs_(w.size()) {
+        for (std::size_t i = 0; i < w.size(); i++) {
+            ptrs_[i] = kVMakers[static_cast<std::size_t>(w.kind[i])](&slots_[i], w.a[i], w.b[i]);
+        }
+    }
+    ~VirtualImpl() {
+        for (VShape* p : ptrs_) p->~VShape();
+    }
+    VirtualImpl(const VirtualImpl&) = delete;
+    VirtualImpl& operator=(const VirtualImpl&) = delete;
+
+    void areas(double* out) const {
+        for (std::size_t i = 0; i < ptrs_.size(); i++) out[i] = ptrs_[i]->area();
+    }
+    void draw(DispatchCanvas& canvas) const {
+        for (const VShape* p : ptrs_) p->draw(canvas);
+    }
+    const std::vector<VShape*>& shapes() const { return ptrs_; }
+
+private:
+    std::unique_ptr<VSlot[]> slots_;
+    std::vector<VShape*> ptrs_;
+};
+
+/*
+ * 和 17_virtual_function_impl 的 Shape_area_batch 相同：容器额外记下每个对象的类型编号，
+ * 同类型的连续段足够长就对整段调用一次 area_run；否则把接下来的一块按类型计数排序出下标，
+ * 每种类型调用一次。找段和排序的开销都算在耗时里。
+ */
+class SortedBatchImpl {
+public:
+    static constexpr std::size_t kBlock = 2048;
+    static constexpr std::size_t kMinRun = 32;
+
+    explicit SortedBatchImpl(const Workload& w) : objs_(w), kinds_(w.size()) {
+        for (std::size_t i = 0; i < w.size(); i++) kinds_[i] = static_cast<std::uint8_t>(w.kind[i]);
+    }
+
+    void areas(double* out) const {
+        const VShape* const* shapes = objs_.shapes().data();
+        const std::size_t n = kinds_.size();
+        for (std::size_t i = 0; i < n;) {
+            std::size_t end = n - i < kBlock ? n : i + kBlock;
+            std::size_t j = i + 1;
+            while (j < end && kinds_[j] == kinds_[i]) j++;
+            if (j - i >= kMinRun || j == n) {
+                shapes[i]->area_run(shapes + i, nullptr, j - i, out + i);
+            } else {
+                j = end;
+                area_block(shapes + i, kinds_.data() + i, j - i, out + i);
+            }
+            i = j;
+        }
+    }
+    void draw(DispatchCanvas& canvas) const { objs_.draw(canvas); }
+
+private:
+    static void area_block(const VShape* const* shapes, const std::uint8_t* kinds, std::size_t n,
+                           double* out) {
+        std::array<std::uint32_t, DISPATCH_MAX_KINDS + 1> start{};
+        for (std::size_t i = 0; i < n; i++) start[kinds[i] + 1u]++;
+        for (std::size_t k = 0; k < DISPATCH_MAX_KINDS; k++) start[k + 1] += start[k];
+        std::array<std::uint32_t, DISPATCH_MAX_KINDS + 1> pos = start;
+        std::array<std::uint32_t, kBlock> idx;
+        for (std::size_t i = 0; i < n; i++) idx[pos[kinds[i]]++] = static_cast<std::uint32_t>(i);
+        for (std::size_t k = 0; k < DISPATCH_MAX_KINDS; k++) {
+            if (start[k] == start[k + 1]) continue;
+            shapes[idx[start[k]]]->area_run(shapes, idx.data() + start[k], start[k + 1] - start[k],
+                                            out);
+        }
+    }
+
+    VirtualImpl objs_;
+    std::vector<std::uint8_t> kinds_;
+};
+
+/* ========================================================================== */
+/*                         3. std::variant 与 4. CRTP                         */
+/* ========================================================================== */
+
+template <class Derived>
+struct CrtpShape {
+    double area() const { return static_cast<const Derived&>(*this).area_impl(); }
+    void draw(DispatchCanvas& canvas) const {
+        canvas.shapes++;
+        canvas.ink += area();
+    }
+};
+
+// 没有虚函数的图形，既作 CRTP 的派生类，也作 variant 的备选类型
+template <std::size_t K>
+struct Poly : CrtpShape<Poly<K>> {
+    Poly(double a_, double b_) : a(a_), b(b_) {}
+    double area_impl() const { return dispatch_shape_area(static_cast<int>(K), a, b); }
+
+    double a;
+    double b;
+};
+
+template <class Seq>
+struct PolyTypes;
+template <std::size_t... K>
+struct PolyTypes<std::index_sequence<K...>> {
+    using Variant = std::variant<Poly<K>...>;
+    using Vectors = std::tuple<std::vector<Poly<K>>...>;
+
+    static constexpr std::array<Variant (*)(double, double), sizeof...(K)> variant_makers{
+        +[](double a, double b) { return Variant(std::in_place_index<K>, a, b); }...};
+    static constexpr std::array<void (*)(Vectors&, double, double), sizeof...(K)> vector_pushers{
+        +[](Vectors& v, double a, double b) { std::get<K>(v).emplace_back(a, b); }...};
+};
+
+template <std::size_t T>
+using PolyTypesFor = PolyTypes<std::make_index_sequence<T>>;
+
+template <std::size_t T>
+class VariantImpl {
+public:
+    explicit VariantImpl(const Workload& w) {
+        shapes_.reserve(w.size());
+        for (std::size_t i = 0; i < w.size(); i++) {
+            auto make = PolyTypesFor<T>::variant_makers[static_cast<std::size_t>(w.kind[i])];
+            shapes_.push_back(make(w.a[i], w.b[i]));
+        }
+    }
+    void areas(double* out) const {
+        for (std::size_t i = 0; i < shapes_.size(); i++) {
+            out[i] = std::visit([](const auto& s) { return s.area(); }, shapes_[i]);
+        }
+    }
+    void draw(DispatchCanvas& canvas) const {
+        for (const auto& v : shapes_) std::visit([&](const auto& s) { s.draw(canvas); }, v);
+    }
+
+private:
+    std::vector<typename PolyTypesFor<T>::Variant> shapes_;
+};
+
+// CRTP 只有静态多态：异构集合只能按类型分开存放，输入顺序对它没有意义
+template <std::size_t T>
+class CrtpImpl {
+public:
+    explicit CrtpImpl(const Workload& w) {
+        for (std::size_t i = 0; i < w.size(); i++) {
+            PolyTypesFor<T>::vector_pushers[static_cast<std::size_t>(w.kind[i])](shapes_, w.a[i],
+                                                                                 w.b[i]);
+        }
+    }
+    void areas(double* out) const {
+        std::apply([&](const auto&... vecs) { (write_areas(vecs, out), ...); }, shapes_);
+    }
+    void draw(DispatchCanvas& canvas) const {
+        std::apply([&](const auto&... vecs) { (draw_all(vecs, canvas), ...); }, shapes_);
+    }
+
+private:
+    template <class Vec>
+    static void write_areas(const Vec& vec, double*& out) {
+        for (const auto& s : vec) *out++ = s.area();
+    }
+    template <class Vec>
+    static void draw_all(const Vec& vec, DispatchCanvas& canvas) {
+        for (const auto& s : vec) s.draw(canvas);
+    }
+
+    typename PolyTypesFor<T>::Vectors shapes_;
+};
+
+/* ========================================================================== */
+/*                              5. switch 类型标签                            */
+/* ========================================================================== */
+
+struct TagShape {
+    std::uint8_t kind;
+    double a;
+    double b;
+};
+
+double tag_area(const TagShape& s) {
+    switch (s.kind) {
+#define DISPATCH_TAG_CASE(K) \
+    case K: return dispatch_shape_area(K, s.a, s.b);
+        DISPATCH_KINDS(DISPATCH_TAG_CASE)
+#undef DISPATCH_TAG_CASE
+    }
+    return 0.0;
+}
+
+class SwitchImpl {
+public:
+    explicit SwitchImpl(const Workload& w) {
+        shapes_.reserve(w.size());
+        for (std::size_t i = 0; i < w.size(); i++) {
+            shapes_.push_back({static_cast<std::uint8_t>(w.kind[i]), w.a[i], w.b[i]});
+        }
+    }
+    void areas(double* out) const {
+        for (std::size_t i = 0; i < shapes_.size(); i++) out[i] = tag_area(shapes_[i]);
+    }
+    void draw(DispatchCanvas& canvas) const {
+        for (const TagShape& s : shapes_) {
+            canvas.shapes++;
+            canvas.ink += tag_area(s);
+        }
+    }
+
+private:
+    std::vector<TagShape> shapes_;
+};
+
+/* ========================================================================== */
+/*                                    驱动                                    */
+/* ========================================================================== */
+
+constexpr const char* kImplNames[] = {"C vtable", "virtual", "variant",
+                                      "CRTP",     "switch",  "sorted batch"};
+constexpr std::size_t kImpls = std::size(kImplNames);
+
+struct Cell {
+    double ns = 0.0;      // 每次 area 调用，取最快的一轮
+    double misses = 0.0;  // 每次调用的分支预测失败，所有轮的平均
+    bool ok = true;       // 面积之和与 draw 的结果和 C vtable 版本一致
+};
+
+struct Reference {
+    double sum = 0.0;
+};
+
+bool close_to(double x, double ref) {
+    double d = x - ref;
+    return d <= 1e-9 * ref && d >= -1e-9 * ref;
+}
+
+template <class Impl>
+Cell measure(const Impl& impl, std::vector<double>& out, BranchMissCounter& counter,
+             Reference& ref, bool is_reference) {
+    Cell cell;
+    counter.start();
+    for (int r = 0; r < kRounds; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        impl.areas(out.data());
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0)
+                        .count() /
+                    static_cast<double>(out.size());
+        if (r == 0 || ns < cell.ns) cell.ns = ns;
+    }
+    cell.misses = static_cast<double>(counter.stop()) / (static_cast<double>(kRounds) * out.size());
+
+    double sum = 0.0;
+    for (double v : out) sum += v;
+    DispatchCanvas canvas{0, 0.0};
+    impl.draw(canvas);
+    if (is_reference) ref.sum = sum;
+    cell.ok = close_to(sum, ref.sum) && close_to(canvas.ink, ref.sum) &&
+              canvas.shapes == out.size();
+    return cell;
+}
+
+template <std::size_t T>
+void run_kind_count(std::size_t column, BranchMissCounter& counter,
+                    std::array<std::array<Cell, kConfigs>, kImpls>& cells) {
+    std::vector<double> out(kObjects);
+    for (int random = 0; random <= 1; random++) {
+        Workload w = make_workload(T, random != 0);
+        Reference ref;
+        std::size_t c = column + static_cast<std::size_t>(random);
+        cells[0][c] = measure(CVtableImpl(w), out, counter, ref, true);
+        cells[1][c] = measure(VirtualImpl(w), out, counter, ref, false);
+        cells[2][c] = measure(VariantImpl<T>(w), out, counter, ref, false);
+        cells[3][c] = measure(CrtpImpl<T>(w), out, counter, ref, false);
+        cells[4][c] = measure(SwitchImpl(w), out, counter, ref, false);
+        cells[5][c] = measure(SortedBatchImpl(w), out, counter, ref, false);
+    }
+}
+
+void print_table(const std::array<std::array<Cell, kConfigs>, kImpls>& cells, bool misses) {
+    std::printf("  实现            ");
+    for (std::size_t kinds : kKindCounts) std::printf(" %6zu 种类型  ", kinds);
+    std::printf("\n                  ");
+    for (std::size_t k = 0; k < std::size(kKindCounts); k++) std::printf("   有序    随机 ");
+    std::printf("\n");
+    for (std::size_t i = 0; i < kImpls; i++) {
+        std::printf("  %-14s  ", kImplNames[i]);
+        for (const Cell& cell : cells[i]) {
+            std::printf(" %6.2f%s", misses ? cell.misses : cell.ns, cell.ok ? " " : "!");
+        }
+        std::printf("\n");
+    }
+}
+
+}  // namespace
+
+int run_benchmark() {
+    BranchMissCounter counter;
+    std::array<std::array<Cell, kConfigs>, kImpls> cells{};
+    run_kind_count<kKindCounts[0]>(0, counter, cells);
+    run_kind_count<kKindCounts[1]>(2, counter, cells);
+    run_kind_count<kKindCounts[2]>(4, counter, cells);
+
+    std::printf("[dispatch] %zu 个对象，同一组面积用六种方式计算，取 %d 轮中最快的一轮\n", kObjects,
+                kRounds);
+    std::printf("每次 area 调用的耗时 (ns)：\n");
+    print_table(cells, false);
+    if (counter.available()) {
+        std::printf("每次 area 调用的分支预测失败次数：\n");
+        print_table(cells, true);
+    } else {
+        std::printf("每次 area 调用的分支预测失败次数：不可用 (perf_event_open 失败："
+                    "没有权限或虚拟机没有 PMU)\n");
+    }
+    std::printf("  CRTP 必须按类型分开存放，“随机”一列和“有序”是同一组对象；\n"
+                "  sorted batch 的耗时包含每轮按类型计数排序；带 ! 的格子结果与 C vtable 不一致。\n");
+    return 0;
+}
+
+}  // namespace dispatch
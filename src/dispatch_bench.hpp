@@ -0,0 +1,26 @@
+/**
+ * @file dispatch_bench.hpp
+ * @brief 多态分派基准：同一个图形层次的六种实现
+ *
+ *   C vtable     dispatch_c.c 中手写的 CShapeVTable，经 CShape* 逐个间接调用
+ *   virtual      C++ 虚函数，经基类指针逐个调用
+ *   variant      std::variant 按值存放，std::visit 分派
+ *   CRTP         静态多态，每种类型一个 std::vector，编译期就知道调用目标
+ *   switch       按值存放的带类型标签结构体，switch 选择公式
+ *   sorted batch 每轮先按类型对指针做计数排序，再对每种类型调用一次虚函数处理整段
+ *
+ * 每种实现分别在 2、8、64 种类型下，以“按类型排好”（分支可预测）和“随机交错”两种顺序，
+ * 测每次 area 调用的耗时与分支预测失败次数（Linux perf_event_open，取不到时显示“不可用”）。
+ */
+
+#ifndef DISPATCH_BENCH_HPP
+#define DISPATCH_BENCH_HPP
+
+namespace dispatch {
+
+// --bench dispatch 的入口，返回进程退出码
+int run_benchmark();
+
+}  // namespace dispatch
+
+#endif /* DISPATCH_BENCH_HPP */
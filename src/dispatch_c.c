@@ -0,0 +1,36 @@
+/**
+ * @file dispatch_c.c
+ * @brief 64 种图形的手写虚函数表，以及通过 vptr 逐个调用的循环
+ */
+
+#include "dispatch_c.h"
+
+/* 每种类型一组 area/draw 函数和一张 vtable，和 17_virtual_function_impl 中 Circle 的写法一样 */
+#define CSHAPE_DEFINE(K)                                                                       \
+    static double cshape_area_##K(const CShape* self) {                                        \
+        return dispatch_shape_area(K, self->a, self->b);                                       \
+    }                                                                                          \
+    static void cshape_draw_##K(const CShape* self, DispatchCanvas* canvas) {                  \
+        canvas->shapes++;                                                                      \
+        canvas->ink += cshape_area_##K(self);                                                  \
+    }
+DISPATCH_KINDS(CSHAPE_DEFINE)
+#undef CSHAPE_DEFINE
+
+#define CSHAPE_VTABLE(K) {cshape_area_##K, cshape_draw_##K},
+static const CShapeVTable cshape_vtables[DISPATCH_MAX_KINDS] = {DISPATCH_KINDS(CSHAPE_VTABLE)};
+#undef CSHAPE_VTABLE
+
+void cshape_init(CShape* self, int kind, double a, double b) {
+    self->vptr = &cshape_vtables[kind];
+    self->a = a;
+    self->b = b;
+}
+
+void cshape_areas(CShape* const* shapes, size_t n, double* out) {
+    for (size_t i = 0; i < n; i++) out[i] = shapes[i]->vptr->area(shapes[i]);
+}
+
+void cshape_draw_all(CShape* const* shapes, size_t n, DispatchCanvas* canvas) {
+    for (size_t i = 0; i < n; i++) shapes[i]->vptr->draw(shapes[i], canvas);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file dispatch_c.h
+ * @brief 多态分派基准的 C 部分：与 17_virtual_function_impl 相同写法的手写虚函数表
+ *
+ * 基准里的图形层次共有 DISPATCH_MAX_KINDS 种类型，按 kind & 3 分成圆、矩形、三角形、椭圆
+ * 四族，再乘上随 kind 变化的系数，保证每种类型的 area 都是不同的函数、编译器无法合并。
+ * 面积公式 dispatch_shape_area 放在这里，C 和 C++ 的各种实现共用，结果逐位相同。
+ */
+
+#ifndef DISPATCH_C_H
+#define DISPATCH_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPATCH_MAX_KINDS 64
+
+/* 对 0..63 每个类型编号展开一次 X(K)，用于生成各类型的函数、vtable 和 switch 分支 */
+#define DISPATCH_KINDS(X)                                                                      \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)                                                    \
+    X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15)                                              \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23)                                            \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)                                            \
+    X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39)                                            \
+    X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47)                                            \
+    X(48) X(49) X(50) X(51) X(52) X(53) X(54) X(55)                                            \
+    X(56) X(57) X(58) X(59) X(60) X(61) X(62) X(63)
+
+/* kind 为编译期常量时整个 switch 会被折叠掉，只剩一两次乘法 */
+static inline double dispatch_shape_area(int kind, double a, double b) {
+    double scale = 1.0 + kind / 64.0;
+    switch (kind & 3) {
+    case 0: return 3.14159 * a * a * scale; /* 圆，a 为半径 */
+    case 1: return a * b * scale;           /* 矩形 */
+    case 2: return 0.5 * a * b * scale;     /* 三角形，底 × 高 / 2 */
+    default: return 3.14159 * a * b * scale; /* 椭圆，a、b 为半轴 */
+    }
+}
+
+/* draw 的“画布”：只累计画过的图形，用来确认各实现做了同样的事 */
+typedef struct {
+    uint64_t shapes;
+    double ink;
+} DispatchCanvas;
+
+struct CShape;
+
+typedef struct {
+    double (*area)(const struct CShape* self);
+    void (*draw)(const struct CShape* self, DispatchCanvas* canvas);
+} CShapeVTable;
+
+typedef struct CShape {
+    const CShapeVTable* vptr;
+    double a;
+    double b;
+} CShape;
+
+/* 构造第 kind 种图形（0 <= kind < DISPATCH_MAX_KINDS） */
+void cshape_init(CShape* self, int kind, double a, double b);
+
+/* out[i] = shapes[i]->vptr->area(shapes[i]) */
+void cshape_areas(CShape* const* shapes, size_t n, double* out);
+void cshape_draw_all(CShape* const* shapes, size_t n, DispatchCanvas* canvas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPATCH_C_H */
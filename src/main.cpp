@@ -1,4 +1,24 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "coro.hpp"
+#include "dispatch_bench.hpp"
+#include "event_loop.hpp"
+#include "parallel.hpp"
+#include "pipeline.hpp"
+#include "task_graph.hpp"
 
 /**
  * 简易C/CPP项目模板的主入口。
@@ -7,11 +27,574 @@
  * 1. 在 VS Code 中按 Ctrl+Shift+P 运行 'CMake: Configure'
  * 2. 运行 'CMake: Build' 或直接按 F5 进行调试
  * 3. 在vscode中按Ctrl+F5进行编译运行
+ *
+ * 带参数运行时演示进阶内容：
+ *   --bench parallel   parallel_for / parallel_reduce 在 10^8 个元素上的加速比
+ *   --bench coro       协程挂起/恢复的开销，以及 10 万个并发协程
+ *   --bench pipeline   读取 → 解析 → 转换 → 写出流水线处理一个 2GB 的生成文本文件
+ *   --bench dispatch   C vtable / virtual / variant / CRTP / switch / 按类型批量 六种多态分派的开销
+ */
+
+namespace {
+
+// 运行 3 次取最快的一次（毫秒），排除首次运行时缺页、升频等干扰
+template <class Fn>
+double best_ms(Fn&& fn) {
+    double best = 0.0;
+    for (int r = 0; r < 3; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        double ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// 计算密集的逐元素函数：加速比接近线程数；纯求和受内存带宽限制，加速比会先饱和
+double poly(float v) {
+    double x = v * 0.001;
+    double y = 0.0;
+    for (int k = 0; k < 8; k++) y = y * x + 1.0 / (k + 1);
+    return y;
+}
+
+int bench_parallel() {
+    constexpr std::size_t kLen = 100'000'000;  // 10^8 个 float，约 400MB
+    std::vector<float> data(kLen);
+    parallel::parallel_for(0, kLen, 0, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) data[i] = static_cast<float>(i % 1000);
+    });
+
+    auto sum_body = [&](std::size_t b, std::size_t e, double acc) {
+        for (std::size_t i = b; i < e; i++) acc += data[i];
+        return acc;
+    };
+    auto poly_body = [&](std::size_t b, std::size_t e, double acc) {
+        for (std::size_t i = b; i < e; i++) acc += poly(data[i]);
+        return acc;
+    };
+    auto plus = [](double a, double b) { return a + b; };
+
+    double serial_sum = 0.0, serial_poly = 0.0;
+    double serial_sum_ms = best_ms([&] { serial_sum = sum_body(0, kLen, 0.0); });
+    double serial_poly_ms = best_ms([&] { serial_poly = poly_body(0, kLen, 0.0); });
+
+    std::printf("[parallel] %zu 个 float, 线程池 %zu 个工作线程 + 调用线程, 3 次取最快\n", kLen,
+                parallel::ThreadPool::instance().size());
+    std::printf("  %9.1f ms            %.17g  串行求和\n", serial_sum_ms, serial_sum);
+    std::printf("  %9.1f ms            %.17g  串行多项式\n", serial_poly_ms, serial_poly);
+
+    const struct {
+        const char* name;
+        bool use_poly;
+        parallel::ReduceOrder order;
+    } cases[] = {
+        {"parallel_reduce 求和", false, parallel::ReduceOrder::Unordered},
+        {"parallel_reduce 多项式", true, parallel::ReduceOrder::Unordered},
+        {"parallel_reduce 多项式 (确定性)", true, parallel::ReduceOrder::Deterministic},
+    };
+    for (const auto& c : cases) {
+        double r = 0.0;
+        double ms = best_ms([&] {
+            r = c.use_poly ? parallel::parallel_reduce(0, kLen, 0, 0.0, poly_body, plus, c.order)
+                           : parallel::parallel_reduce(0, kLen, 0, 0.0, sum_body, plus, c.order);
+        });
+        std::printf("  %9.1f ms  %6.2fx  %.17g  %s\n", ms,
+                    (c.use_poly ? serial_poly_ms : serial_sum_ms) / ms, r, c.name);
+    }
+    std::printf("  确定性模式按 %zu 块切分并按下标合并，任何线程数下结果逐位相同。\n",
+                parallel::kDeterministicChunks);
+    return 0;
+}
+
+/*
+ * 一个“构建”式的任务图：configure 之后有 6 个互不依赖的短编译任务，
+ * 以及一条 codegen → 编译生成代码 → 链接的长链。用 sleep 模拟各步耗时。
+ * 按就绪先后 (FIFO) 调度时长链会排在短任务后面，按关键路径调度时长链最先启动。
+ */
+void demo_task_graph() {
+    using namespace std::chrono_literals;
+    auto work = [](std::chrono::milliseconds d) { return [d] { std::this_thread::sleep_for(d); }; };
+
+    taskgraph::TaskGraph g;
+    auto configure = g.add("configure", work(2ms), {}, 2);
+    std::vector<taskgraph::TaskId> objects;
+    for (char c = 'a'; c <= 'f'; c++) {
+        objects.push_back(g.add(std::string("compile ") + c + ".cpp", work(6ms), {configure}, 6));
+    }
+    auto codegen = g.add("codegen", work(8ms), {configure}, 8);
+    objects.push_back(g.add("compile generated.cpp", work(12ms), {codegen}, 12));
+    auto lib = g.add("link libcore.a", work(3ms), {}, 3);
+    for (auto o : objects) g.precede(o, lib);
+    g.add("link app", work(3ms), {lib}, 3);
+
+    taskgraph::Executor pool(2);
+    pool.run(g, taskgraph::Policy::Fifo);
+    double fifo_ms = g.wall_ms();
+    pool.run(g, taskgraph::Policy::CriticalPath);
+    std::printf("任务图 (%zu 个任务, %zu 个工作线程): FIFO 调度 %.1f ms, 关键路径优先 %.1f ms\n",
+                g.size(), pool.size(), fifo_ms, g.wall_ms());
+    g.dump_timing();
+}
+
+/* ========================================================================== */
+/*                              协程                                          */
+/* ========================================================================== */
+
+using namespace std::chrono_literals;
+
+coro::task<int> delayed_value(coro::EventLoop& loop, int v, std::chrono::milliseconds d) {
+    co_await loop.sleep_for(d);
+    co_return v;
+}
+
+coro::task<void> demo_coro_main(coro::EventLoop& loop) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto since = [&] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0)
+            .count();
+    };
+
+    // 两个定时器并发等待：总耗时取决于较长的那个，而不是两者之和
+    auto [a, b] = co_await coro::when_all(delayed_value(loop, 1, 20ms), delayed_value(loop, 2, 30ms));
+    std::printf("协程 when_all: %d + %d, 用时 %.0f ms (20ms 与 30ms 并发)\n", a, b, since());
+
+    std::vector<coro::task<int>> racers;
+    racers.push_back(delayed_value(loop, 100, 15ms));
+    racers.push_back(delayed_value(loop, 200, 5ms));
+    racers.push_back(delayed_value(loop, 300, 25ms));
+    t0 = std::chrono::steady_clock::now();
+    auto first = co_await coro::when_any(std::move(racers));
+    std::printf("协程 when_any: 第 %zu 个最先完成, 值 %d, 用时 %.0f ms\n", first.index, first.value,
+                since());
+
+#if defined(__linux__)
+    // 异步读文件：先写一个临时文件，再通过事件循环读回来
+    char path[] = "/tmp/coro_demo_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        const char text[] = "hello from io_uring";
+        if (::write(fd, text, sizeof(text) - 1) == static_cast<ssize_t>(sizeof(text) - 1)) {
+            char buf[64] = {};
+            long n = co_await loop.read(fd, buf, sizeof(buf) - 1, 0);
+            std::printf("协程读文件 (%s): %ld 字节 \"%s\"\n",
+                        loop.uring_enabled() ? "io_uring" : "pread 后备", n, n > 0 ? buf : "");
+        }
+        ::close(fd);
+        ::unlink(path);
+    }
+#endif
+}
+
+/* 基准用的叶子协程：只返回一个值，测的是创建 + 启动/返回 + 销毁 */
+coro::task<int> leaf(int x) {
+    co_return x + 1;
+}
+
+coro::task<long> await_leaves(int n) {
+    long sum = 0;
+    for (int i = 0; i < n; i++) sum += co_await leaf(i);
+    co_return sum;
+}
+
+coro::task<void> yield_loop(coro::Scheduler& s, int n) {
+    for (int i = 0; i < n; i++) co_await s.schedule();
+}
+
+coro::task<void> sleeper(coro::EventLoop& loop, std::atomic<int>& done) {
+    co_await loop.sleep_for(1ms);
+    done.fetch_add(1, std::memory_order_relaxed);
+}
+
+coro::task<int> hop_and_work(coro::Scheduler& s, int x) {
+    co_await s.schedule();  // 换到线程池上执行
+    int y = x;
+    for (int k = 0; k < 100; k++) y = y * 1103515245 + 12345;
+    co_return y & 1;
+}
+
+coro::task<long> fan_out(coro::Scheduler& s, int n) {
+    std::vector<coro::task<int>> tasks;
+    tasks.reserve(static_cast<std::size_t>(n));
+    for (int i = 0; i < n; i++) tasks.push_back(hop_and_work(s, i));
+    auto results = co_await coro::when_all(std::move(tasks));
+    long sum = 0;
+    for (int r : results) sum += r;
+    co_return sum;
+}
+
+coro::task<void> many_sleepers(coro::EventLoop& loop, int n, std::atomic<int>& done) {
+    std::vector<coro::task<void>> tasks;
+    tasks.reserve(static_cast<std::size_t>(n));
+    for (int i = 0; i < n; i++) tasks.push_back(sleeper(loop, done));
+    co_await coro::when_all(std::move(tasks));
+}
+
+double ns_per(std::chrono::steady_clock::time_point t0, long n) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() /
+           static_cast<double>(n);
+}
+
+int bench_coro() {
+    constexpr int kAwaits = 10'000'000;
+    constexpr int kYields = 5'000'000;
+    constexpr int kTasks = 100'000;
+    using Clock = std::chrono::steady_clock;
+
+    std::printf("[coro] 协程开销\n");
+    for (bool pooled : {true, false}) {
+        coro::FramePool::set_enabled(pooled);
+        auto t0 = Clock::now();
+        long sum = coro::sync_wait(await_leaves(kAwaits));
+        std::printf("  co_await 子协程 (创建+启动/返回+销毁), 帧%s: %6.1f ns/次  (校验 %ld)\n",
+                    pooled ? "池    " : "走堆  ", ns_per(t0, kAwaits), sum);
+    }
+    coro::FramePool::set_enabled(true);
+
+    {
+        coro::EventLoop loop;
+        auto t0 = Clock::now();
+        loop.run(yield_loop(loop, kYields));
+        std::printf("  单线程事件循环 schedule() 挂起+恢复:      %6.1f ns/次\n", ns_per(t0, kYields));
+    }
+    {
+        coro::ThreadPoolScheduler pool;
+        auto t0 = Clock::now();
+        coro::sync_wait(yield_loop(pool, kYields / 10));
+        std::printf("  线程池 (%zu 线程) schedule() 挂起+恢复:     %6.1f ns/次\n", pool.size(),
+                    ns_per(t0, kYields / 10));
+    }
+
+    std::printf("[coro] %d 个并发协程\n", kTasks);
+    {
+        coro::EventLoop loop;
+        std::atomic<int> done{0};
+        auto t0 = Clock::now();
+        loop.run(many_sleepers(loop, kTasks, done));
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::printf("  事件循环: 各 sleep 1ms 后 when_all, 总计 %.1f ms (%.0f ns/协程), 完成 %d\n",
+                    ms, ms * 1e6 / kTasks, done.load());
+    }
+    {
+        coro::ThreadPoolScheduler pool;
+        auto t0 = Clock::now();
+        long sum = coro::sync_wait(fan_out(pool, kTasks));
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::printf("  线程池 (%zu 线程): 各跳到线程池计算后 when_all, 总计 %.1f ms (%.0f ns/协程), 校验 %ld\n",
+                    pool.size(), ms, ms * 1e6 / kTasks, sum);
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/*                              分级流水线                                    */
+/* ========================================================================== */
+
+/*
+ * 一个典型的批处理作业：输入是每行 "用户id,类别,单价,数量" 的文本，
+ * 输出每笔数量大于 1 的订单的 "用户id,总价(分)"。
+ * 文本按 4MB 的块流过流水线，块在换行处切开，解析和转换可以多线程。
  */
-int main() {
+constexpr std::size_t kPipeBlock = 4u << 20;
+constexpr std::uint64_t kPipeInputBytes = 2ull << 30;
+
+struct Order {
+    std::uint32_t user;
+    std::uint32_t cents;
+    std::uint16_t qty;
+    std::uint8_t category;
+};
+
+/* 一个输出块及其校验：hash 是块内容的 FNV-1a，用来比较各种运行方式的输出 */
+struct OutBlock {
+    std::string text;
+    std::uint64_t hash = 0;
+};
+
+std::uint64_t fnv1a(std::string_view s, std::uint64_t h = 1469598103934665603ull) {
+    for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+void append_uint(std::string& s, std::uint64_t v) {
+    char num[20];
+    auto r = std::to_chars(num, num + sizeof(num), v);
+    s.append(num, r.ptr);
+}
+
+/* 生成输入文件；内容由固定种子决定，每次相同 */
+bool pipe_generate(const std::filesystem::path& path, std::uint64_t bytes) {
+    static constexpr const char* kCategories[] = {"books", "games", "music", "garden", "tools"};
+    std::FILE* f = std::fopen(path.string().c_str(), "wb");
+    if (!f) return false;
+    std::string buf;
+    buf.reserve(kPipeBlock + 64);
+    std::uint64_t x = 0x9E3779B97F4A7C15ull, written = 0;
+    while (written < bytes) {
+        buf.clear();
+        while (buf.size() < kPipeBlock) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            append_uint(buf, x % 10'000'000);
+            buf += ',';
+            buf += kCategories[(x >> 24) % 5];
+            buf += ',';
+            append_uint(buf, (x >> 32) % 500);
+            buf += '.';
+            std::uint64_t frac = (x >> 40) % 100;
+            if (frac < 10) buf += '0';
+            append_uint(buf, frac);
+            buf += ',';
+            append_uint(buf, 1 + (x >> 48) % 9);
+            buf += '\n';
+        }
+        if (std::fwrite(buf.data(), 1, buf.size(), f) != buf.size()) break;
+        written += buf.size();
+    }
+    return std::fclose(f) == 0 && written >= bytes;
+}
+
+/* 读取：每次读一块，在最后一个换行处切开，剩下的半行留给下一块 */
+class BlockReader {
+public:
+    explicit BlockReader(std::FILE* f) : f_(f) {}
+
+    bool next(std::string& out) {
+        out.assign(carry_);
+        carry_.clear();
+        std::size_t have = out.size();
+        out.resize(have + kPipeBlock);
+        std::size_t n = std::fread(out.data() + have, 1, kPipeBlock, f_);
+        out.resize(have + n);
+        if (out.empty()) return false;
+        if (n == kPipeBlock) {
+            std::size_t cut = out.rfind('\n');
+            if (cut != std::string::npos) {
+                carry_.assign(out, cut + 1);
+                out.resize(cut + 1);
+            }
+        }
+        return true;
+    }
+
+private:
+    std::FILE* f_;
+    std::string carry_;
+};
+
+const char* find_char(const char* p, const char* end, char c) {
+    return static_cast<const char*>(std::memchr(p, c, static_cast<std::size_t>(end - p)));
+}
+
+/* 解析：跳过格式不对的行 */
+std::vector<Order> pipe_parse(const std::string& text) {
+    std::vector<Order> orders;
+    orders.reserve(text.size() / 24);
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* eol = find_char(p, end, '\n');
+        if (!eol) eol = end;
+        Order o{};
+        unsigned whole = 0, frac = 0, qty = 0;
+        auto r = std::from_chars(p, eol, o.user);
+        const char* c = r.ptr + 1;
+        const char* comma = c < eol ? find_char(c, eol, ',') : nullptr;
+        if (r.ec == std::errc{} && comma) {
+            o.category = static_cast<std::uint8_t>(comma - c);  // 这里只关心类别名的长度
+            r = std::from_chars(comma + 1, eol, whole);
+            if (r.ec == std::errc{} && *r.ptr == '.') r = std::from_chars(r.ptr + 1, eol, frac);
+            if (r.ec == std::errc{} && *r.ptr == ',') r = std::from_chars(r.ptr + 1, eol, qty);
+            if (r.ec == std::errc{}) {
+                o.cents = whole * 100 + frac;
+                o.qty = static_cast<std::uint16_t>(qty);
+                orders.push_back(o);
+            }
+        }
+        p = eol + 1;
+    }
+    return orders;
+}
+
+/* 转换：过滤并格式化成输出文本 */
+OutBlock pipe_transform(const std::vector<Order>& orders) {
+    OutBlock out;
+    out.text.reserve(orders.size() * 16);
+    for (const Order& o : orders) {
+        if (o.qty <= 1) continue;
+        append_uint(out.text, o.user);
+        out.text += ',';
+        append_uint(out.text, std::uint64_t{o.cents} * o.qty);
+        out.text += '\n';
+    }
+    out.hash = fnv1a(out.text);
+    return out;
+}
+
+/* 写出端的汇总：chained 依赖块的顺序，sum 与顺序无关 */
+struct PipeResult {
+    std::uint64_t bytes = 0;
+    std::uint64_t chained = 1469598103934665603ull;
+    std::uint64_t sum = 0;
+    double seconds = 0.0;
+
+    void add(const OutBlock& b) {
+        bytes += b.text.size();
+        chained = (chained ^ b.hash) * 1099511628211ull;
+        sum += b.hash;
+    }
+};
+
+PipeResult pipe_serial(const std::filesystem::path& in, const std::filesystem::path& out) {
+    PipeResult res;
+    std::FILE* fi = std::fopen(in.string().c_str(), "rb");
+    std::FILE* fo = std::fopen(out.string().c_str(), "wb");
+    if (fi && fo) {
+        auto t0 = pipeline::Clock::now();
+        BlockReader reader(fi);
+        std::string text;
+        while (reader.next(text)) {
+            OutBlock b = pipe_transform(pipe_parse(text));
+            std::fwrite(b.text.data(), 1, b.text.size(), fo);
+            res.add(b);
+        }
+        std::fflush(fo);
+        res.seconds = std::chrono::duration<double>(pipeline::Clock::now() - t0).count();
+    }
+    if (fi) std::fclose(fi);
+    if (fo) std::fclose(fo);
+    return res;
+}
+
+PipeResult pipe_parallel(const std::filesystem::path& in, const std::filesystem::path& out,
+                         bool ordered, std::size_t workers) {
+    PipeResult res;
+    std::FILE* fi = std::fopen(in.string().c_str(), "rb");
+    std::FILE* fo = std::fopen(out.string().c_str(), "wb");
+    if (fi && fo) {
+        BlockReader reader(fi);
+        pipeline::Pipeline p({.queue_capacity = 4, .max_in_flight = 16, .ordered = ordered});
+        auto text = p.source<std::string>("read", [&](std::string& s) { return reader.next(s); });
+        auto orders =
+            p.stage("parse", workers, text, [](std::string&& s) { return pipe_parse(s); });
+        auto blocks = p.stage("transform", workers, orders,
+                              [](std::vector<Order>&& o) { return pipe_transform(o); });
+        p.sink("write", blocks, [&](OutBlock&& b) {
+            std::fwrite(b.text.data(), 1, b.text.size(), fo);
+            res.add(b);
+        });
+        p.run();
+        std::fflush(fo);
+        res.seconds = p.wall_seconds();
+        p.report();
+    }
+    if (fi) std::fclose(fi);
+    if (fo) std::fclose(fo);
+    return res;
+}
+
+int bench_pipeline() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path dir = fs::temp_directory_path(ec);
+    if (ec) dir = ".";
+    fs::path in = dir / "pipeline_bench_input.txt";
+    fs::path out = dir / "pipeline_bench_output.txt";
+
+    std::printf("[pipeline] 生成 %.1f GB 的输入文件 %s ...\n",
+                static_cast<double>(kPipeInputBytes) / (1 << 30), in.string().c_str());
+    auto t0 = pipeline::Clock::now();
+    if (!pipe_generate(in, kPipeInputBytes)) {
+        std::fprintf(stderr, "无法写入 %s\n", in.string().c_str());
+        fs::remove(in, ec);
+        return 1;
+    }
+    double gen_s = std::chrono::duration<double>(pipeline::Clock::now() - t0).count();
+    double gb = static_cast<double>(fs::file_size(in, ec)) / (1 << 30);
+    std::printf("  生成用时 %.2f s\n", gen_s);
+
+    std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t workers = std::max<std::size_t>(1, hw / 2);
+
+    PipeResult serial = pipe_serial(in, out);
+    std::printf("  串行: %.2f s (%.2f GB/s), 输出 %.1f MB\n", serial.seconds, gb / serial.seconds,
+                static_cast<double>(serial.bytes) / (1 << 20));
+
+    for (bool ordered : {true, false}) {
+        std::printf("  流水线, %s输出, 解析/转换各 %zu 线程:\n", ordered ? "有序" : "乱序", workers);
+        PipeResult r = pipe_parallel(in, out, ordered, workers);
+        bool same = ordered ? r.chained == serial.chained : r.sum == serial.sum;
+        std::printf("  => %.2f s (%.2f GB/s, 相对串行 %.2fx), 输出%s\n", r.seconds, gb / r.seconds,
+                    serial.seconds / r.seconds,
+                    !same                 ? "与串行不一致!"
+                    : ordered             ? "与串行逐块相同"
+                    : r.chained == serial.chained ? "内容相同 (碰巧同序)"
+                                                  : "内容相同、块的顺序不同");
+    }
+    std::printf("  在途条目上限 16 × 4MB：无论输入多大，流水线里最多约 64MB 数据\n");
+    fs::remove(in, ec);
+    fs::remove(out, ec);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    // --bench 名称：运行基准测试而不是功能演示
+    if (argc > 2 && std::string_view(argv[1]) == "--bench") {
+        const struct {
+            std::string_view name;
+            int (*run)();
+        } benches[] = {
+            {"parallel", bench_parallel},
+            {"coro", bench_coro},
+            {"pipeline", bench_pipeline},
+            {"dispatch", dispatch::run_benchmark},
+        };
+        for (const auto& b : benches) {
+            if (b.name == argv[2]) return b.run();
+        }
+        std::fprintf(stderr, "未知的基准: %s\n", argv[2]);
+        return 1;
+    }
+
     // 终端打印 Hello World
     // std::endl 会在末尾添加换行符并刷新流，确保输出立即在控制台显示
     std::cout << "Hello World! 欢迎开启 C/C++ 学习之旅。" << std::endl;
 
+    // 数据并行：把 1..1000000 的求和分给多个线程
+    constexpr std::size_t kN = 1'000'000;
+    std::uint64_t sum = parallel::parallel_reduce(
+        1, kN + 1, 0, std::uint64_t{0},
+        [](std::size_t b, std::size_t e, std::uint64_t acc) {
+            for (std::size_t i = b; i < e; i++) acc += i;
+            return acc;
+        },
+        [](std::uint64_t a, std::uint64_t b) { return a + b; });
+    std::cout << "parallel_reduce: 1 + 2 + ... + " << kN << " = " << sum << std::endl;
+
+    // 嵌套并行：外层的块（包括调用线程自己领到的块）里再次 parallel_for，内层直接串行执行
+    {
+        parallel::ThreadPool pool(2);
+        std::atomic<std::size_t> cells{0};
+        parallel::parallel_for(0, 64, 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; i++) {
+                parallel::parallel_for(0, 64, 1, [&](std::size_t ib, std::size_t ie) {
+                    cells.fetch_add(ie - ib, std::memory_order_relaxed);
+                }, pool);
+            }
+        }, pool);
+        std::cout << "嵌套 parallel_for: 64 x 64 = " << cells.load() << std::endl;
+    }
+
+    // 带依赖的任务图：每个任务在前驱全部完成后才进入就绪队列
+    demo_task_graph();
+
+    // 协程：定时器、when_all/when_any 与异步读文件都跑在同一个单线程事件循环上
+    coro::EventLoop loop;
+    loop.run(demo_coro_main(loop));
+
     return 0;
 }